@@ -0,0 +1,67 @@
+/*
+ * Filename: nrLDPC_bg.h
+ *
+ * Base graphs of the 5G NR LDPC codes (TS 38.212 section 5.3.2): the non-zero circulants of BG1 and BG2 with
+ * their shift coefficients V(i,j) for the 8 sets of lifting sizes. The parity-check matrix H of a lifting size
+ * Zc replaces each circulant by the Zc x Zc identity cyclically shifted right by P(i,j) = V(i,j) mod Zc, that is
+ * row k of the block sums bit (k + P(i,j)) mod Zc of column j, and every other entry by the zero matrix.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_BG_H_
+#define NRLDPC_BG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define NRLDPC_BG_NUM_ILS 8   /* Sets of lifting sizes, Table 5.3.2-1 */
+#define NRLDPC_BG_MAX_ROWS 46 /* Rows of BG1 */
+#define NRLDPC_BG_MAX_COLS 68 /* Columns of BG1 */
+#define NRLDPC_BG_MAX_Z 384   /* Largest lifting size */
+#define NRLDPC_BG_PUNCTURED 2 /* Systematic columns never transmitted */
+
+/* Non-zero circulant of a base graph row */
+struct nrLDPC_bg_entry {
+        uint8_t col;                   /* Column j */
+        uint16_t v[NRLDPC_BG_NUM_ILS]; /* Shift coefficient V(i,j) of each set of lifting sizes */
+};
+
+/* Base graph */
+struct nrLDPC_bg {
+        uint8_t bg;                            /* 1 or 2 */
+        uint8_t rows;                          /* 46 for BG1, 42 for BG2 */
+        uint8_t cols;                          /* 68 for BG1, 52 for BG2 */
+        uint8_t kb;                            /* Systematic columns: 22 for BG1, 10 for BG2 */
+        const uint16_t *row_start;             /* Index in entries of the first circulant of each row, and the end */
+        const struct nrLDPC_bg_entry *entries; /* Circulants row by row, by increasing column */
+};
+
+/**
+ * Get a base graph
+ *
+ * @bg [in]: Base graph, as given by OAI
+ * @return: The base graph, NULL unless bg is 1 or 2
+ */
+const struct nrLDPC_bg *nrLDPC_bg_get(uint8_t bg);
+
+/**
+ * Set of a lifting size, the index i of the V(i,j) to use
+ *
+ * @z [in]: Lifting size (Zc)
+ * @return: The set index, -1 when z is not a lifting size of Table 5.3.2-1
+ */
+int nrLDPC_bg_ils(uint16_t z);
+
+/**
+ * Check a codeword against the parity-check matrix
+ *
+ * @g [in]: Base graph
+ * @z [in]: Lifting size (Zc)
+ * @cw [in]: The cols * z bits of the codeword, punctured columns included, one bit per byte
+ * @return: Number of the rows * z parity checks that fail, 0 for a codeword
+ */
+uint32_t nrLDPC_bg_syndrome(const struct nrLDPC_bg *g, uint16_t z, const uint8_t *cw);
+
+#endif // NRLDPC_BG_H_
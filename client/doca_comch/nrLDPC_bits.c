@@ -0,0 +1,138 @@
+/*
+ * Filename: nrLDPC_bits.c
+ *
+ * Bit packing/unpacking of the encoder input and codeword, AVX2 kernels with a scalar fallback
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <string.h>
+
+#include "nrLDPC_bits.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NRLDPC_BITS_AVX2 1
+#endif
+
+void nrLDPC_bits_pack_scalar(const uint8_t *bytes, uint32_t nbits, uint8_t *packed)
+{
+        uint32_t i, b;
+        uint8_t byte;
+
+        for (i = 0; i < nbits / 8; i++) {
+                byte = 0;
+                for (b = 0; b < 8; b++)
+                        byte |= (bytes[i * 8 + b] & 1) << (7 - b);
+                packed[i] = byte;
+        }
+
+        if (nbits % 8 != 0) {
+                byte = 0;
+                for (b = 0; b < nbits % 8; b++)
+                        byte |= (bytes[i * 8 + b] & 1) << (7 - b);
+                packed[i] = byte;
+        }
+}
+
+void nrLDPC_bits_unpack_scalar(const uint8_t *packed, uint32_t nbits, uint8_t *bytes)
+{
+        uint32_t i;
+
+        for (i = 0; i < nbits; i++)
+                bytes[i] = (packed[i / 8] >> (7 - i % 8)) & 1;
+}
+
+#ifdef NRLDPC_BITS_AVX2
+/**
+ * AVX2 pack, 32 bits per iteration: the bytes of each group of 8 are reversed so that movemask, which
+ * collects the bits LSB first, yields MSB first bytes
+ *
+ * @bytes [in]: nbits bytes
+ * @nbits [in]: Number of bits
+ * @packed [out]: nrLDPC_bits_bytes(nbits) bytes
+ */
+__attribute__((target("avx2"))) static void bits_pack_avx2(const uint8_t *bytes, uint32_t nbits, uint8_t *packed)
+{
+        const __m256i reverse8 = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                                  7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+        __m256i v;
+        uint32_t mask;
+        uint32_t i;
+
+        for (i = 0; i + 32 <= nbits; i += 32) {
+                v = _mm256_loadu_si256((const __m256i *)(bytes + i));
+                v = _mm256_shuffle_epi8(v, reverse8);
+                /* Move the LSB of every byte to its MSB, the one movemask reads */
+                v = _mm256_slli_epi16(v, 7);
+                mask = (uint32_t)_mm256_movemask_epi8(v);
+                memcpy(packed + i / 8, &mask, sizeof(mask));
+        }
+
+        if (i < nbits)
+                nrLDPC_bits_pack_scalar(bytes + i, nbits - i, packed + i / 8);
+}
+
+/**
+ * AVX2 unpack, 32 bits per iteration: every output byte picks its source byte and tests its own bit
+ *
+ * @packed [in]: nrLDPC_bits_bytes(nbits) bytes
+ * @nbits [in]: Number of bits
+ * @bytes [out]: nbits bytes
+ */
+__attribute__((target("avx2"))) static void bits_unpack_avx2(const uint8_t *packed, uint32_t nbits, uint8_t *bytes)
+{
+        const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                                2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+        const __m256i bit = _mm256_setr_epi8(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                             0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                             0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                             0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+        const __m256i one = _mm256_set1_epi8(1);
+        __m256i v;
+        uint32_t word;
+        uint32_t i;
+
+        for (i = 0; i + 32 <= nbits; i += 32) {
+                memcpy(&word, packed + i / 8, sizeof(word));
+                v = _mm256_shuffle_epi8(_mm256_set1_epi32((int)word), spread);
+                v = _mm256_cmpeq_epi8(_mm256_and_si256(v, bit), bit);
+                _mm256_storeu_si256((__m256i *)(bytes + i), _mm256_and_si256(v, one));
+        }
+
+        if (i < nbits)
+                nrLDPC_bits_unpack_scalar(packed + i / 8, nbits - i, bytes + i);
+}
+#endif
+
+bool nrLDPC_bits_simd(void)
+{
+#ifdef NRLDPC_BITS_AVX2
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+}
+
+void nrLDPC_bits_pack(const uint8_t *bytes, uint32_t nbits, uint8_t *packed)
+{
+#ifdef NRLDPC_BITS_AVX2
+        if (__builtin_cpu_supports("avx2")) {
+                bits_pack_avx2(bytes, nbits, packed);
+                return;
+        }
+#endif
+        nrLDPC_bits_pack_scalar(bytes, nbits, packed);
+}
+
+void nrLDPC_bits_unpack(const uint8_t *packed, uint32_t nbits, uint8_t *bytes)
+{
+#ifdef NRLDPC_BITS_AVX2
+        if (__builtin_cpu_supports("avx2")) {
+                bits_unpack_avx2(packed, nbits, bytes);
+                return;
+        }
+#endif
+        nrLDPC_bits_unpack_scalar(packed, nbits, bytes);
+}
@@ -0,0 +1,73 @@
+/*
+ * Filename: nrLDPC_bits.h
+ *
+ * Conversion between the one-bit-per-byte layout of OAI (values 0/1, ASCII '0'/'1' also accepted on input)
+ * and the packed layout sent over PCIe: 8 bits per byte, first bit in the MSB, as OAI packs its segments.
+ * The AVX2 kernels are selected at run time when the CPU supports them, the scalar ones otherwise.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_BITS_H_
+#define NRLDPC_BITS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Bytes needed to pack a number of bits
+ *
+ * @nbits [in]: Number of bits
+ * @return: Number of bytes
+ */
+static inline uint32_t nrLDPC_bits_bytes(uint32_t nbits)
+{
+        return (nbits + 7) / 8;
+}
+
+/**
+ * Pack one bit per byte into 8 bits per byte. Only the LSB of each input byte is used, the padding
+ * bits of the last output byte are 0.
+ *
+ * @bytes [in]: nbits bytes
+ * @nbits [in]: Number of bits
+ * @packed [out]: nrLDPC_bits_bytes(nbits) bytes
+ */
+void nrLDPC_bits_pack(const uint8_t *bytes, uint32_t nbits, uint8_t *packed);
+
+/**
+ * Unpack 8 bits per byte into one bit per byte (0 or 1), exactly nbits bytes are written
+ *
+ * @packed [in]: nrLDPC_bits_bytes(nbits) bytes
+ * @nbits [in]: Number of bits
+ * @bytes [out]: nbits bytes
+ */
+void nrLDPC_bits_unpack(const uint8_t *packed, uint32_t nbits, uint8_t *bytes);
+
+/**
+ * Scalar implementation of nrLDPC_bits_pack, the reference of the SIMD kernel
+ *
+ * @bytes [in]: nbits bytes
+ * @nbits [in]: Number of bits
+ * @packed [out]: nrLDPC_bits_bytes(nbits) bytes
+ */
+void nrLDPC_bits_pack_scalar(const uint8_t *bytes, uint32_t nbits, uint8_t *packed);
+
+/**
+ * Scalar implementation of nrLDPC_bits_unpack, the reference of the SIMD kernel
+ *
+ * @packed [in]: nrLDPC_bits_bytes(nbits) bytes
+ * @nbits [in]: Number of bits
+ * @bytes [out]: nbits bytes
+ */
+void nrLDPC_bits_unpack_scalar(const uint8_t *packed, uint32_t nbits, uint8_t *bytes);
+
+/**
+ * Whether nrLDPC_bits_pack / nrLDPC_bits_unpack run the AVX2 kernels
+ *
+ * @return: true when the AVX2 kernels are used
+ */
+bool nrLDPC_bits_simd(void);
+
+#endif // NRLDPC_BITS_H_
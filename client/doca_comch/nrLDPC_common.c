@@ -22,6 +22,8 @@
  *
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include <doca_buf.h>
@@ -36,10 +38,18 @@
 
 #include "comch_ctrl_path_common.h"
 #include "nrLDPC_common.h"
+#include "nrLDPC_standin.h"
 #include "common.h"
 
 DOCA_LOG_REGISTER(NRLDPC_COMMON);
 
+static _Atomic(uint64_t) mem_registrations; /* Memory regions registered for the data path */
+
+uint64_t comch_data_path_mem_registrations(void)
+{
+        return atomic_load_explicit(&mem_registrations, memory_order_relaxed);
+}
+
 void clean_local_mem_bufs(struct local_mem_bufs *local)
 {
         doca_error_t result;
@@ -129,6 +139,7 @@ doca_error_t init_local_mem_bufs(struct local_mem_bufs *local, struct doca_dev *
                 goto destroy_mmap;
         }
 
+        atomic_fetch_add_explicit(&mem_registrations, 1, memory_order_relaxed);
         return DOCA_SUCCESS;
 
 destroy_mmap:
@@ -145,47 +156,246 @@ free_mem:
         return result;
 }
 
-void clean_comch_producer(struct doca_comch_producer *producer, struct doca_pe *pe)
+/**
+ * Pack a free-list head
+ *
+ * @tag [in]: ABA tag, bumped on every update
+ * @slot [in]: First free slot
+ * @return: Packed head
+ */
+static inline uint64_t slab_head(uint32_t tag, uint32_t slot)
+{
+        return ((uint64_t)tag << 32) | slot;
+}
+
+uint32_t local_mem_slab_get(struct local_mem_slab *slab)
+{
+        uint64_t head = atomic_load_explicit(&slab->free_head, memory_order_acquire);
+        uint64_t next;
+        uint32_t slot;
+
+        do {
+                slot = (uint32_t)head;
+                if (slot == CC_DATA_PATH_INVALID_SLOT)
+                        return CC_DATA_PATH_INVALID_SLOT;
+                next = slab_head((uint32_t)(head >> 32) + 1,
+                                 atomic_load_explicit(&slab->next[slot], memory_order_relaxed));
+        } while (!atomic_compare_exchange_weak_explicit(&slab->free_head,
+                                                        &head,
+                                                        next,
+                                                        memory_order_acq_rel,
+                                                        memory_order_acquire));
+
+        return slot;
+}
+
+void local_mem_slab_put(struct local_mem_slab *slab, uint32_t slot)
+{
+        uint64_t head = atomic_load_explicit(&slab->free_head, memory_order_relaxed);
+
+        do {
+                atomic_store_explicit(&slab->next[slot], (uint32_t)head, memory_order_relaxed);
+        } while (!atomic_compare_exchange_weak_explicit(&slab->free_head,
+                                                        &head,
+                                                        slab_head((uint32_t)(head >> 32) + 1, slot),
+                                                        memory_order_release,
+                                                        memory_order_relaxed));
+}
+
+void clean_local_mem_slab(struct local_mem_slab *slab)
+{
+        void *mem = slab->mem.mem; /* clean_local_mem_bufs forgets it without freeing */
+        uint32_t i;
+
+        if (slab->bufs != NULL) {
+                for (i = 0; i < slab->num_slots; i++) {
+                        if (slab->bufs[i] != NULL)
+                                (void)doca_buf_dec_refcount(slab->bufs[i], NULL);
+                }
+        }
+
+        if (slab->mem.mmap != NULL)
+                clean_local_mem_bufs(&slab->mem);
+
+        free(mem);
+        free(slab->bufs);
+        free((void *)slab->next);
+        slab->mem.mem = NULL;
+        slab->bufs = NULL;
+        slab->next = NULL;
+        slab->num_slots = 0;
+}
+
+doca_error_t init_local_mem_slab(struct local_mem_slab *slab, struct doca_dev *dev, uint32_t slot_size, uint32_t num_slots)
 {
         doca_error_t result;
+        uint32_t i;
+
+        memset(slab, 0, sizeof(*slab));
+        slab->slot_size = (slot_size + CC_DATA_PATH_SLOT_ALIGN - 1) & ~(CC_DATA_PATH_SLOT_ALIGN - 1);
+        slab->num_slots = num_slots;
+
+        /* Allocated here, so clean_local_mem_bufs must not free it */
+        slab->mem.need_alloc_mem = false;
+        slab->mem.mem = aligned_alloc(CC_DATA_PATH_SLOT_ALIGN, (size_t)slab->slot_size * num_slots);
+        slab->bufs = calloc(num_slots, sizeof(*slab->bufs));
+        slab->next = calloc(num_slots, sizeof(*slab->next));
+        if (slab->mem.mem == NULL || slab->bufs == NULL || slab->next == NULL) {
+                result = DOCA_ERROR_NO_MEMORY;
+                DOCA_LOG_ERR("Unable to alloc slab of %u x %u bytes: %s",
+                             num_slots,
+                             slab->slot_size,
+                             doca_error_get_descr(result));
+                goto clean_slab;
+        }
+        memset(slab->mem.mem, 0, (size_t)slab->slot_size * num_slots);
 
-        if (producer != NULL) {
-                result = doca_comch_producer_destroy(producer);
+        if (dev != NULL) {
+                result = init_local_mem_bufs(&slab->mem, dev, slab->slot_size, num_slots);
                 if (result != DOCA_SUCCESS)
-                        DOCA_LOG_ERR("Failed to destroy producer properly with error=%s", doca_error_get_name(result));
+                        goto clean_slab;
+
+                for (i = 0; i < num_slots; i++) {
+                        result = doca_buf_inventory_buf_get_by_addr(slab->mem.buf_inv,
+                                                                    slab->mem.mmap,
+                                                                    local_mem_slab_addr(slab, i),
+                                                                    slab->slot_size,
+                                                                    &slab->bufs[i]);
+                        if (result != DOCA_SUCCESS) {
+                                DOCA_LOG_ERR("Failed to get doca buf for slab slot %u with error = %s",
+                                             i,
+                                             doca_error_get_name(result));
+                                goto clean_slab;
+                        }
+                }
+        } else {
+                /* Host memory only (stand-in server), account it as the registration it replaces */
+                atomic_fetch_add_explicit(&mem_registrations, 1, memory_order_relaxed);
+        }
+
+        /* Chain all the slots in the free-list */
+        for (i = 0; i < num_slots; i++)
+                atomic_store_explicit(&slab->next[i],
+                                      i + 1 < num_slots ? i + 1 : CC_DATA_PATH_INVALID_SLOT,
+                                      memory_order_relaxed);
+        atomic_store_explicit(&slab->free_head, slab_head(0, 0), memory_order_release);
+
+        return DOCA_SUCCESS;
+
+clean_slab:
+        clean_local_mem_slab(slab);
+        return result;
+}
+
+/* Slot sizes of the producer pool classes below the largest message, see local_mem_pool */
+static const uint32_t pool_class_sizes[] = {1024, 4 * 1024, 8 * 1024, 32 * 1024};
+
+_Static_assert(sizeof(pool_class_sizes) / sizeof(pool_class_sizes[0]) < CC_DATA_PATH_SLOT_CLASSES,
+               "The largest message takes a class of its own");
+
+void clean_local_mem_pool(struct local_mem_pool *pool)
+{
+        uint32_t i;
+
+        for (i = 0; i < pool->num_classes; i++)
+                clean_local_mem_slab(&pool->classes[i]);
+        pool->num_classes = 0;
+}
+
+doca_error_t init_local_mem_pool(struct local_mem_pool *pool,
+                                 struct doca_dev *dev,
+                                 uint32_t max_size,
+                                 uint32_t num_slots,
+                                 bool one_size)
+{
+        uint32_t sizes[CC_DATA_PATH_SLOT_CLASSES];
+        uint32_t num_classes = 0;
+        doca_error_t result;
+        uint32_t i;
+
+        memset(pool, 0, sizeof(*pool));
+        for (i = 0; one_size == false && i < sizeof(pool_class_sizes) / sizeof(pool_class_sizes[0]); i++) {
+                if (pool_class_sizes[i] < max_size)
+                        sizes[num_classes++] = pool_class_sizes[i];
         }
+        sizes[num_classes++] = max_size;
 
-        if (pe != NULL) {
-                result = doca_pe_destroy(pe);
+        for (i = 0; i < num_classes; i++) {
+                result = init_local_mem_slab(&pool->classes[i], dev, sizes[i], num_slots);
+                if (result != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Failed to init the %u bytes slot class with error = %s",
+                                     sizes[i],
+                                     doca_error_get_name(result));
+                        clean_local_mem_pool(pool);
+                        return result;
+                }
+                pool->num_classes = i + 1;
+        }
+
+        return DOCA_SUCCESS;
+}
+
+uint32_t local_mem_pool_get(struct local_mem_pool *pool, uint32_t len)
+{
+        uint32_t slot;
+        uint32_t i;
+
+        /* A class exhausted by a burst lends the slots of the larger ones */
+        for (i = 0; i < pool->num_classes; i++) {
+                if (pool->classes[i].slot_size < len)
+                        continue;
+                slot = local_mem_slab_get(&pool->classes[i]);
+                if (slot != CC_DATA_PATH_INVALID_SLOT)
+                        return i << CC_DATA_PATH_CLASS_SHIFT | slot;
+        }
+
+        return CC_DATA_PATH_INVALID_SLOT;
+}
+
+void local_mem_pool_put(struct local_mem_pool *pool, uint32_t slot)
+{
+        local_mem_slab_put(local_mem_pool_slab(pool, slot), slot & CC_DATA_PATH_SLOT_MASK);
+}
+
+uint32_t local_mem_pool_slots(const struct local_mem_pool *pool)
+{
+        uint32_t slots = 0;
+        uint32_t i;
+
+        for (i = 0; i < pool->num_classes; i++)
+                slots += pool->classes[i].num_slots;
+        return slots;
+}
+
+void clean_comch_producer(struct doca_comch_producer *producer)
+{
+        doca_error_t result;
+
+        if (producer != NULL) {
+                result = doca_comch_producer_destroy(producer);
                 if (result != DOCA_SUCCESS)
-                        DOCA_LOG_ERR("Failed to destroy pe properly with error=%s", doca_error_get_name(result));
+                        DOCA_LOG_ERR("Failed to destroy producer properly with error=%s", doca_error_get_name(result));
         }
 }
 
 doca_error_t init_comch_producer(struct doca_comch_connection *connection,
+                                 struct doca_pe *pe,
                                  struct comch_producer_cb_config *cfg,
-                                 struct doca_comch_producer **producer,
-                                 struct doca_pe **pe)
+                                 struct doca_comch_producer **producer)
 {
         doca_error_t result;
         struct doca_ctx *ctx;
         union doca_data user_data;
 
-        result = doca_pe_create(pe);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed creating pe with error = %s", doca_error_get_name(result));
-                return result;
-        }
-
         result = doca_comch_producer_create(connection, producer);
         if (result != DOCA_SUCCESS) {
                 DOCA_LOG_ERR("Failed to create producer with error = %s", doca_error_get_name(result));
-                goto destroy_pe;
+                return result;
         }
 
         ctx = doca_comch_producer_as_ctx(*producer);
 
-        result = doca_pe_connect_ctx(*pe, ctx);
+        result = doca_pe_connect_ctx(pe, ctx);
         if (result != DOCA_SUCCESS) {
                 DOCA_LOG_ERR("Failed adding pe context to producer with error = %s", doca_error_get_name(result));
                 goto destroy_producer;
@@ -200,7 +410,7 @@ doca_error_t init_comch_producer(struct doca_comch_connection *connection,
         result = doca_comch_producer_task_send_set_conf(*producer,
                                                         cfg->send_task_comp_cb,
                                                         cfg->send_task_comp_err_cb,
-                                                        CC_DATA_PATH_TASK_NUM);
+                                                        cfg->num_tasks != 0 ? cfg->num_tasks : CC_DATA_PATH_TASK_NUM);
         if (result != DOCA_SUCCESS) {
                 DOCA_LOG_ERR("Failed setting producer send task cbs with error = %s", doca_error_get_name(result));
                 goto destroy_producer;
@@ -224,13 +434,10 @@ doca_error_t init_comch_producer(struct doca_comch_connection *connection,
 destroy_producer:
         doca_comch_producer_destroy(*producer);
         *producer = NULL;
-destroy_pe:
-        doca_pe_destroy(*pe);
-        *pe = NULL;
         return result;
 }
 
-void clean_comch_consumer(struct doca_comch_consumer *consumer, struct doca_pe *pe)
+void clean_comch_consumer(struct doca_comch_consumer *consumer)
 {
         doca_error_t result;
 
@@ -240,39 +447,27 @@ void clean_comch_consumer(struct doca_comch_consumer *consumer, struct doca_pe *
                         DOCA_LOG_ERR("Failed to destroy consumer properly with error = %s",
                                      doca_error_get_name(result));
         }
-
-        if (pe != NULL) {
-                result = doca_pe_destroy(pe);
-                if (result != DOCA_SUCCESS)
-                        DOCA_LOG_ERR("Failed to destroy pe properly with error = %s", doca_error_get_name(result));
-        }
 }
 
 doca_error_t init_comch_consumer(struct doca_comch_connection *connection,
+                                 struct doca_pe *pe,
                                  struct doca_mmap *user_mmap,
                                  struct comch_consumer_cb_config *cfg,
-                                 struct doca_comch_consumer **consumer,
-                                 struct doca_pe **pe)
+                                 struct doca_comch_consumer **consumer)
 {
         doca_error_t result;
         struct doca_ctx *ctx;
         union doca_data user_data;
 
-        result = doca_pe_create(pe);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed creating pe with error = %s", doca_error_get_name(result));
-                return result;
-        }
-
         result = doca_comch_consumer_create(connection, user_mmap, consumer);
         if (result != DOCA_SUCCESS) {
                 DOCA_LOG_ERR("Failed to create consumer with error = %s", doca_error_get_name(result));
-                goto destroy_pe;
+                return result;
         }
 
         ctx = doca_comch_consumer_as_ctx(*consumer);
 
-        result = doca_pe_connect_ctx(*pe, ctx);
+        result = doca_pe_connect_ctx(pe, ctx);
         if (result != DOCA_SUCCESS) {
                 DOCA_LOG_ERR("Failed adding pe context to server with error = %s", doca_error_get_name(result));
                 goto destroy_consumer;
@@ -287,7 +482,8 @@ doca_error_t init_comch_consumer(struct doca_comch_connection *connection,
         result = doca_comch_consumer_task_post_recv_set_conf(*consumer,
                                                              cfg->recv_task_comp_cb,
                                                              cfg->recv_task_comp_err_cb,
-                                                             CC_DATA_PATH_TASK_NUM);
+                                                             cfg->num_tasks != 0 ? cfg->num_tasks :
+                                                                                   CC_DATA_PATH_TASK_NUM);
         if (result != DOCA_SUCCESS) {
                 DOCA_LOG_ERR("Failed setting consumer recv task cbs with error = %s", doca_error_get_name(result));
                 goto destroy_consumer;
@@ -311,9 +507,6 @@ doca_error_t init_comch_consumer(struct doca_comch_connection *connection,
 destroy_consumer:
         doca_comch_consumer_destroy(*consumer);
         *consumer = NULL;
-destroy_pe:
-        doca_pe_destroy(*pe);
-        *pe = NULL;
         return result;
 }
 
@@ -329,36 +522,14 @@ static void producer_send_task_completion_callback(struct doca_comch_producer_ta
                                                    union doca_data ctx_user_data)
 {
         struct comch_data_path_objects *data_path;
-        const struct doca_buf *buf;
-
-        (void)task_user_data;
 
         data_path = (struct comch_data_path_objects *)(ctx_user_data.ptr);
         data_path->producer_result = DOCA_SUCCESS;
+        data_path->msg_sent = true;
 
-
-
-        /* strcpy(data_path->text, CC_LDPC_REQ); */                                                             /* VBrusse */
-        /* DOCA_LOG_INFO("Producer task enviou mensagem: %s", data_path->text);                                    VBrusse */
-        /* DOCA_LOG_INFO("\n\n\n*** Input Block ===> %s\n\n", (char *)((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->inputBlock);         VBrusse */
-/*        DOCA_LOG_INFO("====================> LLRs (Log-Likelihood Ratios) values <====================");
-        for (int8_t i = 0; i < 12; i++) {
-                printf("%d ", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->llrs[i]);
-        }
-        printf("\n");
-        DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->bg);
-        DOCA_LOG_INFO("*** z = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->z);
-        DOCA_LOG_INFO("*** num_its = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->num_its);
-*/
-
-
-
-        DOCA_LOG_INFO("Producer task sent successfully");
-
-        buf = doca_comch_producer_task_send_get_buf(task);
-        (void)doca_buf_dec_refcount((struct doca_buf *)buf, NULL);
+        /* The slot keeps its DOCA buf, only hand it back to its class */
+        local_mem_pool_put(&data_path->producer_pool, (uint32_t)task_user_data.u64);
         doca_task_free(doca_comch_producer_task_send_as_task(task));
-        (void)doca_ctx_stop(doca_comch_producer_as_ctx(data_path->producer));
 }
 
 /**
@@ -373,85 +544,77 @@ static void producer_send_task_completion_err_callback(struct doca_comch_produce
                                                        union doca_data ctx_user_data)
 {
         struct comch_data_path_objects *data_path;
-        const struct doca_buf *buf;
-
-        (void)task_user_data;
 
         data_path = (struct comch_data_path_objects *)(ctx_user_data.ptr);
         data_path->producer_result = doca_task_get_status(doca_comch_producer_task_send_as_task(task));
-        DOCA_LOG_ERR("Producer message failed to send with error = %s",
-                     doca_error_get_name(data_path->producer_result));
+        data_path->msg_sent = true;
+        if (data_path->stopping == false)
+                DOCA_LOG_ERR("Producer message failed to send with error = %s",
+                             doca_error_get_name(data_path->producer_result));
 
-        buf = doca_comch_producer_task_send_get_buf(task);
-        (void)doca_buf_dec_refcount((struct doca_buf *)buf, NULL);
+        local_mem_pool_put(&data_path->producer_pool, (uint32_t)task_user_data.u64);
         doca_task_free(doca_comch_producer_task_send_as_task(task));
-        (void)doca_ctx_stop(doca_comch_producer_as_ctx(data_path->producer));
 }
 
 /**
- * Use producers to send a msg
+ * Use producers to send the message staged in a producer slot
  *
  * @data_path [in]: CC data path resources
+ * @slot [in]: Producer slot holding the message, returned to the pool on completion
+ * @len [in]: Length of the staged message
  * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
-static doca_error_t producer_send_msg(struct comch_data_path_objects *data_path)
+static doca_error_t producer_send_msg(struct comch_data_path_objects *data_path, uint32_t slot, uint32_t len)
 {
+        struct local_mem_pool *pool = &data_path->producer_pool;
         struct doca_comch_producer_task_send *producer_task;
-        struct doca_buf *buf;
+        struct doca_buf *buf = local_mem_pool_slab(pool, slot)->bufs[slot & CC_DATA_PATH_SLOT_MASK];
+        const uint8_t *imm_data = NULL;
+        uint32_t imm_data_len = 0;
         struct doca_task *task_obj;
+        union doca_data task_user_data;
+        uint32_t retries;
         doca_error_t result;
 
-        struct timespec ts = {
-                .tv_sec = 0,
-                .tv_nsec = SLEEP_IN_NANOS,
-        };
-
-
-
-        void *p_ldpc_data;                                      /* VBrusse */
-
-        if (data_path->pldpc_enc_pars != NULL) {
-                p_ldpc_data = data_path->pldpc_enc_pars;
-        }
-
-        if (data_path->pldpc_dec_pars != NULL) {
-                p_ldpc_data = data_path->pldpc_dec_pars;
-        }
-
-
-
-        result = doca_buf_inventory_buf_get_by_data(data_path->producer_mem.buf_inv,
-                                                    data_path->producer_mem.mmap,
-                                                    /*(void *)(data_path->text)*/ /*(void *)(data_path->pldpc_enc_pars)*/ (void *)p_ldpc_data,  /* VBrusse */
-                                                    /*strnlen(data_path->text, CC_DATA_PATH_MAX_MSG_SIZE)*/ /*sizeof (struct ldpc_encod_params_t)*/ data_path->size_ldpc_data,
-                                                    &buf);
+        result = doca_buf_set_data(buf, local_mem_pool_addr(pool, slot), len);
         if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to get doca buf from producer mmap with error = %s", doca_error_get_name(result));
+                DOCA_LOG_ERR("Failed to set producer slot data with error = %s", doca_error_get_name(result));
                 return result;
         }
 
+        /* A data path sharing the connection with others tells the server which consumer to answer */
+        if (data_path->route_replies == true) {
+                imm_data = (const uint8_t *)&data_path->reply_consumer_id;
+                imm_data_len = sizeof(data_path->reply_consumer_id);
+        }
+
         result = doca_comch_producer_task_send_alloc_init(data_path->producer,
                                                           buf,
-                                                          NULL,
-                                                          0,
+                                                          imm_data,
+                                                          imm_data_len,
                                                           data_path->remote_consumer_id,
                                                           &producer_task);
         if (result != DOCA_SUCCESS) {
-                (void)doca_buf_dec_refcount(buf, NULL);
                 DOCA_LOG_ERR("Failed to get allocate task from producer with error = %s", doca_error_get_name(result));
                 return result;
         }
 
         task_obj = doca_comch_producer_task_send_as_task(producer_task);
-        do {
+        task_user_data.u64 = slot;
+        doca_task_set_user_data(task_obj, task_user_data);
+
+        /* Credits keep the server receives posted, a refusal is transient: retry a bounded number of rounds */
+        for (retries = 0; retries < CC_DATA_PATH_SUBMIT_RETRIES; retries++) {
                 result = doca_task_submit(task_obj);
-                if (result == DOCA_ERROR_AGAIN)
-                        nanosleep(&ts, &ts);
-        } while (result == DOCA_ERROR_AGAIN);
+                if (result != DOCA_ERROR_AGAIN)
+                        break;
+                if (doca_pe_progress(data_path->pe) == 0)
+                        comch_data_path_idle(data_path);
+        }
         if (result != DOCA_SUCCESS) {
-                (void)doca_buf_dec_refcount(buf, NULL);
                 doca_task_free(task_obj);
-                DOCA_LOG_ERR("Failed submitting send task with error = %s", doca_error_get_name(result));
+                if (result != DOCA_ERROR_AGAIN)
+                        DOCA_LOG_ERR("Failed submitting send task with error = %s", doca_error_get_name(result));
                 return result;
         }
 
@@ -480,6 +643,7 @@ static void producer_state_changed_callback(const union doca_data user_data,
         case DOCA_CTX_STATE_IDLE:
                 DOCA_LOG_INFO("CC producer context has been stopped");
                 /* We can stop progressing the PE */
+                data_path->producer_running = false;
                 data_path->producer_finish = true;
                 break;
         case DOCA_CTX_STATE_STARTING:
@@ -489,13 +653,8 @@ static void producer_state_changed_callback(const union doca_data user_data,
                 DOCA_LOG_INFO("CC producer context entered into starting state");
                 break;
         case DOCA_CTX_STATE_RUNNING:
-                DOCA_LOG_INFO("CC producer context is running. Posting message to consumer, waiting finish");
-                data_path->producer_result = producer_send_msg(data_path);
-                if (data_path->producer_result != DOCA_SUCCESS) {
-                        DOCA_LOG_ERR("Failed to submit producer send task with error = %s",
-                                     doca_error_get_name(data_path->producer_result));
-                        (void)doca_ctx_stop(doca_comch_producer_as_ctx(data_path->producer));
-                }
+                DOCA_LOG_INFO("CC producer context is running");
+                data_path->producer_running = true;
                 break;
         case DOCA_CTX_STATE_STOPPING:
                 /**
@@ -509,11 +668,50 @@ static void producer_state_changed_callback(const union doca_data user_data,
         }
 }
 
+/**
+ * Queue a received message until comch_data_path_recv_msg reads it
+ *
+ * @data_path [in]: CC data path resources
+ * @slot [in]: Consumer slot holding the message
+ * @len [in]: Message length
+ * @ready_ns [in]: Stand-in only: when the message reaches the host
+ * @service_ns [in]: Stand-in only: emulated DPU processing time of the request of the message
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t consumer_queue_msg(struct comch_data_path_objects *data_path,
+                                       uint32_t slot,
+                                       uint32_t len,
+                                       uint64_t ready_ns,
+                                       uint32_t service_ns)
+{
+        struct comch_recv_fifo *fifo = &data_path->recv_done;
+
+        uint32_t idx;
+
+        if (fifo->count == fifo->size) {
+                DOCA_LOG_ERR("Dropping %u bytes message, %u received messages are not read yet", len, fifo->size);
+                return DOCA_ERROR_FULL;
+        }
+
+        idx = (fifo->head + fifo->count) % fifo->size;
+        fifo->slots[idx] = slot;
+        fifo->lens[idx] = len;
+        if (data_path->standin != NULL) {
+                fifo->ready_ns[idx] = ready_ns;
+                fifo->service_ns[idx] = service_ns;
+        }
+        fifo->count++;
+        return DOCA_SUCCESS;
+}
+
 /**
  * Callback for consumer post recv task successful completion
  *
+ * The message stays in its slot until comch_data_path_recv_msg copies it out and re-posts the task,
+ * so recv_depth receives are outstanding whenever no response is waiting to be read.
+ *
  * @task [in]: Recv task object
- * @task_user_data [in]: User data for task
+ * @task_user_data [in]: Consumer slot of the task
  * @ctx_user_data [in]: User data for context
  */
 static void consumer_recv_task_completion_callback(struct doca_comch_consumer_task_post_recv *task,
@@ -521,71 +719,30 @@ static void consumer_recv_task_completion_callback(struct doca_comch_consumer_ta
                                                    union doca_data ctx_user_data)
 {
         struct comch_data_path_objects *data_path;
+        uint32_t slot = (uint32_t)task_user_data.u64;
         size_t recv_msg_len;
-        void *recv_msg;
         struct doca_buf *buf;
-
-        (void)task_user_data;
-
-
-
-        /* struct ldpc_encod_params_t *pars;                                            VBrusse */
-
-
+        doca_error_t result;
 
         data_path = (struct comch_data_path_objects *)(ctx_user_data.ptr);
 
         buf = doca_comch_consumer_task_post_recv_get_buf(task);
 
-        data_path->consumer_result = doca_buf_get_data(buf, &recv_msg);
-        if (data_path->consumer_result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to get data address from DOCA buf with error = %s",
-                             doca_error_get_name(data_path->consumer_result));
+        result = doca_buf_get_data_len(buf, &recv_msg_len);
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to get data length from DOCA buf with error = %s", doca_error_get_name(result));
                 goto err_out;
         }
 
-        data_path->consumer_result = doca_buf_get_data_len(buf, &recv_msg_len);
-        if (data_path->consumer_result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to get data length from DOCA buf with error = %s",
-                             doca_error_get_name(data_path->consumer_result));
+        result = consumer_queue_msg(data_path, slot, recv_msg_len, 0, 0);
+        if (result != DOCA_SUCCESS)
                 goto err_out;
-        }
-
-        DOCA_LOG_INFO("Message received: '%.*s'", (int)recv_msg_len, (char *)recv_msg);
-
-
-
-        DOCA_LOG_INFO("===> Tamanho da Mensagem Recebida ===> %ld", recv_msg_len);                      /* VBrusse */
-
-        /* pars = (struct ldpc_encod_params_t *)recv_msg; */                                            /* VBrusse */
-        if (data_path->pldpc_enc_pars != NULL) {
-                data_path->pldpc_enc_pars = (struct ldpc_encod_params_t *)recv_msg;
-        }
-
-        if (data_path->pldpc_dec_pars != NULL) {
-                data_path->pldpc_dec_pars = (struct ldpc_decod_params_t *)recv_msg;
-
-
-                // DOCA_LOG_INFO("====================> LLRs <====================");
-                // for (int i= 0; i < ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->n; i++) {                                                    /* VBrusse */
-                        // printf("%d ", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->llrs[i]);
-                // }
-                printf("\n");
-                DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->bg);
-                DOCA_LOG_INFO("*** z = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->z);
-                DOCA_LOG_INFO("*** num_its = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->num_its);
-                DOCA_LOG_INFO("*** Decoded Output:");
-
-                for (int i= 0; i < ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->kp; i++) {
-                        // printf("%d ", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->data_out[i]);
-                        printf("%02x ", (uint8_t)((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->data_out[i]);
-                }
-                printf("\n");
-        }
 
+        return;
 
 err_out:
-        (void)doca_buf_dec_refcount(buf, NULL);
+        data_path->consumer_result = result;
+        data_path->recv_tasks[slot] = NULL;
         doca_task_free(doca_comch_consumer_task_post_recv_as_task(task));
         (void)doca_ctx_stop(doca_comch_consumer_as_ctx(data_path->consumer));
 }
@@ -594,7 +751,7 @@ err_out:
  * Callback for consumer post recv task completion with error
  *
  * @task [in]: Send task object
- * @task_user_data [in]: User data for task
+ * @task_user_data [in]: Consumer slot of the task
  * @ctx_user_data [in]: User data for context
  */
 static void consumer_recv_task_completion_err_callback(struct doca_comch_consumer_task_post_recv *task,
@@ -602,60 +759,86 @@ static void consumer_recv_task_completion_err_callback(struct doca_comch_consume
                                                        union doca_data ctx_user_data)
 {
         struct comch_data_path_objects *data_path;
-        struct doca_buf *buf;
-
-        (void)task_user_data;
 
         data_path = (struct comch_data_path_objects *)(ctx_user_data.ptr);
-        data_path->consumer_result = doca_task_get_status(doca_comch_consumer_task_post_recv_as_task(task));
-        DOCA_LOG_ERR("Consumer failed to recv message with error = %s",
-                     doca_error_get_name(data_path->consumer_result));
 
-        buf = doca_comch_consumer_task_post_recv_get_buf(task);
-        (void)doca_buf_dec_refcount(buf, NULL);
+        /* Posted receives are flushed with an error when the consumer is stopped */
+        if (data_path->stopping == false) {
+                data_path->consumer_result = doca_task_get_status(doca_comch_consumer_task_post_recv_as_task(task));
+                DOCA_LOG_ERR("Consumer failed to recv message with error = %s",
+                             doca_error_get_name(data_path->consumer_result));
+        }
+
+        /* The slot buffer belongs to the consumer slab, it is released with it */
+        data_path->recv_tasks[(uint32_t)task_user_data.u64] = NULL;
         doca_task_free(doca_comch_consumer_task_post_recv_as_task(task));
-        (void)doca_ctx_stop(doca_comch_consumer_as_ctx(data_path->consumer));
+        if (data_path->stopping == false)
+                (void)doca_ctx_stop(doca_comch_consumer_as_ctx(data_path->consumer));
 }
 
 /**
- * Use consumer to recv a msg
+ * Post a consumer receive task over a slot of the consumer slab. The task is kept for the lifetime
+ * of the consumer and re-submitted each time the message of its slot has been read.
  *
  * @data_path [in]: CC data path resources
+ * @slot [in]: Consumer slot to receive into
  * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
-static doca_error_t consumer_recv_msg(struct comch_data_path_objects *data_path)
+static doca_error_t consumer_post_recv(struct comch_data_path_objects *data_path, uint32_t slot)
 {
         struct doca_comch_consumer_task_post_recv *consumer_task;
-        struct doca_buf *buf;
         struct doca_task *task_obj;
+        union doca_data task_user_data;
         doca_error_t result;
 
-        /* Receive msg from server */
-        result = doca_buf_inventory_buf_get_by_addr(data_path->consumer_mem.buf_inv,
-                                                    data_path->consumer_mem.mmap,
-                                                    data_path->consumer_mem.mem,
-                                                    CC_DATA_PATH_MAX_MSG_SIZE,
-                                                    &buf);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to get doca buf from consumer mmap with error = %s", doca_error_get_name(result));
-                return result;
-        }
-
-        result = doca_comch_consumer_task_post_recv_alloc_init(data_path->consumer, buf, &consumer_task);
+        result = doca_comch_consumer_task_post_recv_alloc_init(data_path->consumer,
+                                                               data_path->consumer_slab.bufs[slot],
+                                                               &consumer_task);
         if (result != DOCA_SUCCESS) {
                 DOCA_LOG_ERR("Failed to allocate task for consumer with error = %s", doca_error_get_name(result));
                 return result;
         }
 
         task_obj = doca_comch_consumer_task_post_recv_as_task(consumer_task);
+        task_user_data.u64 = slot;
+        doca_task_set_user_data(task_obj, task_user_data);
         result = doca_task_submit(task_obj);
         if (result != DOCA_SUCCESS) {
-                (void)doca_buf_dec_refcount(buf, NULL);
                 doca_task_free(task_obj);
-                DOCA_LOG_ERR("Failed submitting send task with error = %s", doca_error_get_name(result));
+                DOCA_LOG_ERR("Failed submitting recv task with error = %s", doca_error_get_name(result));
                 return result;
         }
 
+        data_path->recv_tasks[slot] = consumer_task;
+        return DOCA_SUCCESS;
+}
+
+/**
+ * Post recv_depth receives, each over its own consumer slot
+ *
+ * @data_path [in]: CC data path resources
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t consumer_post_recvs(struct comch_data_path_objects *data_path)
+{
+        doca_error_t result;
+        uint32_t slot;
+        uint32_t i;
+
+        for (i = 0; i < data_path->recv_depth; i++) {
+                slot = local_mem_slab_get(&data_path->consumer_slab);
+                if (slot == CC_DATA_PATH_INVALID_SLOT) {
+                        DOCA_LOG_ERR("No free consumer slot to post receive %u", i);
+                        return DOCA_ERROR_NO_MEMORY;
+                }
+
+                result = consumer_post_recv(data_path, slot);
+                if (result != DOCA_SUCCESS) {
+                        local_mem_slab_put(&data_path->consumer_slab, slot);
+                        return result;
+                }
+        }
+
         return DOCA_SUCCESS;
 }
 
@@ -686,6 +869,7 @@ static void consumer_state_changed_callback(const union doca_data user_data,
                         data_path->consumer_result = DOCA_ERROR_UNEXPECTED;
 
                 /* We can stop progressing the PE */
+                data_path->consumer_running = false;
                 data_path->consumer_finish = true;
                 break;
         case DOCA_CTX_STATE_STARTING:
@@ -696,13 +880,15 @@ static void consumer_state_changed_callback(const union doca_data user_data,
                         "CC consumer context entered into starting state. Waiting consumer producer negotiation finish");
                 break;
         case DOCA_CTX_STATE_RUNNING:
-                DOCA_LOG_INFO("CC consumer context is running. Receiving message from producer, waiting finish");
-                data_path->consumer_result = consumer_recv_msg(data_path);
+                DOCA_LOG_INFO("CC consumer context is running. Posting %u receive buffers", data_path->recv_depth);
+                data_path->consumer_result = consumer_post_recvs(data_path);
                 if (data_path->consumer_result != DOCA_SUCCESS) {
                         DOCA_LOG_ERR("Failed to submit consumer recv task with error = %s",
                                      doca_error_get_name(data_path->consumer_result));
                         (void)doca_ctx_stop(doca_comch_consumer_as_ctx(data_path->consumer));
+                        break;
                 }
+                data_path->consumer_running = true;
                 break;
         case DOCA_CTX_STATE_STOPPING:
                 /**
@@ -716,10 +902,59 @@ static void consumer_state_changed_callback(const union doca_data user_data,
         }
 }
 
-doca_error_t comch_data_path_send_msg(struct comch_data_path_objects *data_path)
+/**
+ * Release the receive bookkeeping of a data path
+ *
+ * @data_path [in]: CC data path resources
+ */
+static void clean_recv_state(struct comch_data_path_objects *data_path)
+{
+        free(data_path->recv_tasks);
+        free(data_path->recv_done.slots);
+        free(data_path->recv_done.lens);
+        free(data_path->recv_done.ready_ns);
+        free(data_path->recv_done.service_ns);
+        data_path->recv_tasks = NULL;
+        memset(&data_path->recv_done, 0, sizeof(data_path->recv_done));
+        data_path->in_flight = 0;
+}
+
+/**
+ * Allocate the receive bookkeeping of a data path: one task pointer per consumer slot and a FIFO
+ * large enough to hold every posted receive
+ *
+ * @data_path [in]: CC data path resources, consumer_slab must be initialized
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t init_recv_state(struct comch_data_path_objects *data_path)
+{
+        uint32_t num_slots = data_path->consumer_slab.num_slots;
+
+        data_path->recv_tasks = calloc(num_slots, sizeof(*data_path->recv_tasks));
+        data_path->recv_done.slots = calloc(num_slots, sizeof(uint32_t));
+        data_path->recv_done.lens = calloc(num_slots, sizeof(uint32_t));
+        data_path->recv_done.ready_ns = calloc(num_slots, sizeof(uint64_t));
+        data_path->recv_done.service_ns = calloc(num_slots, sizeof(uint32_t));
+        data_path->recv_done.size = num_slots;
+        data_path->recv_done.head = 0;
+        data_path->recv_done.count = 0;
+        data_path->in_flight = 0;
+        if (data_path->recv_tasks == NULL || data_path->recv_done.slots == NULL || data_path->recv_done.lens == NULL ||
+            data_path->recv_done.ready_ns == NULL || data_path->recv_done.service_ns == NULL) {
+                clean_recv_state(data_path);
+                return DOCA_ERROR_NO_MEMORY;
+        }
+
+        return DOCA_SUCCESS;
+}
+
+doca_error_t comch_data_path_start(struct comch_data_path_objects *data_path)
 {
         doca_error_t result;
-        struct local_mem_bufs *pmem = &data_path->producer_mem;
+        struct local_mem_pool *pool = &data_path->producer_pool;
+        struct local_mem_slab *cslab = &data_path->consumer_slab;
+        uint32_t num_slots = data_path->num_slots != 0 ? data_path->num_slots : CC_DATA_PATH_SLAB_SLOTS;
+        uint32_t recv_slots;
         struct timespec ts = {
                 .tv_sec = 0,
                 .tv_nsec = SLEEP_IN_NANOS,
@@ -729,8 +964,42 @@ doca_error_t comch_data_path_send_msg(struct comch_data_path_objects *data_path)
                                                                    producer_send_task_completion_err_callback,
                                                            .ctx_user_data = data_path,
                                                            .ctx_state_changed_cb = producer_state_changed_callback};
+        struct comch_consumer_cb_config consumer_cb_cfg = {.recv_task_comp_cb = consumer_recv_task_completion_callback,
+                                                           .recv_task_comp_err_cb =
+                                                                   consumer_recv_task_completion_err_callback,
+                                                           .ctx_user_data = data_path,
+                                                           .ctx_state_changed_cb = consumer_state_changed_callback};
+
+        data_path->stopping = false;
+        if (data_path->recv_depth == 0)
+                data_path->recv_depth = CC_DATA_PATH_RECV_DEPTH;
+
+        /* Every posted receive owns a consumer slot, it can hold any response */
+        recv_slots = num_slots > data_path->recv_depth ? num_slots : data_path->recv_depth;
+        consumer_cb_cfg.num_tasks = data_path->recv_depth;
+
+        /* The stand-in server needs plain memory only, there is no device to register it with */
+        if (data_path->standin != NULL) {
+                result = init_local_mem_pool(pool, NULL, data_path->max_msg_size, num_slots, data_path->one_slot_size);
+                if (result != DOCA_SUCCESS)
+                        return result;
+                result = init_local_mem_slab(cslab, NULL, data_path->max_msg_size, recv_slots);
+                if (result != DOCA_SUCCESS) {
+                        clean_local_mem_pool(pool);
+                        return result;
+                }
+                result = init_recv_state(data_path);
+                if (result != DOCA_SUCCESS) {
+                        clean_local_mem_slab(cslab);
+                        clean_local_mem_pool(pool);
+                        return result;
+                }
+                data_path->producer_running = true;
+                data_path->consumer_running = true;
+                return DOCA_SUCCESS;
+        }
 
-        /* When remote_consumer_id != 1, it means the remote_consumer is ready to use */
+        /* When remote_consumer_id != 0, it means the remote_consumer is ready to use */
         while (data_path->remote_consumer_id == 0) {
                 if (doca_pe_progress(data_path->pe) == 0)
                         nanosleep(&ts, &ts);
@@ -740,194 +1009,491 @@ doca_error_t comch_data_path_send_msg(struct comch_data_path_objects *data_path)
                 return DOCA_ERROR_UNEXPECTED;
 
         /*
-         * Need a cc producer to send message to server
-         * Based on user input, to setup producer's mmap and doca_buf infrastructure
-
-        pmem->mem = (void *)data_path->text;
-        pmem->need_alloc_mem = false;
-        result = init_local_mem_bufs(pmem, data_path->hw_dev, strnlen(data_path->text, CC_DATA_PATH_MAX_MSG_SIZE), 1);
+         * Register the producer and consumer slabs once, every request of the session takes its slots from them
+         */
+        result = init_local_mem_pool(pool,
+                                     data_path->hw_dev,
+                                     data_path->max_msg_size,
+                                     num_slots,
+                                     data_path->one_slot_size);
         if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to producer memory with error = %s", doca_error_get_name(result));
+                DOCA_LOG_ERR("Failed to init producer slabs with error = %s", doca_error_get_name(result));
                 return result;
         }
-        */
-
-
-
-/*      DOCA_LOG_INFO("*** Input Block ===> %s", (char *)((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->inputBlock);      VBrusse */
-/*      DOCA_LOG_INFO("====================> LLRs (Log-Likelihood Ratios) values <====================");
-        for (int8_t i = 0; i < 12; i++) {
-                printf("%d ", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->llrs[i]);
-        }
-        printf("\n");
-        DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->bg);
-        DOCA_LOG_INFO("*** z = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->z);
-        DOCA_LOG_INFO("*** num_its = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->num_its);
-*/
-
-        /*
-         * Need a consumer's mmap and doca_buf infrastructure for input parameters of LDPC encoder
-         * to send message to server
-         */
-        pmem->need_alloc_mem = false;
+        /* Every producer slot can be in flight, whatever its class */
+        producer_cb_cfg.num_tasks = local_mem_pool_slots(pool);
 
-        if (data_path->pldpc_enc_pars != NULL) {
-                pmem->mem = (struct ldpc_encod_params_t *)data_path->pldpc_enc_pars;                            /* VBrusse */
+        result = init_local_mem_slab(cslab, data_path->hw_dev, data_path->max_msg_size, recv_slots);
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to init consumer slab with error = %s", doca_error_get_name(result));
+                goto clean_pool;
         }
 
-        if (data_path->pldpc_dec_pars != NULL) {
-                pmem->mem = (struct ldpc_decod_params_t *)data_path->pldpc_dec_pars;
+        result = init_recv_state(data_path);
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to init receive state with error = %s", doca_error_get_name(result));
+                goto clean_cslab;
         }
 
-        result = init_local_mem_bufs(pmem, data_path->hw_dev, /*sizeof(struct ldpc_encod_params_t)*/ data_path->size_ldpc_data, 1);           /* VBrusse */
+        /* Init a cc producer, on the PE of the client so that a single progress call drains every completion */
+        result = init_comch_producer(data_path->connection, data_path->pe, &producer_cb_cfg, &(data_path->producer));
         if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to producer memory with error = %s", doca_error_get_name(result));
-                return result;
+                DOCA_LOG_ERR("Failed to init a producer with error = %s", doca_error_get_name(result));
+                goto clean_recv;
         }
 
-        /* Init a cc producer */
-        result = init_comch_producer(data_path->connection,
-                                     &producer_cb_cfg,
-                                     &(data_path->producer),
-                                     &(data_path->producer_pe));
+        /* Init a consumer, on the same PE */
+        result = init_comch_consumer(data_path->connection,
+                                     data_path->pe,
+                                     cslab->mem.mmap,
+                                     &consumer_cb_cfg,
+                                     &(data_path->consumer));
         if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to init a producer with error = %s", doca_error_get_name(result));
-                clean_local_mem_bufs(pmem);
-                return result;
+                DOCA_LOG_ERR("Failed to init a consumer with error = %s", doca_error_get_name(result));
+                goto clean_producer;
         }
 
-        /* Send msg to server */
-        while (data_path->producer_finish == false) {
-                if (doca_pe_progress(data_path->producer_pe) == 0)
+        /* Wait for both ends of the data path to be usable */
+        while ((data_path->producer_running == false || data_path->consumer_running == false) &&
+               data_path->producer_finish == false && data_path->consumer_finish == false) {
+                if (doca_pe_progress(data_path->pe) == 0)
                         nanosleep(&ts, &ts);
         }
 
+        if (data_path->producer_running == false || data_path->consumer_running == false) {
+                comch_data_path_stop(data_path);
+                return DOCA_ERROR_INITIALIZATION;
+        }
 
+        if (data_path->route_replies == true) {
+                result = doca_comch_consumer_get_id(data_path->consumer, &data_path->reply_consumer_id);
+                if (result != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Failed to get the consumer ID with error = %s", doca_error_get_name(result));
+                        comch_data_path_stop(data_path);
+                        return result;
+                }
+        }
 
-/*      DOCA_LOG_INFO("\n\n\n*** size_ldpc_data = %d", data_path->size_ldpc_data);                                            VBruss
-        DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->bg);
-        DOCA_LOG_INFO("*** z = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->z);
-        DOCA_LOG_INFO("*** num_its = %d", ((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->num_its);
-*/
+        return DOCA_SUCCESS;
 
+clean_producer:
+        clean_comch_producer(data_path->producer);
+        data_path->producer = NULL;
+clean_recv:
+        clean_recv_state(data_path);
+clean_cslab:
+        clean_local_mem_slab(cslab);
+clean_pool:
+        clean_local_mem_pool(pool);
+        return result;
+}
 
-        /* DOCA_LOG_INFO("Mensagem enviada: %s", data_path->text); */                    /* VBrusse */
+void comch_data_path_stop(struct comch_data_path_objects *data_path)
+{
+        doca_error_t result;
+        struct timespec ts = {
+                .tv_sec = 0,
+                .tv_nsec = SLEEP_IN_NANOS,
+        };
 
+        data_path->stopping = true;
+        data_path->producer_running = false;
+        data_path->consumer_running = false;
 
-        /* clean_comch_producer(data_path->producer, data_path->producer_pe);
-        data_path->producer = NULL;
-        data_path->producer_pe = NULL;
-        clean_local_mem_bufs(pmem); */
+        if (data_path->standin != NULL) {
+                clean_recv_state(data_path);
+                clean_local_mem_pool(&data_path->producer_pool);
+                clean_local_mem_slab(&data_path->consumer_slab);
+                return;
+        }
 
-        return data_path->producer_result;
+        /* Stopping the consumer flushes the posted receive tasks */
+        if (data_path->consumer != NULL) {
+                result = doca_ctx_stop(doca_comch_consumer_as_ctx(data_path->consumer));
+                while ((result == DOCA_SUCCESS || result == DOCA_ERROR_IN_PROGRESS) &&
+                       data_path->consumer_finish == false) {
+                        if (doca_pe_progress(data_path->pe) == 0)
+                                nanosleep(&ts, &ts);
+                }
+        }
+        clean_comch_consumer(data_path->consumer);
+        data_path->consumer = NULL;
+        clean_recv_state(data_path);
+        clean_local_mem_slab(&data_path->consumer_slab);
+
+        if (data_path->producer != NULL) {
+                result = doca_ctx_stop(doca_comch_producer_as_ctx(data_path->producer));
+                while ((result == DOCA_SUCCESS || result == DOCA_ERROR_IN_PROGRESS) &&
+                       data_path->producer_finish == false) {
+                        if (doca_pe_progress(data_path->pe) == 0)
+                                nanosleep(&ts, &ts);
+                }
+        }
+        clean_comch_producer(data_path->producer);
+        data_path->producer = NULL;
+        clean_local_mem_pool(&data_path->producer_pool);
 }
 
-doca_error_t comch_data_path_recv_msg(struct comch_data_path_objects *data_path)
+void comch_data_path_idle(const struct comch_data_path_objects *data_path)
 {
-        doca_error_t result;
-        struct local_mem_bufs *cmem = &data_path->consumer_mem;
         struct timespec ts = {
                 .tv_sec = 0,
                 .tv_nsec = SLEEP_IN_NANOS,
         };
-        struct comch_consumer_cb_config consumer_cb_cfg = {.recv_task_comp_cb = consumer_recv_task_completion_callback,
-                                                           .recv_task_comp_err_cb =
-                                                                   consumer_recv_task_completion_err_callback,
-                                                           .ctx_user_data = data_path,
-                                                           .ctx_state_changed_cb = consumer_state_changed_callback};
-        /*
-         * Need a cc consumer to recv message from server
-         * Setup consumer's mmap and doca_buf infrastructure
-         */
-        /*
-        cmem->need_alloc_mem = true;
-        result = init_local_mem_bufs(cmem, data_path->hw_dev, CC_DATA_PATH_MAX_MSG_SIZE, 1);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to consumer memory with error = %s", doca_error_get_name(result));
-                return result;
+
+        if (data_path->busy_poll == false) {
+                nanosleep(&ts, NULL);
+                return;
         }
-        */
 
+        /* Let the sibling hyper-thread run while spinning */
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        __asm__ __volatile__("yield");
+#endif
+}
 
-/*
-        DOCA_LOG_INFO("*** Input Block ===> %s", (char *)((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->inputBlock); VBrusse
-        DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->bg);
-        DOCA_LOG_INFO("*** z = %d", ((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->z);
-        DOCA_LOG_INFO("*** k = %d", ((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->k);
-        DOCA_LOG_INFO("*** len_filler_bits = %d", ((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->len_filler_bits);
-*/
+doca_error_t comch_data_path_stage_msg(struct comch_data_path_objects *data_path,
+                                       const void *msg,
+                                       uint32_t len,
+                                       uint32_t *slot)
+{
+        if (data_path->producer_running == false)
+                return DOCA_ERROR_NOT_CONNECTED;
 
-        /*
-         * Need to setup a consumer's mmap and doca_buf infrastructure for input parameters of LDPC encoder
-         * to recv message from server
-         */
-        cmem->need_alloc_mem = true;
-        /* result = init_local_mem_bufs(cmem, data_path->hw_dev, CC_DATA_PATH_MAX_MSG_SIZE, 1);                    VBrusse */
+        if (len > data_path->max_msg_size) {
+                DOCA_LOG_ERR("Message of %u bytes exceeds the %u bytes data path buffer", len, data_path->max_msg_size);
+                return DOCA_ERROR_INVALID_VALUE;
+        }
+
+        /* Exhausted classes mean too many sends in flight */
+        *slot = local_mem_pool_get(&data_path->producer_pool, len);
+        if (*slot == CC_DATA_PATH_INVALID_SLOT)
+                return DOCA_ERROR_AGAIN;
+        memcpy(local_mem_pool_addr(&data_path->producer_pool, *slot), msg, len);
+
+        return DOCA_SUCCESS;
+}
+
+doca_error_t comch_data_path_restage(struct comch_data_path_objects *data_path,
+                                     uint32_t *slot,
+                                     uint32_t len,
+                                     uint32_t size)
+{
+        struct local_mem_pool *pool = &data_path->producer_pool;
+        uint32_t to;
 
-        result = init_local_mem_bufs(cmem, data_path->hw_dev, /*sizeof(struct ldpc_encod_params_t)*/ data_path->size_ldpc_data, 1);
+        if (size <= local_mem_pool_size(pool, *slot))
+                return DOCA_SUCCESS;
+        if (size > data_path->max_msg_size)
+                return DOCA_ERROR_INVALID_VALUE;
+
+        to = local_mem_pool_get(pool, size);
+        if (to == CC_DATA_PATH_INVALID_SLOT)
+                return DOCA_ERROR_AGAIN;
+        memcpy(local_mem_pool_addr(pool, to), local_mem_pool_addr(pool, *slot), len);
+        local_mem_pool_put(pool, *slot);
+        *slot = to;
+
+        return DOCA_SUCCESS;
+}
+
+void comch_data_path_unstage(struct comch_data_path_objects *data_path, uint32_t slot)
+{
+        local_mem_pool_put(&data_path->producer_pool, slot);
+}
+
+/**
+ * Take one of the server credits of a data path
+ *
+ * @data_path [in]: CC data path resources
+ * @return: true when a credit was taken or the data path has no credit limit
+ */
+static bool credit_take(struct comch_data_path_objects *data_path)
+{
+        uint32_t credits;
+
+        if (data_path->credits == NULL)
+                return true;
+
+        credits = atomic_load_explicit(data_path->credits, memory_order_relaxed);
+        do {
+                if (credits == 0)
+                        return false;
+        } while (atomic_compare_exchange_weak_explicit(data_path->credits,
+                                                       &credits,
+                                                       credits - 1,
+                                                       memory_order_acquire,
+                                                       memory_order_relaxed) == false);
+        return true;
+}
+
+/**
+ * Give a server credit back, the request that took it was answered or not sent
+ *
+ * @data_path [in]: CC data path resources
+ */
+static void credit_put(struct comch_data_path_objects *data_path)
+{
+        if (data_path->credits != NULL)
+                atomic_fetch_add_explicit(data_path->credits, 1, memory_order_release);
+}
+
+#ifdef NRLDPC_LOOPBACK_BUILD
+/**
+ * Answer a staged request with the stand-in server right away, into a consumer slot, as if a posted receive
+ * completed
+ *
+ * @data_path [in]: CC data path resources, with its stand-in
+ * @slot [in]: Producer slot of the request, released
+ * @len [in]: Request length
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t standin_send(struct comch_data_path_objects *data_path, uint32_t slot, uint32_t len)
+{
+        void *addr = local_mem_pool_addr(&data_path->producer_pool, slot);
+        uint32_t service_ns = 0;
+        doca_error_t result;
+        uint32_t resp_slot;
+        uint32_t resp_len;
+        uint64_t ready_ns;
+        bool cancel;
+        void *resp;
+
+        resp_slot = local_mem_slab_get(&data_path->consumer_slab);
+        resp = local_mem_slab_addr(&data_path->consumer_slab, resp_slot);
+        cancel = nrLDPC_standin_cancel(data_path->standin,
+                                       addr,
+                                       len,
+                                       &data_path->recv_done,
+                                       &data_path->consumer_slab,
+                                       resp,
+                                       data_path->max_msg_size,
+                                       &resp_len);
+        if (cancel == false)
+                nrLDPC_standin_serve(data_path->standin,
+                                     addr,
+                                     len,
+                                     resp,
+                                     data_path->max_msg_size,
+                                     &resp_len,
+                                     &service_ns);
+        ready_ns = nrLDPC_standin_ready_ns(data_path->standin, cancel == false, service_ns);
+        local_mem_pool_put(&data_path->producer_pool, slot);
+        result = consumer_queue_msg(data_path, resp_slot, resp_len, ready_ns, service_ns);
         if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to consumer memory with error = %s", doca_error_get_name(result));
+                local_mem_slab_put(&data_path->consumer_slab, resp_slot);
+                credit_put(data_path);
                 return result;
         }
+        data_path->in_flight++;
+        return DOCA_SUCCESS;
+}
+#endif
 
+doca_error_t comch_data_path_send_staged(struct comch_data_path_objects *data_path, uint32_t slot, uint32_t len)
+{
+        doca_error_t result;
 
+        if (data_path->producer_running == false) {
+                local_mem_pool_put(&data_path->producer_pool, slot);
+                return DOCA_ERROR_NOT_CONNECTED;
+        }
 
+        /* Every response needs a posted receive, do not outrun them, nor those of the server */
+        if (data_path->in_flight >= data_path->recv_depth || credit_take(data_path) == false)
+                return DOCA_ERROR_AGAIN;
 
-        /* Init a consumer */
-        result = init_comch_consumer(data_path->connection,
-                                     cmem->mmap,
-                                     &consumer_cb_cfg,
-                                     &(data_path->consumer),
-                                     &(data_path->consumer_pe));
+#ifdef NRLDPC_LOOPBACK_BUILD
+        if (data_path->standin != NULL)
+                return standin_send(data_path, slot, len);
+#endif
+
+        data_path->msg_sent = false;
+        result = producer_send_msg(data_path, slot, len);
         if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to init a consumer with error = %s", doca_error_get_name(result));
-                clean_local_mem_bufs(cmem);
+                credit_put(data_path);
+                if (result != DOCA_ERROR_AGAIN)
+                        local_mem_pool_put(&data_path->producer_pool, slot);
                 return result;
         }
 
-        /* Receive msg from server */
-        while (data_path->consumer_finish == false) {
+        /* Send msg to server */
+        while (data_path->msg_sent == false) {
+                data_path->send_polls++;
                 if (doca_pe_progress(data_path->pe) == 0)
-                        nanosleep(&ts, &ts);
-                if (doca_pe_progress(data_path->consumer_pe) == 0)
-                        nanosleep(&ts, &ts);
+                        comch_data_path_idle(data_path);
         }
 
+        if (data_path->producer_result == DOCA_SUCCESS)
+                data_path->in_flight++;
+        else
+                credit_put(data_path);
+
+        return data_path->producer_result;
+}
+
+doca_error_t comch_data_path_send_msg(struct comch_data_path_objects *data_path, const void *msg, uint32_t len)
+{
+        doca_error_t result;
+        uint32_t slot;
+
+        if (data_path->producer_running == false)
+                return DOCA_ERROR_NOT_CONNECTED;
 
+        /* Every response needs a posted receive, do not outrun them */
+        if (data_path->in_flight >= data_path->recv_depth)
+                return DOCA_ERROR_AGAIN;
 
-        if (data_path->pldpc_enc_pars != NULL) {
-                data_path->pldpc_enc_pars = (struct ldpc_encod_params_t *)cmem->mem;                                     /* VBrusse */
+        /* Stage the message in a registered producer slot */
+        result = comch_data_path_stage_msg(data_path, msg, len, &slot);
+        if (result != DOCA_SUCCESS)
+                return result;
+
+        result = comch_data_path_send_staged(data_path, slot, len);
+        if (result == DOCA_ERROR_AGAIN)
+                comch_data_path_unstage(data_path, slot);
+        return result;
+}
+
+/**
+ * Whether the oldest completed receive can be read
+ *
+ * @data_path [in]: CC data path resources
+ * @return: true when a message is ready
+ */
+static bool recv_fifo_ready(struct comch_data_path_objects *data_path)
+{
+        struct comch_recv_fifo *fifo = &data_path->recv_done;
+
+        if (fifo->count == 0)
+                return false;
+#ifdef NRLDPC_LOOPBACK_BUILD
+        return data_path->standin == NULL || nrLDPC_standin_arrived(fifo->ready_ns[fifo->head]);
+#else
+        return true;
+#endif
+}
+
+/**
+ * Read the oldest completed receive and re-post its receive
+ *
+ * @data_path [in]: CC data path resources
+ * @msg [out]: Buffer the received message is copied to
+ * @size [in]: Size of the msg buffer
+ * @len [out]: Length of the received message, may be NULL
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t recv_fifo_pop(struct comch_data_path_objects *data_path, void *msg, uint32_t size, uint32_t *len)
+{
+        struct comch_recv_fifo *fifo = &data_path->recv_done;
+        struct doca_comch_consumer_task_post_recv *task;
+        doca_error_t result = DOCA_SUCCESS;
+        uint32_t slot;
+        uint32_t msg_len;
+
+        slot = fifo->slots[fifo->head];
+        msg_len = fifo->lens[fifo->head];
+        fifo->head = (fifo->head + 1) % fifo->size;
+        fifo->count--;
+        if (data_path->in_flight > 0) {
+                data_path->in_flight--;
+                credit_put(data_path);
         }
 
-         if (data_path->pldpc_dec_pars != NULL) {
-                data_path->pldpc_dec_pars = (struct ldpc_decod_params_t *)cmem->mem;
+        if (msg_len > size) {
+                DOCA_LOG_ERR("Received %u bytes message, larger than the %u bytes response buffer", msg_len, size);
+                result = DOCA_ERROR_NO_MEMORY;
+                msg_len = size;
         }
+        memcpy(msg, local_mem_slab_addr(&data_path->consumer_slab, slot), msg_len);
+        if (len != NULL)
+                *len = msg_len;
 
-        /* DOCA_LOG_INFO("*** Input Block ===> %s", (char *)((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->inputBlock);   VBrusse */
-/*      DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->bg);
-        DOCA_LOG_INFO("*** z = %d", ((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->z);
-        DOCA_LOG_INFO("*** len_filler_bits = %d", ((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->len_filler_bits);
-*/
-        /* DOCA_LOG_INFO("*** Output Block ===> %s\n\n", (char *)((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->outputBlock); */
+        if (data_path->standin != NULL) {
+                local_mem_slab_put(&data_path->consumer_slab, slot);
+                return result;
+        }
 
-        /* DOCA_LOG_INFO("Mensagem recebida: %s", data_path->text); */                   /* VBrusse */
-        /* *(struct ldpc_encod_params_t *)data_path->pldpc_enc_pars = *(struct ldpc_encod_params_t *)cmem->mem; */
+        /* The slot is free again, re-post its receive */
+        task = data_path->recv_tasks[slot];
+        (void)doca_buf_reset_data_len(data_path->consumer_slab.bufs[slot]);
+        data_path->consumer_result = doca_task_submit(doca_comch_consumer_task_post_recv_as_task(task));
+        if (data_path->consumer_result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to re-post consumer recv task of slot %u with error = %s",
+                             slot,
+                             doca_error_get_name(data_path->consumer_result));
+                data_path->recv_tasks[slot] = NULL;
+                doca_task_free(doca_comch_consumer_task_post_recv_as_task(task));
+                (void)doca_ctx_stop(doca_comch_consumer_as_ctx(data_path->consumer));
+                return data_path->consumer_result;
+        }
 
+        return result;
+}
 
+doca_error_t comch_data_path_poll_msg(struct comch_data_path_objects *data_path, void *msg, uint32_t size, uint32_t *len)
+{
+        if (data_path->in_flight == 0 && data_path->recv_done.count == 0)
+                return DOCA_ERROR_NOT_FOUND;
 
+        /* One progress call drains the client, producer and consumer completions */
+        if (data_path->recv_done.count == 0 && data_path->consumer_running == true) {
+                data_path->recv_polls++;
+                (void)doca_pe_progress(data_path->pe);
+        }
 
-        /* VBrusse - Free consumer's mmap and doca_buf resources - Original */
-        /* clean_comch_consumer(data_path->consumer, data_path->consumer_pe);
-        data_path->consumer = NULL;
-        data_path->consumer_pe = NULL;
-        clean_local_mem_bufs(cmem); */
+        if (recv_fifo_ready(data_path) == true)
+                return recv_fifo_pop(data_path, msg, size, len);
 
-        /* VBrusse - Free producer's mmap and doca_buf resources */
-        /* clean_comch_producer(data_path->producer, data_path->producer_pe);
-        data_path->producer = NULL;
-        data_path->producer_pe = NULL;
-        clean_local_mem_bufs(&data_path->producer_mem); */
+        if (data_path->recv_done.count == 0 && data_path->consumer_running == false)
+                return data_path->consumer_result != DOCA_SUCCESS ? data_path->consumer_result :
+                                                                    DOCA_ERROR_NOT_CONNECTED;
+        return DOCA_ERROR_AGAIN;
+}
+
+doca_error_t comch_data_path_get_notification_handle(struct comch_data_path_objects *data_path,
+                                                     doca_notification_handle_t *handle)
+{
+        if (data_path->standin != NULL)
+                return DOCA_ERROR_NOT_SUPPORTED;
+
+        return doca_pe_get_notification_handle(data_path->pe, handle);
+}
+
+doca_error_t comch_data_path_arm(struct comch_data_path_objects *data_path, uint64_t *ready_ns)
+{
+        struct comch_recv_fifo *fifo = &data_path->recv_done;
+
+        *ready_ns = 0;
+        if (fifo->count != 0) {
+                /* Nothing to wait for, except the round trip of a stand-in response */
+                *ready_ns = data_path->standin != NULL ? fifo->ready_ns[fifo->head] : 1;
+                return DOCA_SUCCESS;
+        }
+
+        if (data_path->standin != NULL || data_path->consumer_running == false)
+                return DOCA_SUCCESS;
+
+        return doca_pe_request_notification(data_path->pe);
+}
+
+void comch_data_path_disarm(struct comch_data_path_objects *data_path, doca_notification_handle_t handle)
+{
+        if (data_path->standin == NULL && data_path->pe != NULL)
+                (void)doca_pe_clear_notification(data_path->pe, handle);
+}
+
+doca_error_t comch_data_path_recv_msg(struct comch_data_path_objects *data_path, void *msg, uint32_t size, uint32_t *len)
+{
+        doca_error_t result;
 
+        /* Receive msg from server, a stand-in response already queued is spun on like the DPU round trip */
+        while ((result = comch_data_path_poll_msg(data_path, msg, size, len)) == DOCA_ERROR_AGAIN) {
+                if (data_path->recv_done.count == 0)
+                        comch_data_path_idle(data_path);
+        }
 
-        return data_path->consumer_result;
+        return result;
 }
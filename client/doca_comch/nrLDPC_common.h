@@ -25,6 +25,9 @@
 #ifndef NRLDPC_COMMON_H_
 #define NRLDPC_COMMON_H_
 
+#include <stdatomic.h>
+#include <stdint.h>
+
 #include <doca_buf_inventory.h>
 #include <doca_comch.h>
 #include <doca_comch_consumer.h>
@@ -34,14 +37,34 @@
 #include <doca_mmap.h>
 #include <doca_pe.h>
 
-#define CC_DATA_PATH_TASK_NUM 2                 /* Maximum amount of CC consumer and producer task number */
+#define CC_DATA_PATH_TASK_NUM 2                 /* Default amount of CC consumer and producer task number */
 #define CC_DATA_PATH_MAX_MSG_SIZE (1024 * 1024) /* CC DATA PATH maximum message size */
 
 #define STR_START_DATA_PATH_TEST "start_data_path_test" /* The negotiation message between client and server */
 #define STR_STOP_DATA_PATH_TEST "stop_data_path_test"   /* The negotiation message between client and server */
+#define STR_DATA_PATH_CREDITS "data_path_credits="      /* Server announcement of its posted receives, then a count */
+#define STR_DATA_PATH_PROTO "data_path_proto="          /* Server announcement of "<version>,<features>" */
 
 #define INVALID_CONSUMER_ID 0xffff
 
+#define CC_DATA_PATH_SLAB_SLOTS 16              /* Default number of registered slots of a producer/consumer slab */
+#define CC_DATA_PATH_SLOT_ALIGN 64              /* Slot alignment, a cache line */
+#define CC_DATA_PATH_INVALID_SLOT 0xffffffffU   /* Free-list terminator */
+#define CC_DATA_PATH_RECV_DEPTH 32              /* Default number of receives kept posted by the consumer */
+#define CC_DATA_PATH_SUBMIT_RETRIES 64          /* Progress rounds a send task submission is retried for */
+#define CC_DATA_PATH_SLOT_CLASSES 5             /* Most size classes of a producer pool, see local_mem_pool */
+#define CC_DATA_PATH_CLASS_SHIFT 24             /* Producer slot: class << CC_DATA_PATH_CLASS_SHIFT | slot of its slab */
+#define CC_DATA_PATH_SLOT_MASK ((1U << CC_DATA_PATH_CLASS_SHIFT) - 1) /* Slot of its slab, in a producer slot */
+
+/* LDPC offloading services exposed by the DPU, one DOCA Comch server each */
+enum nrLDPC_service_type {
+        NRLDPC_SERVICE_ENCOD = 0, /* nrLDPC_encod_server */
+        NRLDPC_SERVICE_DECOD,     /* nrLDPC_decod_server */
+        NRLDPC_SERVICE_NUM,
+};
+
+struct nrLDPC_standin;
+
 struct local_mem_bufs {
         void *mem;                          /* Memory address for DOCA buf mmap */
         struct doca_mmap *mmap;             /* DOCA mmap object */
@@ -49,6 +72,30 @@ struct local_mem_bufs {
         bool need_alloc_mem;                /* Whether need to allocate memory */
 };
 
+/*
+ * Slab of fixed size, cache line aligned slots registered with the device once.
+ * Free slots are kept in a lock-free LIFO (Treiber stack), the head carries an ABA tag in its upper 32 bits.
+ */
+struct local_mem_slab {
+        struct local_mem_bufs mem;                  /* Mmap and DOCA buf inventory covering all the slots */
+        struct doca_buf **bufs;                     /* DOCA buf of each slot, taken from the inventory once */
+        _Atomic(uint32_t) *next;                    /* Free-list link of each slot */
+        uint32_t slot_size;                         /* Slot size, multiple of CC_DATA_PATH_SLOT_ALIGN */
+        uint32_t num_slots;                         /* Number of slots */
+        _Alignas(CC_DATA_PATH_SLOT_ALIGN) _Atomic(uint64_t) free_head; /* Tag << 32 | first free slot */
+};
+
+/*
+ * Producer slots in size classes, one slab per class: 1, 4, 8 and 32 KiB up to the largest message, then the
+ * largest message itself. A message takes a slot of the smallest class it fits in, so the request of a small code
+ * block stays in a small, cache resident slot while the largest lifting sizes still fit. A slot is named by its
+ * class and its index in the slab of the class, see CC_DATA_PATH_CLASS_SHIFT.
+ */
+struct local_mem_pool {
+        struct local_mem_slab classes[CC_DATA_PATH_SLOT_CLASSES]; /* Slab of each class, smallest slots first */
+        uint32_t num_classes;                                     /* Classes in use */
+};
+
 struct comch_producer_cb_config {
         /* User specified callback when task completed successfully */
         doca_comch_producer_task_send_completion_cb_t send_task_comp_cb;
@@ -58,6 +105,8 @@ struct comch_producer_cb_config {
         void *ctx_user_data;
         /* User specified PE context state changed event callback */
         doca_ctx_state_changed_callback_t ctx_state_changed_cb;
+        /* Maximum number of send tasks, CC_DATA_PATH_TASK_NUM when 0 */
+        uint32_t num_tasks;
 };
 
 struct comch_consumer_cb_config {
@@ -69,31 +118,54 @@ struct comch_consumer_cb_config {
         void *ctx_user_data;
         /* User specified PE context state changed event callback */
         doca_ctx_state_changed_callback_t ctx_state_changed_cb;
+        /* Maximum number of post recv tasks, CC_DATA_PATH_TASK_NUM when 0 */
+        uint32_t num_tasks;
+};
+
+/* Receives completed by the consumer and not read yet, in arrival order */
+struct comch_recv_fifo {
+        uint32_t *slots;      /* Consumer slot holding each message */
+        uint32_t *lens;       /* Length of each message */
+        uint64_t *ready_ns;   /* Stand-in only: when each message reaches the host */
+        uint32_t *service_ns; /* Stand-in only: emulated DPU processing time of the request of each message */
+        uint32_t size;        /* Capacity */
+        uint32_t head;        /* Next entry to read */
+        uint32_t count;       /* Number of entries */
 };
 
 struct comch_data_path_objects {
         struct doca_dev *hw_dev;                  /* Device used in the data path */
-        struct doca_pe *pe;                       /* Connection PE object used in the sample */
+        struct doca_pe *pe;                       /* PE of the client, the producer and the consumer */
         struct doca_comch_connection *connection; /* CC connection object used in the sample */
         struct doca_comch_consumer *consumer;     /* CC consumer object used in the sample */
-        struct doca_pe *consumer_pe;              /* CC consumer's PE object used in the sample */
-        struct local_mem_bufs consumer_mem;       /* Mmap and DOCA buf objects for consumer */
+        struct local_mem_slab consumer_slab;      /* Registered receive slots of the consumer */
         struct doca_comch_producer *producer;     /* CC producer object used in the sample */
-        struct doca_pe *producer_pe;              /* CC producer's PE object used in the sample */
-        struct local_mem_bufs producer_mem;       /* Mmap and DOCA buf objects for producer */
+        struct local_mem_pool producer_pool;      /* Registered send slots of the producer, in size classes */
         uint32_t remote_consumer_id;              /* Consumer ID on the peer side */
-        const char *text;                         /* Message to send to the server */
+        uint32_t max_msg_size;                    /* Largest message, the consumer and largest producer slot size */
+        uint32_t num_slots;                       /* Slots of each slab, CC_DATA_PATH_SLAB_SLOTS when 0 */
+        bool one_slot_size;                       /* Producer slots all of max_msg_size, no smaller classes */
+        uint32_t recv_depth;                      /* Receives kept posted, CC_DATA_PATH_RECV_DEPTH when 0 */
+        struct nrLDPC_standin *standin;           /* In-process stand-in server, NULL when talking to the DPU */
+        bool busy_poll;                           /* Spin while waiting instead of sleeping SLEEP_IN_NANOS */
+        bool route_replies;                       /* Name the consumer to reply to, others share the connection */
+        _Atomic(uint32_t) *credits;               /* Receives the server has left, shared, NULL for no limit */
+        uint32_t reply_consumer_id;               /* Own consumer ID, immediate data of requests when route_replies */
+        uint64_t send_polls;                      /* PE progress calls waiting for a send to complete */
+        uint64_t recv_polls;                      /* PE progress calls waiting for a response */
 
-        void *pldpc_enc_pars;                     /* VBrusse - A pointer to structure ldpc_encod_params_t */
-        void *pldpc_dec_pars;                     /* VBrusse - A pointer to structure ldpc_decod_params_t */
-        /* void *pldpc_pars;                      VBrusse - Pointer to structure ldpc_encod_params_t / ldpc_decod_params_t */
-        uint32_t size_ldpc_data;                  /* VBrusse - size of structure ldpc_encod_params_t / ldpc_decod_params_t */
-                                                  /* Define a Struct: Include a function pointer for the callback in comch_data_path structure. */
+        struct doca_comch_consumer_task_post_recv **recv_tasks; /* Posted receive task of each consumer slot */
+        struct comch_recv_fifo recv_done;         /* Completed receives waiting for comch_data_path_recv_msg */
+        uint32_t in_flight;                       /* Messages sent whose response was not read yet */
 
         doca_error_t producer_result;             /* Holds result will be updated in producer callbacks */
+        bool producer_running;                    /* Producer context reached the running state */
         bool producer_finish;                     /* Controls whether producer progress loop should be run */
+        bool msg_sent;                            /* The last submitted send task has completed */
         doca_error_t consumer_result;             /* Holds result will be updated in consumer callbacks */
+        bool consumer_running;                    /* Consumer context reached the running state */
         bool consumer_finish;                     /* Controls whether consumer progress loop should be run */
+        bool stopping;                            /* Data path is being torn down, task flushes are expected */
 };
 
 /**
@@ -115,65 +187,325 @@ void clean_local_mem_bufs(struct local_mem_bufs *local);
 doca_error_t init_local_mem_bufs(struct local_mem_bufs *local, struct doca_dev *dev, size_t buf_len, size_t max_bufs);
 
 /**
- * Clean producer and its PE
+ * Release a slab: its DOCA bufs, mmap, inventory and memory
+ *
+ * @slab [in]: The slab to clean
+ */
+void clean_local_mem_slab(struct local_mem_slab *slab);
+
+/**
+ * Allocate and register a slab of slots. The memory is registered with the device (when dev is not NULL)
+ * and every slot gets its DOCA buf here, so that getting and returning slots never allocates or registers.
+ *
+ * @slab [in]: The slab to initialize
+ * @dev [in]: Device to register the memory with, NULL for plain host memory
+ * @slot_size [in]: Minimal slot size, rounded up to CC_DATA_PATH_SLOT_ALIGN
+ * @num_slots [in]: Number of slots
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t init_local_mem_slab(struct local_mem_slab *slab, struct doca_dev *dev, uint32_t slot_size, uint32_t num_slots);
+
+/**
+ * Take a free slot from a slab, lock-free
+ *
+ * @slab [in]: The slab
+ * @return: Slot index, CC_DATA_PATH_INVALID_SLOT if the slab is exhausted
+ */
+uint32_t local_mem_slab_get(struct local_mem_slab *slab);
+
+/**
+ * Return a slot to a slab, lock-free
+ *
+ * @slab [in]: The slab
+ * @slot [in]: Slot index returned by local_mem_slab_get
+ */
+void local_mem_slab_put(struct local_mem_slab *slab, uint32_t slot);
+
+/**
+ * Address of a slot
+ *
+ * @slab [in]: The slab
+ * @slot [in]: Slot index
+ * @return: Slot address
+ */
+static inline void *local_mem_slab_addr(const struct local_mem_slab *slab, uint32_t slot)
+{
+        return (char *)slab->mem.mem + (size_t)slot * slab->slot_size;
+}
+
+/**
+ * Allocate and register the slabs of a producer pool, see init_local_mem_slab()
+ *
+ * @pool [in]: The pool to initialize
+ * @dev [in]: Device to register the memory with, NULL for plain host memory
+ * @max_size [in]: Largest message, the slot size of the last class
+ * @num_slots [in]: Number of slots of each class
+ * @one_size [in]: A single class of max_size slots
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t init_local_mem_pool(struct local_mem_pool *pool,
+                                 struct doca_dev *dev,
+                                 uint32_t max_size,
+                                 uint32_t num_slots,
+                                 bool one_size);
+
+/**
+ * Release the slabs of a producer pool
+ *
+ * @pool [in]: The pool to clean
+ */
+void clean_local_mem_pool(struct local_mem_pool *pool);
+
+/**
+ * Take a free slot holding at least len bytes, from the smallest class that has one, lock-free
+ *
+ * @pool [in]: The pool
+ * @len [in]: Message length
+ * @return: Pool slot, CC_DATA_PATH_INVALID_SLOT if every class that fits is exhausted
+ */
+uint32_t local_mem_pool_get(struct local_mem_pool *pool, uint32_t len);
+
+/**
+ * Return a slot to its class, lock-free
+ *
+ * @pool [in]: The pool
+ * @slot [in]: Pool slot returned by local_mem_pool_get
+ */
+void local_mem_pool_put(struct local_mem_pool *pool, uint32_t slot);
+
+/**
+ * Total slots of a pool, all classes together
+ *
+ * @pool [in]: The pool
+ * @return: Number of slots
+ */
+uint32_t local_mem_pool_slots(const struct local_mem_pool *pool);
+
+/**
+ * Slab of the class of a pool slot
+ *
+ * @pool [in]: The pool
+ * @slot [in]: Pool slot
+ * @return: Slab of its class
+ */
+static inline struct local_mem_slab *local_mem_pool_slab(struct local_mem_pool *pool, uint32_t slot)
+{
+        return &pool->classes[slot >> CC_DATA_PATH_CLASS_SHIFT];
+}
+
+/**
+ * Address of a pool slot
+ *
+ * @pool [in]: The pool
+ * @slot [in]: Pool slot
+ * @return: Slot address
+ */
+static inline void *local_mem_pool_addr(struct local_mem_pool *pool, uint32_t slot)
+{
+        return local_mem_slab_addr(local_mem_pool_slab(pool, slot), slot & CC_DATA_PATH_SLOT_MASK);
+}
+
+/**
+ * Size of a pool slot
+ *
+ * @pool [in]: The pool
+ * @slot [in]: Pool slot
+ * @return: Slot size, the longest message it holds
+ */
+static inline uint32_t local_mem_pool_size(struct local_mem_pool *pool, uint32_t slot)
+{
+        return local_mem_pool_slab(pool, slot)->slot_size;
+}
+
+/**
+ * Number of memory regions registered for the data path since the library was loaded.
+ * Only the slab creation at session start registers memory, it must not move while requests are served.
+ *
+ * @return: Number of registrations
+ */
+uint64_t comch_data_path_mem_registrations(void);
+
+/**
+ * Clean producer, its PE is left to its owner
  *
  * @producer [in]: Producer object to clean
- * @pe [in]: Producer PE object to clean
  */
-void clean_comch_producer(struct doca_comch_producer *producer, struct doca_pe *pe);
+void clean_comch_producer(struct doca_comch_producer *producer);
 
 /**
- * Initialize a cc producer and its PE
+ * Initialize a cc producer on an existing PE
  *
  * @connection [in]: CC connection the producer is built on
+ * @pe [in]: PE the producer context is connected to, the one of the connection's client
  * @cb_cfg [in]: Producer callback configuration
  * @producer [out]: Producer objects struct to initialize
- * @pe [out]: Producer PE objects struct to initialize
  * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
 doca_error_t init_comch_producer(struct doca_comch_connection *connection,
+                                 struct doca_pe *pe,
                                  struct comch_producer_cb_config *cb_cfg,
-                                 struct doca_comch_producer **producer,
-                                 struct doca_pe **pe);
+                                 struct doca_comch_producer **producer);
 
 /**
- * Clean consumer and its PE
+ * Clean consumer, its PE is left to its owner
  *
  * @consumer [in]: Consumer object to clean
- * @pe [in]: Consumer PE object to clean
  */
-void clean_comch_consumer(struct doca_comch_consumer *consumer, struct doca_pe *pe);
+void clean_comch_consumer(struct doca_comch_consumer *consumer);
 
 /**
- * Initialize a cc producer and its PE
+ * Initialize a cc consumer on an existing PE
  *
  * @connection [in]: CC connection the consumer is built on
+ * @pe [in]: PE the consumer context is connected to, the one of the connection's client
  * @user_mmap [in]: The local memory mmap required by consumer
  * @cb_cfg [in]: Consumer callback configuration
  * @consumer [out]: Consumer objects struct to initialize
- * @pe [out]: Consumer PE objects struct to initialize
  * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
 doca_error_t init_comch_consumer(struct doca_comch_connection *connection,
+                                 struct doca_pe *pe,
                                  struct doca_mmap *user_mmap,
                                  struct comch_consumer_cb_config *cb_cfg,
-                                 struct doca_comch_consumer **consumer,
-                                 struct doca_pe **pe);
+                                 struct doca_comch_consumer **consumer);
+
+/**
+ * Create the producer and consumer of a data path and register their buffers.
+ * They are kept alive until comch_data_path_stop() so that requests only pay for the message exchange,
+ * the consumer keeps recv_depth receives posted so that as many requests can be outstanding.
+ *
+ * @data_path [in]: CC data path resources, connection and max_msg_size must be set
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t comch_data_path_start(struct comch_data_path_objects *data_path);
+
+/**
+ * Stop the producer and consumer of a data path and free their buffers
+ *
+ * @data_path [in]: CC data path resources
+ */
+void comch_data_path_stop(struct comch_data_path_objects *data_path);
+
+/**
+ * Use cc high speed data path to send a msg. It does not wait for the response, up to recv_depth
+ * messages can be sent before reading their responses with comch_data_path_recv_msg().
+ *
+ * @data_path [in]: CC data path resources
+ * @msg [in]: Message to send, copied into a registered producer slot
+ * @len [in]: Message length, up to data_path->max_msg_size
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_AGAIN when recv_depth responses are pending, the server has no
+ *          credit left or the send cannot be submitted yet, and DOCA_ERROR otherwise
+ */
+doca_error_t comch_data_path_send_msg(struct comch_data_path_objects *data_path, const void *msg, uint32_t len);
+
+/**
+ * Copy a message into a registered producer slot of the smallest class it fits in, to be sent later with
+ * comch_data_path_send_staged(). Unlike the other data path calls it can run concurrently with them, from any thread.
+ *
+ * @data_path [in]: CC data path resources
+ * @msg [in]: Message to stage
+ * @len [in]: Message length, up to data_path->max_msg_size
+ * @slot [out]: Producer slot holding the message
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_AGAIN when all producer slots large enough are in use and DOCA_ERROR
+ *          otherwise
+ */
+doca_error_t comch_data_path_stage_msg(struct comch_data_path_objects *data_path,
+                                       const void *msg,
+                                       uint32_t len,
+                                       uint32_t *slot);
+
+/**
+ * Send a message staged by comch_data_path_stage_msg(), the slot goes back to the producer pool once sent.
+ * Each message sent takes one of the server credits, its response gives it back.
+ *
+ * @data_path [in]: CC data path resources
+ * @slot [in]: Producer slot holding the message
+ * @len [in]: Message length
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_AGAIN when recv_depth responses are pending, the server has no
+ *          credit left or the send cannot be submitted yet, the slot is then kept staged, and DOCA_ERROR
+ *          otherwise, the slot is then released
+ */
+doca_error_t comch_data_path_send_staged(struct comch_data_path_objects *data_path, uint32_t slot, uint32_t len);
+
+/**
+ * Move a staged message to a slot of a larger class, for it to grow in place, e.g. requests coalesced into it
+ *
+ * @data_path [in]: CC data path resources
+ * @slot [in/out]: Producer slot holding the message, released, then the slot it moved to
+ * @len [in]: Length of the staged message
+ * @size [in]: Length the message is to grow to, up to data_path->max_msg_size
+ * @return: DOCA_SUCCESS on success, the message stays where it is when the slot is large enough already, and
+ *          DOCA_ERROR_AGAIN when no larger slot is free, the message is then kept in its slot
+ */
+doca_error_t comch_data_path_restage(struct comch_data_path_objects *data_path,
+                                     uint32_t *slot,
+                                     uint32_t len,
+                                     uint32_t size);
+
+/**
+ * Release a staged message without sending it
+ *
+ * @data_path [in]: CC data path resources
+ * @slot [in]: Producer slot holding the message
+ */
+void comch_data_path_unstage(struct comch_data_path_objects *data_path, uint32_t slot);
+
+/**
+ * Wait a little before polling the data path again: spin in busy_poll mode, sleep SLEEP_IN_NANOS otherwise
+ *
+ * @data_path [in]: CC data path resources
+ */
+void comch_data_path_idle(const struct comch_data_path_objects *data_path);
+
+/**
+ * Get the notification handle that becomes readable when a response completes, to wait on it with epoll
+ *
+ * @data_path [in]: CC data path resources
+ * @handle [out]: Notification handle
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_NOT_SUPPORTED with the stand-in server and DOCA_ERROR otherwise
+ */
+doca_error_t comch_data_path_get_notification_handle(struct comch_data_path_objects *data_path,
+                                                     doca_notification_handle_t *handle);
 
 /**
- * Use cc high speed data path to send a msg
+ * Arm the notification of the next response. Call it when polling found nothing, then wait on the handle
+ * unless a response is already queued.
  *
  * @data_path [in]: CC data path resources
+ * @ready_ns [out]: 0, or CLOCK_MONOTONIC time at which the oldest queued response can be read
  * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
-doca_error_t comch_data_path_send_msg(struct comch_data_path_objects *data_path);
+doca_error_t comch_data_path_arm(struct comch_data_path_objects *data_path, uint64_t *ready_ns);
+
+/**
+ * Acknowledge the notification armed by comch_data_path_arm(), before polling again
+ *
+ * @data_path [in]: CC data path resources
+ * @handle [in]: Notification handle
+ */
+void comch_data_path_disarm(struct comch_data_path_objects *data_path, doca_notification_handle_t handle);
 
 /**
- * Use cc high speed data path to recv a msg
+ * Use cc high speed data path to recv a msg, the oldest one not read yet
  *
  * @data_path [in]: CC data path resources
+ * @msg [out]: Buffer the received message is copied to
+ * @size [in]: Size of the msg buffer
+ * @len [out]: Length of the received message
  * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
-doca_error_t comch_data_path_recv_msg(struct comch_data_path_objects *data_path);
+doca_error_t comch_data_path_recv_msg(struct comch_data_path_objects *data_path, void *msg, uint32_t size, uint32_t *len);
+
+/**
+ * Non-blocking comch_data_path_recv_msg: progress the data path once and read the oldest message if it arrived
+ *
+ * @data_path [in]: CC data path resources
+ * @msg [out]: Buffer the received message is copied to
+ * @size [in]: Size of the msg buffer
+ * @len [out]: Length of the received message
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_AGAIN when the oldest response has not arrived yet,
+ *          DOCA_ERROR_NOT_FOUND when no message is outstanding and DOCA_ERROR otherwise
+ */
+doca_error_t comch_data_path_poll_msg(struct comch_data_path_objects *data_path, void *msg, uint32_t size, uint32_t *len);
 
 #endif // NRLDPC_COMMON_H_
@@ -0,0 +1,180 @@
+/*
+ * Filename: nrLDPC_crc.c
+ *
+ * CRC of the code blocks, see nrLDPC_crc.h. Four bytes at a time (slicing-by-4), with tables per CRC built on
+ * first use: the register is kept in the top bits of a 32-bit word whatever the CRC length, so the three share the
+ * same loop. The host decoder checks the CRC after every iteration, a table lookup per byte would be latency bound.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include <doca_log.h>
+
+#include "nrLDPC_crc.h"
+
+DOCA_LOG_REGISTER(NRLDPC_CRC);
+
+#define CRC_KINDS 3 /* NRLDPC_PROTO_CRC_24A to NRLDPC_PROTO_CRC_16 */
+
+/* Generator polynomials of TS 38.212 5.1, without their highest term, and their lengths */
+static const uint32_t crc_poly[CRC_KINDS] = {0x864cfb, 0x800063, 0x1021};
+static const uint8_t crc_bits[CRC_KINDS] = {24, 24, 16};
+
+static uint32_t crc_table[CRC_KINDS][4][256];             /* [c][n][i]: i in the top bits after 8 * (n + 1) bits */
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT; /* Builds crc_table */
+
+/* Counters of the CRC checks, updated by the calling threads without a lock */
+struct crc_counters {
+        _Atomic(uint64_t) dpu_blocks;     /* Code blocks whose CRC the DPU checked */
+        _Atomic(uint64_t) dpu_failed;     /* Of those, CRC failed */
+        _Atomic(uint64_t) dpu_iterations; /* Iterations the DPU ran on them */
+        _Atomic(uint64_t) dpu_max;        /* Iterations it would have run without the CRC */
+        _Atomic(uint64_t) host_blocks;    /* Code blocks whose CRC the host decoder checked */
+        _Atomic(uint64_t) host_failed;    /* Of those, CRC failed */
+};
+
+static struct crc_counters counters;
+
+/**
+ * Build the tables of the CRCs
+ */
+static void crc_table_build(void)
+{
+        uint32_t poly, reg;
+        uint32_t c, b, i;
+
+        for (c = 0; c < CRC_KINDS; c++) {
+                poly = crc_poly[c] << (32 - crc_bits[c]);
+                for (i = 0; i < 256; i++) {
+                        reg = i << 24;
+                        for (b = 0; b < 8; b++)
+                                reg = (reg & 0x80000000U) != 0 ? reg << 1 ^ poly : reg << 1;
+                        crc_table[c][0][i] = reg;
+                }
+                /* A byte n bytes ahead of the top one: its one byte table entry, run over n zero bytes */
+                for (b = 1; b < 4; b++)
+                        for (i = 0; i < 256; i++) {
+                                reg = crc_table[c][b - 1][i];
+                                crc_table[c][b][i] = reg << 8 ^ crc_table[c][0][reg >> 24];
+                        }
+        }
+}
+
+uint8_t nrLDPC_crc_from_params(const t_nrLDPC_dec_params *p)
+{
+        if (p->check_crc == NULL)
+                return NRLDPC_PROTO_CRC_NONE;
+
+        switch (p->crc_type) {
+        case NRLDPC_CRC24_A:
+                return NRLDPC_PROTO_CRC_24A;
+        case NRLDPC_CRC24_B:
+                return NRLDPC_PROTO_CRC_24B;
+        case NRLDPC_CRC16:
+                return NRLDPC_PROTO_CRC_16;
+        default:
+                return NRLDPC_PROTO_CRC_NONE;
+        }
+}
+
+uint32_t nrLDPC_crc_len(uint8_t crc)
+{
+        if (crc == NRLDPC_PROTO_CRC_NONE || crc > CRC_KINDS)
+                return 0;
+        return crc_bits[crc - 1];
+}
+
+uint32_t nrLDPC_crc_compute(uint8_t crc, const uint8_t *bytes, uint32_t len)
+{
+        const uint32_t(*table)[256];
+        uint32_t reg = 0;
+        uint32_t i;
+
+        if (nrLDPC_crc_len(crc) == 0)
+                return 0;
+
+        pthread_once(&crc_table_once, crc_table_build);
+        table = crc_table[crc - 1];
+        for (i = 0; i + 4 <= len; i += 4) {
+                reg ^= (uint32_t)bytes[i] << 24 | (uint32_t)bytes[i + 1] << 16 | (uint32_t)bytes[i + 2] << 8 |
+                       bytes[i + 3];
+                reg = table[3][reg >> 24] ^ table[2][reg >> 16 & 0xff] ^ table[1][reg >> 8 & 0xff] ^
+                      table[0][reg & 0xff];
+        }
+        for (; i < len; i++)
+                reg = reg << 8 ^ table[0][(reg >> 24 ^ bytes[i]) & 0xff];
+
+        return reg >> (32 - crc_bits[crc - 1]);
+}
+
+bool nrLDPC_crc_check(uint8_t crc, const uint8_t *bytes, uint32_t len)
+{
+        uint32_t bits = nrLDPC_crc_len(crc);
+
+        /* The remainder of a block followed by its CRC is zero */
+        if (bits == 0 || (uint64_t)len * 8 <= bits)
+                return false;
+        return nrLDPC_crc_compute(crc, bytes, len) == 0;
+}
+
+void nrLDPC_crc_init(void)
+{
+        atomic_store(&counters.dpu_blocks, 0);
+        atomic_store(&counters.dpu_failed, 0);
+        atomic_store(&counters.dpu_iterations, 0);
+        atomic_store(&counters.dpu_max, 0);
+        atomic_store(&counters.host_blocks, 0);
+        atomic_store(&counters.host_failed, 0);
+}
+
+void nrLDPC_crc_count_dpu(uint32_t num_its, int32_t status)
+{
+        uint32_t ran = status > (int32_t)num_its ? num_its : (uint32_t)status;
+
+        if (status < 0)
+                return;
+        atomic_fetch_add_explicit(&counters.dpu_blocks, 1, memory_order_relaxed);
+        if (status > (int32_t)num_its)
+                atomic_fetch_add_explicit(&counters.dpu_failed, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters.dpu_iterations, ran, memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters.dpu_max, num_its, memory_order_relaxed);
+}
+
+void nrLDPC_crc_count_host(bool passed)
+{
+        atomic_fetch_add_explicit(&counters.host_blocks, 1, memory_order_relaxed);
+        if (passed == false)
+                atomic_fetch_add_explicit(&counters.host_failed, 1, memory_order_relaxed);
+}
+
+void nrLDPC_crc_get_stats(struct nrLDPC_crc_stats *stats)
+{
+        stats->dpu_blocks = atomic_load_explicit(&counters.dpu_blocks, memory_order_relaxed);
+        stats->dpu_failed = atomic_load_explicit(&counters.dpu_failed, memory_order_relaxed);
+        stats->dpu_iterations = atomic_load_explicit(&counters.dpu_iterations, memory_order_relaxed);
+        stats->dpu_max = atomic_load_explicit(&counters.dpu_max, memory_order_relaxed);
+        stats->host_blocks = atomic_load_explicit(&counters.host_blocks, memory_order_relaxed);
+        stats->host_failed = atomic_load_explicit(&counters.host_failed, memory_order_relaxed);
+}
+
+void nrLDPC_crc_report(void)
+{
+        struct nrLDPC_crc_stats stats;
+
+        nrLDPC_crc_get_stats(&stats);
+        if (stats.host_blocks != 0)
+                DOCA_LOG_INFO("CRC checked by the host decoder: %lu code blocks, %lu failed",
+                              (unsigned long)stats.host_blocks,
+                              (unsigned long)stats.host_failed);
+        if (stats.dpu_blocks == 0)
+                return;
+        DOCA_LOG_INFO("CRC checked on the DPU: %lu code blocks, %lu failed, %lu iterations run instead of %lu",
+                      (unsigned long)stats.dpu_blocks,
+                      (unsigned long)stats.dpu_failed,
+                      (unsigned long)stats.dpu_iterations,
+                      (unsigned long)stats.dpu_max);
+}
@@ -0,0 +1,109 @@
+/*
+ * Filename: nrLDPC_crc.h
+ *
+ * CRC of the code blocks, TS 38.212 5.1: CRC24A of a transport block carried by a single code block, CRC24B of
+ * each code block of a segmented one, CRC16 of a small transport block. The decoder request names the CRC attached
+ * to the last bits of its Kprime (crc_idx, see nrLDPC_proto.h): the DPU checks it after each iteration and stops
+ * at the first one it passes, instead of running all of them, and answers the iterations it ran, num_its + 1 when
+ * the CRC never passed, as OAI's decoder counts them. The host trusts that answer and runs no CRC pass of its own.
+ * The host decoder checks the CRC the same way when it decodes instead.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_CRC_H_
+#define NRLDPC_CRC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <nrLDPC_defs.h>
+
+#include "nrLDPC_proto.h"
+
+/* crc_type of t_nrLDPC_dec_params, as openair1/PHY/CODING/coding_defs.h numbers them */
+#define NRLDPC_CRC24_A 0
+#define NRLDPC_CRC24_B 1
+#define NRLDPC_CRC16 2
+
+/* CRC checks of the decoded code blocks */
+struct nrLDPC_crc_stats {
+        uint64_t dpu_blocks;     /* Code blocks whose CRC the DPU checked */
+        uint64_t dpu_failed;     /* Of those, CRC failed after num_its iterations */
+        uint64_t dpu_iterations; /* Iterations the DPU ran on them */
+        uint64_t dpu_max;        /* Iterations it would have run without the CRC, num_its per block */
+        uint64_t host_blocks;    /* Code blocks whose CRC the host decoder checked */
+        uint64_t host_failed;    /* Of those, CRC failed */
+};
+
+/**
+ * CRC of the decoder request, NRLDPC_PROTO_CRC_*, from the OAI decoder parameters: the one of crc_type when OAI
+ * asks for the CRC to be checked, i.e. sets check_crc
+ *
+ * @p [in]: OAI decoder parameters
+ * @return: NRLDPC_PROTO_CRC_NONE when no CRC is checked, or for a crc_type this library does not know
+ */
+uint8_t nrLDPC_crc_from_params(const t_nrLDPC_dec_params *p);
+
+/**
+ * Length of a CRC
+ *
+ * @crc [in]: NRLDPC_PROTO_CRC_*
+ * @return: Bits of the CRC, 0 for NRLDPC_PROTO_CRC_NONE or an unknown one
+ */
+uint32_t nrLDPC_crc_len(uint8_t crc);
+
+/**
+ * Compute the CRC of bytes, bits MSB first as the decoder packs them
+ *
+ * @crc [in]: NRLDPC_PROTO_CRC_*
+ * @bytes [in]: Bytes
+ * @len [in]: Number of bytes
+ * @return: CRC, in its nrLDPC_crc_len() low bits, 0 for NRLDPC_PROTO_CRC_NONE
+ */
+uint32_t nrLDPC_crc_compute(uint8_t crc, const uint8_t *bytes, uint32_t len);
+
+/**
+ * Check a decoded code block carrying its CRC in its last nrLDPC_crc_len() bits
+ *
+ * @crc [in]: NRLDPC_PROTO_CRC_*
+ * @bytes [in]: Decoded bits, packed, Kprime / 8 bytes
+ * @len [in]: Number of bytes, Kprime / 8
+ * @return: true when the CRC passes, false when it fails or the block is shorter than it
+ */
+bool nrLDPC_crc_check(uint8_t crc, const uint8_t *bytes, uint32_t len);
+
+/**
+ * Reset the counters, called by the session when it is created
+ */
+void nrLDPC_crc_init(void);
+
+/**
+ * Count a code block whose CRC the DPU checked
+ *
+ * @num_its [in]: Iterations the block could run
+ * @status [in]: Status the DPU answered, the iterations it ran, num_its + 1 when the CRC failed
+ */
+void nrLDPC_crc_count_dpu(uint32_t num_its, int32_t status);
+
+/**
+ * Count a code block whose CRC the host decoder checked
+ *
+ * @passed [in]: The CRC passed
+ */
+void nrLDPC_crc_count_host(bool passed);
+
+/**
+ * Read the counters
+ *
+ * @stats [out]: Counters since the session was created
+ */
+void nrLDPC_crc_get_stats(struct nrLDPC_crc_stats *stats);
+
+/**
+ * Log the counters, called by the session when it is destroyed
+ */
+void nrLDPC_crc_report(void);
+
+#endif // NRLDPC_CRC_H_
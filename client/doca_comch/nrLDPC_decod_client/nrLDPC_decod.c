@@ -22,17 +22,23 @@
  *
  */
 
+#include <pthread.h>
 #include <stdlib.h>
 
 #include <string.h>                                                     /* VBrusse - used by memset */
 
-#include <doca_argp.h>
 #include <doca_dev.h>
 #include <doca_log.h>
 
 #include "comch_ctrl_path_common.h"
+#include "nrLDPC_crc.h"
+#include "nrLDPC_dispatch.h"
+#include "nrLDPC_harq.h"
+#include "nrLDPC_host_decod.h"
+#include "nrLDPC_proto.h"
+#include "nrLDPC_ratematch.h"
+#include "nrLDPC_session.h"
 
-#define DEFAULT_PCI_ADDR "b1:00.0"
 #define DEFAULT_MESSAGE "Message from the client"                       /* VBrusse */
 
 
@@ -55,9 +61,74 @@ extern int32_t LDPCdecoder(t_nrLDPC_dec_params *p_decParams,
 DOCA_LOG_REGISTER(NRLDPC_DECOD_CLIENT::MAIN);
 
 /* DOCA comch client's logic */
-doca_error_t start_nrLDPC_decod_client(const char *server_name,
-                                       const char *dev_pci_addr,
-                                       struct ldpc_decod_params_t *pldpc_decod_params);
+doca_error_t start_nrLDPC_decod_client(struct nrLDPC_proto_hdr *hdr,
+                                     const int8_t *llrs,
+                                     const struct nrLDPC_proto_harq *harq,
+                                     const struct nrLDPC_proto_rm *rm,
+                                     e_nrLDPC_outMode out_mode,
+                                     uint8_t *output,
+                                     uint32_t output_size,
+                                     uint32_t *output_len);
+doca_error_t start_nrLDPC_decod_client_async(struct nrLDPC_proto_hdr *hdr,
+                                           const int8_t *llrs,
+                                           const struct nrLDPC_proto_harq *harq,
+                                           const struct nrLDPC_proto_rm *rm,
+                                           e_nrLDPC_outMode out_mode,
+                                           uint8_t *output,
+                                           uint32_t output_size,
+                                           const t_nrLDPC_dec_params *host_params,
+                                           const struct nrLDPC_dispatch_ticket *ticket,
+                                           decode_abort_t *ab,
+                                           task_ans_t *ans);
+doca_error_t start_nrLDPC_decod_client_hedged(struct nrLDPC_proto_hdr *hdr,
+                                            const int8_t *llrs,
+                                            uint8_t *output,
+                                            uint32_t output_size,
+                                            const t_nrLDPC_dec_params *host_params,
+                                            uint32_t pct,
+                                            uint64_t deadline_ns,
+                                            struct nrLDPC_dispatch_ticket *ticket,
+                                            uint32_t *output_len);
+doca_error_t start_nrLDPC_decod_client_harq_free(uint8_t ulsch_id, uint8_t harq_pid);
+
+/* LLRs the host prepares for a call, too large for the stacks of the OAI threads */
+struct decod_ws {
+        int8_t llrs[NRLDPC_RM_MAX_LLRS];             /* Recovered from the rate matched ones */
+        int8_t combined[NRLDPC_HARQ_MAX_LLRS];       /* Combined with the soft buffer of the host store */
+};
+
+static pthread_key_t decod_ws_key;                       /* Owns the decod_ws of each thread */
+static pthread_once_t decod_ws_once = PTHREAD_ONCE_INIT; /* Creates decod_ws_key */
+
+/*
+ * Create the key of the per thread workspaces
+ */
+static void decod_ws_key_create(void)
+{
+        (void)pthread_key_create(&decod_ws_key, free);
+}
+
+/**
+ * Get the workspace of the calling thread
+ *
+ * @return: The workspace on success and NULL otherwise
+ */
+static struct decod_ws *decod_ws_get(void)
+{
+        struct decod_ws *ws;
+
+        pthread_once(&decod_ws_once, decod_ws_key_create);
+        ws = pthread_getspecific(decod_ws_key);
+        if (ws == NULL) {
+                ws = malloc(sizeof(*ws));
+                if (ws == NULL || pthread_setspecific(decod_ws_key, ws) != 0) {
+                        free(ws);
+                        return NULL;
+                }
+        }
+
+        return ws;
+}
 
 
 /*
@@ -345,199 +416,366 @@ doca_error_t start_nrLDPC_decod_client(const char *server_name,
         uint8_t c[22 * 384]; //padded input, unpacked, max size
         uint8_t d[68 * 384]; // coded output, unpacked, max size
 */
-int32_t nrLDPC_decod_offloading(t_nrLDPC_dec_params *p_decParams,
-                                uint8_t harq_pid,
-                                uint8_t ulsch_id,
-                                uint8_t C,
-                                int8_t *p_llr,
-                                int8_t *p_out,
-                                t_nrLDPC_time_stats *p_time_stats,
-                                decode_abort_t *ab)
+/**
+ * Decode a segment on the host CPU, the fallback of the DPU decoder service (see nrLDPC_host_decod.h)
+ *
+ * @p_decParams [in]: OAI decoder parameters
+ * @p_llr [in]: LLRs
+ * @p_out [out]: Decoded bits, in the layout of p_decParams->outMode
+ * @num_iter [out]: Iterations run, p_decParams->numMaxIter + 1 when the decoding or its CRC failed
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t decod_host(const t_nrLDPC_dec_params *p_decParams,
+                               const int8_t *p_llr,
+                               int8_t *p_out,
+                               uint32_t *num_iter)
 {
-        struct comch_config cfg;
-        const char *server_name = "nrLDPC_decod_server";
         doca_error_t result;
-        struct doca_log_backend *sdk_log;
-        int exit_status = EXIT_FAILURE;
 
+        result = nrLDPC_host_decod(p_decParams, p_llr, p_out, num_iter);
+        if (result == DOCA_SUCCESS && *num_iter > p_decParams->numMaxIter)
+                DOCA_LOG_DBG("Host decoding did not converge in %u iterations", p_decParams->numMaxIter);
+
+        return result;
+}
+
+/**
+ * Combine the LLRs of a transmission with the soft buffer the host keeps for its code block, and decode them on
+ * the host CPU, when the DPU is not used
+ *
+ * @p_decParams [in]: OAI decoder parameters
+ * @harq [in]: Code block and NRLDPC_PROTO_HARQ_NEW_DATA
+ * @n [in]: LLRs of the code block
+ * @num_bufs [in]: Buffers of the host store, NRLDPC_HARQ_BUFFERS
+ * @p_llr [in]: LLRs of the transmission, n of them
+ * @p_out [out]: Decoded bits, in the layout of p_decParams->outMode
+ * @num_iter [out]: Iterations run, as decod_host
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t decod_host_harq(const t_nrLDPC_dec_params *p_decParams,
+                                    const struct nrLDPC_proto_harq *harq,
+                                    uint32_t n,
+                                    uint32_t num_bufs,
+                                    const int8_t *p_llr,
+                                    int8_t *p_out,
+                                    uint32_t *num_iter)
+{
+        struct decod_ws *ws = decod_ws_get();
+        struct nrLDPC_proto_harq all = *harq;
+        doca_error_t result;
+        bool missed;
+
+        if (ws == NULL)
+                return DOCA_ERROR_NO_MEMORY;
+        all.offset = 0;
+        result = nrLDPC_harq_combine(nrLDPC_harq_host_store(num_bufs), &all, n, p_llr, n, ws->combined, &missed);
+        if (result != DOCA_SUCCESS)
+                return result;
+        if (missed == true)
+                DOCA_LOG_DBG("No HARQ soft buffer for segment %u of harq_pid = %d, ulsch_id = %d",
+                             harq->segment,
+                             harq->harq_pid,
+                             harq->ulsch_id);
+
+        return decod_host(p_decParams, ws->combined, p_out, num_iter);
+}
+
+/**
+ * Recover the LLRs of a rate matched code block and decode them on the host CPU, when the DPU is not used
+ *
+ * @p_decParams [in]: OAI decoder parameters
+ * @rm [in]: Rate matching of the code block
+ * @p_e [in]: The rm->e rate matched LLRs
+ * @p_out [out]: Decoded bits, in the layout of p_decParams->outMode
+ * @num_iter [out]: Iterations run, as decod_host
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t decod_host_rm(const t_nrLDPC_dec_params *p_decParams,
+                                  const struct nrLDPC_proto_rm *rm,
+                                  const int8_t *p_e,
+                                  int8_t *p_out,
+                                  uint32_t *num_iter)
+{
+        struct decod_ws *ws = decod_ws_get();
+        doca_error_t result;
+
+        if (ws == NULL)
+                return DOCA_ERROR_NO_MEMORY;
+        result = nrLDPC_rm_recover(p_decParams->BG, p_decParams->Z, rm, p_e, ws->llrs);
+        if (result != DOCA_SUCCESS)
+                return result;
+        nrLDPC_rm_count_host();
+
+        return decod_host(p_decParams, ws->llrs, p_out, num_iter);
+}
+
+/**
+ * Value returned by a blocking call: EXIT_SUCCESS or EXIT_FAILURE, or, when OAI asks for the CRC to be checked,
+ * the iterations run as OAI's decoder returns them, numMaxIter + 1 when the CRC or the decoding failed
+ *
+ * @p_decParams [in]: OAI decoder parameters
+ * @decoded [in]: The segment was decoded
+ * @num_iter [in]: Iterations run, read when decoded
+ * @return: Value to return to OAI
+ */
+static int32_t decod_ret(const t_nrLDPC_dec_params *p_decParams, bool decoded, uint32_t num_iter)
+{
+        if (nrLDPC_crc_from_params(p_decParams) == NRLDPC_PROTO_CRC_NONE)
+                return decoded == true ? EXIT_SUCCESS : EXIT_FAILURE;
+        if (decoded == false || num_iter > p_decParams->numMaxIter)
+                return p_decParams->numMaxIter + 1;
+        return (int32_t)num_iter;
+}
 
-        int argc = 3;                                                   /* VBrusse */
-        char *argv[] = {
-                "nrLDPC_decod_client",
-                "-p",
-                "03:00.0"                                               /* VBrusse - PCIe address = "03:00.0", representor address = "b1:00.0" */
-        };                                                              /* client connection with -p, server connection with -p and -r */
+/**
+ * Offload the decoding of one OAI call, synchronously or, when ans is set, asynchronously. The host CPU decodes
+ * instead as NRLDPC_HOST says: when the session cannot be set up or the DPU fails, always, or with auto when the
+ * dispatcher expects it to finish sooner. With NRLDPC_HEDGE_PCT, a synchronous call the DPU is late to answer is
+ * decoded on the host too. A HARQ call is combined with its soft buffer, on the DPU or on the host when it decodes
+ * by itself, and is neither routed by the dispatcher nor hedged: the soft buffer lives where it was combined.
+ * A rate matched call sends its E LLRs, recovered where they are decoded, and is not hedged either.
+ * p_out is in the layout of outMode whichever decoder answers: the packed bits of the DPU are unpacked for
+ * nrLDPC_outMode_BITINT8, and nrLDPC_outMode_LLRINT8, LLRs the DPU does not return, is decoded on the host.
+ * With check_crc set, the CRC of crc_type is checked where the segment is decoded, which stops at the first
+ * iteration it passes. The host does not check it again: a blocking call returns the iterations, see decod_ret(),
+ * and an asynchronous call whose CRC fails aborts its transport block, ab, as OAI does.
+ * What the decoder server does not serve (see nrLDPC_session_features()) is done on the host: a HARQ call is
+ * combined and decoded there, rate matched LLRs are recovered there and sent as N, and the CRC is checked on the
+ * bits the server returns after all its iterations.
+ *
+ * @p_decParams [in]: OAI decoder parameters
+ * @harq_pid [in]: HARQ process
+ * @ulsch_id [in]: ULSCH process
+ * @C [in]: Number of segments of the transport block, unused
+ * @p_llr [in]: LLRs, the rm->e rate matched ones with rm
+ * @p_out [out]: Decoded bits, in the layout of p_decParams->outMode
+ * @p_time_stats [in]: Unused
+ * @ab [in]: Abort flag of the transport block: once set, the code block is not sent, or cancelled when in flight
+ * @harq [in]: Soft buffer of the code block, NULL to decode p_llr as it is
+ * @rm [in]: Rate matching of p_llr, NULL when they are the N LLRs to decode
+ * @ans [in]: Task answer completed when the decoded bits are written, NULL to wait for them here
+ * @return: EXIT_SUCCESS on success and EXIT_FAILURE otherwise, the iterations of decod_ret() for a blocking call
+ * checking the CRC
+ */
+static int32_t decod_offload(t_nrLDPC_dec_params *p_decParams,
+                             uint8_t harq_pid,
+                             uint8_t ulsch_id,
+                             uint8_t C,
+                             int8_t *p_llr,
+                             int8_t *p_out,
+                             t_nrLDPC_time_stats *p_time_stats,
+                             decode_abort_t *ab,
+                             const struct nrLDPC_proto_harq *harq,
+                             const struct nrLDPC_proto_rm *rm,
+                             task_ans_t *ans)
+{
+        struct nrLDPC_proto_hdr hdr = {0};
+        struct nrLDPC_dispatch_ticket ticket = {0};
+        struct nrLDPC_session_cfg env_cfg;
+        const struct nrLDPC_session_cfg *cfg;
+        struct nrLDPC_session *s;
+        uint32_t out_len = 0;
+        uint32_t out_size;
+        uint32_t num_iter = 0;
+        uint32_t features = 0;
+        bool llr_out = p_decParams->outMode == nrLDPC_outMode_LLRINT8;
+        struct decod_ws *ws;
+        doca_error_t result;
 
         /* Calculate the p_llr buffer size according to ArmRAL documentation. i.e. it shall be calculate as length 68 * Z for BG=1 and 52 * Z for BG=2. */
         /* Maximum Z (Lifting Factor / Lifting Size) = 384 */
         int N = 0;
         int Z = p_decParams->Z;
 
+        /* Another code block of the transport block failed, decoding this one is wasted work */
+        if (nrLDPC_session_aborted(ab) == true) {
+                DOCA_LOG_DBG("Transport block aborted, segment of harq_pid = %d, ulsch_id = %d not sent",
+                             harq_pid,
+                             ulsch_id);
+                goto fail;
+        }
+
         if (p_decParams->BG == 1 || p_decParams->BG == 2) {
                 if (p_decParams->BG == 1)
                         N = 68 * Z;
                 if (p_decParams->BG == 2)
                         N = 52 * Z;
         } else {
-                printf("\n[nrLDPC_decod] Received a BG value different from 1 or 2.\n");
-                goto sample_exit;
-        }
-
-
-        printf("\n[nrLDPC_decod_offloading] *** Start the nrLDPC_decod_offloading function ... ***\n");
-        printf("\n");
-        printf("BG = %d\n", p_decParams->BG);
-        printf("Z = %d\n", p_decParams->Z);
-        printf("R = %d\n", p_decParams->R);
-        printf("numMaxIter = %d\n", p_decParams->numMaxIter);
-        printf("Kprime = %d\n", p_decParams->Kprime);
-        printf("outMode = %d\n", p_decParams->outMode);
-        printf("crc_type = %d\n", p_decParams->crc_type);
-        /* int (*check_crc)(uint8_t* decoded_bytes, uint32_t n, uint8_t crc_type); */ /**< Parity check function */
-        printf("\n");
-        printf("*** harq_pid = %d\n", harq_pid);
-        printf("*** ulsch_id = %d\n", ulsch_id);
-        /* printf("*** C = %d\n", C); */                        /* 'C' is not an argument relevant for LDPC decoding */
-        printf("*** N = %d\n", N);
-        printf("\n");
-
-        printf("[nrLDPC_decod_offloading] ====================> p_llr - LLRs (Log-Likelihood Ratios) - soft values <====================\n");
-        for (int i = 0; i < N; i++) {
-                printf("%d ", *(p_llr + i));
-        }
-
-
-
-        // Step 1: Correctly calculate the total memory needed for the array
-        // size_t total_size = N * sizeof(int8_t);
-
-        // Step 2: Allocate the memory and assign it to the pointer
-        // We're assigning the result of malloc directly to the struct member.
-        // cfg.ldpc_decod_params.llrs = (int8_t *)malloc(total_size);
-
-        // It's good practice to check if the allocation was successful
-/*      if (cfg.ldpc_decod_params.llrs == NULL) {
-                // Handle the allocation error (e.g., print an error and exit)
-                goto sample_exit;
+                DOCA_LOG_ERR("[nrLDPC_decod] Received a BG value different from 1 or 2");
+                goto fail;
         }
-*/
-        // Step 3: Now the pointer is valid. Use it directly for memset or memcpy.
-        // You do NOT need the '&...[0]' part when using a pointer.
-        // memset(cfg.ldpc_decod_params.llrs, 0, N);
-        // memcpy(cfg.ldpc_decod_params.llrs, p_llr, N);
-
-
 
-        /* memset(&cfg.ldpc_decod_params.llrs[0], 0, CC_LDPC_IN_BLOCK_LEN); */          /* Use memset and memcpy instead of loop for eficiency */
-        memset(&cfg.ldpc_decod_params.llrs[0], 0, N);
-        /* memcpy(&cfg.ldpc_decod_params.llrs[0], p_llr, CC_LDPC_IN_BLOCK_LEN); */
-        memcpy(&cfg.ldpc_decod_params.llrs[0], p_llr, N);
-
-        size_t k_bytes = p_decParams->Kprime / 8;               // Kprime is given in bits. The total size of the decoded buffer in bytes.
-                                                                // NOTE: This assumes kprime is a multiple of 8.
+        DOCA_LOG_DBG("Decoding segment: BG = %d, Z = %d, R = %d, numMaxIter = %d, Kprime = %d, harq_pid = %d, ulsch_id = %d, N = %d",
+                     p_decParams->BG,
+                     p_decParams->Z,
+                     p_decParams->R,
+                     p_decParams->numMaxIter,
+                     p_decParams->Kprime,
+                     harq_pid,
+                     ulsch_id,
+                     N);
 
         if (p_decParams->Kprime % 8 != 0) {                     // Check for non-byte aligned input
-                printf("[nrLDPC_decod_offloading] Kprime must be a multiple of 8 bits for byte-aligned access.");
-                goto sample_exit;
+                DOCA_LOG_ERR("[nrLDPC_decod_offloading] Kprime must be a multiple of 8 bits for byte-aligned access");
+                goto fail;
         }
 
-        // cfg.ldpc_decod_params.llrs = p_llr;
-
-        cfg.ldpc_decod_params.n = N;
-
-        cfg.ldpc_decod_params.kp = k_bytes;                     // kp value is the Kprime value in bytes
-
-        cfg.ldpc_decod_params.bg = p_decParams->BG;
-
-        cfg.ldpc_decod_params.z = p_decParams->Z;
-
-        cfg.ldpc_decod_params.num_its = p_decParams->numMaxIter;
-
-        cfg.ldpc_decod_params.crc_idx = 0;                      /* There is no CRC attached, set this to ARMRAL_LDPC_NO_CRC = 0 */
-
-        printf("\n\n[nrLDPC_decod_offloading] ====================> cfg.ldpc_decod_params <====================\n");
-        // for (int i = 0; i < cfg.ldpc_decod_params.n; i++) {
-        // for (int i = 0; i < N; i++) {
-                // printf("%d ", cfg.ldpc_decod_params.llrs[i]);
-                // printf("%d ", *(cfg.ldpc_decod_params.llrs + i));
-        // }
-        printf("\n\n");
-        printf("*** n = %d\n", cfg.ldpc_decod_params.n);
-        printf("*** kp = %d\n", cfg.ldpc_decod_params.kp);
-        printf("*** bg = %d\n", cfg.ldpc_decod_params.bg);
-        printf("*** z = %d\n", cfg.ldpc_decod_params.z);
-        printf("*** num_its = %d\n", cfg.ldpc_decod_params.num_its);
-        printf("*** crc_idx = %d\n\n", cfg.ldpc_decod_params.crc_idx);
-
-
-
-        /* Set the default configuration values, client so no need for the comch_dev_rep_pci_addr field */
-        strcpy(cfg.comch_dev_pci_addr, DEFAULT_PCI_ADDR);
-
-        /* Register a logger backend */
-        result = doca_log_backend_create_standard();
-        if (result != DOCA_SUCCESS)
-                goto sample_exit;
-
-        /* Register a logger backend for internal SDK errors and warnings */
-        result = doca_log_backend_create_with_file_sdk(stderr, &sdk_log);
-        if (result != DOCA_SUCCESS)
-                goto sample_exit;
-        result = doca_log_backend_set_sdk_level(sdk_log, DOCA_LOG_LEVEL_WARNING);
-        if (result != DOCA_SUCCESS)
-                goto sample_exit;
-
-        DOCA_LOG_INFO("Starting the sample");
-
-        /* Parse cmdline/json arguments */
-        result = doca_argp_init("doca_comch_data_path_client", &cfg);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to init ARGP resources: %s", doca_error_get_descr(result));
-                goto sample_exit;
+        /* Only the N LLRs travel, and only the Kprime / 8 decoded bytes come back, see nrLDPC_proto.h */
+        hdr.bg = p_decParams->BG;
+        hdr.z = p_decParams->Z;
+        hdr.k = p_decParams->Kprime;
+        hdr.n = N;
+        hdr.num_its = p_decParams->numMaxIter;
+        hdr.crc_idx = nrLDPC_crc_from_params(p_decParams);      /* Checked on the DPU, it stops once the CRC passes */
+        out_size = p_decParams->outMode == nrLDPC_outMode_BITINT8 ? p_decParams->Kprime : p_decParams->Kprime / 8;
+
+        /* The client and its data path are set up once by LDPCinit, see nrLDPC_session.h */
+        s = nrLDPC_session_get();
+        if (s != NULL) {
+                cfg = &s->cfg;
+        } else {
+                nrLDPC_session_cfg_from_env(&env_cfg);
+                cfg = &env_cfg;
+                if (cfg->host_mode == NRLDPC_HOST_OFF)
+                        goto fail;
         }
-
-        result = register_comch_params();
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to register CC client sample parameters: %s", doca_error_get_descr(result));
-                goto argp_cleanup;
+        if (llr_out == true && cfg->host_mode == NRLDPC_HOST_OFF) {
+                DOCA_LOG_ERR("LLR output of the decoder needs the host decoder, NRLDPC_HOST is off");
+                goto fail;
         }
-
-        result = doca_argp_start(argc, argv);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to parse sample input: %s", doca_error_get_descr(result));
-                goto argp_cleanup;
+        if (s == NULL || cfg->host_mode == NRLDPC_HOST_ALWAYS || llr_out == true)
+                goto host;
+
+        /* A HARQ call the server cannot combine is combined and decoded on the host, see nrLDPC_proto.h */
+        features = nrLDPC_session_features(NRLDPC_SERVICE_DECOD);
+        if (harq != NULL && (features & NRLDPC_PROTO_FEATURE_HARQ) == 0) {
+                if (cfg->host_mode == NRLDPC_HOST_OFF) {
+                        DOCA_LOG_ERR("The decoder server keeps no HARQ soft buffers and NRLDPC_HOST is off");
+                        goto fail;
+                }
+                goto host;
         }
-
-        /* Start the client */
-
-        result = start_nrLDPC_decod_client(server_name, cfg.comch_dev_pci_addr, &cfg.ldpc_decod_params);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to run sample: %s", doca_error_get_descr(result));
-                goto argp_cleanup;
+        /*
+         * From E = N on, the N recovered LLRs are fewer bytes to send than the E received ones, and always fit.
+         * A server that does not recover rate matched LLRs is sent the N ones the host recovers.
+         */
+        if (rm != NULL && ((features & NRLDPC_PROTO_FEATURE_RM_DECOD) == 0 || rm->e >= (uint32_t)N ||
+                           sizeof(*rm) + rm->e > NRLDPC_PROTO_MAX_PAYLOAD)) {
+                ws = decod_ws_get();
+                if (ws == NULL) {
+                        DOCA_LOG_ERR("Failed to allocate the LLRs of E = %u", rm->e);
+                        goto fail;
+                }
+                result = nrLDPC_rm_recover(p_decParams->BG, p_decParams->Z, rm, p_llr, ws->llrs);
+                if (result != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Failed to recover the LLRs of E = %u: %s", rm->e, doca_error_get_descr(result));
+                        goto fail;
+                }
+                nrLDPC_rm_count_host();
+                /* rm is cleared: decod_host_rm(), which reuses ws, is not called for this call */
+                p_llr = ws->llrs;
+                rm = NULL;
         }
 
+        if (cfg->host_mode == NRLDPC_HOST_AUTO && harq == NULL &&
+            nrLDPC_dispatch_route(NRLDPC_SERVICE_DECOD, hdr.bg, hdr.z, hdr.num_its, 1, ans == NULL, &ticket) ==
+                    NRLDPC_ROUTE_HOST)
+                goto host;
 
-
-        // Free the allocated memory to avoid a memory leak
-        // free(cfg.ldpc_decod_params.llrs);
-
-        // Return the decoded output in the pointer p_out using memcpy instead of loop for eficiency
         // 'Kprime' is the K' in the standard 3GPP TS 38.212 section 5.2.2. It is the number of the payload bits per uncoded segment.
         // In other word, it is the number of useful bits in the output of the decoder.
+        /* Queued requests of an aborted transport block are dropped, in-flight ones cancelled */
+        nrLDPC_session_set_abort(ab);
+        if (ans != NULL)
+                result = start_nrLDPC_decod_client_async(&hdr,
+                                                         p_llr,
+                                                         harq,
+                                                         rm,
+                                                         p_decParams->outMode,
+                                                         (uint8_t *)p_out,
+                                                         out_size,
+                                                         cfg->host_mode != NRLDPC_HOST_OFF ? p_decParams : NULL,
+                                                         &ticket,
+                                                         ab,
+                                                         ans);
+        else if (cfg->hedge_pct != 0 && cfg->host_mode != NRLDPC_HOST_OFF && harq == NULL && rm == NULL)
+                result = start_nrLDPC_decod_client_hedged(&hdr,
+                                                          p_llr,
+                                                          (uint8_t *)p_out,
+                                                          out_size,
+                                                          p_decParams,
+                                                          cfg->hedge_pct,
+                                                          nrLDPC_session_deadline(NRLDPC_SERVICE_DECOD),
+                                                          &ticket,
+                                                          &out_len);
+        else
+                result = start_nrLDPC_decod_client(&hdr,
+                                                   p_llr,
+                                                   harq,
+                                                   rm,
+                                                   p_decParams->outMode,
+                                                   (uint8_t *)p_out,
+                                                   out_size,
+                                                   &out_len);
+        nrLDPC_session_set_abort(NULL);
+        /* The asynchronous call records its outcome when it completes, the hedged one took the ticket over */
+        if (ans == NULL)
+                nrLDPC_dispatch_done(&ticket, result);
+        if (result == NRLDPC_PROTO_ERROR_CANCELLED) {
+                DOCA_LOG_DBG("Transport block aborted, segment of harq_pid = %d, ulsch_id = %d cancelled",
+                             harq_pid,
+                             ulsch_id);
+                return ans != NULL ? EXIT_FAILURE : decod_ret(p_decParams, false, 0);
+        }
+        if (result == DOCA_SUCCESS)
+                return ans != NULL ? EXIT_SUCCESS : decod_ret(p_decParams, true, (uint32_t)hdr.status);
+        /* The asynchronous call completed ans in any case, its callback decoded the failed request on the host */
+        if (ans != NULL || cfg->host_mode == NRLDPC_HOST_OFF) {
+                DOCA_LOG_ERR("Failed to offload the LDPC decoding: %s", doca_error_get_descr(result));
+                return ans != NULL ? EXIT_FAILURE : decod_ret(p_decParams, false, 0);
+        }
+        DOCA_LOG_DBG("Failed to offload the LDPC decoding: %s, decoding on the host", doca_error_get_descr(result));
+
+host:
+        /*
+         * The soft buffer of a call the DPU failed stays on the DPU, the host decodes this transmission alone.
+         * features is 0 unless the DPU was asked: the host combines whenever the DPU does not.
+         */
+        if (harq != NULL && (features & NRLDPC_PROTO_FEATURE_HARQ) == 0)
+                result = decod_host_harq(p_decParams, harq, N, cfg->harq_buffers, p_llr, p_out, &num_iter);
+        else if (rm != NULL)
+                result = decod_host_rm(p_decParams, rm, p_llr, p_out, &num_iter);
+        else
+                result = decod_host(p_decParams, p_llr, p_out, &num_iter);
+        nrLDPC_dispatch_done(&ticket, result);
+        if (ans != NULL && result == DOCA_SUCCESS && decod_ret(p_decParams, true, num_iter) > p_decParams->numMaxIter)
+                nrLDPC_session_abort(ab);
+        if (ans != NULL)
+                completed_task_ans(ans);
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to decode on the host: %s", doca_error_get_descr(result));
+                return ans != NULL ? EXIT_FAILURE : decod_ret(p_decParams, false, 0);
+        }
 
-        memcpy(p_out, cfg.ldpc_decod_params.data_out, p_decParams->Kprime);
-        // memcpy(p_out, cfg.ldpc_decod_params.data_out, CC_LDPC_OUT_BLOCK_LEN);
+        return ans != NULL ? EXIT_SUCCESS : decod_ret(p_decParams, true, num_iter);
 
-        exit_status = EXIT_SUCCESS;
+fail:
+        /* The asynchronous caller waits for its answer whatever happens */
+        if (ans != NULL)
+                completed_task_ans(ans);
+        return ans != NULL ? EXIT_FAILURE : decod_ret(p_decParams, false, 0);
+}
 
-argp_cleanup:
-        doca_argp_destroy();
-sample_exit:
-        if (exit_status == EXIT_SUCCESS)
-                DOCA_LOG_INFO("Sample finished successfully");
-        else
-                DOCA_LOG_INFO("Sample finished with errors");
-        return exit_status;
+int32_t nrLDPC_decod_offloading(t_nrLDPC_dec_params *p_decParams,
+                                uint8_t harq_pid,
+                                uint8_t ulsch_id,
+                                uint8_t C,
+                                int8_t *p_llr,
+                                int8_t *p_out,
+                                t_nrLDPC_time_stats *p_time_stats,
+                                decode_abort_t *ab)
+{
+        return decod_offload(p_decParams, harq_pid, ulsch_id, C, p_llr, p_out, p_time_stats, ab, NULL, NULL, NULL);
 }
 
 /*
@@ -645,34 +883,194 @@ int32_t nrLDPC_decod(t_nrLDPC_dec_params *p_decParams,
                      t_nrLDPC_time_stats *p_time_stats,
                      decode_abort_t *ab)
 {
-        doca_error_t result;
         int exit_status = EXIT_FAILURE;
 
+        /* Start the LDPC decoder function offloading to DPU */
+        exit_status = nrLDPC_decod_offloading(p_decParams, harq_pid, ulsch_id, C, p_llr, p_out, p_time_stats, ab);
+        /* Checking the CRC, the iterations are returned and a failure is OAI's to handle */
+        if (nrLDPC_crc_from_params(p_decParams) == NRLDPC_PROTO_CRC_NONE && exit_status != EXIT_SUCCESS &&
+            nrLDPC_session_aborted(ab) == false)
+                DOCA_LOG_ERR("[nrLDPC_decod] Failed to call the nrLDPC_decod_offloading function");
 
-        printf("\n\n[nrLDPC_decod] *** nrLDPC_decod function has been called by the Rate dematching function of the DU High-PHY Layer - Uplink direction ***\n");
-                                                                                        /* Start the LDPC decoder function offloading to DPU */
-        result = nrLDPC_decod_offloading(p_decParams, harq_pid, ulsch_id, C, p_llr, p_out, p_time_stats, ab);
+        return exit_status;
+}
 
-        if (result != DOCA_SUCCESS) {
-                printf("[nrLDPC_decod] Failed to call the nrLDPC_decod_offloading function\n");
+/*
+ * nrLDPC_decod_async - Asynchronous nrLDPC_decod for the OAI thread pool: returns as soon as the LLRs are sent
+ * to the DPU, the calling worker can keep more code blocks in flight and go on with other High-PHY work.
+ * When the decoded bits are written to p_out, ans is completed the way OAI's completed_task_ans() does:
+ * its counter is decremented and its semaphore posted when the counter reaches 0. It is completed exactly
+ * once per call, also when the call fails.
+ *
+ * @p_decParams [in]: As nrLDPC_decod
+ * @harq_pid [in]: As nrLDPC_decod
+ * @ulsch_id [in]: As nrLDPC_decod
+ * @C [in]: As nrLDPC_decod
+ * @p_llr [in]: LLRs, read before the function returns
+ * @p_out [out]: Decoded bits, written when ans is completed
+ * @p_time_stats [in]: As nrLDPC_decod
+ * @ab [in]: As nrLDPC_decod
+ * @ans [in]: OAI task answer to complete
+ *
+ * @return: EXIT_SUCCESS when the decoding is submitted and EXIT_FAILURE otherwise
+ */
+int32_t nrLDPC_decod_async(t_nrLDPC_dec_params *p_decParams,
+                           uint8_t harq_pid,
+                           uint8_t ulsch_id,
+                           uint8_t C,
+                           int8_t *p_llr,
+                           int8_t *p_out,
+                           t_nrLDPC_time_stats *p_time_stats,
+                           decode_abort_t *ab,
+                           task_ans_t *ans)
+{
+        if (ans == NULL) {
+                DOCA_LOG_ERR("[nrLDPC_decod_async] No task answer to complete");
+                return EXIT_FAILURE;
         }
 
+        return decod_offload(p_decParams, harq_pid, ulsch_id, C, p_llr, p_out, p_time_stats, ab, NULL, NULL, ans);
+}
 
-        printf("[nrLDPC_decod] ====================> Final Decoder Output <====================\n");
+/*
+ * nrLDPC_decod_harq - nrLDPC_decod with the HARQ soft combining done where the segment is decoded: p_llr holds the
+ * LLRs of this transmission only, 0 where it does not cover the code block, and the DPU adds them to the soft
+ * buffer it keeps for (ulsch_id, harq_pid, segment) before decoding the combined LLRs. A retransmission only
+ * sends the window of LLRs it covers across PCIe, and the host does no combining pass. The buffers are freed by
+ * nrLDPC_decod_harq_release() on ACK and restarted by new_data, the DPU reuses the least recently used one when
+ * they are all taken. The segment coding interface of OAI carries no new data indicator, hence this entry point.
+ *
+ * @p_decParams [in]: As nrLDPC_decod
+ * @harq_pid [in]: HARQ process
+ * @ulsch_id [in]: ULSCH process
+ * @segment [in]: Code block of the transport block
+ * @new_data [in]: First transmission of the transport block, the soft buffer restarts from 0
+ * @p_llr [in]: LLRs of this transmission, N of them, read before the function returns
+ * @p_out [out]: As nrLDPC_decod, written when ans is completed
+ * @ab [in]: As nrLDPC_decod
+ * @ans [in]: OAI task answer to complete as nrLDPC_decod_async, NULL to wait for the decoded bits here
+ *
+ * @return: EXIT_SUCCESS on success and EXIT_FAILURE otherwise
+ */
+int32_t nrLDPC_decod_harq(t_nrLDPC_dec_params *p_decParams,
+                          uint8_t harq_pid,
+                          uint8_t ulsch_id,
+                          uint16_t segment,
+                          bool new_data,
+                          int8_t *p_llr,
+                          int8_t *p_out,
+                          decode_abort_t *ab,
+                          task_ans_t *ans)
+{
+        struct nrLDPC_proto_harq harq = {
+                .ulsch_id = ulsch_id,
+                .harq_pid = harq_pid,
+                .segment = segment,
+                .ctrl = new_data == true ? NRLDPC_PROTO_HARQ_NEW_DATA : 0,
+        };
+
+        if (segment >= NR_LDPC_MAX_NUM_CB) {
+                DOCA_LOG_ERR("[nrLDPC_decod_harq] Segment %u of a transport block of %u at most",
+                             segment,
+                             NR_LDPC_MAX_NUM_CB);
+                if (ans != NULL)
+                        completed_task_ans(ans);
+                return EXIT_FAILURE;
+        }
 
-        size_t k_bytes = p_decParams->Kprime / 8;
+        return decod_offload(p_decParams, harq_pid, ulsch_id, 0, p_llr, p_out, NULL, ab, &harq, NULL, ans);
+}
 
-        for (int i = 0; i < k_bytes; i++) {
-        // for (int i = 0; i < CC_LDPC_OUT_BLOCK_LEN; i++) {
-                // printf("%d ", *(p_out + i));
-                // printf("%u ", (uint8_t)*(p_out + i));
-                printf("%02x ", (uint8_t)*(p_out + i));
-        }
-        printf("\n\n");
+/*
+ * nrLDPC_decod_harq_release - Free the soft buffers of every segment of a HARQ process once its transport block
+ * is acknowledged, on the DPU and on the host. The DPU is not waited for: no decode of the process is in flight
+ * once it is acknowledged, and the next one with new data restarts its buffers anyway.
+ *
+ * @harq_pid [in]: HARQ process
+ * @ulsch_id [in]: ULSCH process
+ *
+ * @return: EXIT_SUCCESS when the buffers are freed or the request to free them is sent and EXIT_FAILURE otherwise
+ */
+int32_t nrLDPC_decod_harq_release(uint8_t harq_pid, uint8_t ulsch_id)
+{
+        struct nrLDPC_session *s;
+        doca_error_t result;
 
+        (void)nrLDPC_harq_release(nrLDPC_harq_host_store(0), ulsch_id, harq_pid);
 
+        /* A server without HARQ keeps no soft buffer, they were all combined on the host */
+        s = nrLDPC_session_get();
+        if (s == NULL || s->cfg.host_mode == NRLDPC_HOST_ALWAYS ||
+            (nrLDPC_session_features(NRLDPC_SERVICE_DECOD) & NRLDPC_PROTO_FEATURE_HARQ) == 0)
+                return EXIT_SUCCESS;
 
-        exit_status = EXIT_SUCCESS;
+        nrLDPC_harq_count_release();
+        result = start_nrLDPC_decod_client_harq_free(ulsch_id, harq_pid);
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("[nrLDPC_decod_harq_release] Failed to free the soft buffers of harq_pid = %d, "
+                             "ulsch_id = %d: %s",
+                             harq_pid,
+                             ulsch_id,
+                             doca_error_get_descr(result));
+                return EXIT_FAILURE;
+        }
 
-        return exit_status;
+        return EXIT_SUCCESS;
+}
+
+/*
+ * nrLDPC_decod_rm - nrLDPC_decod taking the LLRs of the segment as received, before the rate recovery: the E LLRs
+ * of the bit selection and bit interleaving of TS 38.212 5.4.2, sent to the DPU as they are with rv, Qm, F and
+ * Ncb. The DPU undoes the interleaving and places them in the circular buffer, repeated bits added, filler bits
+ * known to be 0, so at high code rates E bytes cross PCIe instead of N and the host spends no cycle on the
+ * recovery. From E = N on, or when the E LLRs do not fit a message, the host recovers the N LLRs and sends those.
+ * The segment coding interface of OAI takes the recovered LLRs, hence this entry point.
+ *
+ * @p_decParams [in]: As nrLDPC_decod
+ * @harq_pid [in]: As nrLDPC_decod
+ * @ulsch_id [in]: As nrLDPC_decod
+ * @E [in]: Rate matched bits of the segment, a multiple of Qm
+ * @rv [in]: Redundancy version, 0 to 3
+ * @Qm [in]: Modulation order, bits per symbol
+ * @F [in]: Filler bits, K - Kprime with K = 22 * Z for BG1 and 10 * Z for BG2
+ * @Ncb [in]: Circular buffer length, 66 * Z for BG1 and 50 * Z for BG2 unless limited (LBRM)
+ * @p_e [in]: The E LLRs, read before the function returns
+ * @p_out [out]: As nrLDPC_decod, written when ans is completed
+ * @ab [in]: As nrLDPC_decod
+ * @ans [in]: OAI task answer to complete as nrLDPC_decod_async, NULL to wait for the decoded bits here
+ *
+ * @return: EXIT_SUCCESS on success and EXIT_FAILURE otherwise
+ */
+int32_t nrLDPC_decod_rm(t_nrLDPC_dec_params *p_decParams,
+                        uint8_t harq_pid,
+                        uint8_t ulsch_id,
+                        uint32_t E,
+                        uint8_t rv,
+                        uint8_t Qm,
+                        uint32_t F,
+                        uint32_t Ncb,
+                        int8_t *p_e,
+                        int8_t *p_out,
+                        decode_abort_t *ab,
+                        task_ans_t *ans)
+{
+        struct nrLDPC_proto_rm rm = {
+                .e = E,
+                .ncb = (uint16_t)Ncb,
+                .f = (uint16_t)F,
+                .rv = rv,
+                .qm = Qm,
+        };
+
+        if (F > UINT16_MAX || Ncb > UINT16_MAX ||
+            nrLDPC_rm_check(p_decParams->BG, p_decParams->Z, &rm) != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("[nrLDPC_decod_rm] Invalid rate matching of harq_pid = %d, ulsch_id = %d",
+                             harq_pid,
+                             ulsch_id);
+                if (ans != NULL)
+                        completed_task_ans(ans);
+                return EXIT_FAILURE;
+        }
+
+        return decod_offload(p_decParams, harq_pid, ulsch_id, 0, p_e, p_out, NULL, ab, NULL, &rm, ans);
 }
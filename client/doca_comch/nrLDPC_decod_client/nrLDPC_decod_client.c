@@ -22,606 +22,686 @@
  *
  */
 
-#include <signal.h>
-#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <unistd.h>
-
-#include <doca_buf.h>
-#include <doca_buf_inventory.h>
-#include <doca_comch.h>
-#include <doca_comch_consumer.h>
-#include <doca_comch_producer.h>
-#include <doca_ctx.h>
-#include <doca_dev.h>
+
 #include <doca_error.h>
 #include <doca_log.h>
-#include <doca_mmap.h>
-#include <doca_pe.h>
 
 #include "comch_ctrl_path_common.h"
-#include "nrLDPC_common.h"
-/* #include "nrLDPC_decod_common.h"                                     VBrusse */
-#include "common.h"
+#include "nrLDPC_bits.h"
+#include "nrLDPC_crc.h"
+#include "nrLDPC_dispatch.h"
+#include "nrLDPC_harq.h"
+#include "nrLDPC_hedge.h"
+#include "nrLDPC_host_decod.h"
+#include "nrLDPC_proto.h"
+#include "nrLDPC_ratematch.h"
+#include "nrLDPC_session.h"
 
 DOCA_LOG_REGISTER(NRLDPC_DECOD_CLIENT);
 
-/* Sample's objects */
-struct comch_data_path_client_objects {
-        struct doca_dev *hw_dev;                   /* Device used in the sample */
-        struct doca_pe *pe;                        /* PE object used in the sample */
-        struct doca_comch_client *client;          /* Client object used in the sample */
-        struct doca_comch_connection *connection;  /* CC connection object used in the sample */
-        doca_error_t client_result;                /* Holds result will be updated in client callbacks */
-        bool client_finish;                        /* Controls whether client progress loop should be run */
-        bool data_path_test_started;               /* Indicate whether we can start data_path test */
-        bool data_path_test_stopped;               /* Indicate whether we can stop data_path test */
-        struct comch_data_path_objects *data_path; /* Data path objects */
+/* Asynchronous decoding call, freed by its completion */
+struct decod_async_ctx {
+        struct nrLDPC_proto_hdr req_hdr;      /* Request header */
+        uint8_t *output;                      /* Decoded bits, in the layout of out_mode */
+        uint32_t output_size;                 /* Size of the output buffer */
+        e_nrLDPC_outMode out_mode;            /* Layout of output, nrLDPC_outMode_BIT or nrLDPC_outMode_BITINT8 */
+        task_ans_t *ans;                      /* Signalled once the response is written */
+        t_nrLDPC_dec_params host_params;      /* Parameters of the host decoder, used when host_llr is set */
+        int8_t *host_llr;                     /* LLRs kept for the host fallback, NULL without it */
+        struct nrLDPC_proto_rm host_rm;       /* Rate matching of host_llr, e is 0 when they are the N LLRs */
+        struct nrLDPC_dispatch_ticket ticket; /* Routing decision, its outcome recorded on completion */
+        decode_abort_t *ab;                   /* Abort flag of the transport block, set when the CRC fails */
 };
 
-/**
- * Callback for client send task successful completion
- *
- * @task [in]: Send task object
- * @task_user_data [in]: User data for task
- * @ctx_user_data [in]: User data for context
- */
-static void client_send_task_completion_callback(struct doca_comch_task_send *task,
-                                                 union doca_data task_user_data,
-                                                 union doca_data ctx_user_data)
-{
-        struct comch_data_path_client_objects *sample_objects;
-
-        (void)task_user_data;
+/* Hedged decoding call, shared by the caller and the completion of its DPU request */
+struct decod_hedge_ctx {
+        struct nrLDPC_proto_hdr req_hdr;      /* Request header */
+        pthread_mutex_t lock;                 /* Protects refs, dpu_done and dpu_status */
+        pthread_cond_t cond;                  /* Signalled when the DPU answers */
+        uint32_t refs;                        /* Caller and completion, the last one frees the call */
+        bool dpu_done;                        /* The DPU request completed */
+        doca_error_t dpu_status;              /* Its result */
+        _Atomic(bool) stop;                   /* The DPU answered, the host decoding stops */
+        struct nrLDPC_dispatch_ticket ticket; /* Routing decision, its outcome recorded when the DPU answers */
+        e_nrLDPC_outMode out_mode;            /* Layout of output, the one of the host decoder */
+        uint32_t output_size;                 /* Size of output */
+        uint32_t output_len;                  /* Length the DPU wrote to output */
+        uint8_t output[];                     /* Decoded bits of the DPU, copied out by the caller if used */
+};
 
-        sample_objects = (struct comch_data_path_client_objects *)(ctx_user_data.ptr);
-        sample_objects->client_result = DOCA_SUCCESS;
+/* LLRs the progress thread recovers for the host fallback, too large for its stack */
+struct decod_client_ws {
+        int8_t llrs[NRLDPC_RM_MAX_LLRS];      /* Recovered from the rate matched ones */
+};
 
+static pthread_key_t decod_ws_key;                       /* Owns the decod_client_ws of each thread */
+static pthread_once_t decod_ws_once = PTHREAD_ONCE_INIT; /* Creates decod_ws_key */
 
-/*      DOCA_LOG_INFO("Client enviou mensagem: %s", sample_objects->data_path->text);             VBrusse */
+/*
+ * Create the key of the per thread workspaces
+ */
+static void decod_ws_key_create(void)
+{
+        (void)pthread_key_create(&decod_ws_key, free);
+}
 
+/**
+ * Get the workspace of the calling thread
+ *
+ * @return: The workspace on success and NULL otherwise
+ */
+static struct decod_client_ws *decod_ws_get(void)
+{
+        struct decod_client_ws *ws;
+
+        pthread_once(&decod_ws_once, decod_ws_key_create);
+        ws = pthread_getspecific(decod_ws_key);
+        if (ws == NULL) {
+                ws = malloc(sizeof(*ws));
+                if (ws == NULL || pthread_setspecific(decod_ws_key, ws) != 0) {
+                        free(ws);
+                        return NULL;
+                }
+        }
 
-        DOCA_LOG_INFO("Client task sent successfully");
-        doca_task_free(doca_comch_task_send_as_task(task));
+        return ws;
 }
 
 /**
- * Callback for client send task completion with error
+ * Tell whether the CRC of a decoder request is checked by the client rather than by the server
  *
- * @task [in]: Send task object
- * @task_user_data [in]: User data for task
- * @ctx_user_data [in]: User data for context
+ * @hdr [in]: Request header
+ * @return: true when hdr->crc_idx names a CRC the decoder server does not check, see NRLDPC_PROTO_FEATURE_CRC
  */
-static void client_send_task_completion_err_callback(struct doca_comch_task_send *task,
-                                                     union doca_data task_user_data,
-                                                     union doca_data ctx_user_data)
+static bool decod_host_crc(const struct nrLDPC_proto_hdr *hdr)
 {
-        struct comch_data_path_client_objects *sample_objects;
+        return hdr->crc_idx != NRLDPC_PROTO_CRC_NONE &&
+               (nrLDPC_session_features(NRLDPC_SERVICE_DECOD) & NRLDPC_PROTO_FEATURE_CRC) == 0;
+}
 
-        (void)task_user_data;
+/**
+ * Build a decoder request
+ *
+ * @hdr [in/out]: Request header, op, flags and req_id are filled in here
+ * @llrs [in]: LLRs, hdr->n bytes, or rm->e bytes with rm
+ * @harq [in]: Soft buffer to combine the LLRs with on the DPU, NULL for none, its offset is set from the LLRs
+ * @rm [in]: Rate matching of the LLRs, recovered on the DPU, NULL when they are the N LLRs to decode
+ * @req [out]: Request message, NRLDPC_PROTO_MAX_MSG_SIZE bytes
+ * @req_len [out]: Request message length
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t decod_build_req(struct nrLDPC_proto_hdr *hdr,
+                                    const int8_t *llrs,
+                                    const struct nrLDPC_proto_harq *harq,
+                                    const struct nrLDPC_proto_rm *rm,
+                                    uint8_t *req,
+                                    uint32_t *req_len)
+{
+        uint8_t *payload = req + sizeof(*hdr);
+        struct nrLDPC_proto_harq window;
+        uint32_t offset, len, first;
+        uint32_t payload_len;
+        uint8_t crc_idx = hdr->crc_idx;
+
+        hdr->op = NRLDPC_PROTO_OP_DECOD_REQ;
+        hdr->req_id = nrLDPC_proto_next_req_id();
+        /* A server checking no CRC runs every iteration, decod_parse_resp() checks the CRC on the decoded bits */
+        if (decod_host_crc(hdr) == true)
+                hdr->crc_idx = NRLDPC_PROTO_CRC_NONE;
+        if (harq != NULL && rm != NULL) {
+                DOCA_LOG_ERR("decod request combining rate matched LLRs with a HARQ soft buffer is not supported");
+                return DOCA_ERROR_NOT_SUPPORTED;
+        }
+        if (rm != NULL) {
+                /* Only the E LLRs received travel, the DPU recovers the N LLRs it decodes */
+                len = rm->e;
+                hdr->flags |= NRLDPC_PROTO_FLAG_RATE_MATCHED;
+                payload_len = sizeof(*rm) + len;
+                *req_len = 0;
+                if (payload_len <= NRLDPC_PROTO_MAX_PAYLOAD) {
+                        memcpy(payload, rm, sizeof(*rm));
+                        memcpy(payload + sizeof(*rm), llrs, len);
+                        *req_len = nrLDPC_proto_pack(req, NRLDPC_PROTO_MAX_MSG_SIZE, hdr, payload, payload_len);
+                }
+        } else if (harq == NULL) {
+                len = hdr->n;
+                payload_len = len;
+                *req_len = nrLDPC_proto_pack(req, NRLDPC_PROTO_MAX_MSG_SIZE, hdr, llrs, payload_len);
+        } else {
+                /* Only the LLRs the transmission covers travel, the DPU adds them to the soft buffer */
+                nrLDPC_harq_window(llrs, hdr->n, &offset, &len);
+                window = *harq;
+                window.offset = (uint16_t)offset;
+                hdr->flags |= NRLDPC_PROTO_FLAG_HARQ;
+                payload_len = sizeof(window) + len;
+                *req_len = 0;
+                if (payload_len <= NRLDPC_PROTO_MAX_PAYLOAD) {
+                        first = hdr->n - offset < len ? hdr->n - offset : len;
+                        memcpy(payload, &window, sizeof(window));
+                        memcpy(payload + sizeof(window), llrs + offset, first);
+                        memcpy(payload + sizeof(window) + first, llrs, len - first);
+                        *req_len = nrLDPC_proto_pack(req, NRLDPC_PROTO_MAX_MSG_SIZE, hdr, payload, payload_len);
+                }
+        }
+        hdr->crc_idx = crc_idx;
+        if (*req_len == 0) {
+                DOCA_LOG_ERR("decod request of %u bytes exceeds the %u bytes payload limit",
+                             payload_len,
+                             NRLDPC_PROTO_MAX_PAYLOAD);
+                return DOCA_ERROR_INVALID_VALUE;
+        }
+        if (harq != NULL)
+                nrLDPC_harq_count_sent(hdr->n, len, (harq->ctrl & NRLDPC_PROTO_HARQ_NEW_DATA) == 0);
+        if (rm != NULL)
+                nrLDPC_rm_count_sent(hdr->n, len);
 
-        sample_objects = (struct comch_data_path_client_objects *)(ctx_user_data.ptr);
-        sample_objects->client_result = doca_task_get_status(doca_comch_task_send_as_task(task));
-        DOCA_LOG_ERR("Message failed to send with error = %s", doca_error_get_name(sample_objects->client_result));
-        doca_task_free(doca_comch_task_send_as_task(task));
-        (void)doca_ctx_stop(doca_comch_client_as_ctx(sample_objects->client));
+        return DOCA_SUCCESS;
 }
 
 /**
- * Callback for client message recv event
+ * Check a decoder response and copy its decoded bits out, in the layout the caller asked for: the DPU answers
+ * them packed, as the host decoder writes them for nrLDPC_outMode_BIT
  *
- * @event [in]: Recv event object
- * @recv_buffer [in]: Message buffer
- * @msg_len [in]: Message len
- * @comch_connection [in]: Connection the message was received on
+ * @hdr [in/out]: Request header, status is filled in from the response: the iterations run with a CRC
+ * @resp [in]: Response message
+ * @resp_len [in]: Response message length
+ * @out_mode [in]: Layout of output, nrLDPC_outMode_BIT (packed) or nrLDPC_outMode_BITINT8 (one bit per byte)
+ * @output [out]: Decoded bits
+ * @output_size [in]: Size of the output buffer
+ * @output_len [out]: Length written to output, may be NULL
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
-static void client_message_recv_callback(struct doca_comch_event_msg_recv *event,
-                                         uint8_t *recv_buffer,
-                                         uint32_t msg_len,
-                                         struct doca_comch_connection *comch_connection)
+static doca_error_t decod_parse_resp(struct nrLDPC_proto_hdr *hdr,
+                                     const void *resp,
+                                     uint32_t resp_len,
+                                     e_nrLDPC_outMode out_mode,
+                                     uint8_t *output,
+                                     uint32_t output_size,
+                                     uint32_t *output_len)
 {
-        union doca_data user_data;
-        struct doca_comch_client *comch_client;
-        struct comch_data_path_client_objects *sample_objects;
+        struct nrLDPC_proto_hdr resp_hdr;
+        const void *payload;
         doca_error_t result;
+        uint32_t len;
+        bool passed;
 
-        (void)event;
-
-        DOCA_LOG_INFO("Message received: '%.*s'", (int)msg_len, recv_buffer);                   /* Recebe a resposta do server no recv_buffer */
+        result = nrLDPC_proto_unpack(resp, resp_len, &resp_hdr, &payload);
+        if (result != DOCA_SUCCESS)
+                return result;
 
+        result = nrLDPC_proto_check_resp(hdr, &resp_hdr);
+        if (result != DOCA_SUCCESS)
+                return result;
 
-/*
-        if (strncmp(CC_LDPC_RES, (char *)recv_buffer, 1) == 0) {                                VBrusse
-                DOCA_LOG_INFO("Cliente recebeu mensagem do Servidor");
+        /* The soft buffer was reused while the process waited for its retransmission, only its LLRs were decoded */
+        if ((resp_hdr.flags & NRLDPC_PROTO_FLAG_HARQ_MISS) != 0) {
+                DOCA_LOG_DBG("decod request %u found no HARQ soft buffer on the DPU", hdr->req_id);
+                nrLDPC_harq_count_missed();
         }
-*/
-
-
-        comch_client = doca_comch_client_get_client_ctx(comch_connection);
 
-        result = doca_ctx_get_user_data(doca_comch_client_as_ctx(comch_client), &user_data);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to get user data from ctx with error = %s", doca_error_get_name(result));
-                return;
+        len = out_mode == nrLDPC_outMode_BITINT8 ? resp_hdr.payload_len * 8 : resp_hdr.payload_len;
+        if (len > output_size) {
+                DOCA_LOG_ERR("decod response of %u bytes exceeds the %u bytes output buffer", len, output_size);
+                return DOCA_ERROR_NO_MEMORY;
         }
 
-        sample_objects = (struct comch_data_path_client_objects *)(user_data.ptr);
-
-        if ((msg_len == strlen(STR_START_DATA_PATH_TEST)) &&
-            (strncmp(STR_START_DATA_PATH_TEST, (char *)recv_buffer, msg_len) == 0))
-                sample_objects->data_path_test_started = true;
-        else if ((msg_len == strlen(STR_STOP_DATA_PATH_TEST)) &&
-                 (strncmp(STR_STOP_DATA_PATH_TEST, (char *)recv_buffer, msg_len) == 0)) {
-                sample_objects->data_path_test_stopped = true;
-                sample_objects->data_path->remote_consumer_id = INVALID_CONSUMER_ID;
-                (void)doca_ctx_stop(doca_comch_client_as_ctx(sample_objects->client));
+        if (out_mode == nrLDPC_outMode_BITINT8)
+                nrLDPC_bits_unpack(payload, len, output);
+        else
+                memcpy(output, payload, len);
+        if (output_len != NULL)
+                *output_len = len;
+        hdr->status = resp_hdr.status;
+        if (decod_host_crc(hdr) == true) {
+                /* Every iteration ran, the CRC passes on their outcome or never did */
+                passed = nrLDPC_crc_check(hdr->crc_idx, payload, resp_hdr.payload_len);
+                hdr->status = passed == true ? hdr->num_its : hdr->num_its + 1;
+                nrLDPC_crc_count_host(passed);
+        } else if (hdr->crc_idx != NRLDPC_PROTO_CRC_NONE) {
+                nrLDPC_crc_count_dpu(hdr->num_its, resp_hdr.status);
         }
+
+        return DOCA_SUCCESS;
 }
 
 /**
- * Client sends a message to server
+ * Run one LDPC decoder request on the DPU over the session data path
+ *
+ * The DOCA Comch client, its connection and the producer/consumer are owned by the session
+ * (see nrLDPC_session.h), this function only exchanges the request and the response (see nrLDPC_proto.h).
  *
- * @sample_objects [in]: The sample object to use
- * @msg [in]: The msg to send
- * @len [in]: The msg length
+ * @hdr [in/out]: Request header, op, flags and req_id are filled in here
+ * @llrs [in]: LLRs, hdr->n bytes, or rm->e bytes with rm
+ * @harq [in]: Soft buffer to combine the LLRs with on the DPU, NULL for none
+ * @rm [in]: Rate matching of the LLRs, recovered on the DPU, NULL when they are the N LLRs to decode
+ * @out_mode [in]: Layout of output, nrLDPC_outMode_BIT or nrLDPC_outMode_BITINT8
+ * @output [out]: Decoded bits
+ * @output_size [in]: Size of the output buffer
+ * @output_len [out]: Length written to output
  * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
-static doca_error_t client_send_msg(struct comch_data_path_client_objects *sample_objects, const char *msg, size_t len)
+doca_error_t start_nrLDPC_decod_client(struct nrLDPC_proto_hdr *hdr,
+                                     const int8_t *llrs,
+                                     const struct nrLDPC_proto_harq *harq,
+                                     const struct nrLDPC_proto_rm *rm,
+                                     e_nrLDPC_outMode out_mode,
+                                     uint8_t *output,
+                                     uint32_t output_size,
+                                     uint32_t *output_len)
 {
+        uint8_t req[NRLDPC_PROTO_MAX_MSG_SIZE];
+        uint8_t resp[NRLDPC_PROTO_DECOD_RESP_SIZE];
+        uint32_t req_len;
+        uint32_t resp_len = 0;
         doca_error_t result;
-        struct doca_comch_task_send *task;
 
-
-
-        /* strcpy((char *)msg, CC_LDPC_REQ); */                                                      /* VBrusse */
-        /* len = CC_LDPC_MSG_SIZE; */
-        /* DOCA_LOG_INFO("Cliente enviou essa mensagem: '%.*s'", (int)len, msg);                        VBrusse inseriu */
-
-
-
-        result = doca_comch_client_task_send_alloc_init(sample_objects->client,
-                                                        sample_objects->connection,
-                                                        (void *)msg,                            /* Formata msg a ser enviada ao server */
-                                                        len,
-                                                        &task);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to allocate client task with error = %s", doca_error_get_name(result));
+        result = decod_build_req(hdr, llrs, harq, rm, req, &req_len);
+        if (result != DOCA_SUCCESS)
                 return result;
-        }
 
-        result = doca_task_submit(doca_comch_task_send_as_task(task));                          /* Envia msg ao server */
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to send client task with error = %s", doca_error_get_name(result));
-                doca_task_free(doca_comch_task_send_as_task(task));
+        result = nrLDPC_session_transact(NRLDPC_SERVICE_DECOD, req, req_len, resp, sizeof(resp), &resp_len);
+        if (result != DOCA_SUCCESS)
                 return result;
-        }
 
-        return DOCA_SUCCESS;
+        return decod_parse_resp(hdr, resp, resp_len, out_mode, output, output_size, output_len);
 }
 
 /**
- * Callback triggered whenever CC client context state changes
+ * Completion of an asynchronous decoding call
  *
- * @user_data [in]: User data associated with the CC client context.
- * @ctx [in]: The CC client context that had a state change
- * @prev_state [in]: Previous context state
- * @next_state [in]: Next context state (context is already in this state when the callback is called)
+ * @user_data [in]: The decod_async_ctx of the call
+ * @tag [in]: Index of the request, always 0
+ * @resp [in]: Response message
+ * @resp_len [in]: Response message length
+ * @status [in]: DOCA_SUCCESS when resp holds the response
  */
-static void client_state_changed_callback(const union doca_data user_data,
-                                          struct doca_ctx *ctx,
-                                          enum doca_ctx_states prev_state,
-                                          enum doca_ctx_states next_state)
+static void decod_async_done(void *user_data, uint32_t tag, const void *resp, uint32_t resp_len, doca_error_t status)
 {
-        (void)ctx;
-        (void)prev_state;
-
-        struct comch_data_path_client_objects *sample_objects = (struct comch_data_path_client_objects *)user_data.ptr;
-
-        switch (next_state) {
-        case DOCA_CTX_STATE_IDLE:
-                DOCA_LOG_INFO("CC client context has been stopped");
-                /* We can stop progressing the PE */
-                sample_objects->client_finish = true;
-                break;
-        case DOCA_CTX_STATE_STARTING:
-                /**
-                 * The context is in starting state, need to progress until connection with server is established.
-                 */
-                DOCA_LOG_INFO("CC client context entered into starting state. Waiting for connection establishment");
-                break;
-        case DOCA_CTX_STATE_RUNNING:
-                /* Get a connection channel */
-                if (sample_objects->connection == NULL) {
-                        sample_objects->client_result =
-                                doca_comch_client_get_connection(sample_objects->client, &sample_objects->connection);
-                        if (sample_objects->client_result != DOCA_SUCCESS) {
-                                DOCA_LOG_ERR("Failed to get connection from cc client with error = %s",
-                                             doca_error_get_name(sample_objects->client_result));
-                                (void)doca_ctx_stop(doca_comch_client_as_ctx(sample_objects->client));
+        struct decod_async_ctx *ctx = user_data;
+        struct decod_client_ws *ws;
+        const int8_t *host_llr;
+        uint32_t num_iter = 0;
+
+        (void)tag;
+        if (status == DOCA_SUCCESS)
+                status = decod_parse_resp(&ctx->req_hdr,
+                                          resp,
+                                          resp_len,
+                                          ctx->out_mode,
+                                          ctx->output,
+                                          ctx->output_size,
+                                          NULL);
+        if (status == DOCA_SUCCESS)
+                num_iter = (uint32_t)ctx->req_hdr.status;
+        nrLDPC_dispatch_done(&ctx->ticket, status);
+        /* The segment of a transport block still alive is decoded on the host when the DPU cannot */
+        if (status != DOCA_SUCCESS && status != NRLDPC_PROTO_ERROR_CANCELLED && ctx->host_llr != NULL) {
+                DOCA_LOG_DBG("Asynchronous decoding request %u failed: %s, decoding on the host",
+                             ctx->req_hdr.req_id,
+                             doca_error_get_descr(status));
+                host_llr = ctx->host_llr;
+                status = DOCA_SUCCESS;
+                if (ctx->host_rm.e != 0) {
+                        ws = decod_ws_get();
+                        if (ws != NULL) {
+                                status = nrLDPC_rm_recover(ctx->req_hdr.bg,
+                                                           ctx->req_hdr.z,
+                                                           &ctx->host_rm,
+                                                           host_llr,
+                                                           ws->llrs);
+                                host_llr = ws->llrs;
+                                nrLDPC_rm_count_host();
+                        } else {
+                                status = DOCA_ERROR_NO_MEMORY;
                         }
-                        DOCA_LOG_INFO("CC client context is running. Get a connection from server");
                 }
-                break;
-        case DOCA_CTX_STATE_STOPPING:
-                /**
-                 * The context is in stopping, this can happen when fatal error encountered or when stopping context.
-                 * doca_pe_progress() will cause all tasks to be flushed, and finally transition state to idle
-                 */
-                DOCA_LOG_INFO("CC client context entered into stopping state. Waiting for connection termination");
-                break;
-        default:
-                break;
+                if (status == DOCA_SUCCESS)
+                        status = nrLDPC_host_decod(&ctx->host_params, host_llr, (int8_t *)ctx->output, &num_iter);
         }
+        if (status == NRLDPC_PROTO_ERROR_CANCELLED)
+                DOCA_LOG_DBG("Asynchronous decoding request %u cancelled, its transport block was aborted",
+                             ctx->req_hdr.req_id);
+        else if (status != DOCA_SUCCESS)
+                DOCA_LOG_ERR("Asynchronous decoding request %u failed: %s",
+                             ctx->req_hdr.req_id,
+                             doca_error_get_descr(status));
+        /* The caller does not see the iterations: a failed CRC aborts the transport block, as OAI does */
+        else if (ctx->req_hdr.crc_idx != NRLDPC_PROTO_CRC_NONE && num_iter > ctx->req_hdr.num_its)
+                nrLDPC_session_abort(ctx->ab);
+
+        completed_task_ans(ctx->ans);
+        free(ctx);
 }
 
 /**
- * Callback for new consumer arrival event
+ * Asynchronous start_nrLDPC_decod_client: returns once the request is sent, the decoded bits are written to
+ * output and ans is completed (counter decremented, semaphore posted when it reaches 0) when they arrive.
+ * ans is completed exactly once in every case, failures are logged, and returned when known at submission.
+ * With host_params, a request the DPU fails to decode is decoded on the host by its completion instead, from
+ * the LLRs of this transmission alone for a HARQ request, from the LLRs it recovers for a rate matched one.
+ * A request checking a CRC that does not pass aborts its transport block, ab.
  *
- * @event [in]: New remote consumer event object
- * @comch_connection [in]: The connection related to the consumer
- * @id [in]: The ID of the new remote consumer
+ * @hdr [in]: Request header
+ * @llrs [in]: LLRs, hdr->n bytes, or rm->e bytes with rm, read before this function returns
+ * @harq [in]: Soft buffer to combine the LLRs with on the DPU, NULL for none
+ * @rm [in]: Rate matching of the LLRs, recovered on the DPU, NULL when they are the N LLRs to decode
+ * @out_mode [in]: Layout of output, nrLDPC_outMode_BIT or nrLDPC_outMode_BITINT8, host_params->outMode with them
+ * @output [out]: Decoded bits, must stay valid until ans
+ * @output_size [in]: Size of the output buffer
+ * @host_params [in]: Parameters of the host decoder to fall back to, NULL for none
+ * @ticket [in]: Routing decision of the call, its outcome is recorded once the DPU answers, NULL for none
+ * @ab [in]: Abort flag of the transport block, set when the CRC of hdr->crc_idx fails, NULL for none
+ * @ans [in]: OAI task answer to complete
+ * @return: DOCA_SUCCESS when the request is sent or decoded on the host and DOCA_ERROR otherwise
  */
-static void new_consumer_callback(struct doca_comch_event_consumer *event,
-                                  struct doca_comch_connection *comch_connection,
-                                  uint32_t id)
+doca_error_t start_nrLDPC_decod_client_async(struct nrLDPC_proto_hdr *hdr,
+                                           const int8_t *llrs,
+                                           const struct nrLDPC_proto_harq *harq,
+                                           const struct nrLDPC_proto_rm *rm,
+                                           e_nrLDPC_outMode out_mode,
+                                           uint8_t *output,
+                                           uint32_t output_size,
+                                           const t_nrLDPC_dec_params *host_params,
+                                           const struct nrLDPC_dispatch_ticket *ticket,
+                                           decode_abort_t *ab,
+                                           task_ans_t *ans)
 {
-        union doca_data user_data;
-        struct doca_comch_client *comch_client;
-        struct comch_data_path_client_objects *sample_objects;
+        uint8_t req[NRLDPC_PROTO_MAX_MSG_SIZE];
+        const void *reqs[1] = {req};
+        uint32_t req_len;
+        uint32_t llr_len = rm != NULL ? rm->e : hdr->n;
+        struct decod_async_ctx *ctx;
         doca_error_t result;
 
-        (void)event;
+        result = decod_build_req(hdr, llrs, harq, rm, req, &req_len);
+        if (result != DOCA_SUCCESS && host_params == NULL) {
+                completed_task_ans(ans);
+                return result;
+        }
 
-        comch_client = doca_comch_client_get_client_ctx(comch_connection);
+        ctx = malloc(sizeof(*ctx) + (host_params != NULL ? llr_len : 0));
+        if (ctx == NULL) {
+                completed_task_ans(ans);
+                return DOCA_ERROR_NO_MEMORY;
+        }
+
+        ctx->req_hdr = *hdr;
+        ctx->output = output;
+        ctx->output_size = output_size;
+        ctx->out_mode = out_mode;
+        ctx->ans = ans;
+        ctx->ab = ab;
+        ctx->host_llr = NULL;
+        memset(&ctx->host_rm, 0, sizeof(ctx->host_rm));
+        memset(&ctx->ticket, 0, sizeof(ctx->ticket));
+        if (ticket != NULL)
+                ctx->ticket = *ticket;
+
+        /* OAI may reuse the LLR buffer once the call returns, keep them in case the DPU fails to decode them */
+        if (host_params != NULL) {
+                ctx->host_params = *host_params;
+                ctx->host_llr = (int8_t *)(ctx + 1);
+                memcpy(ctx->host_llr, llrs, llr_len);
+                if (rm != NULL)
+                        ctx->host_rm = *rm;
+        }
 
-        result = doca_ctx_get_user_data(doca_comch_client_as_ctx(comch_client), &user_data);
+        /* A request the DPU service cannot take, e.g. too many LLRs, goes straight to the host */
         if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to get user data from ctx with error = %s", doca_error_get_name(result));
-                return;
+                decod_async_done(ctx, 0, NULL, 0, result);
+                return DOCA_SUCCESS;
         }
 
-        sample_objects = (struct comch_data_path_client_objects *)(user_data.ptr);
-        sample_objects->data_path->remote_consumer_id = id;
+        /* decod_async_done runs exactly once, also when the request cannot be sent, and releases ctx */
+        result = nrLDPC_session_submit(NRLDPC_SERVICE_DECOD, 1, reqs, &req_len, decod_async_done, ctx);
+        /* A request that could not be sent completed with the error, and was decoded on the host */
+        if (result != DOCA_SUCCESS && result != NRLDPC_PROTO_ERROR_CANCELLED && host_params != NULL)
+                result = DOCA_SUCCESS;
 
-        DOCA_LOG_INFO("Got a new remote consumer with ID = [%d]", id);
+        return result;
 }
 
 /**
- * Callback for expired consumer arrival event
+ * Current time
  *
- * @event [in]: Expired remote consumer event object
- * @comch_connection [in]: The connection related to the consumer
- * @id [in]: The ID of the expired remote consumer
+ * @return: CLOCK_MONOTONIC time in nanoseconds
  */
-void expired_consumer_decod_callback(struct doca_comch_event_consumer *event,
-                                     struct doca_comch_connection *comch_connection,
-                                     uint32_t id)
+static uint64_t decod_now_ns(void)
 {
-        /* These arguments are not in use */
-        (void)event;
-        (void)comch_connection;
-        (void)id;
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
 }
 
 /**
- * Clean all sample resources
+ * Drop a reference to a hedged call, freeing it with the last one
  *
- * @sample_objects [in]: Sample objects struct to clean
+ * @ctx [in]: The decod_hedge_ctx of the call
  */
-static void clean_comch_data_path_client_objects(struct comch_data_path_client_objects *sample_objects)
+static void decod_hedge_put(struct decod_hedge_ctx *ctx)
 {
-        doca_error_t result;
-        struct timespec ts = {
-                .tv_sec = 0,
-                .tv_nsec = SLEEP_IN_NANOS,
-        };
+        bool last;
 
-        if (sample_objects == NULL)
+        pthread_mutex_lock(&ctx->lock);
+        last = --ctx->refs == 0;
+        pthread_mutex_unlock(&ctx->lock);
+        if (last == false)
                 return;
 
-        /* Verify client is not already stopped due to a server error */
-        if (sample_objects->client_finish == false) {
-                /* Exchange message with server to make connection is reliable */
-                sample_objects->client_result =
-                        client_send_msg(sample_objects, STR_STOP_DATA_PATH_TEST, strlen(STR_STOP_DATA_PATH_TEST));
-                if (sample_objects->client_result != DOCA_SUCCESS) {
-                        DOCA_LOG_ERR("Failed to submit send task with error = %s",
-                                     doca_error_get_name(sample_objects->client_result));
-                        (void)doca_ctx_stop(doca_comch_client_as_ctx(sample_objects->client));
-                }
-                while (sample_objects->data_path_test_stopped == false) {
-                        if (doca_pe_progress(sample_objects->pe) == 0)
-                                nanosleep(&ts, &ts);
-                }
-                while (sample_objects->client_finish == false) {
-                        if (doca_pe_progress(sample_objects->pe) == 0)
-                                nanosleep(&ts, &ts);
-                }
-        }
-
-        clean_comch_ctrl_path_client(sample_objects->client, sample_objects->pe);
-        sample_objects->client = NULL;
-        sample_objects->pe = NULL;
-
-        if (sample_objects->hw_dev != NULL) {
-                result = doca_dev_close(sample_objects->hw_dev);
-                if (result != DOCA_SUCCESS)
-                        DOCA_LOG_ERR("Failed to close hw device properly with error = %s", doca_error_get_name(result));
-
-                sample_objects->hw_dev = NULL;
-        }
+        pthread_cond_destroy(&ctx->cond);
+        pthread_mutex_destroy(&ctx->lock);
+        free(ctx);
 }
 
-
-
-
-/* VBrusse
- * terminate_comch_data_path_decod_client - This function terminates the producer and consumer
- * instances freeing their resources allocated by host (client) used by LDPC offloading.
+/**
+ * Completion of the DPU request of a hedged call: stops the host decoding when it answers first
  *
- * @data_path [in]: data/input parameters of the LDPC decoding.
+ * @user_data [in]: The decod_hedge_ctx of the call
+ * @tag [in]: Index of the request, always 0
+ * @resp [in]: Response message
+ * @resp_len [in]: Response message length
+ * @status [in]: DOCA_SUCCESS when resp holds the response
  */
-void terminate_comch_data_path_decod_client(struct comch_data_path_objects *data_path)
+static void decod_hedge_done(void *user_data, uint32_t tag, const void *resp, uint32_t resp_len, doca_error_t status)
 {
-        /* Free consumer's mmap and doca_buf resources */
-        clean_comch_consumer(data_path->consumer, data_path->consumer_pe);
-        data_path->consumer = NULL;
-        data_path->consumer_pe = NULL;
-        clean_local_mem_bufs(&data_path->consumer_mem);
-
-        /* Free producer's mmap and doca_buf resources */
-        clean_comch_producer(data_path->producer, data_path->producer_pe);
-        data_path->producer = NULL;
-        data_path->producer_pe = NULL;
-        clean_local_mem_bufs(&data_path->producer_mem);
+        struct decod_hedge_ctx *ctx = user_data;
+
+        (void)tag;
+        /* The caller reads output only once dpu_done is set */
+        if (status == DOCA_SUCCESS)
+                status = decod_parse_resp(&ctx->req_hdr,
+                                          resp,
+                                          resp_len,
+                                          ctx->out_mode,
+                                          ctx->output,
+                                          ctx->output_size,
+                                          &ctx->output_len);
+        nrLDPC_dispatch_done(&ctx->ticket, status);
+
+        pthread_mutex_lock(&ctx->lock);
+        ctx->dpu_status = status;
+        ctx->dpu_done = true;
+        if (status == DOCA_SUCCESS)
+                atomic_store_explicit(&ctx->stop, true, memory_order_relaxed);
+        pthread_cond_signal(&ctx->cond);
+        pthread_mutex_unlock(&ctx->lock);
+
+        decod_hedge_put(ctx);
 }
 
-
-
-
 /**
- * Initialize sample resources
+ * Hedged start_nrLDPC_decod_client: the request goes to the DPU and, if it has not answered by the hedge time,
+ * pct percent of the time left to the deadline, the segment is decoded on the host too. The first answer is
+ * used: the DPU answer stops the host decoding before its next iteration, the host answer leaves the DPU one to
+ * be dropped by the completion.
  *
- * @server_name [in]: Server name to connect to
- * @dev_pci_addr [in]: PCI address to connect over
- * @pldpc_decod_params [in]: Pointer to structure to send to server
- * @sample_objects [in]: Sample objects struct to initialize
- * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ * @hdr [in/out]: Request header, op and req_id are filled in here, status from the decoder that answered
+ * @llrs [in]: LLRs, hdr->n bytes
+ * @output [out]: Decoded bits, in the layout of host_params->outMode, nrLDPC_outMode_BIT or nrLDPC_outMode_BITINT8,
+ * whichever decoder answers
+ * @output_size [in]: Size of the output buffer
+ * @host_params [in]: Parameters of the host decoder
+ * @pct [in]: Percent of the time left to the deadline the DPU gets, NRLDPC_HEDGE_PCT
+ * @deadline_ns [in]: CLOCK_MONOTONIC deadline of the call
+ * @ticket [in/out]: Routing decision of the call, its outcome is recorded once the DPU answers, no longer tracked
+ * by the caller on return, NULL for none
+ * @output_len [out]: Length written to output
+ * @return: DOCA_SUCCESS when one of the decoders answered, the DPU error when it failed before the hedge time,
+ *          and DOCA_ERROR otherwise
  */
-static doca_error_t init_comch_data_path_client_objects(const char *server_name,
-                                                        const char *dev_pci_addr,
-                                                        struct ldpc_decod_params_t *pldpc_decod_params,
-                                                        struct comch_data_path_client_objects *sample_objects)
+doca_error_t start_nrLDPC_decod_client_hedged(struct nrLDPC_proto_hdr *hdr,
+                                            const int8_t *llrs,
+                                            uint8_t *output,
+                                            uint32_t output_size,
+                                            const t_nrLDPC_dec_params *host_params,
+                                            uint32_t pct,
+                                            uint64_t deadline_ns,
+                                            struct nrLDPC_dispatch_ticket *ticket,
+                                            uint32_t *output_len)
 {
-        doca_error_t result;
-        struct comch_ctrl_path_client_cb_config client_cb_cfg = {
-                .send_task_comp_cb = client_send_task_completion_callback,
-                .send_task_comp_err_cb = client_send_task_completion_err_callback,
-                .msg_recv_cb = client_message_recv_callback,
-                .data_path_mode = true,
-                .new_consumer_cb = new_consumer_callback,
-                .expired_consumer_cb = expired_consumer_decod_callback,
-                .ctx_user_data = sample_objects,
-                .ctx_state_changed_cb = client_state_changed_callback};
-        struct timespec ts = {
-                .tv_sec = 0,
-                .tv_nsec = SLEEP_IN_NANOS,
-        };
-
-        /* sample_objects->data_path->text = text;                              VBrusse: comment */
-
-
-
-        /* sample_objects->data_path->pldpc_dec_pars = pldpc_decod_params;                 VBrusse */
-        /* DOCA_LOG_INFO("Cliente envia data_path->pldpc_enc_pars ao Servidor"); */
-/*      DOCA_LOG_INFO("*** Input Block ===> %s", (char *)((struct ldpc_encod_params_t *)(sample_objects->data_path->pldpc_enc_pars))->inputBlock);
-        DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_encod_params_t *)(sample_objects->data_path->pldpc_enc_pars))->bg);
-        DOCA_LOG_INFO("*** z = %d", ((struct ldpc_encod_params_t *)(sample_objects->data_path->pldpc_enc_pars))->z);
-        DOCA_LOG_INFO("*** k = %d", ((struct ldpc_encod_params_t *)(sample_objects->data_path->pldpc_enc_pars))->k);
-        DOCA_LOG_INFO("*** len_filler_bits = %d", ((struct ldpc_encod_params_t *)(sample_objects->data_path->pldpc_enc_pars))->len_filler_bits);
-*/
-
-
-        /* Open DOCA device according to the given PCI address */
-        result = open_doca_device_with_pci(dev_pci_addr, NULL, &(sample_objects->hw_dev));
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to open Comm Channel DOCA device based on PCI address");
+        uint8_t req[NRLDPC_PROTO_MAX_MSG_SIZE];
+        const void *reqs[1] = {req};
+        enum nrLDPC_route winner = NRLDPC_ROUTE_DPU;
+        struct decod_hedge_ctx *ctx;
+        uint64_t start_ns, hedge_ns, end_ns;
+        doca_error_t result, host_result;
+        uint32_t req_len, num_iter;
+        bool fired;
+
+        result = decod_build_req(hdr, llrs, NULL, NULL, req, &req_len);
+        if (result != DOCA_SUCCESS)
                 return result;
-        }
-        sample_objects->data_path->hw_dev = sample_objects->hw_dev;
-
-        /* Init CC client */
-        result = init_comch_ctrl_path_client(server_name,
-                                             sample_objects->hw_dev,
-                                             &client_cb_cfg,
-                                             &(sample_objects->client),
-                                             &(sample_objects->pe));
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to init cc client with error = %s", doca_error_get_name(result));
-                goto close_hw_dev;
-        }
-        sample_objects->data_path->pe = sample_objects->pe;
 
-        /* Wait connection establishment */
-        while (sample_objects->connection == NULL && sample_objects->client_finish == false) {
-                if (doca_pe_progress(sample_objects->pe) == 0)
-                        nanosleep(&ts, &ts);
+        ctx = malloc(sizeof(*ctx) + output_size);
+        if (ctx == NULL)
+                return DOCA_ERROR_NO_MEMORY;
+
+        pthread_mutex_init(&ctx->lock, NULL);
+        pthread_cond_init(&ctx->cond, NULL);
+        ctx->req_hdr = *hdr;
+        ctx->refs = 2;
+        ctx->dpu_done = false;
+        ctx->dpu_status = DOCA_SUCCESS;
+        atomic_init(&ctx->stop, false);
+        memset(&ctx->ticket, 0, sizeof(ctx->ticket));
+        if (ticket != NULL) {
+                ctx->ticket = *ticket;
+                ticket->tracked = false;
         }
-
-        if (sample_objects->client_finish == true) {
-                clean_comch_data_path_client_objects(sample_objects);
-                return DOCA_ERROR_INITIALIZATION;
+        ctx->out_mode = host_params->outMode;
+        ctx->output_size = output_size;
+        ctx->output_len = 0;
+
+        start_ns = decod_now_ns();
+        hedge_ns = nrLDPC_hedge_time(pct, start_ns, deadline_ns);
+
+        /* decod_hedge_done runs exactly once, also when the request cannot be sent */
+        (void)nrLDPC_session_submit(NRLDPC_SERVICE_DECOD, 1, reqs, &req_len, decod_hedge_done, ctx);
+
+        /* Poll the service as a blocking call does, the completion runs here or on the progress thread */
+        pthread_mutex_lock(&ctx->lock);
+        while (ctx->dpu_done == false && decod_now_ns() < hedge_ns) {
+                pthread_mutex_unlock(&ctx->lock);
+                if (nrLDPC_session_poll(NRLDPC_SERVICE_DECOD) == 0)
+                        sched_yield();
+                pthread_mutex_lock(&ctx->lock);
         }
-
-        sample_objects->data_path->connection = sample_objects->connection;
-
-        /* Exchange message with server, to make connection is reliable */
-        sample_objects->client_result =
-                client_send_msg(sample_objects, STR_START_DATA_PATH_TEST, strlen(STR_START_DATA_PATH_TEST));
-        if (sample_objects->client_result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to submit send task with error = %s",
-                             doca_error_get_name(sample_objects->client_result));
-                (void)doca_ctx_stop(doca_comch_client_as_ctx(sample_objects->client));
-                goto destroy_client;
-        }
-        while (sample_objects->data_path_test_started == false) {
-                if (doca_pe_progress(sample_objects->pe) == 0)
-                        nanosleep(&ts, &ts);
+        fired = ctx->dpu_done == false;
+        pthread_mutex_unlock(&ctx->lock);
+
+        if (fired == true) {
+                /* The DPU is late: the host decodes too, until the DPU answers */
+                host_result = nrLDPC_host_decod_stoppable(host_params, llrs, (int8_t *)output, &num_iter, &ctx->stop);
+                if (host_result == DOCA_SUCCESS) {
+                        winner = NRLDPC_ROUTE_HOST;
+                        *output_len = output_size;
+                        hdr->status = (int32_t)num_iter;
+                        goto out;
+                }
+                if (host_result != DOCA_ERROR_AGAIN)
+                        DOCA_LOG_ERR("Failed to decode request %u on the host: %s",
+                                     hdr->req_id,
+                                     doca_error_get_descr(host_result));
+
+                pthread_mutex_lock(&ctx->lock);
+                while (ctx->dpu_done == false)
+                        pthread_cond_wait(&ctx->cond, &ctx->lock);
+                pthread_mutex_unlock(&ctx->lock);
         }
 
-        return DOCA_SUCCESS;
+        result = ctx->dpu_status;
+        if (result == DOCA_SUCCESS) {
+                memcpy(output, ctx->output, ctx->output_len);
+                *output_len = ctx->output_len;
+                hdr->status = ctx->req_hdr.status;
+        }
 
-destroy_client:
-        clean_comch_ctrl_path_client(sample_objects->client, sample_objects->pe);
-close_hw_dev:
-        (void)doca_dev_close(sample_objects->hw_dev);
+out:
+        end_ns = decod_now_ns();
+        if (result == DOCA_SUCCESS)
+                nrLDPC_hedge_record(fired, winner, end_ns - start_ns, end_ns > deadline_ns);
+        decod_hedge_put(ctx);
         return result;
 }
 
 /**
- * Run comch_data_path_client sample
+ * Completion of a HARQ free request
  *
- * @server_name [in]: Server name to connect to
- * @dev_pci_addr [in]: PCI address to connect over
- * @pldpc_decod_params [in/out]: Address to structure to send to the server
- * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ * @user_data [in]: Header of the request, freed here
+ * @tag [in]: Index of the request, always 0
+ * @resp [in]: Response message
+ * @resp_len [in]: Response message length
+ * @status [in]: DOCA_SUCCESS when resp holds the response
  */
-doca_error_t start_nrLDPC_decod_client(const char *server_name,
-                                       const char *dev_pci_addr,
-                                       struct ldpc_decod_params_t *pldpc_decod_params)
+static void decod_harq_free_done(void *user_data, uint32_t tag, const void *resp, uint32_t resp_len, doca_error_t status)
 {
-        doca_error_t result;
-        struct comch_data_path_client_objects sample_objects = {0};
-        struct comch_data_path_objects data_path = {0};
-
-
-
-        data_path.pldpc_dec_pars = (struct ldpc_decod_params_t *)pldpc_decod_params;    /* VBrusse - 2024/12/12 - area de memoria alocada para conter os ldpc data */
-                                                                /* =======> testar se ha necessidade desse comando, uma vez que a area de memoria foi alocada na DU */
-        data_path.pldpc_enc_pars = NULL;
-        data_path.size_ldpc_data = sizeof(struct ldpc_decod_params_t);
-        DOCA_LOG_INFO("*** size_ldpc_data = %d", data_path.size_ldpc_data);
-
-
-
-        sample_objects.data_path = &data_path;
-
-
-
-        result = init_comch_data_path_client_objects(server_name, dev_pci_addr, pldpc_decod_params, &sample_objects);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to initialize sample with error = %s", doca_error_get_name(result));
-                return result;
-        }
-
-
-
-        /*
-         * Representation of an LLR (-9) in 1 Byte (int8_t)
-         *
-         * In 5G NR LDPC decoding, LLRs (Log-Likelihood Ratios) are typically stored as 8-bit signed integers (int8_t) for efficiency.
-         *
-         * Here's how -9 is represented:
-         *
-         * 1. Binary Representation of -9 in int8_t
-         *
-         *      int8_t range: -128 to +127 (two's complement format).
-         *
-         *      Step-by-step conversion:
-         *
-         *      1. Absolute value of -9: 9.
-         *      2. Binary of 9: 00001001 (8 bits).
-         *      3. Two's complement for -9:
-         *              Invert bits: 11110110.
-         *              Add 1: 11110111 (0xF7 in hex).
-         *
-         *      Final 8-bit representation of -9:
-         *              Binary: 11110111
-         *              Hex: 0xF7
-         *              Decimal (unsigned interpretation): 247
-         *
-         * 2. Key Points
-         *
-         *      Negative LLRs favor bit 0, positive LLRs favor bit 1.
-         *
-         *      Magnitude indicates confidence (higher = more reliable).
-         *
-         *      Two's complement is used for signed integers in virtually all modern systems.
-         *
-         *      OAI's decoder expects this exact format (no scaling needed for int8_t).
-         *
-         * 3. Special Cases
-         *
-         *      0: Neutral (equal probability of 0 or 1).
-         *
-         *      -128 (0x80): Extremely strong 0 (but may saturate).
-         *
-         *      +127 (0x7F): Extremely strong 1.
-         */
-
-        DOCA_LOG_INFO("*** BEFORE send");
-        DOCA_LOG_INFO("===================> LLRs <===================");
-        for (int i= 0; i < ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->n; i++) {
-        // for (int i= 0; i < ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->n; i++) {
-                printf("%d ", ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->llrs[i]);
-        }
-        printf("\n");
-        DOCA_LOG_INFO("*** n = %d", ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->n);
-        DOCA_LOG_INFO("*** kp = %d", ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->kp);
-        DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->bg);
-        DOCA_LOG_INFO("*** z = %d", ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->z);
-        DOCA_LOG_INFO("*** num_its = %d\n\n", ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->num_its);
-
-
-
-        result = comch_data_path_send_msg(&data_path);
-        if (result != DOCA_SUCCESS)
-                goto exit;
-
-
-        result = comch_data_path_recv_msg(&data_path);
-        if (result != DOCA_SUCCESS)
-                goto exit;
-
-
-
-        DOCA_LOG_INFO("*** AFTER recv");
-        DOCA_LOG_INFO("===================> Decoded Output <===================");
-
-        // Get a correctly typed pointer to the SOURCE ldpc_decod_params_t struct
-        // This is the struct that contains the 'data_out' array where the decoded data is located.
-        struct ldpc_decod_params_t *source_decoded_data_ptr = (struct ldpc_decod_params_t *)data_path.pldpc_dec_pars;
-
-        // memcpy for efficiency (instead of loop)
-        // This copies 'CC_LDPC_OUT_BLOCK_LEN' bytes from 'source_decoded_data_ptr->data_out' to 'pldpc_decod_params->data_out'.
-        memcpy(pldpc_decod_params->data_out, source_decoded_data_ptr->data_out, CC_LDPC_OUT_BLOCK_LEN);
-
-        for (int i = 0; i < ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->kp; i++) {
-                // printf("%d ", pldpc_decod_params->data_out[i]);
-                printf("%02x ", pldpc_decod_params->data_out[i]);
-        }
-        printf("\n");
-
-
-
-        /* VBrusse */
-        /* DOCA_LOG_INFO("\n\n\n*** =====> nrLDPC_decod_client DEPOIS do recv_msg <====="); */
-        /* DOCA_LOG_INFO("*** Input Block ===> %s", (char *)((struct ldpc_decod_params_t *)(data_path->pldpc_dec_pars))->inputBlock); */
-
-        /* DOCA_LOG_INFO("*** Input Block ===> %s", (char *)((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->inputBlock); */
-        /* DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->bg); */
-        /* DOCA_LOG_INFO("*** z = %d", ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->z); */
-        /* DOCA_LOG_INFO("*** num_its = %d", ((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->num_its); */
-        /* DOCA_LOG_INFO("*** Output Block ===> %s\n\n", (char *)((struct ldpc_decod_params_t *)(data_path.pldpc_dec_pars))->outputBlock); */
-
-
-        terminate_comch_data_path_decod_client(&data_path);                          /* free resources allocated by host */
-
-
-
-exit:
-        clean_comch_data_path_client_objects(&sample_objects);
+        struct nrLDPC_proto_hdr *req_hdr = user_data;
+        struct nrLDPC_proto_hdr resp_hdr;
+        const void *payload;
+
+        (void)tag;
+        if (status == DOCA_SUCCESS)
+                status = nrLDPC_proto_unpack(resp, resp_len, &resp_hdr, &payload);
+        if (status == DOCA_SUCCESS)
+                status = nrLDPC_proto_check_resp(req_hdr, &resp_hdr);
+        /* The buffers stay on the DPU until they are reused, nothing else is lost */
+        if (status != DOCA_SUCCESS)
+                DOCA_LOG_ERR("HARQ free request %u failed: %s", req_hdr->req_id, doca_error_get_descr(status));
+        else
+                DOCA_LOG_DBG("HARQ free request %u freed %d soft buffers", req_hdr->req_id, resp_hdr.status);
+
+        free(req_hdr);
+}
 
-        return result != DOCA_SUCCESS ? result : sample_objects.client_result;
+/**
+ * Free the soft buffers the DPU keeps for every segment of a HARQ process, without waiting for the answer
+ *
+ * @ulsch_id [in]: ULSCH process
+ * @harq_pid [in]: HARQ process
+ * @return: DOCA_SUCCESS when the request is sent and DOCA_ERROR otherwise
+ */
+doca_error_t start_nrLDPC_decod_client_harq_free(uint8_t ulsch_id, uint8_t harq_pid)
+{
+        struct nrLDPC_proto_harq harq = {.ulsch_id = ulsch_id, .harq_pid = harq_pid};
+        uint8_t req[sizeof(struct nrLDPC_proto_hdr) + sizeof(harq)];
+        const void *reqs[1] = {req};
+        struct nrLDPC_proto_hdr *hdr;
+        uint32_t req_len;
+
+        hdr = calloc(1, sizeof(*hdr));
+        if (hdr == NULL)
+                return DOCA_ERROR_NO_MEMORY;
+
+        hdr->op = NRLDPC_PROTO_OP_HARQ_FREE_REQ;
+        hdr->req_id = nrLDPC_proto_next_req_id();
+        req_len = nrLDPC_proto_pack(req, sizeof(req), hdr, &harq, sizeof(harq));
+
+        /* decod_harq_free_done runs exactly once, also when the request cannot be sent, and releases hdr */
+        return nrLDPC_session_submit(NRLDPC_SERVICE_DECOD, 1, reqs, &req_len, decod_harq_free_done, hdr);
 }
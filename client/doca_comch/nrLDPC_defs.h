@@ -35,7 +35,10 @@
 #ifndef __NRLDPC_DEFS__H__
 #define __NRLDPC_DEFS__H__
 
+#include <semaphore.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /*
  * From /openairinterface5g/openair1/PHY/CODING/nrLDPC_decoder/nrLDPCdecoder_defs.h
@@ -164,8 +167,6 @@ typedef struct nrLDPC_time_stats {
 /*
  * From /openairinterface5g/common/utils/threadPool/task_ans.h
  */
-#include <semaphore.h>
-
 extern sem_t sfn_semaphore;
 
 /*
@@ -178,7 +179,15 @@ typedef struct {
   _Alignas(LEVEL1_DCACHE_LINESIZE) _Atomic(int) counter;
 } task_ans_t;
 
-
+/*
+ * From /openairinterface5g/common/utils/threadPool/task_ans.h
+ *
+ * Defined by OAI's task_ans.c in the process that loads this library; programs built without OAI
+ * (the vDU test and bench) link their own copy.
+ */
+void init_task_ans(task_ans_t* ans, unsigned int num_jobs);
+void completed_task_ans(task_ans_t* task);
+void join_task_ans(task_ans_t* ans);
 
 /*
  * From /openairinterface5g/openair1/PHY/CODING/nrLDPC_defs.h
@@ -0,0 +1,392 @@
+/*
+ * Filename: nrLDPC_dispatch.c
+ *
+ * Cost-model dispatcher of NRLDPC_HOST=auto, see nrLDPC_dispatch.h.
+ *
+ * Each kind of call has an entry in an open addressing table, with moving averages of the time each path took
+ * for one of its code blocks. A DPU round trip is a fixed part, the PCIe round trip and the decoding itself,
+ * plus the time the requests ahead of it take: the DPU time is fitted as a line of the requests outstanding
+ * when the call was routed, by least squares over the moving averages of the depth, the time, their product and
+ * the depth squared. The host budget is a token bucket of CPU time, filled at host_cpu_pct percent of the wall
+ * clock time and drained by the time the host takes.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include <doca_log.h>
+
+#include "nrLDPC_dispatch.h"
+#include "nrLDPC_session.h"
+
+DOCA_LOG_REGISTER(NRLDPC_DISPATCH);
+
+/* Moving averages the DPU time is fitted on, x the requests outstanding at the decision and y the time */
+struct dispatch_fit {
+        double x;                                       /* Requests outstanding */
+        double y;                                       /* DPU time of a code block */
+        double xx;                                      /* x * x */
+        double xy;                                      /* x * y */
+};
+
+/* Model of one kind of call */
+struct dispatch_entry {
+        uint32_t key;                                   /* dispatch_key() of the call, 0 for a free entry */
+        struct dispatch_fit dpu;                        /* DPU time against the requests outstanding */
+        double host_ns;                                 /* Host time of a code block */
+        uint32_t dpu_samples;                           /* DPU measurements, up to NRLDPC_DISPATCH_WARMUP */
+        uint32_t host_samples;                          /* Host measurements, up to NRLDPC_DISPATCH_WARMUP */
+        uint32_t decisions;                             /* Calls routed, paces the exploration */
+};
+
+/* Dispatcher state, shared by all the calling threads */
+struct dispatch {
+        pthread_mutex_t lock;                           /* Serialises the decisions and the outcomes */
+        uint32_t generation;                            /* Incremented by nrLDPC_dispatch_init() */
+        uint32_t host_cpu_pct;                          /* Host CPU budget, percent of one core */
+        uint32_t explore;                               /* One decision in explore goes to the slower path */
+        int64_t budget_ns;                              /* Host CPU time left, negative when overspent */
+        int64_t budget_max_ns;                          /* Host CPU time the budget holds at most */
+        uint64_t budget_ns_at;                          /* Time budget_ns was last filled at */
+        struct dispatch_entry table[NRLDPC_DISPATCH_SLOTS];     /* Models, by dispatch_key() */
+        struct nrLDPC_dispatch_stats stats[NRLDPC_SERVICE_NUM]; /* Counters of each service */
+};
+
+static struct dispatch dispatch = {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .host_cpu_pct = NRLDPC_DISPATCH_HOST_CPU_PCT,
+        .explore = NRLDPC_DISPATCH_EXPLORE,
+        .budget_ns = NRLDPC_DISPATCH_BURST_US * 1000LL,
+        .budget_max_ns = NRLDPC_DISPATCH_BURST_US * 1000LL,
+};
+
+/**
+ * Current time
+ *
+ * @return: CLOCK_MONOTONIC time in nanoseconds
+ */
+static uint64_t dispatch_now_ns(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/**
+ * Key of a kind of call in the cost table, never 0
+ *
+ * @type [in]: Service
+ * @bg [in]: Base graph
+ * @z [in]: Lifting size
+ * @iters [in]: Decoder iterations, 0 for the encoder
+ * @return: Key
+ */
+static uint32_t dispatch_key(enum nrLDPC_service_type type, uint8_t bg, uint16_t z, uint16_t iters)
+{
+        return 1U | ((uint32_t)type & 1) << 1 | ((uint32_t)bg & 3) << 2 | ((uint32_t)z & 0x1ff) << 4 |
+               ((uint32_t)iters & 0x7ff) << 13;
+}
+
+/**
+ * Find the entry of a key, the lock must be held
+ *
+ * @key [in]: dispatch_key() of the call
+ * @insert [in]: Take a free entry when the key has none
+ * @return: Index of the entry, NRLDPC_DISPATCH_SLOTS when there is none
+ */
+static uint32_t dispatch_lookup(uint32_t key, bool insert)
+{
+        uint32_t slot = (key * 0x9e3779b1U) >> 23;
+        uint32_t i;
+
+        for (i = 0; i < NRLDPC_DISPATCH_SLOTS; i++, slot = (slot + 1) % NRLDPC_DISPATCH_SLOTS) {
+                if (dispatch.table[slot].key == key)
+                        return slot;
+                if (dispatch.table[slot].key == 0) {
+                        if (insert == false)
+                                return NRLDPC_DISPATCH_SLOTS;
+                        dispatch.table[slot].key = key;
+                        return slot;
+                }
+        }
+
+        return NRLDPC_DISPATCH_SLOTS;
+}
+
+/**
+ * Fill the host budget with the time elapsed since it was last filled, the lock must be held
+ *
+ * @now [in]: Current time
+ */
+static void dispatch_budget_fill(uint64_t now)
+{
+        dispatch.budget_ns += (int64_t)((now - dispatch.budget_ns_at) * dispatch.host_cpu_pct / 100);
+        if (dispatch.budget_ns > dispatch.budget_max_ns)
+                dispatch.budget_ns = dispatch.budget_max_ns;
+        dispatch.budget_ns_at = now;
+}
+
+/**
+ * Add a measurement to a moving average
+ *
+ * @avg [in/out]: Moving average
+ * @first [in]: First measurement, it replaces the average
+ * @value [in]: Measurement
+ */
+static void dispatch_ewma(double *avg, bool first, double value)
+{
+        *avg = first == true ? value : *avg + (value - *avg) / (1 << NRLDPC_DISPATCH_EWMA_SHIFT);
+}
+
+/**
+ * Bound a time measurement to NRLDPC_DISPATCH_OUTLIER times its moving average: a thread preempted once must not
+ * turn a path away for the many calls the average takes to forget it, a path that got slower still shows
+ *
+ * @avg [in]: Moving average of the time
+ * @first [in]: First measurement, nothing to compare it with
+ * @value [in]: Measurement
+ * @return: Measurement to average
+ */
+static double dispatch_clip(double avg, bool first, double value)
+{
+        return first == false && value > avg * NRLDPC_DISPATCH_OUTLIER ? avg * NRLDPC_DISPATCH_OUTLIER : value;
+}
+
+/**
+ * Expected DPU time of a code block
+ *
+ * @fit [in]: Moving averages of the DPU measurements
+ * @depth [in]: Requests outstanding
+ * @queue_ns [out]: Time each request outstanding adds, may be NULL
+ * @return: Expected time, 0 before the first measurement
+ */
+static double dispatch_dpu_ns(const struct dispatch_fit *fit, uint32_t depth, double *queue_ns)
+{
+        double var = fit->xx - fit->x * fit->x;
+        double slope = 0;
+        double t;
+
+        /* Without enough spread of the depth, or when it does not show, the average time is all there is */
+        if (var > 0.25)
+                slope = (fit->xy - fit->x * fit->y) / var;
+        if (slope < 0)
+                slope = 0;
+        if (queue_ns != NULL)
+                *queue_ns = slope;
+        t = fit->y + slope * ((double)depth - fit->x);
+        return t > 0 ? t : 0;
+}
+
+void nrLDPC_dispatch_init(uint32_t host_cpu_pct, uint32_t explore)
+{
+        pthread_mutex_lock(&dispatch.lock);
+        dispatch.generation++;
+        dispatch.host_cpu_pct = host_cpu_pct;
+        dispatch.explore = explore;
+        dispatch.budget_max_ns = (int64_t)NRLDPC_DISPATCH_BURST_US * 1000 * host_cpu_pct / 100;
+        dispatch.budget_ns = dispatch.budget_max_ns;
+        dispatch.budget_ns_at = dispatch_now_ns();
+        memset(dispatch.table, 0, sizeof(dispatch.table));
+        memset(dispatch.stats, 0, sizeof(dispatch.stats));
+        pthread_mutex_unlock(&dispatch.lock);
+}
+
+enum nrLDPC_route nrLDPC_dispatch_route(enum nrLDPC_service_type type,
+                                        uint8_t bg,
+                                        uint16_t z,
+                                        uint16_t iters,
+                                        uint32_t blocks,
+                                        bool blocking,
+                                        struct nrLDPC_dispatch_ticket *ticket)
+{
+        struct nrLDPC_dispatch_stats *stats = &dispatch.stats[type];
+        uint32_t depth = nrLDPC_session_depth(type);
+        struct dispatch_entry *e;
+        enum nrLDPC_route fast, route;
+        bool explore = false;
+        uint64_t now = dispatch_now_ns();
+        double dpu_ns, host_ns;
+        uint32_t slot;
+
+        memset(ticket, 0, sizeof(*ticket));
+        if (blocks == 0)
+                blocks = 1;
+
+        pthread_mutex_lock(&dispatch.lock);
+        slot = dispatch_lookup(dispatch_key(type, bg, z, iters), true);
+        if (slot == NRLDPC_DISPATCH_SLOTS) {
+                stats->routed[NRLDPC_ROUTE_DPU] += blocks;
+                pthread_mutex_unlock(&dispatch.lock);
+                return NRLDPC_ROUTE_DPU;
+        }
+        e = &dispatch.table[slot];
+        dispatch_budget_fill(now);
+
+        dpu_ns = dispatch_dpu_ns(&e->dpu, depth, NULL) * blocks;
+        host_ns = e->host_ns * blocks;
+        e->decisions++;
+
+        /* Each path is measured a few times before the model is trusted, the DPU first */
+        fast = host_ns < dpu_ns ? NRLDPC_ROUTE_HOST : NRLDPC_ROUTE_DPU;
+        if (e->dpu_samples < NRLDPC_DISPATCH_WARMUP || e->host_samples < NRLDPC_DISPATCH_WARMUP)
+                fast = NRLDPC_ROUTE_DPU;
+        explore = e->dpu_samples >= NRLDPC_DISPATCH_WARMUP && e->host_samples < NRLDPC_DISPATCH_WARMUP;
+        /* Now and then the slower path, for its time to follow the load */
+        if (e->host_samples >= NRLDPC_DISPATCH_WARMUP && dispatch.explore != 0)
+                explore = e->decisions % dispatch.explore == 0;
+        /*
+         * An asynchronous call routed to the host runs inline and delays the later submits of its thread by the
+         * host time, which its own time does not show: it stays on the DPU and only feeds the DPU model
+         */
+        if (blocking == false) {
+                fast = NRLDPC_ROUTE_DPU;
+                explore = false;
+        }
+        route = fast;
+        if (explore == true)
+                route = fast == NRLDPC_ROUTE_HOST ? NRLDPC_ROUTE_DPU : NRLDPC_ROUTE_HOST;
+
+        if (route == NRLDPC_ROUTE_HOST && (double)dispatch.budget_ns < host_ns) {
+                if (explore == false)
+                        stats->budget_denied += blocks;
+                route = NRLDPC_ROUTE_DPU;
+        }
+        if (explore == true && route != fast)
+                stats->explored += blocks;
+        stats->routed[route] += blocks;
+
+        /* The host time is set aside now, concurrent callers must not spend it twice */
+        if (route == NRLDPC_ROUTE_HOST) {
+                ticket->reserved_ns = (uint64_t)host_ns;
+                dispatch.budget_ns -= (int64_t)ticket->reserved_ns;
+        }
+        pthread_mutex_unlock(&dispatch.lock);
+
+        ticket->tracked = true;
+        ticket->type = type;
+        ticket->route = route;
+        ticket->slot = slot;
+        ticket->generation = dispatch.generation;
+        ticket->blocks = blocks;
+        ticket->depth = depth;
+        ticket->start_ns = now;
+        ticket->other_ns = (uint64_t)(route == NRLDPC_ROUTE_HOST ? dpu_ns : host_ns);
+        return route;
+}
+
+void nrLDPC_dispatch_done(struct nrLDPC_dispatch_ticket *ticket, doca_error_t status)
+{
+        struct nrLDPC_dispatch_stats *stats;
+        struct dispatch_entry *e;
+        uint64_t elapsed;
+        double t;
+        bool first;
+
+        if (ticket == NULL || ticket->tracked == false)
+                return;
+        ticket->tracked = false;
+        elapsed = dispatch_now_ns() - ticket->start_ns;
+
+        pthread_mutex_lock(&dispatch.lock);
+        /* The session was created again since, the ticket belongs to a model that is gone */
+        if (ticket->generation != dispatch.generation) {
+                pthread_mutex_unlock(&dispatch.lock);
+                return;
+        }
+        stats = &dispatch.stats[ticket->type];
+        e = &dispatch.table[ticket->slot];
+
+        /* The host spent its time whatever the outcome */
+        if (ticket->route == NRLDPC_ROUTE_HOST) {
+                dispatch.budget_ns += (int64_t)ticket->reserved_ns - (int64_t)elapsed;
+                stats->host_ns += elapsed;
+        }
+
+        if (status != DOCA_SUCCESS) {
+                stats->failed[ticket->route] += ticket->blocks;
+                pthread_mutex_unlock(&dispatch.lock);
+                return;
+        }
+
+        stats->completed[ticket->route] += ticket->blocks;
+        if (ticket->other_ns != 0 && elapsed > ticket->other_ns)
+                stats->late[ticket->route] += ticket->blocks;
+        t = (double)elapsed / ticket->blocks;
+        if (ticket->route == NRLDPC_ROUTE_DPU) {
+                first = e->dpu_samples == 0;
+                t = dispatch_clip(dispatch_dpu_ns(&e->dpu, ticket->depth, NULL), first, t);
+                dispatch_ewma(&e->dpu.x, first, ticket->depth);
+                dispatch_ewma(&e->dpu.y, first, t);
+                dispatch_ewma(&e->dpu.xx, first, (double)ticket->depth * ticket->depth);
+                dispatch_ewma(&e->dpu.xy, first, ticket->depth * t);
+                if (e->dpu_samples < NRLDPC_DISPATCH_WARMUP)
+                        e->dpu_samples++;
+        } else {
+                first = e->host_samples == 0;
+                dispatch_ewma(&e->host_ns, first, dispatch_clip(e->host_ns, first, t));
+                if (e->host_samples < NRLDPC_DISPATCH_WARMUP)
+                        e->host_samples++;
+        }
+        pthread_mutex_unlock(&dispatch.lock);
+}
+
+void nrLDPC_dispatch_get_stats(enum nrLDPC_service_type type, struct nrLDPC_dispatch_stats *stats)
+{
+        pthread_mutex_lock(&dispatch.lock);
+        *stats = dispatch.stats[type];
+        pthread_mutex_unlock(&dispatch.lock);
+}
+
+bool nrLDPC_dispatch_estimate(enum nrLDPC_service_type type,
+                              uint8_t bg,
+                              uint16_t z,
+                              uint16_t iters,
+                              uint64_t *dpu_ns,
+                              uint64_t *queue_ns,
+                              uint64_t *host_ns)
+{
+        double slope = 0;
+        uint32_t slot;
+
+        *dpu_ns = 0;
+        *host_ns = 0;
+        pthread_mutex_lock(&dispatch.lock);
+        slot = dispatch_lookup(dispatch_key(type, bg, z, iters), false);
+        if (slot != NRLDPC_DISPATCH_SLOTS) {
+                *dpu_ns = (uint64_t)dispatch_dpu_ns(&dispatch.table[slot].dpu, 0, &slope);
+                *host_ns = (uint64_t)dispatch.table[slot].host_ns;
+        }
+        *queue_ns = (uint64_t)slope;
+        pthread_mutex_unlock(&dispatch.lock);
+
+        return slot != NRLDPC_DISPATCH_SLOTS;
+}
+
+void nrLDPC_dispatch_report(void)
+{
+        static const char *const names[NRLDPC_SERVICE_NUM] = {"Encoder", "Decoder"};
+        struct nrLDPC_dispatch_stats stats;
+        int i;
+
+        for (i = 0; i < NRLDPC_SERVICE_NUM; i++) {
+                nrLDPC_dispatch_get_stats(i, &stats);
+                if (stats.routed[NRLDPC_ROUTE_DPU] + stats.routed[NRLDPC_ROUTE_HOST] == 0)
+                        continue;
+                DOCA_LOG_INFO("%s: %lu code blocks routed to the DPU, %lu to the host (%lu explored, %lu denied "
+                              "by the host budget), %lu and %lu late, %lu and %lu failed",
+                              names[i],
+                              (unsigned long)stats.routed[NRLDPC_ROUTE_DPU],
+                              (unsigned long)stats.routed[NRLDPC_ROUTE_HOST],
+                              (unsigned long)stats.explored,
+                              (unsigned long)stats.budget_denied,
+                              (unsigned long)stats.late[NRLDPC_ROUTE_DPU],
+                              (unsigned long)stats.late[NRLDPC_ROUTE_HOST],
+                              (unsigned long)stats.failed[NRLDPC_ROUTE_DPU],
+                              (unsigned long)stats.failed[NRLDPC_ROUTE_HOST]);
+        }
+}
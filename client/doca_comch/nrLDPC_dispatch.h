@@ -0,0 +1,139 @@
+/*
+ * Filename: nrLDPC_dispatch.h
+ *
+ * Cost-model dispatcher of NRLDPC_HOST=auto: each call goes to the DPU service or to the host CPU, whichever
+ * is expected to finish it sooner. The expected times come from an online model per (service, BG, Zc,
+ * iterations): the measured DPU round trip, as a function of the requests outstanding on the service, against
+ * the measured host compute time. The host takes a call only while its CPU budget, NRLDPC_HOST_CPU_PCT percent
+ * of a core, has time left for it.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_DISPATCH_H_
+#define NRLDPC_DISPATCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <doca_error.h>
+
+#include "nrLDPC_common.h"
+
+#define NRLDPC_DISPATCH_SLOTS 512               /* Entries of the cost table, (service, BG, Zc, iterations) keys */
+#define NRLDPC_DISPATCH_EWMA_SHIFT 3            /* Weight 1/8 of the last measurement in its moving average */
+#define NRLDPC_DISPATCH_OUTLIER 4               /* Measurements count as this many times the average at most */
+#define NRLDPC_DISPATCH_WARMUP 4                /* Measurements of each path before the model is trusted */
+#define NRLDPC_DISPATCH_EXPLORE 64              /* Default NRLDPC_DISPATCH_EXPLORE */
+#define NRLDPC_DISPATCH_HOST_CPU_PCT 100        /* Default NRLDPC_HOST_CPU_PCT */
+#define NRLDPC_DISPATCH_BURST_US 1000           /* Host budget that can build up while the host is idle, at 100% */
+
+/* Path a call is routed to */
+enum nrLDPC_route {
+        NRLDPC_ROUTE_DPU,  /* DPU service */
+        NRLDPC_ROUTE_HOST, /* Host CPU */
+        NRLDPC_ROUTE_NUM,
+};
+
+/* Routing decision of one call, handed back to nrLDPC_dispatch_done() with its outcome */
+struct nrLDPC_dispatch_ticket {
+        bool tracked;                   /* The decision is in the model, false when zeroed or once recorded */
+        enum nrLDPC_service_type type;  /* Service of the call */
+        enum nrLDPC_route route;        /* Path taken */
+        uint32_t slot;                  /* Entry of the cost table */
+        uint32_t generation;            /* Tells the decisions of this session from older ones */
+        uint32_t blocks;                /* Code blocks of the call */
+        uint32_t depth;                 /* DPU requests outstanding at the decision */
+        uint64_t start_ns;              /* CLOCK_MONOTONIC time of the decision */
+        uint64_t other_ns;              /* Expected time of the path not taken, 0 when unknown */
+        uint64_t reserved_ns;           /* Host budget set aside for the call */
+};
+
+/* Routing decisions of a service and their outcomes, in code blocks */
+struct nrLDPC_dispatch_stats {
+        uint64_t routed[NRLDPC_ROUTE_NUM];    /* Sent to each path */
+        uint64_t explored;                    /* Of those, sent to the path expected to be slower, to measure it */
+        uint64_t budget_denied;               /* Sent to the DPU while the host was faster, its budget spent */
+        uint64_t completed[NRLDPC_ROUTE_NUM]; /* Completed by each path */
+        uint64_t failed[NRLDPC_ROUTE_NUM];    /* Failed or cancelled on each path */
+        uint64_t late[NRLDPC_ROUTE_NUM];      /* Completed after the other path was expected to */
+        uint64_t host_ns;                     /* Host CPU time spent on the blocks routed to the host */
+};
+
+/**
+ * Reset the model, the counters and the host budget, called by the session when it is created
+ *
+ * @host_cpu_pct [in]: Host CPU budget, percent of one core
+ * @explore [in]: One decision in explore goes to the path expected to be slower, 0 never
+ */
+void nrLDPC_dispatch_init(uint32_t host_cpu_pct, uint32_t explore);
+
+/**
+ * Route one call: to the host when it is expected to finish sooner there and the host budget allows, to the
+ * DPU otherwise. A call the model has no room for goes to the DPU, untracked. An asynchronous call always goes
+ * to the DPU, tracked: on the host it would run inline on the submitting thread and hold back its next submits.
+ * NRLDPC_HOST=auto therefore only routes blocking calls: nrLDPC_encod_async(), nrLDPC_decod_async() and the rate
+ * matched calls given a task answer go to the DPU whatever their base graph, lifting size or CRC, and only fall
+ * back to the host when the DPU fails them.
+ *
+ * @type [in]: Service of the call
+ * @bg [in]: Base graph
+ * @z [in]: Lifting size
+ * @iters [in]: Decoder iterations, 0 for the encoder
+ * @blocks [in]: Code blocks of the call
+ * @blocking [in]: false for an asynchronous call
+ * @ticket [out]: Decision, to give to nrLDPC_dispatch_done() once the call completes
+ * @return: Path to take
+ */
+enum nrLDPC_route nrLDPC_dispatch_route(enum nrLDPC_service_type type,
+                                        uint8_t bg,
+                                        uint16_t z,
+                                        uint16_t iters,
+                                        uint32_t blocks,
+                                        bool blocking,
+                                        struct nrLDPC_dispatch_ticket *ticket);
+
+/**
+ * Record the outcome of a routed call: its time updates the model of its path, and the host time is charged to
+ * the host budget. Does nothing for a ticket that is not tracked, so it can be called again on the same ticket.
+ *
+ * @ticket [in/out]: Decision of nrLDPC_dispatch_route(), no longer tracked on return
+ * @status [in]: DOCA_SUCCESS when the path produced the output and DOCA_ERROR otherwise
+ */
+void nrLDPC_dispatch_done(struct nrLDPC_dispatch_ticket *ticket, doca_error_t status);
+
+/**
+ * Read the routing counters of a service
+ *
+ * @type [in]: Service
+ * @stats [out]: Counters since the session was created
+ */
+void nrLDPC_dispatch_get_stats(enum nrLDPC_service_type type, struct nrLDPC_dispatch_stats *stats);
+
+/**
+ * Read the model of one kind of call
+ *
+ * @type [in]: Service
+ * @bg [in]: Base graph
+ * @z [in]: Lifting size
+ * @iters [in]: Decoder iterations, 0 for the encoder
+ * @dpu_ns [out]: Expected DPU time of a code block, with no other request outstanding, 0 when not measured
+ * @queue_ns [out]: DPU time each request outstanding adds to it
+ * @host_ns [out]: Expected host time of a code block, 0 when not measured
+ * @return: true when the model has an entry for the call
+ */
+bool nrLDPC_dispatch_estimate(enum nrLDPC_service_type type,
+                              uint8_t bg,
+                              uint16_t z,
+                              uint16_t iters,
+                              uint64_t *dpu_ns,
+                              uint64_t *queue_ns,
+                              uint64_t *host_ns);
+
+/**
+ * Log the routing counters of both services, called by the session when it is destroyed
+ */
+void nrLDPC_dispatch_report(void);
+
+#endif // NRLDPC_DISPATCH_H_
@@ -22,14 +22,18 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
-#include <doca_argp.h>
 #include <doca_dev.h>
 #include <doca_log.h>
 
 #include "comch_ctrl_path_common.h"
+#include "nrLDPC_dispatch.h"
+#include "nrLDPC_host_encod.h"
+#include "nrLDPC_proto.h"
+#include "nrLDPC_ratematch.h"
+#include "nrLDPC_session.h"
 
-#define DEFAULT_PCI_ADDR "b1:00.0"
 #define DEFAULT_MESSAGE "Message from the client"                                         /* VBrusse */
 
 
@@ -59,9 +63,20 @@ extern int32_t LDPCencoder(uint8_t **input, uint8_t *output, encoder_implemparam
 DOCA_LOG_REGISTER(NRLDPC_ENCOD_CLIENT::MAIN);
 
 /* DOCA comch client's logic */
-doca_error_t start_nrLDPC_encod_client(const char *server_name,
-                                       const char *dev_pci_addr,
-                                       struct ldpc_encod_params_t *pldpc_encod_params);
+doca_error_t start_nrLDPC_encod_client(const struct nrLDPC_proto_hdr *hdr,
+                                     const uint8_t *const *segs,
+                                     const struct nrLDPC_proto_rm *rm,
+                                     uint32_t num_segs,
+                                     bool input_packed,
+                                     uint8_t *output);
+doca_error_t start_nrLDPC_encod_client_async(const struct nrLDPC_proto_hdr *hdr,
+                                           const uint8_t *const *segs,
+                                           const struct nrLDPC_proto_rm *rm,
+                                           uint32_t num_segs,
+                                           bool input_packed,
+                                           uint8_t *output,
+                                           const struct nrLDPC_dispatch_ticket *ticket,
+                                           task_ans_t *ans);
 
 
 /*
@@ -341,21 +356,82 @@ doca_error_t start_nrLDPC_encod_client(const char *server_name,
         uint8_t c[22 * 384]; //padded input, unpacked, max size
         uint8_t d[68 * 384]; // coded output, unpacked, max size
 */
-int32_t nrLDPC_encod_offloading(uint8_t **inputArr, uint8_t *outputArr, encoder_implemparams_t *impp)
+/**
+ * Encode segments on the host CPU, the fallback of the DPU encoder service (see nrLDPC_host_encod.h)
+ *
+ * @hdr [in]: Segment parameters: bg, z, k, n and f, shared by all segments
+ * @segs [in]: Input bits of each segment
+ * @rm [in]: Rate matching of each segment, NULL for the codewords
+ * @num_segs [in]: Number of segments
+ * @input_packed [in]: Layout of the segments
+ * @output [out]: Codewords, one bit per byte, n bytes per segment back to back, or the rm[i].e rate matched
+ * bits of each segment back to back
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t encod_host(const struct nrLDPC_proto_hdr *hdr,
+                               const uint8_t *const *segs,
+                               const struct nrLDPC_proto_rm *rm,
+                               uint32_t num_segs,
+                               bool input_packed,
+                               uint8_t *output)
 {
-        struct comch_config cfg = {0};                  /* Antes de incluir a estrutura ldpc nao precisava inicializar */
-        const char *server_name = "nrLDPC_encod_server";
+        uint32_t i;
         doca_error_t result;
-        struct doca_log_backend *sdk_log;
-        int exit_status = EXIT_FAILURE;
 
+        for (i = 0; rm != NULL && i < num_segs; i++) {
+                nrLDPC_rm_count_encod_host();
+                result = nrLDPC_rm_encod(hdr->bg, hdr->z, hdr->k, &rm[i], segs[i], input_packed, output);
+                if (result != DOCA_SUCCESS)
+                        return result;
+                output += rm[i].e;
+        }
+        if (rm != NULL)
+                return DOCA_SUCCESS;
+
+        for (i = 0; i < num_segs; i++) {
+                result = nrLDPC_host_encod(hdr->bg,
+                                           hdr->z,
+                                           hdr->k,
+                                           hdr->f,
+                                           segs[i],
+                                           input_packed,
+                                           output + (size_t)i * hdr->n);
+                if (result != DOCA_SUCCESS)
+                        return result;
+        }
+
+        return DOCA_SUCCESS;
+}
 
-        int argc = 3;                                                   /* VBrusse */
-        char *argv[] = {
-                "nrLDPC_encod_client",
-                "-p",
-                "03:00.0"                                               /* VBrusse - pcie address = "03:00.0", representor address = "b1:00.0" */
-        };                                                              /* client connection with -r, server connection with -p and -r */
+/**
+ * Offload the encoding of one OAI call, synchronously or, when ans is set, asynchronously. The host CPU encodes
+ * instead as NRLDPC_HOST says: when the session cannot be set up or the DPU fails, always, or with auto when the
+ * dispatcher expects it to finish sooner. A rate matched call is encoded on the host when the encoder server does
+ * not rate match, see nrLDPC_session_features().
+ *
+ * @inputArr [in]: Segments
+ * @outputArr [out]: Codewords when pencod_params->output is NULL
+ * @impp [in]: OAI encoder parameters
+ * @rm [in]: Rate matching of each segment, indexed as inputArr, NULL to get the codewords
+ * @ans [in]: Task answer completed when the codewords are written, NULL to wait for them here
+ * @return: EXIT_SUCCESS on success and EXIT_FAILURE otherwise
+ */
+static int32_t encod_offload(uint8_t **inputArr,
+                             uint8_t *outputArr,
+                             encoder_implemparams_t *impp,
+                             const struct nrLDPC_proto_rm *rm,
+                             task_ans_t *ans)
+{
+        struct nrLDPC_proto_hdr hdr = {0};
+        struct nrLDPC_dispatch_ticket ticket = {0};
+        struct nrLDPC_session_cfg env_cfg;
+        const struct nrLDPC_session_cfg *cfg;
+        struct nrLDPC_session *s;
+        uint32_t first_seg = 0;
+        uint32_t num_segs = 1;
+        uint8_t *output = outputArr;
+        uint32_t i;
+        doca_error_t result;
 
         struct oai_encoder_params_t oai_ldpc_encod = {                  /* VBrusse: the useful ldpc encoder input data */
                 .inputArray = *inputArr,                                /* single code block iinput as a sequence of bits to be transmitted */
@@ -367,118 +443,129 @@ int32_t nrLDPC_encod_offloading(uint8_t **inputArr, uint8_t *outputArr, encoder_
                 .F = impp->F                                            /* Number of "Filler" bits */
         };
 
-
-/*      oai_ldpc_encod.inputArray = *inputArr;                          single code block iinput as a sequence of bits to be transmitted */
-/*      oai_ldpc_encod.outputArray = outputArr;                         ldpc output as a sequence of encoded bits (codeword) */
-/*      oai_ldpc_encod.BG = impp->BG;                                   selected Base Graph (BG) */
-/*      oai_ldpc_encod.Zc = impp->Zc;                                   Lifting Size (Zc) */
-/*      oai_ldpc_encod.K = impp->K;                                     Size in bits of the code segments (K) */
-/*      oai_ldpc_encod.Kb = impp->Kb;                                   Number of lifting sizes to fit the payload (Kb) */
-/*      oai_ldpc_encod.F = impp->F;                                     Number of "Filler" bits */
-
-
-        /* cfg.ldpc_encod_params.inputBlock = oai_ldpc_encod.inputArray;        VBrusse */
-        strcpy((char *)cfg.ldpc_encod_params.inputBlock, (char *)oai_ldpc_encod.inputArray);
-        /* cfg.ldpc_encod_params.outputBlock = oai_ldpc_encod.outputArray; */
-        cfg.ldpc_encod_params.bg = oai_ldpc_encod.BG;
-        cfg.ldpc_encod_params.z = oai_ldpc_encod.Zc;
-        cfg.ldpc_encod_params.k = oai_ldpc_encod.K;
-        // cfg.ldpc_encod_params.kb = oai_ldpc_encod.Kb;
-        cfg.ldpc_encod_params.len_filler_bits = oai_ldpc_encod.F;
-
-        printf("*** [nrLDPC_encod_offloading] Input Block (cfg.ldpc_encod_params) ===> %s\n", (char *)cfg.ldpc_encod_params.inputBlock);
-        printf("*** BG = %d\n", cfg.ldpc_encod_params.bg);
-        printf("*** Zc = %d\n", cfg.ldpc_encod_params.z);
-        printf("*** K = %d\n", cfg.ldpc_encod_params.k);
-        // printf("*** Kb = %d\n", cfg.ldpc_encod_params.kb);
-        printf("*** F = %d\n\n", cfg.ldpc_encod_params.len_filler_bits);
-
-
-
-
-        /* Set the default configuration values, client so no need for the comch_dev_rep_pci_addr field */
-        strcpy(cfg.comch_dev_pci_addr, DEFAULT_PCI_ADDR);
-
-        /* Register a logger backend */
-        result = doca_log_backend_create_standard();
-        if (result != DOCA_SUCCESS)
-                goto sample_exit;
-
-        /* Register a logger backend for internal SDK errors and warnings */
-        result = doca_log_backend_create_with_file_sdk(stderr, &sdk_log);
-        if (result != DOCA_SUCCESS)
-                goto sample_exit;
-        result = doca_log_backend_set_sdk_level(sdk_log, DOCA_LOG_LEVEL_WARNING);
-        if (result != DOCA_SUCCESS)
-                goto sample_exit;
-
-        DOCA_LOG_INFO("Starting the sample");
-
-
-
-        /* strcpy((char *)cfg.ldpc_encod_params.inputBlock, INPUT_BLOCK_128);              VBrusse
-        DOCA_LOG_INFO("\n\n\n*** Input Block ===> %s", (char *)cfg.ldpc_encod_params.inputBlock);
-        DOCA_LOG_INFO("*** bg = %d", cfg.ldpc_encod_params.bg);
-        DOCA_LOG_INFO("*** z = %d", cfg.ldpc_encod_params.z);
-        DOCA_LOG_INFO("*** k = %d", cfg.ldpc_encod_params.k);
-        DOCA_LOG_INFO("*** kb = %d", cfg.ldpc_encod_params.kb);
-        DOCA_LOG_INFO("*** len_filler_bits = %d\n\n", cfg.ldpc_encod_params.len_filler_bits); */
-
-
-
-        /* Parse cmdline/json arguments */
-        result = doca_argp_init("doca_comch_data_path_client", &cfg);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to init ARGP resources: %s", doca_error_get_descr(result));
-                goto sample_exit;
+        /* The client and its data path are set up once by LDPCinit, see nrLDPC_session.h */
+        s = nrLDPC_session_get();
+        if (s != NULL) {
+                cfg = &s->cfg;
+        } else {
+                nrLDPC_session_cfg_from_env(&env_cfg);
+                cfg = &env_cfg;
+                if (cfg->host_mode == NRLDPC_HOST_OFF)
+                        goto fail;
         }
 
-        result = register_comch_params();
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to register CC client sample parameters: %s", doca_error_get_descr(result));
-                goto argp_cleanup;
+        /*
+         * Transport block: segments first_seg to n_segments - 1 of input[] are encoded in one round trip and
+         * their codewords written back to back to pencod_params->output. n_segments = 0 is the single segment
+         * input[0] encoded into output, as before.
+         */
+        if (impp->n_segments != 0) {
+                if (impp->first_seg >= impp->n_segments || impp->n_segments > NRLDPC_PROTO_ENCOD_MAX_SEGS) {
+                        DOCA_LOG_ERR("Invalid segments %u to %u of a transport block",
+                                     impp->first_seg,
+                                     impp->n_segments - 1);
+                        goto fail;
+                }
+                first_seg = impp->first_seg;
+                num_segs = impp->n_segments - impp->first_seg;
+                if (impp->output != NULL)
+                        output = impp->output;
         }
 
-        result = doca_argp_start(argc, argv);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to parse sample input: %s", doca_error_get_descr(result));
-                goto argp_cleanup;
+        /* Only the K input bits travel, packed, and the N codeword bits come back packed, see nrLDPC_proto.h */
+        hdr.bg = oai_ldpc_encod.BG;
+        hdr.z = oai_ldpc_encod.Zc;
+        hdr.k = oai_ldpc_encod.K;
+        hdr.n = (oai_ldpc_encod.BG == 2 ? 50 : 66) * oai_ldpc_encod.Zc; /* The first 2 * Zc columns are punctured */
+        hdr.f = oai_ldpc_encod.F;
+
+        DOCA_LOG_DBG("Encoding %u blocks: BG = %d, Zc = %d, K = %d, F = %d, N = %d",
+                     num_segs,
+                     hdr.bg,
+                     hdr.z,
+                     hdr.k,
+                     hdr.f,
+                     hdr.n);
+
+        if (hdr.k > NRLDPC_PROTO_ENCOD_MAX_K || hdr.n > NRLDPC_PROTO_ENCOD_MAX_N) {
+                DOCA_LOG_ERR("Segment of K = %u, N = %u bits exceeds the BG1 Zc = 384 limits", hdr.k, hdr.n);
+                goto fail;
         }
 
-        /* Start the client */
-        result = start_nrLDPC_encod_client(server_name, cfg.comch_dev_pci_addr, &cfg.ldpc_encod_params);
+        if (s == NULL || cfg->host_mode == NRLDPC_HOST_ALWAYS)
+                goto host;
+        /* A server that does not rate match leaves the whole call to the host, see nrLDPC_proto.h */
+        if (rm != NULL && (nrLDPC_session_features(NRLDPC_SERVICE_ENCOD) & NRLDPC_PROTO_FEATURE_RM_ENCOD) == 0) {
+                if (cfg->host_mode == NRLDPC_HOST_OFF) {
+                        DOCA_LOG_ERR("The encoder server does not rate match and NRLDPC_HOST is off");
+                        goto fail;
+                }
+                goto host;
+        }
+        /* The DPU returns E bits per segment within the message size of a codeword, more are repeated here */
+        for (i = first_seg; rm != NULL && i < first_seg + num_segs; i++)
+                if (rm[i].e > NRLDPC_PROTO_ENCOD_MAX_N && cfg->host_mode != NRLDPC_HOST_OFF)
+                        goto host;
+        if (cfg->host_mode == NRLDPC_HOST_AUTO &&
+            nrLDPC_dispatch_route(NRLDPC_SERVICE_ENCOD, hdr.bg, hdr.z, 0, num_segs, ans == NULL, &ticket) ==
+                    NRLDPC_ROUTE_HOST)
+                goto host;
+
+        if (ans != NULL)
+                result = start_nrLDPC_encod_client_async(&hdr,
+                                                         (const uint8_t *const *)inputArr + first_seg,
+                                                         rm != NULL ? rm + first_seg : NULL,
+                                                         num_segs,
+                                                         cfg->encod_input_packed,
+                                                         output,
+                                                         &ticket,
+                                                         ans);
+        else
+                result = start_nrLDPC_encod_client(&hdr,
+                                                   (const uint8_t *const *)inputArr + first_seg,
+                                                   rm != NULL ? rm + first_seg : NULL,
+                                                   num_segs,
+                                                   cfg->encod_input_packed,
+                                                   output);
+        /* The asynchronous call records its outcome when its last request completes */
+        if (ans == NULL)
+                nrLDPC_dispatch_done(&ticket, result);
+        if (result == DOCA_SUCCESS)
+                return EXIT_SUCCESS;
+        /* The asynchronous call completed ans in any case, its callbacks encoded the failed requests on the host */
+        if (ans != NULL || cfg->host_mode == NRLDPC_HOST_OFF) {
+                DOCA_LOG_ERR("Failed to offload the LDPC encoding: %s", doca_error_get_descr(result));
+                return EXIT_FAILURE;
+        }
+        DOCA_LOG_DBG("Failed to offload the LDPC encoding: %s, encoding on the host", doca_error_get_descr(result));
+
+host:
+        result = encod_host(&hdr,
+                            (const uint8_t *const *)inputArr + first_seg,
+                            rm != NULL ? rm + first_seg : NULL,
+                            num_segs,
+                            cfg->encod_input_packed,
+                            output);
+        nrLDPC_dispatch_done(&ticket, result);
+        if (ans != NULL)
+                completed_task_ans(ans);
         if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to run sample: %s", doca_error_get_descr(result));
-                goto argp_cleanup;
+                DOCA_LOG_ERR("Failed to encode on the host: %s", doca_error_get_descr(result));
+                return EXIT_FAILURE;
         }
 
+        return EXIT_SUCCESS;
 
+fail:
+        /* The asynchronous caller waits for its answer whatever happens */
+        if (ans != NULL)
+                completed_task_ans(ans);
+        return EXIT_FAILURE;
+}
 
-
-        // *outputArr = &cfg.ldpc_encod_params.outputBlock[0];
-
-        memcpy(outputArr, cfg.ldpc_encod_params.outputBlock, 128);
-
-        /* \n\n\n*** ==========> nrLDPC_encod <========== ***");
-        DOCA_LOG_INFO("*** Input Block ===> %s", (char *)cfg.ldpc_encod_params.inputBlock);
-        DOCA_LOG_INFO("*** bg = %d", cfg.ldpc_encod_params.bg);
-        DOCA_LOG_INFO("*** z = %d", cfg.ldpc_encod_params.z);
-        DOCA_LOG_INFO("*** k = %d", cfg.ldpc_encod_params.k);
-        DOCA_LOG_INFO("*** kb = %d", cfg.ldpc_encod_params.kb);
-        DOCA_LOG_INFO("*** len_filler_bits = %d", cfg.ldpc_encod_params.len_filler_bits);
-        DOCA_LOG_INFO("\n\n*** AQUI - Output Block ===> %s\n\n", (char *)cfg.ldpc_encod_params.outputBlock);    */
-
-
-        exit_status = EXIT_SUCCESS;
-
-argp_cleanup:
-        doca_argp_destroy();
-sample_exit:
-        if (exit_status == EXIT_SUCCESS)
-                DOCA_LOG_INFO("Sample finished successfully");
-        else
-                DOCA_LOG_INFO("Sample finished with errors");
-        return exit_status;
+int32_t nrLDPC_encod_offloading(uint8_t **inputArr, uint8_t *outputArr, encoder_implemparams_t *impp)
+{
+        return encod_offload(inputArr, outputArr, impp, NULL, NULL);
 }
 
 /*
@@ -526,28 +613,95 @@ int32_t nrLDPC_encod(uint8_t **input, uint8_t *output, encoder_implemparams_t *p
 {
         int exit_status = EXIT_FAILURE;
 
-
-        /* printf("\n\n\n*** [nrLDPC_encod] Input Block ===> %s\n", (char *)input); */
-        printf("*** [nrLDPC_encod] Input Block ===> %s\n", (char *)*input);
-        printf("*** BG = %d\n", pencod_params->BG);
-        printf("*** Zc = %d\n", pencod_params->Zc);
-        printf("*** K = %d\n", pencod_params->K);
-        printf("*** K = %d\n", pencod_params->Kb);
-        printf("*** F = %d\n\n", pencod_params->F);
-
+        DOCA_LOG_DBG("[nrLDPC_encod] BG = %d, Zc = %d, K = %d, Kb = %d, F = %d",
+                     pencod_params->BG,
+                     pencod_params->Zc,
+                     pencod_params->K,
+                     pencod_params->Kb,
+                     pencod_params->F);
 
         exit_status = nrLDPC_encod_offloading(input, output, pencod_params);
+        if (exit_status != EXIT_SUCCESS)
+                DOCA_LOG_ERR("[nrLDPC_encod] Failed to call the nrLDPC_encod_offloading function");
 
+        return (exit_status == EXIT_FAILURE ? EXIT_FAILURE : EXIT_SUCCESS);
+}
 
-        exit_status = EXIT_SUCCESS;
-        if (exit_status != EXIT_SUCCESS) {
-                printf("[nrLDPC_encod] Failed to call the nrLDPC_encod_offloading function\n");
+/*
+ * nrLDPC_encod_async - Asynchronous nrLDPC_encod for the OAI thread pool: returns as soon as the segments are
+ * sent to the DPU, the calling worker can keep more code blocks in flight and go on with other High-PHY work.
+ * When the codewords are written, pencod_params->ans is completed the way OAI's completed_task_ans() does:
+ * its counter is decremented and its semaphore posted when the counter reaches 0, so join_task_ans() on it
+ * waits for all the calls sharing it. It is completed exactly once per call, also when the call fails.
+ *
+ * @input [in]: Segments, read before the function returns
+ * @output [out]: Codewords when pencod_params->output is NULL, written when ans is completed
+ * @pencod_params [in]: OAI encoder parameters, ans must be set
+ *
+ * @return: EXIT_SUCCESS when the encoding is submitted and EXIT_FAILURE otherwise
+ */
+int32_t nrLDPC_encod_async(uint8_t **input, uint8_t *output, encoder_implemparams_t *pencod_params)
+{
+        if (pencod_params->ans == NULL) {
+                DOCA_LOG_ERR("[nrLDPC_encod_async] No task answer to complete");
+                return EXIT_FAILURE;
         }
 
-        DOCA_LOG_INFO("\n\n[nrLDPC_encod] ==========> Block encoded <========== ***");
-        DOCA_LOG_INFO("*** Output Block ===> %s\n\n", (char *)output);
-
+        return encod_offload(input, output, pencod_params, NULL, pencod_params->ans);
+}
 
+/*
+ * nrLDPC_encod_rm - nrLDPC_encod returning the segments rate matched: the E bits of the bit selection and bit
+ * interleaving of TS 38.212 5.4.2, ready for scrambling, instead of the N bits of each codeword. The DPU rate
+ * matches the codewords it encodes, so only E bits per segment cross PCIe and the host has no rate matching
+ * pass left; the output is bit-exact with nrLDPC_rm_encod(), which the host runs when it encodes instead.
+ *
+ * @input [in]: As nrLDPC_encod
+ * @output [out]: The E bits of each segment encoded, one bit per byte, back to back, when
+ * pencod_params->output is NULL
+ * @pencod_params [in]: As nrLDPC_encod, the segments are first_seg to n_segments - 1, or input[0] alone
+ * @perCB [in]: E_cb, the rate matched bits of each segment, indexed as input, a multiple of Qm
+ * @rv [in]: Redundancy version, 0 to 3
+ * @Qm [in]: Modulation order, bits per symbol
+ * @Ncb [in]: Circular buffer length, 66 * Zc for BG1 and 50 * Zc for BG2 unless limited (LBRM)
+ * @ans [in]: OAI task answer to complete as nrLDPC_encod_async, NULL to wait for the bits here
+ *
+ * @return: EXIT_SUCCESS on success and EXIT_FAILURE otherwise
+ */
+int32_t nrLDPC_encod_rm(uint8_t **input,
+                        uint8_t *output,
+                        encoder_implemparams_t *pencod_params,
+                        const nrLDPC_params_per_cb_t *perCB,
+                        uint8_t rv,
+                        uint8_t Qm,
+                        uint32_t Ncb,
+                        task_ans_t *ans)
+{
+        struct nrLDPC_proto_rm rm[NRLDPC_PROTO_ENCOD_MAX_SEGS];
+        uint32_t segs = pencod_params->n_segments != 0 ? pencod_params->n_segments : 1;
+        uint32_t i;
+
+        for (i = 0; i < segs && segs <= NRLDPC_PROTO_ENCOD_MAX_SEGS; i++) {
+                memset(&rm[i], 0, sizeof(rm[i]));
+                rm[i].e = perCB[i].E_cb;
+                rm[i].ncb = (uint16_t)Ncb;
+                rm[i].f = (uint16_t)pencod_params->F;
+                rm[i].rv = rv;
+                rm[i].qm = Qm;
+                if (i >= pencod_params->first_seg &&
+                    nrLDPC_rm_check(pencod_params->BG, pencod_params->Zc, &rm[i]) != DOCA_SUCCESS)
+                        break;
+        }
+        if (segs > NRLDPC_PROTO_ENCOD_MAX_SEGS || i < segs || pencod_params->F > UINT16_MAX || Ncb > UINT16_MAX) {
+                DOCA_LOG_ERR("[nrLDPC_encod_rm] Invalid rate matching of %u segments: rv = %d, Qm = %d, Ncb = %u",
+                             segs,
+                             rv,
+                             Qm,
+                             Ncb);
+                if (ans != NULL)
+                        completed_task_ans(ans);
+                return EXIT_FAILURE;
+        }
 
-        return (exit_status == EXIT_FAILURE ? EXIT_FAILURE : EXIT_SUCCESS);
+        return encod_offload(input, output, pencod_params, rm, ans);
 }
@@ -22,551 +22,546 @@
  *
  */
 
-#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
-#include <time.h>
-#include <unistd.h>
-
-#include <doca_buf.h>
-#include <doca_buf_inventory.h>
-#include <doca_comch.h>
-#include <doca_comch_consumer.h>
-#include <doca_comch_producer.h>
-#include <doca_ctx.h>
-#include <doca_dev.h>
+
 #include <doca_error.h>
 #include <doca_log.h>
-#include <doca_mmap.h>
-#include <doca_pe.h>
 
 #include "comch_ctrl_path_common.h"
-#include "nrLDPC_common.h"
-/* #include "nrLDPC_encod_common.h"                     VBrusse */
-#include "common.h"
+#include "nrLDPC_bits.h"
+#include "nrLDPC_dispatch.h"
+#include "nrLDPC_host_encod.h"
+#include "nrLDPC_proto.h"
+#include "nrLDPC_ratematch.h"
+#include "nrLDPC_session.h"
 
 DOCA_LOG_REGISTER(NRLDPC_ENCOD_CLIENT);
 
-/* Sample's objects */
-struct comch_data_path_client_objects {
-        struct doca_dev *hw_dev;                   /* Device used in the sample */
-        struct doca_pe *pe;                        /* PE object used in the sample */
-        struct doca_comch_client *client;          /* Client object used in the sample */
-        struct doca_comch_connection *connection;  /* CC connection object used in the sample */
-        doca_error_t client_result;                /* Holds result will be updated in client callbacks */
-        bool client_finish;                        /* Controls whether client progress loop should be run */
-        bool data_path_test_started;               /* Indicate whether we can start data_path test */
-        bool data_path_test_stopped;               /* Indicate whether we can stop data_path test */
-        struct comch_data_path_objects *data_path; /* Data path objects */
+/* Per thread staging buffer of the requests and responses, sized for the largest transport block seen */
+struct encod_client_buf {
+        uint8_t *mem; /* Requests, then responses */
+        size_t size;  /* Size of mem */
 };
 
+static pthread_key_t encod_buf_key;                     /* Owns the encod_client_buf of each thread */
+static pthread_once_t encod_buf_once = PTHREAD_ONCE_INIT; /* Creates encod_buf_key */
+
 /**
- * Callback for client send task successful completion
+ * Release the staging buffer of an exiting thread
  *
- * @task [in]: Send task object
- * @task_user_data [in]: User data for task
- * @ctx_user_data [in]: User data for context
+ * @arg [in]: The thread encod_client_buf
  */
-static void client_send_task_completion_callback(struct doca_comch_task_send *task,
-                                                 union doca_data task_user_data,
-                                                 union doca_data ctx_user_data)
+static void encod_buf_free(void *arg)
 {
-        struct comch_data_path_client_objects *sample_objects;
-
-        (void)task_user_data;
+        struct encod_client_buf *buf = arg;
 
-        sample_objects = (struct comch_data_path_client_objects *)(ctx_user_data.ptr);
-        sample_objects->client_result = DOCA_SUCCESS;
+        free(buf->mem);
+        free(buf);
+}
 
+/*
+ * Create the key of the per thread staging buffers
+ */
+static void encod_buf_key_create(void)
+{
+        (void)pthread_key_create(&encod_buf_key, encod_buf_free);
+}
 
+/**
+ * Get the staging buffer of the calling thread, growing it to at least size bytes
+ *
+ * @size [in]: Bytes needed
+ * @return: The buffer on success and NULL otherwise
+ */
+static uint8_t *encod_buf_get(size_t size)
+{
+        struct encod_client_buf *buf;
+        uint8_t *mem;
+
+        pthread_once(&encod_buf_once, encod_buf_key_create);
+        buf = pthread_getspecific(encod_buf_key);
+        if (buf == NULL) {
+                buf = calloc(1, sizeof(*buf));
+                if (buf == NULL || pthread_setspecific(encod_buf_key, buf) != 0) {
+                        free(buf);
+                        return NULL;
+                }
+        }
 
-/*      DOCA_LOG_INFO("Client enviou mensagem: %s", sample_objects->data_path->text);               VBrusse */
+        if (buf->size < size) {
+                mem = realloc(buf->mem, size);
+                if (mem == NULL)
+                        return NULL;
+                buf->mem = mem;
+                buf->size = size;
+        }
 
+        return buf->mem;
+}
 
+/* Requests of one encoding call, laid out in the staging buffer */
+struct encod_msgs {
+        const void *reqs[NRLDPC_PROTO_ENCOD_MAX_SEGS];   /* Request messages */
+        void *resps[NRLDPC_PROTO_ENCOD_MAX_SEGS];        /* Response buffers */
+        uint32_t req_lens[NRLDPC_PROTO_ENCOD_MAX_SEGS];  /* Request message lengths */
+        uint32_t resp_lens[NRLDPC_PROTO_ENCOD_MAX_SEGS]; /* Response message lengths */
+        uint32_t resp_size;                               /* Size of each response buffer */
+        uint32_t num_msgs;                                /* Number of requests */
+        uint32_t segs_per_msg;                            /* Segments of each request, fewer in the last one */
+};
 
-        DOCA_LOG_INFO("Client task sent successfully");
-        doca_task_free(doca_comch_task_send_as_task(task));
-}
+/* Asynchronous encoding call, freed by the completion of its last request */
+struct encod_async_ctx {
+        uint32_t n;                           /* Codeword bits of each segment */
+        uint32_t segs_per_msg;                /* Segments of each request */
+        uint8_t *output;                      /* Codewords or rate matched bits, one bit per byte */
+        task_ans_t *ans;                      /* Signalled once all requests completed */
+        _Atomic(uint32_t) remaining;          /* Requests not completed yet, plus the submitter reference */
+        uint32_t seg_in;                      /* Packed input bytes of each segment */
+        uint8_t *host_input;                  /* Packed segments kept for the host fallback, NULL without it */
+        struct nrLDPC_proto_rm *rm;           /* Rate matching of each segment, NULL for the codewords */
+        struct nrLDPC_dispatch_ticket ticket; /* Routing decision, its outcome recorded by the last completion */
+        doca_error_t dpu_status;              /* First error of the DPU, DOCA_SUCCESS when none */
+        struct nrLDPC_proto_hdr req_hdrs[];   /* Header of each request */
+};
 
 /**
- * Callback for client send task completion with error
+ * Output position of a segment: the codewords are N bits each, the rate matched segments E bits each
  *
- * @task [in]: Send task object
- * @task_user_data [in]: User data for task
- * @ctx_user_data [in]: User data for context
+ * @n [in]: Codeword bits of each segment
+ * @rm [in]: Rate matching of each segment, NULL for the codewords
+ * @seg [in]: Index of the segment
+ * @return: Position of its first bit
  */
-static void client_send_task_completion_err_callback(struct doca_comch_task_send *task,
-                                                     union doca_data task_user_data,
-                                                     union doca_data ctx_user_data)
+static size_t encod_out_offset(uint32_t n, const struct nrLDPC_proto_rm *rm, uint32_t seg)
 {
-        struct comch_data_path_client_objects *sample_objects;
+        size_t offset = 0;
+        uint32_t i;
 
-        (void)task_user_data;
+        if (rm == NULL)
+                return (size_t)seg * n;
+        for (i = 0; i < seg; i++)
+                offset += rm[i].e;
 
-        sample_objects = (struct comch_data_path_client_objects *)(ctx_user_data.ptr);
-        sample_objects->client_result = doca_task_get_status(doca_comch_task_send_as_task(task));
-        DOCA_LOG_ERR("Message failed to send with error = %s", doca_error_get_name(sample_objects->client_result));
-        doca_task_free(doca_comch_task_send_as_task(task));
-        (void)doca_ctx_stop(doca_comch_client_as_ctx(sample_objects->client));
+        return offset;
 }
 
 /**
- * Callback for client message recv event
+ * Build the requests carrying a set of segments: as few as the encoder message size allows
  *
- * @event [in]: Recv event object
- * @recv_buffer [in]: Message buffer
- * @msg_len [in]: Message len
- * @comch_connection [in]: Connection the message was received on
+ * @hdr [in]: Segment parameters: bg, z, k, n and f, shared by all segments
+ * @segs [in]: Input bits of each segment, packed, or one bit per byte when input_packed is false
+ * @rm [in]: Rate matching of each segment, NULL to get the codewords
+ * @num_segs [in]: Number of segments
+ * @input_packed [in]: Layout of the segments
+ * @msgs [out]: The requests, in the calling thread staging buffer
+ * @req_hdrs [out]: Header of each request, NRLDPC_PROTO_ENCOD_MAX_SEGS entries
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
-static void client_message_recv_callback(struct doca_comch_event_msg_recv *event,
-                                         uint8_t *recv_buffer,
-                                         uint32_t msg_len,
-                                         struct doca_comch_connection *comch_connection)
+static doca_error_t encod_build_msgs(const struct nrLDPC_proto_hdr *hdr,
+                                     const uint8_t *const *segs,
+                                     const struct nrLDPC_proto_rm *rm,
+                                     uint32_t num_segs,
+                                     bool input_packed,
+                                     struct encod_msgs *msgs,
+                                     struct nrLDPC_proto_hdr *req_hdrs)
 {
-        union doca_data user_data;
-        struct doca_comch_client *comch_client;
-        struct comch_data_path_client_objects *sample_objects;
-        doca_error_t result;
-
-        (void)event;
-
-        DOCA_LOG_INFO("Message received: '%.*s'", (int)msg_len, recv_buffer);                   /* Recebe a resposta do server no recv_buffer */
-
-
-/*
-        if (strncmp(CC_LDPC_RES, (char *)recv_buffer, 1) == 0) {                                VBrusse
-                DOCA_LOG_INFO("Cliente recebeu mensagem do Servidor");
+        uint32_t seg_in = nrLDPC_bits_bytes(hdr->k);
+        uint32_t seg_req = seg_in + (rm != NULL ? sizeof(*rm) : 0);
+        uint32_t seg_out = nrLDPC_bits_bytes(hdr->n);
+        uint32_t max_payload = nrLDPC_session_max_msg_size(NRLDPC_SERVICE_ENCOD) - sizeof(struct nrLDPC_proto_hdr);
+        uint32_t req_size;
+        uint32_t first, cnt;
+        uint32_t m, i;
+        uint8_t *mem;
+        uint8_t *dst;
+        uint8_t *in;
+
+        /* A rate matched segment returns E bits, the requests are sized for the largest E of the call */
+        for (i = 0; rm != NULL && i < num_segs && i < NRLDPC_PROTO_ENCOD_MAX_SEGS; i++) {
+                if (rm[i].f != hdr->f || rm[i].e > NRLDPC_PROTO_ENCOD_MAX_N) {
+                        DOCA_LOG_ERR("encod request segment %u: E = %u, F = %u, the DPU rate matches E = %u at most "
+                                     "with the F = %u of the call",
+                                     i,
+                                     rm[i].e,
+                                     rm[i].f,
+                                     NRLDPC_PROTO_ENCOD_MAX_N,
+                                     hdr->f);
+                        return DOCA_ERROR_INVALID_VALUE;
+                }
+                if (i == 0 || nrLDPC_bits_bytes(rm[i].e) > seg_out)
+                        seg_out = nrLDPC_bits_bytes(rm[i].e);
         }
-*/
 
-
-        comch_client = doca_comch_client_get_client_ctx(comch_connection);
-
-        result = doca_ctx_get_user_data(doca_comch_client_as_ctx(comch_client), &user_data);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to get user data from ctx with error = %s", doca_error_get_name(result));
-                return;
+        if (num_segs == 0 || num_segs > NRLDPC_PROTO_ENCOD_MAX_SEGS || (rm == NULL && seg_out < seg_in) ||
+            seg_out > max_payload || seg_req > max_payload) {
+                DOCA_LOG_ERR("encod request of %u segments, K = %u, N = %u does not fit the %u bytes messages",
+                             num_segs,
+                             hdr->k,
+                             hdr->n,
+                             max_payload);
+                return DOCA_ERROR_INVALID_VALUE;
         }
 
-        sample_objects = (struct comch_data_path_client_objects *)(user_data.ptr);
+        msgs->segs_per_msg = max_payload / (seg_out > seg_req ? seg_out : seg_req);
+        if (msgs->segs_per_msg > num_segs)
+                msgs->segs_per_msg = num_segs;
+        msgs->num_msgs = (num_segs + msgs->segs_per_msg - 1) / msgs->segs_per_msg;
+        req_size = sizeof(struct nrLDPC_proto_hdr) + msgs->segs_per_msg * seg_req;
+        msgs->resp_size = sizeof(struct nrLDPC_proto_hdr) + msgs->segs_per_msg * seg_out;
+
+        mem = encod_buf_get((size_t)msgs->num_msgs * (req_size + msgs->resp_size));
+        if (mem == NULL)
+                return DOCA_ERROR_NO_MEMORY;
+
+        /*
+         * Lay the segments out right after each request header, behind their rate matching when they have one,
+         * nrLDPC_proto_pack then leaves them in place
+         */
+        for (m = 0; m < msgs->num_msgs; m++) {
+                first = m * msgs->segs_per_msg;
+                cnt = num_segs - first < msgs->segs_per_msg ? num_segs - first : msgs->segs_per_msg;
+                dst = mem + (size_t)m * req_size + sizeof(struct nrLDPC_proto_hdr);
+                in = dst;
+                if (rm != NULL) {
+                        memcpy(dst, &rm[first], cnt * sizeof(*rm));
+                        for (i = 0; i < cnt; i++)
+                                nrLDPC_rm_count_encod(hdr->n, rm[first + i].e);
+                        in += cnt * sizeof(*rm);
+                }
+                for (i = 0; i < cnt; i++) {
+                        if (input_packed == true)
+                                memcpy(in + i * seg_in, segs[first + i], seg_in);
+                        else
+                                nrLDPC_bits_pack(segs[first + i], hdr->k, in + i * seg_in);
+                }
 
-        if ((msg_len == strlen(STR_START_DATA_PATH_TEST)) &&
-            (strncmp(STR_START_DATA_PATH_TEST, (char *)recv_buffer, msg_len) == 0))
-                sample_objects->data_path_test_started = true;
-        else if ((msg_len == strlen(STR_STOP_DATA_PATH_TEST)) &&
-                 (strncmp(STR_STOP_DATA_PATH_TEST, (char *)recv_buffer, msg_len) == 0)) {
-                sample_objects->data_path_test_stopped = true;
-                sample_objects->data_path->remote_consumer_id = INVALID_CONSUMER_ID;
-                (void)doca_ctx_stop(doca_comch_client_as_ctx(sample_objects->client));
+                req_hdrs[m] = *hdr;
+                req_hdrs[m].op = NRLDPC_PROTO_OP_ENCOD_REQ;
+                req_hdrs[m].req_id = nrLDPC_proto_next_req_id();
+                req_hdrs[m].num_segs = cnt;
+                if (rm != NULL)
+                        req_hdrs[m].flags |= NRLDPC_PROTO_FLAG_RATE_MATCHED;
+                msgs->reqs[m] = mem + (size_t)m * req_size;
+                msgs->req_lens[m] = nrLDPC_proto_pack(mem + (size_t)m * req_size,
+                                                      req_size,
+                                                      &req_hdrs[m],
+                                                      dst,
+                                                      cnt * seg_req);
+                msgs->resps[m] = mem + (size_t)msgs->num_msgs * req_size + (size_t)m * msgs->resp_size;
         }
+
+        return DOCA_SUCCESS;
 }
 
 /**
- * Client sends a message to server
+ * Check the response of one request and unpack its codewords or its rate matched bits
  *
- * @sample_objects [in]: The sample object to use
- * @msg [in]: The msg to send
- * @len [in]: The msg length
+ * @req_hdr [in]: Request header
+ * @rm [in]: Rate matching of the request segments, NULL for the codewords
+ * @resp [in]: Response message
+ * @resp_len [in]: Response message length
+ * @output [out]: Codewords of the request segments, one bit per byte, req_hdr->n bytes per segment, or their
+ * rm[i].e rate matched bits back to back
  * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
-static doca_error_t client_send_msg(struct comch_data_path_client_objects *sample_objects, const char *msg, size_t len)
+static doca_error_t encod_parse_resp(const struct nrLDPC_proto_hdr *req_hdr,
+                                     const struct nrLDPC_proto_rm *rm,
+                                     const void *resp,
+                                     uint32_t resp_len,
+                                     uint8_t *output)
 {
+        struct nrLDPC_proto_hdr resp_hdr;
+        const uint8_t *payload;
+        uint32_t seg_out = nrLDPC_bits_bytes(req_hdr->n);
+        uint32_t expected = 0;
+        uint32_t i;
         doca_error_t result;
-        struct doca_comch_task_send *task;
-
-
-
-        /* strcpy((char *)msg, CC_LDPC_REQ); */                                                      /* VBrusse */
-        /* len = CC_LDPC_MSG_SIZE; */
-        /* DOCA_LOG_INFO("Cliente enviou essa mensagem: '%.*s'", (int)len, msg);                        VBrusse inseriu */
-
 
+        result = nrLDPC_proto_unpack(resp, resp_len, &resp_hdr, (const void **)&payload);
+        if (result != DOCA_SUCCESS)
+                return result;
 
-        result = doca_comch_client_task_send_alloc_init(sample_objects->client,
-                                                        sample_objects->connection,
-                                                        (void *)msg,                            /* VBrusse: Formata msg a ser enviada ao server */
-                                                        len,
-                                                        &task);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to allocate client task with error = %s", doca_error_get_name(result));
+        result = nrLDPC_proto_check_resp(req_hdr, &resp_hdr);
+        if (result != DOCA_SUCCESS)
                 return result;
+
+        if (rm != NULL) {
+                for (i = 0; i < req_hdr->num_segs; i++)
+                        expected += nrLDPC_bits_bytes(rm[i].e);
+                if (resp_hdr.payload_len != expected) {
+                        DOCA_LOG_ERR("encod response of %u bytes, expected %u rate matched bytes",
+                                     resp_hdr.payload_len,
+                                     expected);
+                        return DOCA_ERROR_UNEXPECTED;
+                }
+                /* The E bits of each segment, ready for scrambling, back to back */
+                for (i = 0; i < req_hdr->num_segs; i++) {
+                        nrLDPC_bits_unpack(payload, rm[i].e, output);
+                        payload += nrLDPC_bits_bytes(rm[i].e);
+                        output += rm[i].e;
+                }
+                return DOCA_SUCCESS;
         }
 
-        result = doca_task_submit(doca_comch_task_send_as_task(task));                          /* Envia msg ao server */
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to send client task with error = %s", doca_error_get_name(result));
-                doca_task_free(doca_comch_task_send_as_task(task));
-                return result;
+        if (resp_hdr.payload_len != req_hdr->num_segs * seg_out) {
+                DOCA_LOG_ERR("encod response of %u bytes, expected %u codewords of %u bits",
+                             resp_hdr.payload_len,
+                             req_hdr->num_segs,
+                             req_hdr->n);
+                return DOCA_ERROR_UNEXPECTED;
         }
 
+        /* OAI expects one bit per byte, exactly N of them per segment */
+        for (i = 0; i < req_hdr->num_segs; i++)
+                nrLDPC_bits_unpack(payload + i * seg_out,
+                                   req_hdr->n,
+                                   output + (size_t)i * req_hdr->n);
+
         return DOCA_SUCCESS;
 }
 
 /**
- * Callback triggered whenever CC client context state changes
+ * Run the LDPC encoding of a set of segments on the DPU over the session data path
  *
- * @user_data [in]: User data associated with the CC client context.
- * @ctx [in]: The CC client context that had a state change
- * @prev_state [in]: Previous context state
- * @next_state [in]: Next context state (context is already in this state when the callback is called)
- */
-static void client_state_changed_callback(const union doca_data user_data,
-                                          struct doca_ctx *ctx,
-                                          enum doca_ctx_states prev_state,
-                                          enum doca_ctx_states next_state)
-{
-        (void)ctx;
-        (void)prev_state;
-
-        struct comch_data_path_client_objects *sample_objects = (struct comch_data_path_client_objects *)user_data.ptr;
-
-        switch (next_state) {
-        case DOCA_CTX_STATE_IDLE:
-                DOCA_LOG_INFO("CC client context has been stopped");
-                /* We can stop progressing the PE */
-                sample_objects->client_finish = true;
-                break;
-        case DOCA_CTX_STATE_STARTING:
-                /**
-                 * The context is in starting state, need to progress until connection with server is established.
-                 */
-                DOCA_LOG_INFO("CC client context entered into starting state. Waiting for connection establishment");
-                break;
-        case DOCA_CTX_STATE_RUNNING:
-                /* Get a connection channel */
-                if (sample_objects->connection == NULL) {
-                        sample_objects->client_result =
-                                doca_comch_client_get_connection(sample_objects->client, &sample_objects->connection);
-                        if (sample_objects->client_result != DOCA_SUCCESS) {
-                                DOCA_LOG_ERR("Failed to get connection from cc client with error = %s",
-                                             doca_error_get_name(sample_objects->client_result));
-                                (void)doca_ctx_stop(doca_comch_client_as_ctx(sample_objects->client));
-                        }
-                        DOCA_LOG_INFO("CC client context is running. Get a connection from server");
-                }
-                break;
-        case DOCA_CTX_STATE_STOPPING:
-                /**
-                 * The context is in stopping, this can happen when fatal error encountered or when stopping context.
-                 * doca_pe_progress() will cause all tasks to be flushed, and finally transition state to idle
-                 */
-                DOCA_LOG_INFO("CC client context entered into stopping state. Waiting for connection termination");
-                break;
-        default:
-                break;
-        }
-}
-
-/**
- * Callback for new consumer arrival event
+ * The DOCA Comch client, its connection and the producer/consumer are owned by the session
+ * (see nrLDPC_session.h), this function only exchanges the requests and the responses (see nrLDPC_proto.h).
+ * All the segments travel in one request when they fit in the encoder message size, otherwise in as few
+ * requests as needed, pipelined so that the call still costs a single round trip.
+ * With rm, the DPU rate matches the codewords and returns the E bits of each segment instead (see
+ * nrLDPC_ratematch.h).
  *
- * @event [in]: New remote consumer event object
- * @comch_connection [in]: The connection related to the consumer
- * @id [in]: The ID of the new remote consumer
+ * @hdr [in]: Segment parameters: bg, z, k, n and f, shared by all segments
+ * @segs [in]: Input bits of each segment, packed, or one bit per byte when input_packed is false
+ * @rm [in]: Rate matching of each segment, NULL to get the codewords
+ * @num_segs [in]: Number of segments
+ * @input_packed [in]: Layout of the segments
+ * @output [out]: Codewords, one bit per byte, n bytes per segment back to back, or the rm[i].e rate matched
+ * bits of each segment back to back
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
-static void new_consumer_callback(struct doca_comch_event_consumer *event,
-                                  struct doca_comch_connection *comch_connection,
-                                  uint32_t id)
+doca_error_t start_nrLDPC_encod_client(const struct nrLDPC_proto_hdr *hdr,
+                                     const uint8_t *const *segs,
+                                     const struct nrLDPC_proto_rm *rm,
+                                     uint32_t num_segs,
+                                     bool input_packed,
+                                     uint8_t *output)
 {
-        union doca_data user_data;
-        struct doca_comch_client *comch_client;
-        struct comch_data_path_client_objects *sample_objects;
+        struct nrLDPC_proto_hdr req_hdrs[NRLDPC_PROTO_ENCOD_MAX_SEGS];
+        struct encod_msgs msgs;
+        uint32_t m;
         doca_error_t result;
 
-        (void)event;
+        result = encod_build_msgs(hdr, segs, rm, num_segs, input_packed, &msgs, req_hdrs);
+        if (result != DOCA_SUCCESS)
+                return result;
 
-        comch_client = doca_comch_client_get_client_ctx(comch_connection);
+        result = nrLDPC_session_transact_batch(NRLDPC_SERVICE_ENCOD,
+                                               msgs.num_msgs,
+                                               msgs.reqs,
+                                               msgs.req_lens,
+                                               msgs.resps,
+                                               msgs.resp_size,
+                                               msgs.resp_lens);
+        if (result != DOCA_SUCCESS)
+                return result;
 
-        result = doca_ctx_get_user_data(doca_comch_client_as_ctx(comch_client), &user_data);
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to get user data from ctx with error = %s", doca_error_get_name(result));
-                return;
+        for (m = 0; m < msgs.num_msgs; m++) {
+                result = encod_parse_resp(&req_hdrs[m],
+                                          rm != NULL ? &rm[m * msgs.segs_per_msg] : NULL,
+                                          msgs.resps[m],
+                                          msgs.resp_lens[m],
+                                          output + encod_out_offset(hdr->n, rm, m * msgs.segs_per_msg));
+                if (result != DOCA_SUCCESS)
+                        return result;
         }
 
-        sample_objects = (struct comch_data_path_client_objects *)(user_data.ptr);
-        sample_objects->data_path->remote_consumer_id = id;
-
-        DOCA_LOG_INFO("Got a new remote consumer with ID = [%d]", id);
+        return DOCA_SUCCESS;
 }
 
 /**
- * Callback for expired consumer arrival event
+ * Drop a reference to an asynchronous encoding call, the last one completes the OAI task answer
  *
- * @event [in]: Expired remote consumer event object
- * @comch_connection [in]: The connection related to the consumer
- * @id [in]: The ID of the expired remote consumer
+ * @ctx [in]: The call
  */
-void expired_consumer_encod_callback(struct doca_comch_event_consumer *event,
-                                      struct doca_comch_connection *comch_connection,
-                                      uint32_t id)
+static void encod_async_put(struct encod_async_ctx *ctx)
 {
-        /* These arguments are not in use */
-        (void)event;
-        (void)comch_connection;
-        (void)id;
+        if (atomic_fetch_sub_explicit(&ctx->remaining, 1, memory_order_acq_rel) == 1) {
+                nrLDPC_dispatch_done(&ctx->ticket, ctx->dpu_status);
+                completed_task_ans(ctx->ans);
+                free(ctx);
+        }
 }
 
 /**
- * Clean all sample resources
+ * Encode on the host CPU the segments of a request the DPU failed to encode
  *
- * @sample_objects [in]: Sample objects struct to clean
+ * @ctx [in]: The call, with its host_input
+ * @tag [in]: Index of the request
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
  */
-static void clean_comch_data_path_client_objects(struct comch_data_path_client_objects *sample_objects)
+static doca_error_t encod_async_host(struct encod_async_ctx *ctx, uint32_t tag)
 {
+        const struct nrLDPC_proto_hdr *hdr = &ctx->req_hdrs[tag];
+        uint32_t seg = tag * ctx->segs_per_msg;
+        uint32_t i;
         doca_error_t result;
-        struct timespec ts = {
-                .tv_sec = 0,
-                .tv_nsec = SLEEP_IN_NANOS,
-        };
-
-        if (sample_objects == NULL)
-                return;
-
-        /* Verify client is not already stopped due to a server error */
-        if (sample_objects->client_finish == false) {
-                /* Exchange message with server to make connection is reliable */
-                sample_objects->client_result =
-                        client_send_msg(sample_objects, STR_STOP_DATA_PATH_TEST, strlen(STR_STOP_DATA_PATH_TEST));
-                if (sample_objects->client_result != DOCA_SUCCESS) {
-                        DOCA_LOG_ERR("Failed to submit send task with error = %s",
-                                     doca_error_get_name(sample_objects->client_result));
-                        (void)doca_ctx_stop(doca_comch_client_as_ctx(sample_objects->client));
-                }
-                while (sample_objects->data_path_test_stopped == false) {
-                        if (doca_pe_progress(sample_objects->pe) == 0)
-                                nanosleep(&ts, &ts);
-                }
-                while (sample_objects->client_finish == false) {
-                        if (doca_pe_progress(sample_objects->pe) == 0)
-                                nanosleep(&ts, &ts);
-                }
-        }
-
-        clean_comch_ctrl_path_client(sample_objects->client, sample_objects->pe);
-        sample_objects->client = NULL;
-        sample_objects->pe = NULL;
 
-        if (sample_objects->hw_dev != NULL) {
-                result = doca_dev_close(sample_objects->hw_dev);
+        for (i = 0; i < hdr->num_segs; i++, seg++) {
+                if (ctx->rm != NULL) {
+                        nrLDPC_rm_count_encod_host();
+                        result = nrLDPC_rm_encod(hdr->bg,
+                                                 hdr->z,
+                                                 hdr->k,
+                                                 &ctx->rm[seg],
+                                                 ctx->host_input + (size_t)seg * ctx->seg_in,
+                                                 true,
+                                                 ctx->output + encod_out_offset(ctx->n, ctx->rm, seg));
+                        if (result != DOCA_SUCCESS)
+                                return result;
+                        continue;
+                }
+                result = nrLDPC_host_encod(hdr->bg,
+                                           hdr->z,
+                                           hdr->k,
+                                           hdr->f,
+                                           ctx->host_input + (size_t)seg * ctx->seg_in,
+                                           true,
+                                           ctx->output + (size_t)seg * ctx->n);
                 if (result != DOCA_SUCCESS)
-                        DOCA_LOG_ERR("Failed to close hw device properly with error = %s", doca_error_get_name(result));
-
-                sample_objects->hw_dev = NULL;
+                        return result;
         }
-}
-
-
 
-
-/* VBrusse
- * terminate_comch_data_path_encod_client - This function terminates the producer and consumer
- * instances freeing their resources allocated by host (client) used by LDPC offloading.
- *
- * @data_path [in]: data/input parameters of the LDPC encoding.
- */
-void terminate_comch_data_path_encod_client(struct comch_data_path_objects *data_path)
-{
-        /* Free consumer's mmap and doca_buf resources */
-        clean_comch_consumer(data_path->consumer, data_path->consumer_pe);
-        data_path->consumer = NULL;
-        data_path->consumer_pe = NULL;
-        clean_local_mem_bufs(&data_path->consumer_mem);
-
-        /* Free producer's mmap and doca_buf resources */
-        clean_comch_producer(data_path->producer, data_path->producer_pe);
-        data_path->producer = NULL;
-        data_path->producer_pe = NULL;
-        clean_local_mem_bufs(&data_path->producer_mem);
+        return DOCA_SUCCESS;
 }
 
-
-
-
 /**
- * Initialize sample resources
+ * Completion of one request of an asynchronous encoding call
  *
- * @server_name [in]: Server name to connect to
- * @dev_pci_addr [in]: PCI address to connect over
- * @pldpc_encod_params [in]: Pointer to structure to send to server
- * @sample_objects [in]: Sample objects struct to initialize
- * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ * @user_data [in]: The encod_async_ctx of the call
+ * @tag [in]: Index of the request
+ * @resp [in]: Response message
+ * @resp_len [in]: Response message length
+ * @status [in]: DOCA_SUCCESS when resp holds the response
  */
-static doca_error_t init_comch_data_path_client_objects(const char *server_name,
-                                                        const char *dev_pci_addr,
-                                                        struct ldpc_encod_params_t *pldpc_encod_params,
-                                                        struct comch_data_path_client_objects *sample_objects)
+static void encod_async_done(void *user_data, uint32_t tag, const void *resp, uint32_t resp_len, doca_error_t status)
 {
-        doca_error_t result;
-        struct comch_ctrl_path_client_cb_config client_cb_cfg = {
-                .send_task_comp_cb = client_send_task_completion_callback,
-                .send_task_comp_err_cb = client_send_task_completion_err_callback,
-                .msg_recv_cb = client_message_recv_callback,
-                .data_path_mode = true,
-                .new_consumer_cb = new_consumer_callback,
-                .expired_consumer_cb = expired_consumer_encod_callback,
-                .ctx_user_data = sample_objects,
-                .ctx_state_changed_cb = client_state_changed_callback};
-        struct timespec ts = {
-                .tv_sec = 0,
-                .tv_nsec = SLEEP_IN_NANOS,
-        };
-
-        /* sample_objects->data_path->text = text;                                      VBrusse: comment */
-
-
-
-        /* sample_objects->data_path->pldpc_enc_pars = pldpc_encod_params;      VBrusse */
-        /* DOCA_LOG_INFO("Cliente envia data_path->pldpc_enc_pars ao Servidor"); */
-/*      DOCA_LOG_INFO("*** Input Block ===> %s", (char *)((struct ldpc_encod_params_t *)(sample_objects->data_path->pldpc_enc_pars))->inputBlock);
-        DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_encod_params_t *)(sample_objects->data_path->pldpc_enc_pars))->bg);
-        DOCA_LOG_INFO("*** z = %d", ((struct ldpc_encod_params_t *)(sample_objects->data_path->pldpc_enc_pars))->z);
-        DOCA_LOG_INFO("*** k = %d", ((struct ldpc_encod_params_t *)(sample_objects->data_path->pldpc_enc_pars))->k);
-        DOCA_LOG_INFO("*** len_filler_bits = %d", ((struct ldpc_encod_params_t *)(sample_objects->data_path->pldpc_enc_pars))->len_filler_bits);
-*/
-
-
-
-        /* Open DOCA device according to the given PCI address */
-        result = open_doca_device_with_pci(dev_pci_addr, NULL, &(sample_objects->hw_dev));
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to open Comm Channel DOCA device based on PCI address");
-                return result;
-        }
-        sample_objects->data_path->hw_dev = sample_objects->hw_dev;
-
-        /* Init CC client */
-        result = init_comch_ctrl_path_client(server_name,
-                                             sample_objects->hw_dev,
-                                             &client_cb_cfg,
-                                             &(sample_objects->client),
-                                             &(sample_objects->pe));
-        if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to init cc client with error = %s", doca_error_get_name(result));
-                goto close_hw_dev;
-        }
-        sample_objects->data_path->pe = sample_objects->pe;
-
-        /* Wait connection establishment */
-        while (sample_objects->connection == NULL && sample_objects->client_finish == false) {
-                if (doca_pe_progress(sample_objects->pe) == 0)
-                        nanosleep(&ts, &ts);
-        }
-
-        if (sample_objects->client_finish == true) {
-                clean_comch_data_path_client_objects(sample_objects);
-                return DOCA_ERROR_INITIALIZATION;
+        struct encod_async_ctx *ctx = user_data;
+
+        if (status == DOCA_SUCCESS)
+                status = encod_parse_resp(&ctx->req_hdrs[tag],
+                                          ctx->rm != NULL ? &ctx->rm[tag * ctx->segs_per_msg] : NULL,
+                                          resp,
+                                          resp_len,
+                                          ctx->output + encod_out_offset(ctx->n, ctx->rm, tag * ctx->segs_per_msg));
+        if (status != DOCA_SUCCESS && ctx->dpu_status == DOCA_SUCCESS)
+                ctx->dpu_status = status;
+        if (status != DOCA_SUCCESS && ctx->host_input != NULL) {
+                DOCA_LOG_DBG("Encoding request %u failed on the DPU: %s, encoded on the host",
+                             tag,
+                             doca_error_get_descr(status));
+                status = encod_async_host(ctx, tag);
         }
+        if (status != DOCA_SUCCESS)
+                DOCA_LOG_ERR("Asynchronous encoding request %u failed: %s", tag, doca_error_get_descr(status));
 
-        sample_objects->data_path->connection = sample_objects->connection;
-
-        /* Exchange message with server, to make connection is reliable */
-        sample_objects->client_result =
-                client_send_msg(sample_objects, STR_START_DATA_PATH_TEST, strlen(STR_START_DATA_PATH_TEST));
-        if (sample_objects->client_result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to submit send task with error = %s",
-                             doca_error_get_name(sample_objects->client_result));
-                (void)doca_ctx_stop(doca_comch_client_as_ctx(sample_objects->client));
-                goto destroy_client;
-        }
-        while (sample_objects->data_path_test_started == false) {
-                if (doca_pe_progress(sample_objects->pe) == 0)
-                        nanosleep(&ts, &ts);
-        }
-
-        return DOCA_SUCCESS;
-
-destroy_client:
-        clean_comch_ctrl_path_client(sample_objects->client, sample_objects->pe);
-close_hw_dev:
-        (void)doca_dev_close(sample_objects->hw_dev);
-        return result;
+        encod_async_put(ctx);
 }
 
 /**
- * Run comch_data_path_client sample
+ * Asynchronous start_nrLDPC_encod_client: returns once the requests are sent, the codewords are written to
+ * output and ans is completed (counter decremented, semaphore posted when it reaches 0) when they arrive.
+ * ans is completed exactly once in every case, failures are logged, and returned when known at submission.
+ * With the NRLDPC_HOST fallback, the segments of a request that fails are encoded on the host CPU instead, by
+ * the thread completing it, before ans is completed.
  *
- * @server_name [in]: Server name to connect to
- * @dev_pci_addr [in]: PCI address to connect over
- * @ldpc_encod_params [in/out]: Address of the structure to send to server
- * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ * @hdr [in]: Segment parameters: bg, z, k, n and f, shared by all segments
+ * @segs [in]: Input bits of each segment, read before this function returns
+ * @rm [in]: Rate matching of each segment, NULL to get the codewords, read before this function returns
+ * @num_segs [in]: Number of segments
+ * @input_packed [in]: Layout of the segments
+ * @output [out]: Codewords, one bit per byte, n bytes per segment back to back, or the rm[i].e rate matched
+ * bits of each segment back to back, must stay valid until ans
+ * @ticket [in]: Routing decision of the call, its outcome is recorded once all requests completed, NULL for none
+ * @ans [in]: OAI task answer to complete
+ * @return: DOCA_SUCCESS when the requests are sent and DOCA_ERROR otherwise
  */
-doca_error_t start_nrLDPC_encod_client(const char *server_name,
-                                       const char *dev_pci_addr,
-                                       struct ldpc_encod_params_t *pldpc_encod_params)
+doca_error_t start_nrLDPC_encod_client_async(const struct nrLDPC_proto_hdr *hdr,
+                                           const uint8_t *const *segs,
+                                           const struct nrLDPC_proto_rm *rm,
+                                           uint32_t num_segs,
+                                           bool input_packed,
+                                           uint8_t *output,
+                                           const struct nrLDPC_dispatch_ticket *ticket,
+                                           task_ans_t *ans)
 {
+        struct nrLDPC_session *s = nrLDPC_session_get();
+        bool host_fallback = s != NULL && s->cfg.host_mode != NRLDPC_HOST_OFF;
+        uint32_t seg_in = nrLDPC_bits_bytes(hdr->k);
+        size_t rm_size = rm != NULL && num_segs <= NRLDPC_PROTO_ENCOD_MAX_SEGS ? num_segs * sizeof(*rm) : 0;
+        struct encod_async_ctx *ctx;
+        struct encod_msgs msgs;
+        uint32_t m, seg;
+        size_t skip;
         doca_error_t result;
-        struct comch_data_path_client_objects sample_objects = {0};
-        struct comch_data_path_objects data_path = {0};
-
-
-
-
-        /* VBrusse */
-        printf("*** [start_nrLDPC_encod_client] Input Block (pldpc_encod_params) ===> %s\n", (char *)pldpc_encod_params->inputBlock);
-        printf("*** BG = %d\n", pldpc_encod_params->bg);
-        printf("*** Zc = %d\n", pldpc_encod_params->z);
-        printf("*** K = %d\n", pldpc_encod_params->k);
-        printf("*** F = %d\n\n", pldpc_encod_params->len_filler_bits);
-
-
-
-        data_path.pldpc_enc_pars = (struct ldpc_encod_params_t *)pldpc_encod_params;    /* VBrusse - 2024/12/12 - area de memoria alocada para conter os ldpc data */
-                                                                /* =======> testar se ha necessidade desse comando, uma vez que a area de memoria foi alocada na DU */
-        data_path.pldpc_dec_pars = NULL;
-        data_path.size_ldpc_data = sizeof(struct ldpc_encod_params_t);
 
+        ctx = malloc(sizeof(*ctx) + NRLDPC_PROTO_ENCOD_MAX_SEGS * sizeof(ctx->req_hdrs[0]) + rm_size +
+                     (host_fallback ? (size_t)num_segs * seg_in : 0));
+        if (ctx == NULL) {
+                completed_task_ans(ans);
+                return DOCA_ERROR_NO_MEMORY;
+        }
 
-
-        sample_objects.data_path = &data_path;
-
-        result = init_comch_data_path_client_objects(server_name, dev_pci_addr, pldpc_encod_params, &sample_objects);
+        result = encod_build_msgs(hdr, segs, rm, num_segs, input_packed, &msgs, ctx->req_hdrs);
         if (result != DOCA_SUCCESS) {
-                DOCA_LOG_ERR("Failed to initialize sample with error = %s", doca_error_get_name(result));
+                free(ctx);
+                completed_task_ans(ans);
                 return result;
         }
 
-
-        result = comch_data_path_send_msg(&data_path);
-        if (result != DOCA_SUCCESS)
-                goto exit;
-
-
-        /* VBrusse */
-        DOCA_LOG_INFO("\n\n\n*** ANTES DO recv_msg - Input Block - nrLDPC_encod_client ===> %s", (char *)((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->inputBlock);
-        DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->bg);
-        DOCA_LOG_INFO("*** z = %d", ((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->z);
-        DOCA_LOG_INFO("*** k = %d", ((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->k);
-        DOCA_LOG_INFO("*** len_filler_bits = %d\n\n", ((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->len_filler_bits);
-
-
-
-
-        result = comch_data_path_recv_msg(&data_path);
-        if (result != DOCA_SUCCESS)
-                goto exit;
-
-
-
-        /* VBrusse */
-        /* DOCA_LOG_INFO("\n\n\n*** =====> nrLDPC_encod_client DEPOIS do recv_msg <====="); */
-        /* DOCA_LOG_INFO("*** Input Block ===> %s", (char *)((struct ldpc_encod_params_t *)(data_path->pldpc_enc_pars))->inputBlock); */
-
-        /* DOCA_LOG_INFO("*** Input Block ===> %s", (char *)((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->inputBlock); */
-        /* DOCA_LOG_INFO("*** bg = %d", ((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->bg); */
-        /* DOCA_LOG_INFO("*** z = %d", ((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->z); */
-        /* DOCA_LOG_INFO("*** k = %d", ((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->k); */
-        /* DOCA_LOG_INFO("*** len_filler_bits = %d", ((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->len_filler_bits); */
-        /* DOCA_LOG_INFO("*** Output Block ===> %s\n\n", (char *)((struct ldpc_encod_params_t *)(data_path.pldpc_enc_pars))->outputBlock); */
-
-        /* added by VBrusse */
-        *pldpc_encod_params = *(struct ldpc_encod_params_t *)data_path.pldpc_enc_pars;
-        terminate_comch_data_path_encod_client(&data_path);                           /* free resources allocated by host */
-
-
-
-
-exit:
-        clean_comch_data_path_client_objects(&sample_objects);
-
-        return result != DOCA_SUCCESS ? result : sample_objects.client_result;
+        ctx->n = hdr->n;
+        ctx->segs_per_msg = msgs.segs_per_msg;
+        ctx->output = output;
+        ctx->ans = ans;
+        ctx->seg_in = seg_in;
+        ctx->host_input = NULL;
+        ctx->rm = NULL;
+        ctx->dpu_status = DOCA_SUCCESS;
+        memset(&ctx->ticket, 0, sizeof(ctx->ticket));
+        if (ticket != NULL)
+                ctx->ticket = *ticket;
+
+        if (rm != NULL) {
+                ctx->rm = (struct nrLDPC_proto_rm *)&ctx->req_hdrs[NRLDPC_PROTO_ENCOD_MAX_SEGS];
+                memcpy(ctx->rm, rm, rm_size);
+        }
+        /* The staging buffer is the next call's, keep the packed segments in case the DPU fails to encode them */
+        if (host_fallback == true) {
+                ctx->host_input = (uint8_t *)&ctx->req_hdrs[NRLDPC_PROTO_ENCOD_MAX_SEGS] + rm_size;
+                for (m = 0, seg = 0; m < msgs.num_msgs; seg += ctx->req_hdrs[m].num_segs, m++) {
+                        skip = rm != NULL ? ctx->req_hdrs[m].num_segs * sizeof(*rm) : 0;
+                        memcpy(ctx->host_input + (size_t)seg * seg_in,
+                               (const uint8_t *)msgs.reqs[m] + sizeof(struct nrLDPC_proto_hdr) + skip,
+                               (size_t)ctx->req_hdrs[m].num_segs * seg_in);
+                }
+        }
+        /* One extra reference held until the submission returns, so that ctx outlives the callbacks it triggers */
+        atomic_init(&ctx->remaining, msgs.num_msgs + 1);
+
+        result = nrLDPC_session_submit(NRLDPC_SERVICE_ENCOD,
+                                       msgs.num_msgs,
+                                       msgs.reqs,
+                                       msgs.req_lens,
+                                       encod_async_done,
+                                       ctx);
+        /* The requests that could not be sent completed with the error, and were encoded on the host */
+        if (result != DOCA_SUCCESS && host_fallback == true)
+                result = DOCA_SUCCESS;
+
+        encod_async_put(ctx);
+        return result;
 }
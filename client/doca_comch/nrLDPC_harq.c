@@ -0,0 +1,337 @@
+/*
+ * Filename: nrLDPC_harq.c
+ *
+ * HARQ soft buffers of the decoder, see nrLDPC_harq.h. The same store serves the DPU stand-in and the host
+ * decoder. Finding a buffer is a linear scan: a store holds a few hundred buffers, each combining adds a few
+ * thousand LLRs, so the scan is not what a combining costs.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <doca_log.h>
+
+#include "nrLDPC_harq.h"
+
+DOCA_LOG_REGISTER(NRLDPC_HARQ);
+
+#define HARQ_KEY_USED (1U << 31)                /* Set in the key of every buffer in use */
+#define HARQ_KEY_SEG_BITS 12                    /* Bits of the segment in a key, NR_LDPC_MAX_NUM_CB fits */
+
+/* Counters of the HARQ decodes sent, updated by the calling threads without a lock */
+struct harq_counters {
+        _Atomic(uint64_t) calls;      /* Decodes sent with NRLDPC_PROTO_FLAG_HARQ */
+        _Atomic(uint64_t) retx;       /* Of those, retransmissions */
+        _Atomic(uint64_t) missed;     /* Of those, answered with NRLDPC_PROTO_FLAG_HARQ_MISS */
+        _Atomic(uint64_t) llr_bytes;  /* LLR bytes sent */
+        _Atomic(uint64_t) full_bytes; /* LLR bytes the combined buffers would have taken */
+        _Atomic(uint64_t) releases;   /* HARQ processes released */
+};
+
+static struct harq_counters counters;
+
+static struct nrLDPC_harq_store host_store = {.lock = PTHREAD_MUTEX_INITIALIZER};
+
+/**
+ * Key of the HARQ process of a buffer, the key of the buffer without its segment
+ *
+ * @ulsch_id [in]: ULSCH process
+ * @harq_pid [in]: HARQ process
+ * @return: Process key
+ */
+static uint32_t harq_process_key(uint8_t ulsch_id, uint8_t harq_pid)
+{
+        return (HARQ_KEY_USED >> HARQ_KEY_SEG_BITS) | (uint32_t)ulsch_id << 8 | harq_pid;
+}
+
+/**
+ * Key of the buffer of a code block
+ *
+ * @harq [in]: Code block
+ * @return: Buffer key, never 0
+ */
+static uint32_t harq_key(const struct nrLDPC_proto_harq *harq)
+{
+        return harq_process_key(harq->ulsch_id, harq->harq_pid) << HARQ_KEY_SEG_BITS |
+               (harq->segment & ((1U << HARQ_KEY_SEG_BITS) - 1));
+}
+
+/**
+ * Allocate the buffers of a store, the store must be locked
+ *
+ * @store [in]: Store
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t harq_store_alloc(struct nrLDPC_harq_store *store)
+{
+        uint32_t i;
+
+        if (store->bufs != NULL)
+                return DOCA_SUCCESS;
+        if (store->num_bufs == 0)
+                store->num_bufs = NRLDPC_HARQ_BUFFERS;
+
+        store->bufs = calloc(store->num_bufs, sizeof(*store->bufs));
+        store->mem = malloc((size_t)store->num_bufs * NRLDPC_HARQ_MAX_LLRS);
+        if (store->bufs == NULL || store->mem == NULL) {
+                DOCA_LOG_ERR("Failed to allocate %u HARQ soft buffers", store->num_bufs);
+                free(store->bufs);
+                free(store->mem);
+                store->bufs = NULL;
+                store->mem = NULL;
+                return DOCA_ERROR_NO_MEMORY;
+        }
+        for (i = 0; i < store->num_bufs; i++)
+                store->bufs[i].llrs = store->mem + (size_t)i * NRLDPC_HARQ_MAX_LLRS;
+
+        return DOCA_SUCCESS;
+}
+
+void nrLDPC_harq_store_init(struct nrLDPC_harq_store *store, uint32_t num_bufs)
+{
+        memset(store, 0, sizeof(*store));
+        pthread_mutex_init(&store->lock, NULL);
+        store->num_bufs = num_bufs;
+}
+
+/**
+ * Log the counters of a store and free its buffers, the store must be locked or no longer used
+ *
+ * @store [in]: Store
+ */
+static void harq_store_free(struct nrLDPC_harq_store *store)
+{
+        if (store->evicted != 0 || store->missed != 0)
+                DOCA_LOG_INFO("HARQ soft buffers: %lu reused while in use, %lu retransmissions missed theirs",
+                              (unsigned long)store->evicted,
+                              (unsigned long)store->missed);
+        free(store->bufs);
+        free(store->mem);
+}
+
+void nrLDPC_harq_store_clean(struct nrLDPC_harq_store *store)
+{
+        harq_store_free(store);
+        pthread_mutex_destroy(&store->lock);
+        memset(store, 0, sizeof(*store));
+}
+
+/**
+ * Buffer of a code block, a free or the least recently used one when it has none, the store must be locked
+ *
+ * @store [in]: Store
+ * @key [in]: Buffer key of the code block
+ * @n [in]: LLRs of the code block
+ * @found [out]: The code block had the buffer
+ * @return: Buffer
+ */
+static struct nrLDPC_harq_buf *harq_lookup(struct nrLDPC_harq_store *store, uint32_t key, uint32_t n, bool *found)
+{
+        struct nrLDPC_harq_buf *victim = NULL;
+        struct nrLDPC_harq_buf *buf;
+        uint32_t i;
+
+        for (i = 0; i < store->num_bufs; i++) {
+                buf = &store->bufs[i];
+                if (buf->key == key && buf->n == n) {
+                        *found = true;
+                        return buf;
+                }
+                if (victim == NULL || (victim->key != 0 && (buf->key == 0 || buf->used < victim->used)))
+                        victim = buf;
+        }
+
+        *found = false;
+        if (victim->key != 0)
+                store->evicted++;
+        victim->key = key;
+        victim->n = n;
+        return victim;
+}
+
+doca_error_t nrLDPC_harq_combine(struct nrLDPC_harq_store *store,
+                                 const struct nrLDPC_proto_harq *harq,
+                                 uint32_t n,
+                                 const int8_t *llrs,
+                                 uint32_t len,
+                                 int8_t *combined,
+                                 bool *missed)
+{
+        struct nrLDPC_harq_buf *buf;
+        doca_error_t result;
+        uint32_t pos = harq->offset;
+        int32_t sum;
+        bool found;
+        uint32_t i;
+
+        if (n == 0 || n > NRLDPC_HARQ_MAX_LLRS || len > n || pos >= n) {
+                DOCA_LOG_ERR("Invalid HARQ window: %u LLRs from %u in a soft buffer of %u", len, pos, n);
+                return DOCA_ERROR_INVALID_VALUE;
+        }
+
+        pthread_mutex_lock(&store->lock);
+        result = harq_store_alloc(store);
+        if (result != DOCA_SUCCESS) {
+                pthread_mutex_unlock(&store->lock);
+                return result;
+        }
+
+        buf = harq_lookup(store, harq_key(harq), n, &found);
+        *missed = found == false && (harq->ctrl & NRLDPC_PROTO_HARQ_NEW_DATA) == 0;
+        if (*missed == true)
+                store->missed++;
+        if (found == false || (harq->ctrl & NRLDPC_PROTO_HARQ_NEW_DATA) != 0)
+                memset(buf->llrs, 0, n);
+        buf->used = ++store->tick;
+
+        for (i = 0; i < len; i++) {
+                sum = buf->llrs[pos] + llrs[i];
+                if (sum > NRLDPC_HARQ_LLR_MAX)
+                        sum = NRLDPC_HARQ_LLR_MAX;
+                else if (sum < -NRLDPC_HARQ_LLR_MAX)
+                        sum = -NRLDPC_HARQ_LLR_MAX;
+                buf->llrs[pos] = (int8_t)sum;
+                if (++pos == n)
+                        pos = 0;
+        }
+        memcpy(combined, buf->llrs, n);
+        pthread_mutex_unlock(&store->lock);
+
+        return DOCA_SUCCESS;
+}
+
+uint32_t nrLDPC_harq_release(struct nrLDPC_harq_store *store, uint8_t ulsch_id, uint8_t harq_pid)
+{
+        uint32_t key = harq_process_key(ulsch_id, harq_pid);
+        uint32_t freed = 0;
+        uint32_t i;
+
+        pthread_mutex_lock(&store->lock);
+        for (i = 0; store->bufs != NULL && i < store->num_bufs; i++) {
+                if (store->bufs[i].key == 0 || store->bufs[i].key >> HARQ_KEY_SEG_BITS != key)
+                        continue;
+                store->bufs[i].key = 0;
+                freed++;
+        }
+        store->freed += freed;
+        pthread_mutex_unlock(&store->lock);
+
+        return freed;
+}
+
+void nrLDPC_harq_window(const int8_t *llrs, uint32_t n, uint32_t *offset, uint32_t *len)
+{
+        uint32_t first, run_start = 0, run = 0;
+        uint32_t best_start = 0, best = 0;
+        uint32_t i, pos;
+
+        for (first = 0; first < n && llrs[first] == 0; first++)
+                ;
+        if (first == n) {
+                *offset = 0;
+                *len = 0;
+                return;
+        }
+
+        /* Starting after a non-zero LLR, no run of zeros wraps around the end of the scan */
+        for (i = 1; i <= n; i++) {
+                pos = (first + i) % n;
+                if (llrs[pos] != 0) {
+                        run = 0;
+                        continue;
+                }
+                if (run++ == 0)
+                        run_start = pos;
+                if (run > best) {
+                        best = run;
+                        best_start = run_start;
+                }
+        }
+
+        *offset = best != 0 ? (best_start + best) % n : 0;
+        *len = n - best;
+}
+
+struct nrLDPC_harq_store *nrLDPC_harq_host_store(uint32_t num_bufs)
+{
+        pthread_mutex_lock(&host_store.lock);
+        if (host_store.bufs == NULL && num_bufs != 0)
+                host_store.num_bufs = num_bufs;
+        pthread_mutex_unlock(&host_store.lock);
+
+        return &host_store;
+}
+
+void nrLDPC_harq_host_store_clean(void)
+{
+        pthread_mutex_lock(&host_store.lock);
+        harq_store_free(&host_store);
+        host_store.bufs = NULL;
+        host_store.mem = NULL;
+        host_store.num_bufs = 0;
+        host_store.tick = 0;
+        host_store.evicted = 0;
+        host_store.missed = 0;
+        host_store.freed = 0;
+        pthread_mutex_unlock(&host_store.lock);
+}
+
+void nrLDPC_harq_init(void)
+{
+        atomic_store(&counters.calls, 0);
+        atomic_store(&counters.retx, 0);
+        atomic_store(&counters.missed, 0);
+        atomic_store(&counters.llr_bytes, 0);
+        atomic_store(&counters.full_bytes, 0);
+        atomic_store(&counters.releases, 0);
+}
+
+void nrLDPC_harq_count_sent(uint32_t n, uint32_t len, bool retx)
+{
+        atomic_fetch_add_explicit(&counters.calls, 1, memory_order_relaxed);
+        if (retx == true)
+                atomic_fetch_add_explicit(&counters.retx, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters.llr_bytes, len, memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters.full_bytes, n, memory_order_relaxed);
+}
+
+void nrLDPC_harq_count_missed(void)
+{
+        atomic_fetch_add_explicit(&counters.missed, 1, memory_order_relaxed);
+}
+
+void nrLDPC_harq_count_release(void)
+{
+        atomic_fetch_add_explicit(&counters.releases, 1, memory_order_relaxed);
+}
+
+void nrLDPC_harq_get_stats(struct nrLDPC_harq_stats *stats)
+{
+        stats->calls = atomic_load_explicit(&counters.calls, memory_order_relaxed);
+        stats->retx = atomic_load_explicit(&counters.retx, memory_order_relaxed);
+        stats->missed = atomic_load_explicit(&counters.missed, memory_order_relaxed);
+        stats->llr_bytes = atomic_load_explicit(&counters.llr_bytes, memory_order_relaxed);
+        stats->full_bytes = atomic_load_explicit(&counters.full_bytes, memory_order_relaxed);
+        stats->releases = atomic_load_explicit(&counters.releases, memory_order_relaxed);
+}
+
+void nrLDPC_harq_report(void)
+{
+        struct nrLDPC_harq_stats stats;
+
+        nrLDPC_harq_get_stats(&stats);
+        if (stats.calls == 0)
+                return;
+        DOCA_LOG_INFO("HARQ decodes: %lu, %lu retransmissions (%lu missed their soft buffer), %lu LLR bytes sent "
+                      "instead of %lu, %lu processes released",
+                      (unsigned long)stats.calls,
+                      (unsigned long)stats.retx,
+                      (unsigned long)stats.missed,
+                      (unsigned long)stats.llr_bytes,
+                      (unsigned long)stats.full_bytes,
+                      (unsigned long)stats.releases);
+}
@@ -0,0 +1,165 @@
+/*
+ * Filename: nrLDPC_harq.h
+ *
+ * HARQ soft buffers of the decoder, NRLDPC_PROTO_FLAG_HARQ: the LLRs of every transmission of a code block are
+ * combined, added with saturation, into a buffer of N LLRs kept per (ulsch_id, harq_pid, segment), and the
+ * combined LLRs are decoded. The DPU server keeps them resident, so a retransmission only carries its own LLRs
+ * across PCIe and the host has no combining pass; the host keeps a store of its own when it decodes instead.
+ * A store holds a bounded number of buffers and reuses the least recently used one when they are all taken.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_HARQ_H_
+#define NRLDPC_HARQ_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <doca_error.h>
+
+#include "nrLDPC_proto.h"
+
+#define NRLDPC_HARQ_MAX_LLRS (NR_LDPC_NCOL_BG1 * NR_LDPC_ZMAX) /* Soft buffer of the largest code block */
+#define NRLDPC_HARQ_BUFFERS 256                 /* Default NRLDPC_HARQ_BUFFERS */
+#define NRLDPC_HARQ_LLR_MAX 127                 /* Combined LLRs saturate at plus or minus this */
+
+/* Soft buffer of one code block */
+struct nrLDPC_harq_buf {
+        uint32_t key;  /* (ulsch_id, harq_pid, segment) it holds, 0 when free */
+        uint32_t n;    /* LLRs of the code block */
+        uint64_t used; /* Tick of its last combining, the least recent one is reused first */
+        int8_t *llrs;  /* NRLDPC_HARQ_MAX_LLRS combined LLRs */
+};
+
+/* Bounded set of soft buffers, shared by the threads decoding */
+struct nrLDPC_harq_store {
+        pthread_mutex_t lock;          /* Protects the buffers and the counters */
+        struct nrLDPC_harq_buf *bufs;  /* num_bufs buffers, allocated on first use */
+        int8_t *mem;                   /* LLRs of all buffers */
+        uint32_t num_bufs;             /* Buffers of the store */
+        uint64_t tick;                 /* Combinings done, orders the buffers by last use */
+        uint64_t evicted;              /* Buffers reused for another code block while in use */
+        uint64_t missed;               /* Retransmissions whose buffer was not found */
+        uint64_t freed;                /* Buffers freed by nrLDPC_harq_release() */
+};
+
+/* HARQ decodes sent to the DPU */
+struct nrLDPC_harq_stats {
+        uint64_t calls;      /* Decodes sent with NRLDPC_PROTO_FLAG_HARQ */
+        uint64_t retx;       /* Of those, retransmissions */
+        uint64_t missed;     /* Of those, answered with NRLDPC_PROTO_FLAG_HARQ_MISS */
+        uint64_t llr_bytes;  /* LLR bytes sent */
+        uint64_t full_bytes; /* LLR bytes the combined buffers would have taken */
+        uint64_t releases;   /* HARQ processes released */
+};
+
+/**
+ * Set up a store, its buffers are allocated by the first combining
+ *
+ * @store [out]: Store
+ * @num_bufs [in]: Buffers of the store, 0 for NRLDPC_HARQ_BUFFERS
+ */
+void nrLDPC_harq_store_init(struct nrLDPC_harq_store *store, uint32_t num_bufs);
+
+/**
+ * Release a store set up by nrLDPC_harq_store_init()
+ *
+ * @store [in]: Store
+ */
+void nrLDPC_harq_store_clean(struct nrLDPC_harq_store *store);
+
+/**
+ * Combine the LLRs of one transmission with the soft buffer of its code block
+ *
+ * @store [in]: Store
+ * @harq [in]: Code block, position of the LLRs in the buffer and NRLDPC_PROTO_HARQ_NEW_DATA
+ * @n [in]: LLRs of the code block
+ * @llrs [in]: LLRs of the transmission, from position harq->offset, wrapping around at n
+ * @len [in]: Number of LLRs, n at most
+ * @combined [out]: The n combined LLRs
+ * @missed [out]: A retransmission whose buffer was not found, combined with an empty one
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_harq_combine(struct nrLDPC_harq_store *store,
+                                 const struct nrLDPC_proto_harq *harq,
+                                 uint32_t n,
+                                 const int8_t *llrs,
+                                 uint32_t len,
+                                 int8_t *combined,
+                                 bool *missed);
+
+/**
+ * Free the soft buffers of every code block of a HARQ process, once it is acknowledged
+ *
+ * @store [in]: Store
+ * @ulsch_id [in]: ULSCH process
+ * @harq_pid [in]: HARQ process
+ * @return: Number of buffers freed
+ */
+uint32_t nrLDPC_harq_release(struct nrLDPC_harq_store *store, uint8_t ulsch_id, uint8_t harq_pid);
+
+/**
+ * Smallest circular window of LLRs holding all the non-zero ones, the LLRs a transmission has to send: the
+ * complement of the longest run of zeros, the positions it did not cover
+ *
+ * @llrs [in]: LLRs of the transmission, n of them
+ * @n [in]: LLRs of the code block
+ * @offset [out]: Position of the first LLR of the window
+ * @len [out]: LLRs of the window, wrapping around at n, 0 when they are all zero
+ */
+void nrLDPC_harq_window(const int8_t *llrs, uint32_t n, uint32_t *offset, uint32_t *len);
+
+/**
+ * Store of the code blocks decoded on the host, NRLDPC_HOST=always or without a session
+ *
+ * @num_bufs [in]: Buffers of the store when it is first used, 0 to leave them as they are
+ * @return: The process wide host store
+ */
+struct nrLDPC_harq_store *nrLDPC_harq_host_store(uint32_t num_bufs);
+
+/**
+ * Free the buffers of the host store and reset it, called by the session when it is destroyed: the soft
+ * buffers of a previous session are not combined with the transmissions of the next one
+ */
+void nrLDPC_harq_host_store_clean(void);
+
+/**
+ * Reset the counters, called by the session when it is created
+ */
+void nrLDPC_harq_init(void);
+
+/**
+ * Count a HARQ decode sent to the DPU
+ *
+ * @n [in]: LLRs of the code block
+ * @len [in]: LLRs sent
+ * @retx [in]: The decode is a retransmission
+ */
+void nrLDPC_harq_count_sent(uint32_t n, uint32_t len, bool retx);
+
+/**
+ * Count a HARQ decode answered with NRLDPC_PROTO_FLAG_HARQ_MISS
+ */
+void nrLDPC_harq_count_missed(void);
+
+/**
+ * Count a HARQ process released
+ */
+void nrLDPC_harq_count_release(void);
+
+/**
+ * Read the counters
+ *
+ * @stats [out]: Counters since the session was created
+ */
+void nrLDPC_harq_get_stats(struct nrLDPC_harq_stats *stats);
+
+/**
+ * Log the counters, called by the session when it is destroyed
+ */
+void nrLDPC_harq_report(void);
+
+#endif // NRLDPC_HARQ_H_
@@ -0,0 +1,141 @@
+/*
+ * Filename: nrLDPC_hedge.c
+ *
+ * Counters of the hedged decodes, see nrLDPC_hedge.h. The race between the DPU and the host is run by the
+ * decoder client, this only times the hedge and keeps the score. The time to answer goes to a histogram of 8
+ * buckets per power of 2, so that the tail percentiles cost no sorting and no memory per call.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <stdatomic.h>
+
+#include <doca_log.h>
+
+#include "nrLDPC_hedge.h"
+
+DOCA_LOG_REGISTER(NRLDPC_HEDGE);
+
+/* Counters, updated by the calling threads without a lock */
+struct hedge {
+        _Atomic(uint64_t) calls;                             /* Decodes sent with a hedge and answered */
+        _Atomic(uint64_t) fired;                             /* Decoded on the host too */
+        _Atomic(uint64_t) won[NRLDPC_ROUTE_NUM];             /* Of those fired, answered first by each path */
+        _Atomic(uint64_t) late;                              /* Answered after their deadline */
+        _Atomic(uint64_t) hist[NRLDPC_HEDGE_HIST_BUCKETS];   /* Time to answer, by hedge_bucket() */
+};
+
+static struct hedge hedge;
+
+/**
+ * Histogram bucket of a time: the exact value below 8 ns, then 8 buckets per power of 2
+ *
+ * @ns [in]: Time in nanoseconds
+ * @return: Bucket index
+ */
+static uint32_t hedge_bucket(uint64_t ns)
+{
+        uint32_t shift;
+
+        if (ns < (1U << NRLDPC_HEDGE_HIST_SUB_BITS))
+                return (uint32_t)ns;
+        shift = 63 - __builtin_clzll(ns) - NRLDPC_HEDGE_HIST_SUB_BITS;
+        return ((shift + 1) << NRLDPC_HEDGE_HIST_SUB_BITS) |
+               (uint32_t)((ns >> shift) & ((1U << NRLDPC_HEDGE_HIST_SUB_BITS) - 1));
+}
+
+/**
+ * Upper bound of a histogram bucket
+ *
+ * @bucket [in]: Bucket index
+ * @return: Smallest time of the next bucket, in nanoseconds
+ */
+static uint64_t hedge_bucket_end(uint32_t bucket)
+{
+        uint32_t shift;
+        uint64_t mantissa;
+
+        if (bucket < (1U << NRLDPC_HEDGE_HIST_SUB_BITS))
+                return bucket + 1;
+        shift = (bucket >> NRLDPC_HEDGE_HIST_SUB_BITS) - 1;
+        mantissa = (1U << NRLDPC_HEDGE_HIST_SUB_BITS) | (bucket & ((1U << NRLDPC_HEDGE_HIST_SUB_BITS) - 1));
+        if (shift + NRLDPC_HEDGE_HIST_SUB_BITS + 1 >= 64)
+                return UINT64_MAX;
+        return (mantissa + 1) << shift;
+}
+
+void nrLDPC_hedge_init(void)
+{
+        uint32_t i;
+
+        atomic_store(&hedge.calls, 0);
+        atomic_store(&hedge.fired, 0);
+        atomic_store(&hedge.late, 0);
+        for (i = 0; i < NRLDPC_ROUTE_NUM; i++)
+                atomic_store(&hedge.won[i], 0);
+        for (i = 0; i < NRLDPC_HEDGE_HIST_BUCKETS; i++)
+                atomic_store(&hedge.hist[i], 0);
+}
+
+uint64_t nrLDPC_hedge_time(uint32_t pct, uint64_t now_ns, uint64_t deadline_ns)
+{
+        if (deadline_ns <= now_ns)
+                return now_ns;
+        if (pct >= 100)
+                return deadline_ns;
+        return now_ns + (deadline_ns - now_ns) * pct / 100;
+}
+
+void nrLDPC_hedge_record(bool fired, enum nrLDPC_route winner, uint64_t latency_ns, bool late)
+{
+        atomic_fetch_add_explicit(&hedge.calls, 1, memory_order_relaxed);
+        if (fired == true) {
+                atomic_fetch_add_explicit(&hedge.fired, 1, memory_order_relaxed);
+                atomic_fetch_add_explicit(&hedge.won[winner], 1, memory_order_relaxed);
+        }
+        if (late == true)
+                atomic_fetch_add_explicit(&hedge.late, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&hedge.hist[hedge_bucket(latency_ns)], 1, memory_order_relaxed);
+}
+
+void nrLDPC_hedge_get_stats(struct nrLDPC_hedge_stats *stats)
+{
+        uint64_t count = 0;
+        uint64_t rank;
+        uint32_t i;
+
+        stats->calls = atomic_load_explicit(&hedge.calls, memory_order_relaxed);
+        stats->fired = atomic_load_explicit(&hedge.fired, memory_order_relaxed);
+        stats->host_won = atomic_load_explicit(&hedge.won[NRLDPC_ROUTE_HOST], memory_order_relaxed);
+        stats->dpu_won = atomic_load_explicit(&hedge.won[NRLDPC_ROUTE_DPU], memory_order_relaxed);
+        stats->late = atomic_load_explicit(&hedge.late, memory_order_relaxed);
+
+        /* The bucket holding the call ranked 99.9% from the fastest */
+        stats->p999_ns = 0;
+        rank = stats->calls - stats->calls / 1000;
+        for (i = 0; i < NRLDPC_HEDGE_HIST_BUCKETS && stats->calls != 0; i++) {
+                count += atomic_load_explicit(&hedge.hist[i], memory_order_relaxed);
+                if (count >= rank) {
+                        stats->p999_ns = hedge_bucket_end(i);
+                        break;
+                }
+        }
+}
+
+void nrLDPC_hedge_report(void)
+{
+        struct nrLDPC_hedge_stats stats;
+
+        nrLDPC_hedge_get_stats(&stats);
+        if (stats.calls == 0)
+                return;
+        DOCA_LOG_INFO("Hedged decodes: %lu, %lu decoded on the host too (%lu answered first by the host, %lu by the "
+                      "DPU), %lu late, p99.9 %lu us",
+                      (unsigned long)stats.calls,
+                      (unsigned long)stats.fired,
+                      (unsigned long)stats.host_won,
+                      (unsigned long)stats.dpu_won,
+                      (unsigned long)stats.late,
+                      (unsigned long)(stats.p999_ns / 1000));
+}
@@ -0,0 +1,71 @@
+/*
+ * Filename: nrLDPC_hedge.h
+ *
+ * Hedged decoding, NRLDPC_HEDGE_PCT: a blocking decode sent to the DPU that has no answer once NRLDPC_HEDGE_PCT
+ * percent of the time left to its deadline is gone is decoded on the host too, and the first answer is used.
+ * The host decoding stops when the DPU answers first, the DPU answer is dropped when the host is first. The DPU
+ * pays nothing more when it is on time, and a DPU hiccup costs the hedge time plus a host decoding at most.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_HEDGE_H_
+#define NRLDPC_HEDGE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nrLDPC_dispatch.h"
+
+#define NRLDPC_HEDGE_HIST_SUB_BITS 3            /* Latency histogram: 8 buckets per power of 2, 12.5% wide */
+#define NRLDPC_HEDGE_HIST_BUCKETS (64 << NRLDPC_HEDGE_HIST_SUB_BITS) /* Buckets covering any uint64_t time */
+
+/* Hedged decodes and their outcomes */
+struct nrLDPC_hedge_stats {
+        uint64_t calls;    /* Decodes sent with a hedge and answered */
+        uint64_t fired;    /* Of those, decoded on the host too, the DPU late */
+        uint64_t host_won; /* Of those fired, answered by the host first, the DPU answer dropped */
+        uint64_t dpu_won;  /* Of those fired, answered by the DPU first, the host decoding stopped */
+        uint64_t late;     /* Answered after their deadline */
+        uint64_t p999_ns;  /* 99.9th percentile of the time to answer, upper bound of its histogram bucket */
+};
+
+/**
+ * Reset the counters, called by the session when it is created
+ */
+void nrLDPC_hedge_init(void);
+
+/**
+ * Time the host starts decoding a call not answered by the DPU
+ *
+ * @pct [in]: Percent of the time left to the deadline the DPU gets, NRLDPC_HEDGE_PCT
+ * @now_ns [in]: CLOCK_MONOTONIC time the request is sent at
+ * @deadline_ns [in]: CLOCK_MONOTONIC deadline of the call
+ * @return: CLOCK_MONOTONIC hedge time, now_ns when the deadline is already past
+ */
+uint64_t nrLDPC_hedge_time(uint32_t pct, uint64_t now_ns, uint64_t deadline_ns);
+
+/**
+ * Count a hedged call
+ *
+ * @fired [in]: The host decoded it too
+ * @winner [in]: Path whose answer was used
+ * @latency_ns [in]: Time from the request to the answer
+ * @late [in]: Answered after its deadline
+ */
+void nrLDPC_hedge_record(bool fired, enum nrLDPC_route winner, uint64_t latency_ns, bool late);
+
+/**
+ * Read the counters
+ *
+ * @stats [out]: Counters since the session was created
+ */
+void nrLDPC_hedge_get_stats(struct nrLDPC_hedge_stats *stats);
+
+/**
+ * Log the counters, called by the session when it is destroyed
+ */
+void nrLDPC_hedge_report(void);
+
+#endif // NRLDPC_HEDGE_H_
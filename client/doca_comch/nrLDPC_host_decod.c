@@ -0,0 +1,537 @@
+/*
+ * Filename: nrLDPC_host_decod.c
+ *
+ * Host LDPC decoder, AVX2 kernels with a scalar fallback.
+ *
+ * Layered min-sum: the rows of the base graph are decoded one after the other, each one updating the a posteriori
+ * LLRs of its columns before the next row reads them. For each of the Zc check nodes of a row, the message to a
+ * variable is the product of the signs and the smallest magnitude of the messages from the other variables,
+ * scaled by 3/4. Check node k of a circulant of shift s reads bit (k + s) mod Zc of its column; the a posteriori
+ * LLRs of a column are kept twice in a row, as in nrLDPC_host_encod.c, so that the Zc LLRs a circulant reads
+ * are the single contiguous run starting at element s, written back in place.
+ *
+ * The messages and the check node arithmetic are int8, saturated. The a posteriori LLRs are int16: a layered
+ * decoder subtracts the last message of a check node from them before each update, and an int8 sum clipped at 127
+ * would lose the channel LLR under it, high SNR blocks then fail to converge.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nrLDPC_bg.h"
+#include "nrLDPC_bits.h"
+#include "nrLDPC_crc.h"
+#include "nrLDPC_host_decod.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NRLDPC_HOST_DECOD_AVX2 1
+#endif
+
+#define CORE_ROWS 4                                    /* Rows of the double-diagonal core, always decoded */
+#define VEC 32                                         /* int8 of an AVX2 vector, the kernels round Zc up to it */
+#define VEC16 16                                       /* int16 of an AVX2 vector */
+#define APP_STRIDE (2 * NRLDPC_BG_MAX_Z + VEC)         /* Elements of a column of LLRs kept twice */
+#define MSG_STRIDE (NRLDPC_BG_MAX_Z + VEC)             /* Bytes of the check to variable messages of a circulant */
+#define MAX_ENTRIES 316                                /* Circulants of BG1 */
+#define MAX_ROW_DEG 19                                 /* Circulants of the densest row, row 0 of BG1 */
+#define MAG_MAX 127                                    /* Largest magnitude of a message, -128 is never produced */
+
+/* Decoder state of a thread, too large for the stacks of the OAI threads */
+struct decod_ws {
+        uint8_t bg;                                    /* Base graph of p, 0 before the first call */
+        uint16_t z;                                    /* Lifting size of p */
+        uint16_t p[MAX_ENTRIES];                       /* Shift P(i,j) of each entry of the base graph */
+        int16_t app[NRLDPC_BG_MAX_COLS][APP_STRIDE];   /* A posteriori LLRs of each column, twice */
+        int8_t msg[MAX_ENTRIES][MSG_STRIDE];           /* Last check to variable messages of each circulant */
+};
+
+static pthread_key_t decod_ws_key;                       /* Owns the decod_ws of each thread */
+static pthread_once_t decod_ws_once = PTHREAD_ONCE_INIT; /* Creates decod_ws_key */
+
+/* Segment being decoded */
+struct decod_ctx {
+        const struct nrLDPC_bg *g;                     /* Base graph */
+        uint32_t z;                                    /* Lifting size */
+        uint32_t rows;                                 /* Rows decoded */
+        bool simd;                                     /* Use the AVX2 kernels */
+        struct decod_ws *ws;                           /* LLRs and messages */
+};
+
+/*
+ * Create the key of the per thread workspaces
+ */
+static void decod_ws_key_create(void)
+{
+        (void)pthread_key_create(&decod_ws_key, free);
+}
+
+/**
+ * Get the workspace of the calling thread
+ *
+ * @return: The workspace on success and NULL otherwise
+ */
+static struct decod_ws *decod_ws_get(void)
+{
+        struct decod_ws *ws;
+
+        pthread_once(&decod_ws_once, decod_ws_key_create);
+        ws = pthread_getspecific(decod_ws_key);
+        if (ws == NULL) {
+                ws = malloc(sizeof(*ws));
+                if (ws == NULL || pthread_setspecific(decod_ws_key, ws) != 0) {
+                        free(ws);
+                        return NULL;
+                }
+                ws->bg = 0;
+        }
+
+        return ws;
+}
+
+/**
+ * Saturate to int8, as the AVX2 saturating instructions do
+ *
+ * @v [in]: Value
+ * @return: v clamped to [-128, 127]
+ */
+static inline int8_t sat8(int v)
+{
+        return v > INT8_MAX ? INT8_MAX : v < INT8_MIN ? INT8_MIN : v;
+}
+
+/**
+ * Restore the copy of a column after a circulant of shift s wrote its Zc LLRs at elements s to s + Zc - 1
+ *
+ * @app [in/out]: Column, twice
+ * @z [in]: Lifting size
+ * @s [in]: Shift
+ */
+static void app_fixup(int16_t *app, uint32_t z, uint32_t s)
+{
+        memcpy(app, app + z, s * sizeof(*app));
+        memcpy(app + z + s, app + s, (z - s) * sizeof(*app));
+}
+
+/**
+ * Decode one row of the base graph, its Zc check nodes
+ *
+ * @ctx [in/out]: Segment
+ * @r [in]: Row
+ */
+static void layer_scalar(struct decod_ctx *ctx, uint32_t r)
+{
+        struct decod_ws *ws = ctx->ws;
+        uint32_t first = ctx->g->row_start[r];
+        uint32_t deg = ctx->g->row_start[r + 1] - first;
+        int16_t t16[MAX_ROW_DEG];
+        int8_t t[MAX_ROW_DEG];
+        uint8_t mag, min1, min2, m1, m2, sgn;
+        int16_t *app;
+        int8_t msg;
+        uint32_t e, k;
+
+        for (k = 0; k < ctx->z; k++) {
+                min1 = MAG_MAX;
+                min2 = MAG_MAX;
+                sgn = 0;
+                for (e = 0; e < deg; e++) {
+                        app = ws->app[ctx->g->entries[first + e].col] + ws->p[first + e];
+                        t16[e] = app[k] - ws->msg[first + e][k];
+                        t[e] = sat8(t16[e]);
+                        mag = t[e] < -MAG_MAX ? MAG_MAX : abs(t[e]);
+                        if (mag < min1) {
+                                min2 = min1;
+                                min1 = mag;
+                        } else if (mag < min2) {
+                                min2 = mag;
+                        }
+                        sgn ^= (uint8_t)t[e];
+                }
+                m1 = min1 - (min1 >> 2);
+                m2 = min2 - (min2 >> 2);
+
+                for (e = 0; e < deg; e++) {
+                        app = ws->app[ctx->g->entries[first + e].col] + ws->p[first + e];
+                        mag = t[e] < -MAG_MAX ? MAG_MAX : abs(t[e]);
+                        msg = mag == min1 ? m2 : m1;
+                        if (((sgn ^ (uint8_t)t[e]) & 0x80) != 0)
+                                msg = -msg;
+                        ws->msg[first + e][k] = msg;
+                        app[k] = t16[e] + msg;
+                }
+        }
+
+        for (e = 0; e < deg; e++)
+                app_fixup(ws->app[ctx->g->entries[first + e].col], ctx->z, ws->p[first + e]);
+}
+
+/**
+ * Check the rows decoded against the hard decisions of the a posteriori LLRs
+ *
+ * @ctx [in]: Segment
+ * @return: true when every parity check of the rows holds
+ */
+static bool syndrome_zero_scalar(const struct decod_ctx *ctx)
+{
+        const struct decod_ws *ws = ctx->ws;
+        uint32_t r, e, k;
+        uint8_t x;
+
+        for (r = 0; r < ctx->rows; r++) {
+                for (k = 0; k < ctx->z; k++) {
+                        x = 0;
+                        for (e = ctx->g->row_start[r]; e < ctx->g->row_start[r + 1]; e++)
+                                x ^= ws->app[ctx->g->entries[e].col][ws->p[e] + k] < 0;
+                        if (x != 0)
+                                return false;
+                }
+        }
+
+        return true;
+}
+
+#ifdef NRLDPC_HOST_DECOD_AVX2
+/**
+ * AVX2 layer_scalar, 32 check nodes per iteration: Zc is rounded up to a whole number of vectors, the columns and
+ * the messages have room for the extra lanes, whose results are never read back
+ *
+ * @ctx [in/out]: Segment
+ * @r [in]: Row
+ */
+__attribute__((target("avx2"))) static void layer_avx2(struct decod_ctx *ctx, uint32_t r)
+{
+        struct decod_ws *ws = ctx->ws;
+        uint32_t first = ctx->g->row_start[r];
+        uint32_t deg = ctx->g->row_start[r + 1] - first;
+        uint32_t nvec = (ctx->z + VEC - 1) / VEC;
+        const __m256i mag_max = _mm256_set1_epi8(MAG_MAX);
+        const __m256i low6 = _mm256_set1_epi8(0x3f);
+        const __m256i one = _mm256_set1_epi8(1);
+        __m256i t16[MAX_ROW_DEG][2];
+        __m256i t[MAX_ROW_DEG];
+        __m256i mag, min1, min2, m1, m2, sgn, msg;
+        int16_t *app;
+        uint32_t e, i;
+
+        for (i = 0; i < nvec; i++) {
+                min1 = mag_max;
+                min2 = mag_max;
+                sgn = _mm256_setzero_si256();
+                for (e = 0; e < deg; e++) {
+                        app = ws->app[ctx->g->entries[first + e].col] + ws->p[first + e] + i * VEC;
+                        msg = _mm256_loadu_si256((const __m256i *)(ws->msg[first + e] + i * VEC));
+                        t16[e][0] = _mm256_subs_epi16(_mm256_loadu_si256((const __m256i *)app),
+                                                      _mm256_cvtepi8_epi16(_mm256_castsi256_si128(msg)));
+                        t16[e][1] = _mm256_subs_epi16(_mm256_loadu_si256((const __m256i *)(app + VEC16)),
+                                                      _mm256_cvtepi8_epi16(_mm256_extracti128_si256(msg, 1)));
+                        /* packs works within 128-bit lanes, the permutation puts the 32 values back in order */
+                        t[e] = _mm256_permute4x64_epi64(_mm256_packs_epi16(t16[e][0], t16[e][1]), 0xd8);
+                        mag = _mm256_min_epu8(_mm256_abs_epi8(t[e]), mag_max);
+                        min2 = _mm256_min_epu8(min2, _mm256_max_epu8(min1, mag));
+                        min1 = _mm256_min_epu8(min1, mag);
+                        sgn = _mm256_xor_si256(sgn, t[e]);
+                }
+                /* m - m / 4, the bytes shifted in from the next lane are masked off */
+                m1 = _mm256_sub_epi8(min1, _mm256_and_si256(_mm256_srli_epi16(min1, 2), low6));
+                m2 = _mm256_sub_epi8(min2, _mm256_and_si256(_mm256_srli_epi16(min2, 2), low6));
+
+                for (e = 0; e < deg; e++) {
+                        app = ws->app[ctx->g->entries[first + e].col] + ws->p[first + e] + i * VEC;
+                        mag = _mm256_min_epu8(_mm256_abs_epi8(t[e]), mag_max);
+                        msg = _mm256_blendv_epi8(m1, m2, _mm256_cmpeq_epi8(mag, min1));
+                        /* The sign of the other messages, never 0 so that the magnitude is kept */
+                        msg = _mm256_sign_epi8(msg, _mm256_or_si256(_mm256_xor_si256(sgn, t[e]), one));
+                        _mm256_storeu_si256((__m256i *)(ws->msg[first + e] + i * VEC), msg);
+                        _mm256_storeu_si256((__m256i *)app,
+                                            _mm256_adds_epi16(t16[e][0],
+                                                              _mm256_cvtepi8_epi16(_mm256_castsi256_si128(msg))));
+                        _mm256_storeu_si256((__m256i *)(app + VEC16),
+                                            _mm256_adds_epi16(t16[e][1],
+                                                              _mm256_cvtepi8_epi16(_mm256_extracti128_si256(msg, 1))));
+                }
+        }
+
+        for (e = 0; e < deg; e++)
+                app_fixup(ws->app[ctx->g->entries[first + e].col], ctx->z, ws->p[first + e]);
+}
+
+/**
+ * AVX2 syndrome_zero_scalar, 16 checks per iteration
+ *
+ * @ctx [in]: Segment
+ * @return: true when every parity check of the rows holds
+ */
+__attribute__((target("avx2"))) static bool syndrome_zero_avx2(const struct decod_ctx *ctx)
+{
+        const struct decod_ws *ws = ctx->ws;
+        uint32_t nvec = (ctx->z + VEC16 - 1) / VEC16;
+        uint32_t tail = ctx->z - (nvec - 1) * VEC16;
+        uint32_t last_mask = tail == VEC16 ? UINT32_MAX : (1U << (2 * tail)) - 1;
+        const int16_t *app;
+        uint32_t r, e, i, mask;
+        __m256i x;
+
+        for (r = 0; r < ctx->rows; r++) {
+                for (i = 0; i < nvec; i++) {
+                        x = _mm256_setzero_si256();
+                        for (e = ctx->g->row_start[r]; e < ctx->g->row_start[r + 1]; e++) {
+                                app = ws->app[ctx->g->entries[e].col] + ws->p[e] + i * VEC16;
+                                x = _mm256_xor_si256(x, _mm256_loadu_si256((const __m256i *)app));
+                        }
+                        /* The sign of an int16 is the top bit of its second byte */
+                        mask = (uint32_t)_mm256_movemask_epi8(x) & 0xaaaaaaaa;
+                        if (i == nvec - 1)
+                                mask &= last_mask;
+                        if (mask != 0)
+                                return false;
+                }
+        }
+
+        return true;
+}
+#endif
+
+/**
+ * Decode one row with the kernels of the segment
+ *
+ * @ctx [in/out]: Segment
+ * @r [in]: Row
+ */
+static void layer(struct decod_ctx *ctx, uint32_t r)
+{
+#ifdef NRLDPC_HOST_DECOD_AVX2
+        if (ctx->simd) {
+                layer_avx2(ctx, r);
+                return;
+        }
+#endif
+        layer_scalar(ctx, r);
+}
+
+/**
+ * Check the syndrome with the kernels of the segment
+ *
+ * @ctx [in]: Segment
+ * @return: true when every parity check of the rows decoded holds
+ */
+static bool syndrome_zero(const struct decod_ctx *ctx)
+{
+#ifdef NRLDPC_HOST_DECOD_AVX2
+        if (ctx->simd)
+                return syndrome_zero_avx2(ctx);
+#endif
+        return syndrome_zero_scalar(ctx);
+}
+
+/**
+ * Write the Kprime first bits of the codeword in the layout of outMode
+ *
+ * @ctx [in]: Segment, decoded
+ * @kprime [in]: Bits to write
+ * @mode [in]: Output layout
+ * @out [out]: Decoded bits
+ */
+static void decod_output(const struct decod_ctx *ctx, uint32_t kprime, e_nrLDPC_outMode mode, int8_t *out)
+{
+        uint8_t bits[22 * NRLDPC_BG_MAX_Z];
+        uint8_t *dst = mode == nrLDPC_outMode_BIT ? bits : (uint8_t *)out;
+        uint32_t col, k, n;
+
+        for (col = 0; col * ctx->z < kprime; col++) {
+                n = kprime - col * ctx->z < ctx->z ? kprime - col * ctx->z : ctx->z;
+                for (k = 0; k < n; k++) {
+                        if (mode == nrLDPC_outMode_LLRINT8)
+                                out[col * ctx->z + k] = sat8(ctx->ws->app[col][k]);
+                        else
+                                dst[col * ctx->z + k] = ctx->ws->app[col][k] < 0;
+                }
+        }
+        if (mode == nrLDPC_outMode_BIT)
+                nrLDPC_bits_pack(bits, kprime, (uint8_t *)out);
+}
+
+/**
+ * Check the CRC carried by the Kprime first bits of the hard decision of the segment
+ *
+ * @ctx [in]: Segment, after an iteration
+ * @kprime [in]: Bits of the code block, its CRC in the last ones
+ * @crc [in]: NRLDPC_PROTO_CRC_*
+ * @return: true when the CRC passes
+ */
+static bool decod_crc_pass(const struct decod_ctx *ctx, uint32_t kprime, uint8_t crc)
+{
+        uint8_t bits[22 * NRLDPC_BG_MAX_Z];
+        uint8_t bytes[22 * NRLDPC_BG_MAX_Z / 8];
+        uint32_t col, k, n;
+
+        /* Run after every iteration: a column at a time, then the packing kernel, as decod_output() */
+        for (col = 0; col * ctx->z < kprime; col++) {
+                n = kprime - col * ctx->z < ctx->z ? kprime - col * ctx->z : ctx->z;
+                for (k = 0; k < n; k++)
+                        bits[col * ctx->z + k] = ctx->ws->app[col][k] < 0;
+        }
+        nrLDPC_bits_pack(bits, kprime, bytes);
+
+        return nrLDPC_crc_check(crc, bytes, kprime / 8);
+}
+
+/**
+ * Decode one segment with the scalar or the AVX2 kernels
+ *
+ * @p [in]: Decoder parameters
+ * @llr [in]: LLRs of the codeword
+ * @out [out]: Decoded bits in the layout of outMode
+ * @num_iter [out]: Iterations run, numMaxIter + 1 when the syndrome is still not zero or the CRC never passed
+ * @simd [in]: Use the AVX2 kernels
+ * @crc [in]: NRLDPC_PROTO_CRC_* checked after each iteration, the decoding stops once it passes
+ * @stop [in]: Stops the decoding before the next iteration once set, NULL for none
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_AGAIN when stopped and DOCA_ERROR otherwise
+ */
+static doca_error_t host_decod(const t_nrLDPC_dec_params *p,
+                               const int8_t *llr,
+                               int8_t *out,
+                               uint32_t *num_iter,
+                               bool simd,
+                               uint8_t crc,
+                               const _Atomic(bool) *stop)
+{
+        struct decod_ctx ctx;
+        struct decod_ws *ws;
+        uint32_t col, r, e, it;
+        int ils = nrLDPC_bg_ils(p->Z);
+
+        ctx.g = nrLDPC_bg_get(p->BG);
+        ctx.z = p->Z;
+        ctx.simd = simd;
+        if (ctx.g == NULL || ils < 0 || p->Kprime <= 0 || p->Kprime > ctx.g->kb * p->Z || p->numMaxIter == 0 ||
+            p->outMode > nrLDPC_outMode_LLRINT8 || (crc != NRLDPC_PROTO_CRC_NONE && p->Kprime % 8 != 0))
+                return DOCA_ERROR_INVALID_VALUE;
+
+        ws = decod_ws_get();
+        if (ws == NULL)
+                return DOCA_ERROR_NO_MEMORY;
+        ctx.ws = ws;
+
+        /* The segments of a transport block share BG and Zc, the shifts of the last ones the thread decoded are kept */
+        if (ws->bg != p->BG || ws->z != p->Z) {
+                for (e = 0; e < ctx.g->row_start[ctx.g->rows]; e++)
+                        ws->p[e] = ctx.g->entries[e].v[ils] % p->Z;
+                ws->bg = p->BG;
+                ws->z = p->Z;
+        }
+
+        /* Each extension row has a parity column of its own: the rows after the last one transmitted add nothing */
+        ctx.rows = CORE_ROWS;
+        for (r = ctx.g->rows; r > CORE_ROWS; r--) {
+                col = ctx.g->kb + r - 1;
+                for (e = 0; e < ctx.z && llr[col * ctx.z + e] == 0; e++)
+                        ;
+                if (e < ctx.z) {
+                        ctx.rows = r;
+                        break;
+                }
+        }
+
+        for (col = 0; col < ctx.g->kb + ctx.rows; col++) {
+                for (e = 0; e < ctx.z; e++)
+                        ws->app[col][e] = llr[col * ctx.z + e];
+                memcpy(ws->app[col] + ctx.z, ws->app[col], ctx.z * sizeof(ws->app[col][0]));
+        }
+        for (e = 0; e < ctx.g->row_start[ctx.rows]; e++)
+                memset(ws->msg[e], 0, (ctx.z + VEC - 1) / VEC * VEC);
+
+        *num_iter = p->numMaxIter + 1;
+        for (it = 1; it <= p->numMaxIter; it++) {
+                if (stop != NULL && atomic_load_explicit(stop, memory_order_relaxed) == true) {
+                        *num_iter = it - 1;
+                        return DOCA_ERROR_AGAIN;
+                }
+                for (r = 0; r < ctx.rows; r++)
+                        layer(&ctx, r);
+                /* The CRC passes as soon as the systematic bits are right, often before the parity bits are */
+                if (crc != NRLDPC_PROTO_CRC_NONE && decod_crc_pass(&ctx, p->Kprime, crc)) {
+                        *num_iter = it;
+                        break;
+                }
+                /* A codeword the CRC rejects: more iterations do not move away from it */
+                if (syndrome_zero(&ctx)) {
+                        if (crc == NRLDPC_PROTO_CRC_NONE)
+                                *num_iter = it;
+                        break;
+                }
+        }
+
+        decod_output(&ctx, p->Kprime, p->outMode, out);
+        return DOCA_SUCCESS;
+}
+
+bool nrLDPC_host_decod_simd(void)
+{
+#ifdef NRLDPC_HOST_DECOD_AVX2
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+}
+
+doca_error_t nrLDPC_host_decod_scalar(const t_nrLDPC_dec_params *p,
+                                      const int8_t *llr,
+                                      int8_t *out,
+                                      uint32_t *num_iter)
+{
+        return host_decod(p, llr, out, num_iter, false, nrLDPC_crc_from_params(p), NULL);
+}
+
+/**
+ * Decode one segment for the client, checking the CRC OAI asks for and counting the checks
+ *
+ * @p [in]: Decoder parameters, check_crc and crc_type included
+ * @llr [in]: LLRs of the codeword
+ * @out [out]: Decoded bits in the layout of outMode
+ * @num_iter [out]: Iterations run, numMaxIter + 1 when the syndrome is still not zero or the CRC did not pass
+ * @stop [in]: Stops the decoding before the next iteration once set, NULL for none
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_AGAIN when stopped and DOCA_ERROR otherwise
+ */
+static doca_error_t host_decod_client(const t_nrLDPC_dec_params *p,
+                                      const int8_t *llr,
+                                      int8_t *out,
+                                      uint32_t *num_iter,
+                                      const _Atomic(bool) *stop)
+{
+        uint8_t crc = nrLDPC_crc_from_params(p);
+        doca_error_t result;
+
+        result = host_decod(p, llr, out, num_iter, nrLDPC_host_decod_simd(), crc, stop);
+        if (result == DOCA_SUCCESS && crc != NRLDPC_PROTO_CRC_NONE)
+                nrLDPC_crc_count_host(*num_iter <= p->numMaxIter);
+
+        return result;
+}
+
+doca_error_t nrLDPC_host_decod(const t_nrLDPC_dec_params *p, const int8_t *llr, int8_t *out, uint32_t *num_iter)
+{
+        return host_decod_client(p, llr, out, num_iter, NULL);
+}
+
+doca_error_t nrLDPC_host_decod_crc(const t_nrLDPC_dec_params *p,
+                                   const int8_t *llr,
+                                   int8_t *out,
+                                   uint32_t *num_iter,
+                                   uint8_t crc)
+{
+        return host_decod(p, llr, out, num_iter, nrLDPC_host_decod_simd(), crc, NULL);
+}
+
+doca_error_t nrLDPC_host_decod_stoppable(const t_nrLDPC_dec_params *p,
+                                        const int8_t *llr,
+                                        int8_t *out,
+                                        uint32_t *num_iter,
+                                        const _Atomic(bool) *stop)
+{
+        return host_decod_client(p, llr, out, num_iter, stop);
+}
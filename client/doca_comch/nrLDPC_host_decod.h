@@ -0,0 +1,96 @@
+/*
+ * Filename: nrLDPC_host_decod.h
+ *
+ * LDPC decoder running on the host CPU, the fallback of the DPU decoder service: 5G NR BG1/BG2, all lifting
+ * sizes, layered normalised min-sum on int8 LLRs. The Zc check nodes of a base graph row are updated together,
+ * 32 of them per AVX2 instruction when the CPU supports it.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_HOST_DECOD_H_
+#define NRLDPC_HOST_DECOD_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <doca_error.h>
+
+#include <nrLDPC_defs.h>
+
+/**
+ * Decode one segment from the LLRs OAI gives nrLDPC_decod: 68 * Zc LLRs for BG1 and 52 * Zc for BG2, punctured
+ * columns included, positive for a 0. The rows of the parity columns whose LLRs are all 0, never transmitted, are
+ * left out. Decoding stops at the first iteration after which the syndrome is zero, or after numMaxIter. When
+ * check_crc is set, the CRC of crc_type carried by the last bits of Kprime is checked after each iteration
+ * instead, see nrLDPC_crc.h: decoding stops once it passes, or at a zero syndrome the CRC rejects.
+ *
+ * @p [in]: Decoder parameters: BG, Z, Kprime, numMaxIter, outMode, and check_crc and crc_type
+ * @llr [in]: LLRs of the codeword
+ * @out [out]: The Kprime first bits of the codeword: packed (8 per byte, first bit in the MSB, as the DPU service
+ * returns them) for nrLDPC_outMode_BIT, one bit per byte for nrLDPC_outMode_BITINT8, the a posteriori LLRs for
+ * nrLDPC_outMode_LLRINT8
+ * @num_iter [out]: Iterations run, numMaxIter + 1 when the syndrome is still not zero or the CRC did not pass, as
+ * OAI counts them
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_INVALID_VALUE for parameters out of TS 38.212 and
+ * DOCA_ERROR_NO_MEMORY if the thread workspace cannot be allocated
+ */
+doca_error_t nrLDPC_host_decod(const t_nrLDPC_dec_params *p, const int8_t *llr, int8_t *out, uint32_t *num_iter);
+
+/**
+ * nrLDPC_host_decod checking a CRC given as on the wire, the decoder of the DPU server: check_crc is not read
+ *
+ * @p [in]: Decoder parameters: BG, Z, Kprime, numMaxIter and outMode
+ * @llr [in]: LLRs of the codeword
+ * @out [out]: The Kprime first bits of the codeword in the layout of outMode
+ * @num_iter [out]: Iterations run, numMaxIter + 1 when the CRC did not pass, or the syndrome is still not zero
+ * without a CRC
+ * @crc [in]: NRLDPC_PROTO_CRC_* carried by the last bits of Kprime, NRLDPC_PROTO_CRC_NONE for none
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_host_decod_crc(const t_nrLDPC_dec_params *p,
+                                   const int8_t *llr,
+                                   int8_t *out,
+                                   uint32_t *num_iter,
+                                   uint8_t crc);
+
+/**
+ * nrLDPC_host_decod giving up once another decoder answered: stop is read before each iteration
+ *
+ * @p [in]: Decoder parameters: BG, Z, Kprime, numMaxIter and outMode
+ * @llr [in]: LLRs of the codeword
+ * @out [out]: The Kprime first bits of the codeword in the layout of outMode, not written when stopped
+ * @num_iter [out]: Iterations run, numMaxIter + 1 when the syndrome is still not zero
+ * @stop [in]: Set by another thread to stop the decoding
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_AGAIN when stopped and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_host_decod_stoppable(const t_nrLDPC_dec_params *p,
+                                        const int8_t *llr,
+                                        int8_t *out,
+                                        uint32_t *num_iter,
+                                        const _Atomic(bool) *stop);
+
+/**
+ * Scalar implementation of nrLDPC_host_decod, the reference of the SIMD kernels, bit exact with them
+ *
+ * @p [in]: Decoder parameters: BG, Z, Kprime, numMaxIter and outMode
+ * @llr [in]: LLRs of the codeword
+ * @out [out]: The Kprime first bits of the codeword in the layout of outMode
+ * @num_iter [out]: Iterations run, numMaxIter + 1 when the syndrome is still not zero
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_host_decod_scalar(const t_nrLDPC_dec_params *p,
+                                      const int8_t *llr,
+                                      int8_t *out,
+                                      uint32_t *num_iter);
+
+/**
+ * Whether nrLDPC_host_decod runs the AVX2 kernels
+ *
+ * @return: true when the AVX2 kernels are used
+ */
+bool nrLDPC_host_decod_simd(void);
+
+#endif // NRLDPC_HOST_DECOD_H_
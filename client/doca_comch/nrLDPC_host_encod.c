@@ -0,0 +1,408 @@
+/*
+ * Filename: nrLDPC_host_encod.c
+ *
+ * Host LDPC encoder, AVX2 kernels with a scalar fallback.
+ *
+ * Both base graphs share the structure the encoding relies on (TS 38.212 section 5.3.2): the first 4 rows, the
+ * core, hold the Kb systematic columns and 4 parity columns in a double-diagonal; each of the other rows adds one
+ * parity column of its own, shift 0. The core parity bits are solved once the systematic part of the core rows is
+ * known, then every other parity column is the sum of its row over the systematic and core parity columns.
+ * Each term of a sum is one circulant, P^s x: x rotated by s bits. The columns the sums read are kept twice in a
+ * row, x then x again, so that P^s x is the single contiguous run of Zc bytes starting at byte s.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nrLDPC_bg.h"
+#include "nrLDPC_bits.h"
+#include "nrLDPC_host_encod.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NRLDPC_HOST_ENCOD_AVX2 1
+#endif
+
+#define CORE_ROWS 4                                    /* Rows, and parity columns, of the double-diagonal core */
+#define SRC_COLS (22 + CORE_ROWS)                      /* Columns the row sums read: systematic and core parity */
+#define VEC 32                                         /* Bytes of an AVX2 vector, the kernels round Zc up to it */
+#define SUM_STRIDE (NRLDPC_BG_MAX_Z + VEC)             /* Bytes of a row sum */
+#define SRC_STRIDE (2 * NRLDPC_BG_MAX_Z + VEC)         /* Bytes of a column kept twice */
+#define MAX_ENTRIES 316                                /* Circulants of BG1 */
+
+/* Shifts P(i,j) = V(i,j) mod Zc of every circulant of a base graph, for one lifting size */
+struct encod_shifts {
+        uint8_t bg;                                    /* Base graph, 0 before the first call */
+        uint16_t z;                                    /* Lifting size */
+        uint16_t p[MAX_ENTRIES];                       /* Shift of each entry of the base graph */
+};
+
+/* Codeword being encoded */
+struct encod_ctx {
+        const struct nrLDPC_bg *g;                     /* Base graph */
+        uint32_t z;                                    /* Lifting size */
+        const uint16_t *p;                             /* Shift of each entry of the base graph */
+        bool simd;                                     /* Use the AVX2 kernels */
+        uint8_t src[SRC_COLS][SRC_STRIDE];             /* Systematic and core parity columns, each one twice */
+};
+
+/* Encoder state of a thread, too large for the stacks of the OAI threads */
+struct encod_ws {
+        struct encod_shifts shifts;                    /* Of the last segment, those of a transport block share them */
+        struct encod_ctx ctx;                          /* Codeword being encoded */
+        uint8_t sys[22 * NRLDPC_BG_MAX_Z];             /* Systematic bits, one per byte */
+};
+
+static pthread_key_t encod_ws_key;                       /* Owns the encod_ws of each thread */
+static pthread_once_t encod_ws_once = PTHREAD_ONCE_INIT; /* Creates encod_ws_key */
+
+/*
+ * Create the key of the per thread workspaces
+ */
+static void encod_ws_key_create(void)
+{
+        (void)pthread_key_create(&encod_ws_key, free);
+}
+
+/**
+ * Get the workspace of the calling thread
+ *
+ * @return: The workspace on success and NULL otherwise
+ */
+static struct encod_ws *encod_ws_get(void)
+{
+        struct encod_ws *ws;
+
+        pthread_once(&encod_ws_once, encod_ws_key_create);
+        ws = pthread_getspecific(encod_ws_key);
+        if (ws == NULL) {
+                ws = malloc(sizeof(*ws));
+                if (ws == NULL || pthread_setspecific(encod_ws_key, ws) != 0) {
+                        free(ws);
+                        return NULL;
+                }
+                ws->shifts.bg = 0;
+        }
+
+        return ws;
+}
+
+/**
+ * Sum circulants of a row, acc ^= P^s x over the entries e to end - 1
+ *
+ * @acc [in/out]: z bits
+ * @ctx [in]: Codeword
+ * @e [in]: First entry
+ * @end [in]: Entry after the last one
+ */
+static void row_xor_scalar(uint8_t *acc,
+                           const struct encod_ctx *ctx,
+                           const struct nrLDPC_bg_entry *e,
+                           const struct nrLDPC_bg_entry *end)
+{
+        const uint8_t *x;
+        uint32_t k;
+
+        for (; e < end; e++) {
+                x = ctx->src[e->col] + ctx->p[e - ctx->g->entries];
+                for (k = 0; k < ctx->z; k++)
+                        acc[k] ^= x[k];
+        }
+}
+
+#ifdef NRLDPC_HOST_ENCOD_AVX2
+/**
+ * AVX2 row_xor_scalar, 32 bits per iteration: Zc is rounded up to a whole number of vectors, acc and the
+ * columns have room for the extra bytes, which are never read back
+ *
+ * @acc [in/out]: z bits, SUM_STRIDE bytes
+ * @ctx [in]: Codeword
+ * @e [in]: First entry
+ * @end [in]: Entry after the last one
+ */
+__attribute__((target("avx2"))) static void row_xor_avx2(uint8_t *acc,
+                                                         const struct encod_ctx *ctx,
+                                                         const struct nrLDPC_bg_entry *e,
+                                                         const struct nrLDPC_bg_entry *end)
+{
+        __m256i sum[SUM_STRIDE / VEC];
+        const uint8_t *x;
+        uint32_t nvec = (ctx->z + VEC - 1) / VEC;
+        uint32_t i;
+
+        /* The row sum stays in registers, or at least in L1, until the last circulant */
+        for (i = 0; i < nvec; i++)
+                sum[i] = _mm256_loadu_si256((const __m256i *)(acc + i * VEC));
+        for (; e < end; e++) {
+                x = ctx->src[e->col] + ctx->p[e - ctx->g->entries];
+                for (i = 0; i < nvec; i++)
+                        sum[i] = _mm256_xor_si256(sum[i], _mm256_loadu_si256((const __m256i *)(x + i * VEC)));
+        }
+        for (i = 0; i < nvec; i++)
+                _mm256_storeu_si256((__m256i *)(acc + i * VEC), sum[i]);
+}
+#endif
+
+/**
+ * Sum circulants of a row with the kernels of the codeword
+ *
+ * @ctx [in]: Codeword
+ * @acc [in/out]: z bits, SUM_STRIDE bytes
+ * @e [in]: First entry
+ * @end [in]: Entry after the last one
+ */
+static void row_xor(const struct encod_ctx *ctx,
+                    uint8_t *acc,
+                    const struct nrLDPC_bg_entry *e,
+                    const struct nrLDPC_bg_entry *end)
+{
+#ifdef NRLDPC_HOST_ENCOD_AVX2
+        if (ctx->simd) {
+                row_xor_avx2(acc, ctx, e, end);
+                return;
+        }
+#endif
+        row_xor_scalar(acc, ctx, e, end);
+}
+
+/**
+ * Set a column the row sums read, and its copy
+ *
+ * @ctx [in/out]: Codeword
+ * @col [in]: Column
+ * @bits [in]: z bits
+ */
+static void src_set(struct encod_ctx *ctx, uint32_t col, const uint8_t *bits)
+{
+        memcpy(ctx->src[col], bits, ctx->z);
+        memcpy(ctx->src[col] + ctx->z, bits, ctx->z);
+}
+
+/**
+ * y = P^s x, for the few rotations outside the row sums
+ *
+ * @ctx [in]: Codeword
+ * @y [out]: z bits
+ * @x [in]: z bits
+ * @s [in]: Shift, less than z
+ */
+static void rotate(const struct encod_ctx *ctx, uint8_t *y, const uint8_t *x, uint32_t s)
+{
+        memcpy(y, x + s, ctx->z - s);
+        memcpy(y + ctx->z - s, x, s);
+}
+
+/**
+ * First entry of a row at or after a column
+ *
+ * @g [in]: Base graph
+ * @r [in]: Row
+ * @col [in]: Column
+ * @return: The entry, the end of the row if there is none
+ */
+static const struct nrLDPC_bg_entry *row_from(const struct nrLDPC_bg *g, uint32_t r, uint32_t col)
+{
+        const struct nrLDPC_bg_entry *e = &g->entries[g->row_start[r]];
+        const struct nrLDPC_bg_entry *end = &g->entries[g->row_start[r + 1]];
+
+        while (e < end && e->col < col)
+                e++;
+        return e;
+}
+
+/**
+ * Solve the core parity columns kb to kb + 3 from the systematic part of the core rows
+ *
+ * @ctx [in/out]: Codeword, systematic columns set
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR_UNEXPECTED if the base graph has no double-diagonal core
+ */
+static doca_error_t encod_core(struct encod_ctx *ctx)
+{
+        const struct nrLDPC_bg *g = ctx->g;
+        const struct nrLDPC_bg_entry *e, *end, *unknown;
+        uint8_t lambda[CORE_ROWS][SUM_STRIDE];
+        uint8_t rhs[NRLDPC_BG_MAX_Z];
+        uint8_t p[NRLDPC_BG_MAX_Z];
+        uint32_t shifts[CORE_ROWS];
+        uint32_t num_shifts = 0;
+        uint32_t z = ctx->z;
+        uint32_t known = 1;
+        uint32_t r, i, k, pass, num_unknown;
+
+        for (r = 0; r < CORE_ROWS; r++) {
+                memset(lambda[r], 0, SUM_STRIDE);
+                row_xor(ctx, lambda[r], &g->entries[g->row_start[r]], row_from(g, r, g->kb));
+        }
+
+        /*
+         * Summing the 4 core rows cancels p1 to p3, each found twice, and the circulants of p0 whose shifts are
+         * equal in pairs: what remains is P^b p0 = lambda0 + lambda1 + lambda2 + lambda3
+         */
+        for (r = 0; r < CORE_ROWS; r++) {
+                e = row_from(g, r, g->kb);
+                if (e == &g->entries[g->row_start[r + 1]] || e->col != g->kb)
+                        continue;
+                k = ctx->p[e - g->entries];
+                for (i = 0; i < num_shifts && shifts[i] != k; i++)
+                        ;
+                if (i < num_shifts)
+                        shifts[i] = shifts[--num_shifts];
+                else
+                        shifts[num_shifts++] = k;
+        }
+        if (num_shifts != 1)
+                return DOCA_ERROR_UNEXPECTED;
+
+        for (k = 0; k < z; k++)
+                rhs[k] = lambda[0][k] ^ lambda[1][k] ^ lambda[2][k] ^ lambda[3][k];
+        rotate(ctx, p, rhs, (z - shifts[0]) % z);
+        src_set(ctx, g->kb, p);
+
+        /* Then each core row with a single parity column left gives that column */
+        for (pass = 0; pass < CORE_ROWS && known != (1U << CORE_ROWS) - 1; pass++) {
+                for (r = 0; r < CORE_ROWS; r++) {
+                        e = row_from(g, r, g->kb);
+                        end = row_from(g, r, g->kb + CORE_ROWS);
+                        num_unknown = 0;
+                        unknown = NULL;
+                        for (; e < end; e++) {
+                                if ((known & (1U << (e->col - g->kb))) == 0) {
+                                        num_unknown++;
+                                        unknown = e;
+                                }
+                        }
+                        if (num_unknown != 1)
+                                continue;
+
+                        memcpy(rhs, lambda[r], z);
+                        for (e = row_from(g, r, g->kb); e < end; e++) {
+                                if (e == unknown)
+                                        continue;
+                                for (k = 0; k < z; k++)
+                                        rhs[k] ^= ctx->src[e->col][ctx->p[e - g->entries] + k];
+                        }
+                        rotate(ctx, p, rhs, (z - ctx->p[unknown - g->entries]) % z);
+                        src_set(ctx, unknown->col, p);
+                        known |= 1U << (unknown->col - g->kb);
+                }
+        }
+
+        return known == (1U << CORE_ROWS) - 1 ? DOCA_SUCCESS : DOCA_ERROR_UNEXPECTED;
+}
+
+/**
+ * Encode one segment with the scalar or the AVX2 kernels
+ *
+ * @bg [in]: Base graph, 1 or 2
+ * @z [in]: Lifting size (Zc)
+ * @k [in]: Input bits (K), filler bits included
+ * @f [in]: Filler bits (F)
+ * @input [in]: K input bits, packed or one bit per byte
+ * @input_packed [in]: Layout of input
+ * @output [out]: N codeword bits, one bit per byte
+ * @simd [in]: Use the AVX2 kernels
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t host_encod(uint8_t bg,
+                               uint16_t z,
+                               uint32_t k,
+                               uint32_t f,
+                               const uint8_t *input,
+                               bool input_packed,
+                               uint8_t *output,
+                               bool simd)
+{
+        struct encod_ws *ws = encod_ws_get();
+        struct encod_ctx *ctx;
+        uint8_t *sys;
+        uint8_t sum[SUM_STRIDE];
+        uint32_t info, i, r, col;
+        int ils = nrLDPC_bg_ils(z);
+        doca_error_t result;
+
+        if (ws == NULL)
+                return DOCA_ERROR_NO_MEMORY;
+        ctx = &ws->ctx;
+        sys = ws->sys;
+        ctx->g = nrLDPC_bg_get(bg);
+        ctx->z = z;
+        ctx->simd = simd;
+        if (ctx->g == NULL || ils < 0 || k > (uint32_t)ctx->g->kb * z || f > k)
+                return DOCA_ERROR_INVALID_VALUE;
+
+        if (ws->shifts.bg != bg || ws->shifts.z != z) {
+                for (i = 0; i < ctx->g->row_start[ctx->g->rows]; i++)
+                        ws->shifts.p[i] = ctx->g->entries[i].v[ils] % z;
+                ws->shifts.bg = bg;
+                ws->shifts.z = z;
+        }
+        ctx->p = ws->shifts.p;
+
+        /* Systematic bits: the information bits, then the filler and padding 0s up to Kb * Zc */
+        info = k - f;
+        if (input_packed) {
+                nrLDPC_bits_unpack(input, info, sys);
+        } else {
+                for (i = 0; i < info; i++)
+                        sys[i] = input[i] & 1;
+        }
+        memset(sys + info, 0, (uint32_t)ctx->g->kb * z - info);
+        for (col = 0; col < ctx->g->kb; col++)
+                src_set(ctx, col, sys + col * z);
+
+        /* The first 2 columns are punctured, the output starts with column 2 */
+        memcpy(output, sys + NRLDPC_BG_PUNCTURED * z, (ctx->g->kb - NRLDPC_BG_PUNCTURED) * z);
+
+        result = encod_core(ctx);
+        if (result != DOCA_SUCCESS)
+                return result;
+        for (col = ctx->g->kb; col < (uint32_t)ctx->g->kb + CORE_ROWS; col++)
+                memcpy(output + (col - NRLDPC_BG_PUNCTURED) * z, ctx->src[col], z);
+
+        /* Extension rows: their own parity column, shift 0, is the sum of the row up to the core parity columns */
+        for (r = CORE_ROWS; r < ctx->g->rows; r++) {
+                memset(sum, 0, sizeof(sum));
+                row_xor(ctx,
+                        sum,
+                        &ctx->g->entries[ctx->g->row_start[r]],
+                        row_from(ctx->g, r, ctx->g->kb + CORE_ROWS));
+                memcpy(output + (ctx->g->kb + r - NRLDPC_BG_PUNCTURED) * z, sum, z);
+        }
+
+        return DOCA_SUCCESS;
+}
+
+bool nrLDPC_host_encod_simd(void)
+{
+#ifdef NRLDPC_HOST_ENCOD_AVX2
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+}
+
+doca_error_t nrLDPC_host_encod_scalar(uint8_t bg,
+                                      uint16_t z,
+                                      uint32_t k,
+                                      uint32_t f,
+                                      const uint8_t *input,
+                                      bool input_packed,
+                                      uint8_t *output)
+{
+        return host_encod(bg, z, k, f, input, input_packed, output, false);
+}
+
+doca_error_t nrLDPC_host_encod(uint8_t bg,
+                               uint16_t z,
+                               uint32_t k,
+                               uint32_t f,
+                               const uint8_t *input,
+                               bool input_packed,
+                               uint8_t *output)
+{
+        return host_encod(bg, z, k, f, input, input_packed, output, nrLDPC_host_encod_simd());
+}
@@ -0,0 +1,71 @@
+/*
+ * Filename: nrLDPC_host_encod.h
+ *
+ * LDPC encoder running on the host CPU, the fallback of the DPU encoder service: 5G NR BG1/BG2, all lifting
+ * sizes, TS 38.212 section 5.3.2. The codeword is computed from the quasi-cyclic structure of the base graph,
+ * each circulant being one cyclic rotation of Zc bits, one bit per byte, XORed with AVX2 when the CPU supports it.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_HOST_ENCOD_H_
+#define NRLDPC_HOST_ENCOD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <doca_error.h>
+
+/**
+ * Encode one segment, as the DPU encoder does: the codeword bits from column 2 on, N = 66 * Zc bits for BG1 and
+ * 50 * Zc bits for BG2, one bit per byte. The F filler bits, the last ones of the K input bits, and the bits
+ * from K to Kb * Zc are encoded as 0 and written as 0.
+ *
+ * @bg [in]: Base graph, 1 or 2
+ * @z [in]: Lifting size (Zc)
+ * @k [in]: Input bits (K), filler bits included, at most 22 * Zc for BG1 and 10 * Zc for BG2
+ * @f [in]: Filler bits (F)
+ * @input [in]: K input bits, packed (8 per byte, first bit in the MSB) or one bit per byte
+ * @input_packed [in]: Layout of input
+ * @output [out]: N codeword bits, one bit per byte
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_INVALID_VALUE for parameters out of TS 38.212 and
+ * DOCA_ERROR_NO_MEMORY if the thread workspace cannot be allocated
+ */
+doca_error_t nrLDPC_host_encod(uint8_t bg,
+                               uint16_t z,
+                               uint32_t k,
+                               uint32_t f,
+                               const uint8_t *input,
+                               bool input_packed,
+                               uint8_t *output);
+
+/**
+ * Scalar implementation of nrLDPC_host_encod, the reference of the SIMD kernels
+ *
+ * @bg [in]: Base graph, 1 or 2
+ * @z [in]: Lifting size (Zc)
+ * @k [in]: Input bits (K), filler bits included
+ * @f [in]: Filler bits (F)
+ * @input [in]: K input bits, packed or one bit per byte
+ * @input_packed [in]: Layout of input
+ * @output [out]: N codeword bits, one bit per byte
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_INVALID_VALUE for parameters out of TS 38.212 and
+ * DOCA_ERROR_NO_MEMORY if the thread workspace cannot be allocated
+ */
+doca_error_t nrLDPC_host_encod_scalar(uint8_t bg,
+                                      uint16_t z,
+                                      uint32_t k,
+                                      uint32_t f,
+                                      const uint8_t *input,
+                                      bool input_packed,
+                                      uint8_t *output);
+
+/**
+ * Whether nrLDPC_host_encod runs the AVX2 kernels
+ *
+ * @return: true when the AVX2 kernels are used
+ */
+bool nrLDPC_host_encod_simd(void);
+
+#endif // NRLDPC_HOST_ENCOD_H_
@@ -7,6 +7,13 @@
 
 #include <stdint.h>
 
+#include <doca_error.h>
+#include <doca_log.h>
+
+#include "nrLDPC_session.h"
+
+DOCA_LOG_REGISTER(NRLDPC_INITCALL);
+
 // ALIAS DECLARATION
 // LDPCinit declared as an alias for nrLDPC_encod
 extern int32_t LDPCinit(void)
@@ -18,15 +25,24 @@ extern int32_t LDPCinit(void)
  *
  * This function initiates the new 5G NR LDPC function required by OAI interface in the libldpc_armral.so
  * library as required to be dynamically loaded at run-time by the oai shared library loader.
- * Currentely there is nothing to do (dummy function).
+ * It opens the DOCA device and connects the DOCA Comch clients, producers and consumers to the DPU servers
+ * once, so that nrLDPC_encod / nrLDPC_decod calls only exchange messages. The session is configured from the
+ * NRLDPC_* environment variables (see nrLDPC_session.h).
  *
  * @return: EXIT_SUCCESS on success and EXIT_FAILURE otherwise
  */
 int32_t nrLDPC_initcall(void)
 {
+        struct nrLDPC_session_cfg cfg;
+        doca_error_t result;
 
-        /* Library-specific initialization logic */
+        nrLDPC_session_cfg_from_env(&cfg);
 
-        return 0;                            /* Return 0 on success, other values on failure */
+        result = nrLDPC_session_init(&cfg);
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to initialize the LDPC offloading session: %s", doca_error_get_descr(result));
+                return -1;
+        }
 
+        return 0;                            /* Return 0 on success, other values on failure */
 }
@@ -0,0 +1,91 @@
+/*
+ * Filename: nrLDPC_proto.c
+ *
+ * Wire format of the LDPC offloading requests and responses
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include <doca_log.h>
+
+#include "nrLDPC_proto.h"
+
+DOCA_LOG_REGISTER(NRLDPC_PROTO);
+
+static _Atomic(uint32_t) next_req_id; /* Last request id handed out */
+
+uint32_t nrLDPC_proto_next_req_id(void)
+{
+        return atomic_fetch_add_explicit(&next_req_id, 1, memory_order_relaxed) + 1;
+}
+
+uint32_t nrLDPC_proto_pack(void *msg,
+                           uint32_t size,
+                           struct nrLDPC_proto_hdr *hdr,
+                           const void *payload,
+                           uint32_t payload_len)
+{
+        if (size < sizeof(*hdr) || payload_len > size - sizeof(*hdr))
+                return 0;
+
+        hdr->magic = NRLDPC_PROTO_MAGIC;
+        hdr->version = NRLDPC_PROTO_VERSION;
+        hdr->payload_len = payload_len;
+
+        memcpy(msg, hdr, sizeof(*hdr));
+        if (payload_len != 0 && payload != (uint8_t *)msg + sizeof(*hdr))
+                memcpy((uint8_t *)msg + sizeof(*hdr), payload, payload_len);
+
+        return sizeof(*hdr) + payload_len;
+}
+
+doca_error_t nrLDPC_proto_unpack(const void *msg, uint32_t len, struct nrLDPC_proto_hdr *hdr, const void **payload)
+{
+        if (len < sizeof(*hdr)) {
+                DOCA_LOG_ERR("Message of %u bytes is shorter than the header", len);
+                return DOCA_ERROR_INVALID_VALUE;
+        }
+
+        memcpy(hdr, msg, sizeof(*hdr));
+
+        if (hdr->magic != NRLDPC_PROTO_MAGIC || hdr->version != NRLDPC_PROTO_VERSION) {
+                DOCA_LOG_ERR("Unsupported message: magic 0x%04x version %u", hdr->magic, hdr->version);
+                return DOCA_ERROR_NOT_SUPPORTED;
+        }
+
+        if (hdr->payload_len > len - sizeof(*hdr)) {
+                DOCA_LOG_ERR("Truncated message: %u bytes payload announced, %zu received",
+                             hdr->payload_len,
+                             len - sizeof(*hdr));
+                return DOCA_ERROR_INVALID_VALUE;
+        }
+
+        *payload = (const uint8_t *)msg + sizeof(*hdr);
+        return DOCA_SUCCESS;
+}
+
+doca_error_t nrLDPC_proto_check_resp(const struct nrLDPC_proto_hdr *req, const struct nrLDPC_proto_hdr *resp)
+{
+        if (resp->op != req->op + 1 || resp->req_id != req->req_id) {
+                DOCA_LOG_ERR("Response op %u id %u does not answer request op %u id %u",
+                             resp->op,
+                             resp->req_id,
+                             req->op,
+                             req->req_id);
+                return DOCA_ERROR_UNEXPECTED;
+        }
+
+        if (resp->status == NRLDPC_PROTO_STATUS_CANCELLED)
+                return NRLDPC_PROTO_ERROR_CANCELLED;
+
+        if (resp->status < 0) {
+                DOCA_LOG_ERR("Request %u failed on the server with status %d", req->req_id, resp->status);
+                return DOCA_ERROR_IO_FAILED;
+        }
+
+        return DOCA_SUCCESS;
+}
@@ -0,0 +1,220 @@
+/*
+ * Filename: nrLDPC_proto.h
+ *
+ * Wire format of the LDPC offloading requests and responses exchanged with nrLDPC_encod_server /
+ * nrLDPC_decod_server over the DOCA Comch data path.
+ *
+ * Every message is a fixed 32-byte header followed by payload_len bytes:
+ *
+ *      op              request payload                         response payload
+ *      ENCOD_REQ       num_segs x K input bits, packed         -
+ *                      or num_segs x nrLDPC_proto_rm, then
+ *                      num_segs x K input bits, packed
+ *      ENCOD_RESP      -                                       num_segs x N codeword bits, packed
+ *                                                              or E rate matched bits of each segment, packed
+ *      DECOD_REQ       N LLRs, one int8_t each                 -
+ *                      or nrLDPC_proto_rm, then E LLRs
+ *      DECOD_RESP      -                                       Kprime decoded bits, packed (Kprime / 8 bytes)
+ *      CANCEL_REQ      uint32_t req_id of each request to skip -
+ *      CANCEL_RESP     -                                       -
+ *      HARQ_FREE_REQ   nrLDPC_proto_harq of each process       -
+ *      HARQ_FREE_RESP  -                                       -
+ *
+ * Packed bits are 8 per byte, first bit in the MSB (see nrLDPC_bits.h), sizes are rounded up to whole bytes.
+ * The segments of an encoder request all share BG, Z, K and F, each one starts on a byte boundary.
+ * A decoder request flagged NRLDPC_PROTO_FLAG_BLOCKS carries payload_len / N code blocks sharing BG, Z, Kprime
+ * and the iterations; its response holds the Kprime / 8 decoded bytes of each block, then the int32_t status of
+ * each block; the status of the header is only negative when the whole message failed.
+ * A cancel is handled on arrival, ahead of the requests queued before it: the listed requests the server has not
+ * started are answered at once, in their turn, with NRLDPC_PROTO_STATUS_CANCELLED and no payload, the others as
+ * usual. The status of the CANCEL_RESP is the number of requests skipped.
+ * A decoder request flagged NRLDPC_PROTO_FLAG_HARQ is combined with the soft buffer the server keeps for its
+ * (ulsch_id, harq_pid, segment) before it is decoded: its payload is a struct nrLDPC_proto_harq then the LLRs of
+ * this transmission only, payload_len - 8 of them, from position offset of the N LLRs of the buffer and wrapping
+ * around at N. The LLRs outside that window are 0, they leave the buffer as it is. NRLDPC_PROTO_HARQ_NEW_DATA
+ * clears the buffer first. The server bounds its buffers and reuses the least recently used one when they are all
+ * taken; a retransmission whose buffer was reused is decoded from its own LLRs and answered with
+ * NRLDPC_PROTO_FLAG_HARQ_MISS. A HARQ request skipped by a cancel is still combined. A HARQ_FREE_REQ frees the
+ * buffers of every segment of the listed processes, only ulsch_id and harq_pid are read, the status of its
+ * response is the number of buffers freed.
+ * A decoder request flagged NRLDPC_PROTO_FLAG_RATE_MATCHED carries the E LLRs of the code block as received, a
+ * struct nrLDPC_proto_rm then E = payload_len - 12 LLRs: the server undoes the bit interleaving and the bit
+ * selection of TS 38.212 5.4.2 into the N LLRs it decodes, repeated bits added, filler bits known to be 0 and the
+ * bits not sent 0. It is not combined with NRLDPC_PROTO_FLAG_BLOCKS or NRLDPC_PROTO_FLAG_HARQ.
+ * An encoder request flagged NRLDPC_PROTO_FLAG_RATE_MATCHED carries the struct nrLDPC_proto_rm of each segment,
+ * with the f of the header, ahead of the input bits: the server rate matches each codeword as TS 38.212 5.4.2
+ * says and answers the E interleaved bits of each segment, ready for scrambling, instead of its N codeword bits.
+ * E is at most NRLDPC_PROTO_ENCOD_MAX_N, so that a segment never needs more than a codeword of the message size.
+ * Every lifting size of TS 38.212 is carried: a decoder message is at most NRLDPC_PROTO_MAX_MSG_SIZE bytes, the
+ * 68 * 384 LLRs of the largest BG1 code block and a HARQ or rate matching prefix; an encoder message carries up to
+ * NRLDPC_ENCOD_MSG_SEGS codewords. The server receives into buffers of the largest message, the client sends
+ * each message from a buffer of its size class, see nrLDPC_common.h.
+ * A decoder request whose crc_idx names a CRC, NRLDPC_PROTO_CRC_*, carries it in the last bits of its Kprime:
+ * the server checks it after each iteration and stops at the first one it passes. The status of the response, and
+ * of each block of a NRLDPC_PROTO_FLAG_BLOCKS one, is then the iterations run, num_its + 1 when the CRC never
+ * passed, as OAI's decoder counts them: the client does not check the CRC again.
+ * The server announces what it speaks on connection, before it echoes the start of the data path: the message
+ * STR_DATA_PATH_PROTO then "<version>,<features>", NRLDPC_PROTO_VERSION and the NRLDPC_PROTO_FEATURE_* it serves
+ * (see nrLDPC_common.h). The version must match, the client does not offload to a server of another version, or
+ * to one that announces none, which speaks the fixed messages that preceded this header: the LDPC functions run
+ * on the host then. The features are optional: the client sends no flag, op or crc_idx of a feature the server
+ * did not announce, it does that part of the work on the host instead.
+ * Host (x86/Arm) and DPU (Arm) are both little-endian, the header is sent in host byte order.
+ * Requests of a per-thread channel (NRLDPC_THREAD_CHANNELS) carry the 32-bit ID of the consumer to answer as the
+ * immediate data of the producer send task, requests without immediate data are answered on the first consumer
+ * the client announced on the connection.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_PROTO_H_
+#define NRLDPC_PROTO_H_
+
+#include <stdint.h>
+
+#include <doca_error.h>
+
+#include "comch_ctrl_path_common.h"
+
+#define NRLDPC_PROTO_MAGIC 0x504c           /* "LP" */
+#define NRLDPC_PROTO_VERSION 10             /* Bumped on any incompatible change of the header or payloads */
+#define NRLDPC_PROTO_MAX_MSG_SIZE (32 * 1024) /* Largest decoder message, 68 * 384 LLRs and their prefix fit */
+#define NRLDPC_PROTO_MAX_PAYLOAD (NRLDPC_PROTO_MAX_MSG_SIZE - 32) /* Its payload, after the 32-byte header */
+#define NRLDPC_PROTO_DECOD_RESP_SIZE (sizeof(struct nrLDPC_proto_hdr) + 22 * 384 / 8) /* Response of one block */
+#define NRLDPC_PROTO_ENCOD_MAX_K (22 * 384) /* Largest encoder segment, BG1 with Zc = 384 */
+#define NRLDPC_PROTO_ENCOD_MAX_N (66 * 384) /* Largest codeword, BG1 with Zc = 384 */
+#define NRLDPC_PROTO_ENCOD_MAX_SEGS NR_LDPC_MAX_NUM_CB /* Segments of a transport block */
+/* Largest encoder message carrying segs segments of any size, the response is the larger one */
+#define NRLDPC_PROTO_ENCOD_MSG_SIZE(segs) (sizeof(struct nrLDPC_proto_hdr) + (segs) * (NRLDPC_PROTO_ENCOD_MAX_N / 8))
+
+#define NRLDPC_PROTO_FLAG_BLOCKS 0x01       /* Decoder: the payload carries several code blocks, see above */
+#define NRLDPC_PROTO_FLAG_HARQ 0x02         /* Decoder: combined with a soft buffer kept by the server, see above */
+#define NRLDPC_PROTO_FLAG_HARQ_MISS 0x04    /* Decoder response: the soft buffer of a retransmission was not found */
+#define NRLDPC_PROTO_FLAG_RATE_MATCHED 0x08 /* E LLRs as received, or encoder: E bits returned, see above */
+
+/* Optional parts of the protocol, announced by the server on connection, see above */
+#define NRLDPC_PROTO_FEATURE_BLOCKS 0x01       /* Decoder requests flagged NRLDPC_PROTO_FLAG_BLOCKS */
+#define NRLDPC_PROTO_FEATURE_CANCEL 0x02       /* NRLDPC_PROTO_OP_CANCEL_REQ */
+#define NRLDPC_PROTO_FEATURE_HARQ 0x04         /* NRLDPC_PROTO_FLAG_HARQ and NRLDPC_PROTO_OP_HARQ_FREE_REQ */
+#define NRLDPC_PROTO_FEATURE_RM_DECOD 0x08     /* Decoder requests flagged NRLDPC_PROTO_FLAG_RATE_MATCHED */
+#define NRLDPC_PROTO_FEATURE_RM_ENCOD 0x10     /* Encoder requests flagged NRLDPC_PROTO_FLAG_RATE_MATCHED */
+#define NRLDPC_PROTO_FEATURE_CRC 0x20          /* Decoder requests whose crc_idx names a CRC */
+#define NRLDPC_PROTO_FEATURES_ALL 0x3f         /* Every feature of NRLDPC_PROTO_VERSION */
+
+#define NRLDPC_PROTO_CRC_NONE 0 /* crc_idx: no CRC checked, every block runs num_its iterations */
+#define NRLDPC_PROTO_CRC_24A 1  /* crc_idx: CRC24A of TS 38.212 5.1, a transport block of one code block */
+#define NRLDPC_PROTO_CRC_24B 2  /* crc_idx: CRC24B, each code block of a segmented transport block */
+#define NRLDPC_PROTO_CRC_16 3   /* crc_idx: CRC16, a small transport block */
+
+#define NRLDPC_PROTO_HARQ_NEW_DATA 0x01 /* nrLDPC_proto_harq ctrl: first transmission, the buffer starts from 0 */
+
+#define NRLDPC_PROTO_STATUS_CANCELLED (-2)              /* Response status of a request skipped by a cancel */
+#define NRLDPC_PROTO_ERROR_CANCELLED DOCA_ERROR_SHUTDOWN /* Result of a request dropped or skipped on abort */
+
+enum nrLDPC_proto_op {
+        NRLDPC_PROTO_OP_ENCOD_REQ = 1,  /* Encode one code block */
+        NRLDPC_PROTO_OP_ENCOD_RESP,     /* Codeword of an ENCOD_REQ */
+        NRLDPC_PROTO_OP_DECOD_REQ,      /* Decode one code block */
+        NRLDPC_PROTO_OP_DECOD_RESP,     /* Decoded bits of a DECOD_REQ */
+        NRLDPC_PROTO_OP_CANCEL_REQ,     /* Skip requests sent before, not started yet */
+        NRLDPC_PROTO_OP_CANCEL_RESP,    /* Number of requests a CANCEL_REQ skipped */
+        NRLDPC_PROTO_OP_HARQ_FREE_REQ,  /* Free the soft buffers of HARQ processes */
+        NRLDPC_PROTO_OP_HARQ_FREE_RESP, /* Number of soft buffers a HARQ_FREE_REQ freed */
+};
+
+struct nrLDPC_proto_hdr {
+        uint16_t magic;       /* NRLDPC_PROTO_MAGIC */
+        uint8_t version;      /* NRLDPC_PROTO_VERSION */
+        uint8_t op;           /* enum nrLDPC_proto_op */
+        uint8_t bg;           /* Base graph, as given by OAI */
+        uint8_t flags;        /* NRLDPC_PROTO_FLAG_*, 0 for none */
+        uint16_t z;           /* Lifting size (Zc) */
+        uint32_t req_id;      /* Request id, echoed in the response */
+        uint32_t k;           /* K (encoder) or Kprime (decoder), in bits */
+        uint32_t n;           /* Decoder: number of LLRs (68 * Z for BG1, 52 * Z for BG2), encoder: codeword bits */
+        uint16_t f;           /* Encoder: number of filler bits */
+        union {
+                struct {
+                        uint8_t num_its; /* Decoder: maximum number of iterations */
+                        uint8_t crc_idx; /* Decoder: CRC attached to the segment, NRLDPC_PROTO_CRC_* */
+                };
+                uint16_t num_segs;       /* Encoder: number of segments, 0 is read as 1 */
+        };
+        int32_t status;       /* Response: negative on error, decoder: iterations run, see crc_idx above */
+        uint32_t payload_len; /* Bytes following the header */
+};
+
+_Static_assert(sizeof(struct nrLDPC_proto_hdr) == 32, "nrLDPC_proto_hdr is part of the wire format");
+
+/* Soft buffer of a NRLDPC_PROTO_FLAG_HARQ decoder request, at the start of its payload */
+struct nrLDPC_proto_harq {
+        uint8_t ulsch_id; /* ULSCH process, as given by OAI */
+        uint8_t harq_pid; /* HARQ process, as given by OAI */
+        uint16_t segment; /* Code block of the transport block */
+        uint16_t offset;  /* Position of the first LLR of the payload in the buffer */
+        uint8_t ctrl;     /* NRLDPC_PROTO_HARQ_*, 0 for a retransmission */
+        uint8_t reserved; /* 0 */
+};
+
+_Static_assert(sizeof(struct nrLDPC_proto_harq) == 8, "nrLDPC_proto_harq is part of the wire format");
+
+/* Rate matching of a NRLDPC_PROTO_FLAG_RATE_MATCHED request, at the start of its payload, one per segment */
+struct nrLDPC_proto_rm {
+        uint32_t e;        /* Rate matched bits of the code block (E): decoder LLRs following this, encoder bits */
+        uint16_t ncb;      /* Circular buffer length (Ncb), 66 * Z for BG1 and 50 * Z for BG2 without LBRM */
+        uint16_t f;        /* Filler bits (F), the last ones of the K = 22 * Z or 10 * Z systematic bits */
+        uint8_t rv;        /* Redundancy version, 0 to 3 */
+        uint8_t qm;        /* Modulation order, bits per symbol: 1, 2, 4, 6 or 8 */
+        uint16_t reserved; /* 0 */
+};
+
+_Static_assert(sizeof(struct nrLDPC_proto_rm) == 12, "nrLDPC_proto_rm is part of the wire format");
+_Static_assert(NRLDPC_PROTO_MAX_PAYLOAD >= 68 * 384 + sizeof(struct nrLDPC_proto_rm),
+               "A decoder message carries the largest code block with its prefix");
+
+/**
+ * Get a new request id
+ *
+ * @return: Request id, unique for the process lifetime modulo 2^32
+ */
+uint32_t nrLDPC_proto_next_req_id(void);
+
+/**
+ * Serialize a message: the header, with magic, version and payload_len filled in, then the payload
+ *
+ * @msg [out]: Message buffer
+ * @size [in]: Size of the message buffer
+ * @hdr [in/out]: Message header
+ * @payload [in]: Payload, may be NULL when payload_len is 0 or already in place right after the header
+ * @payload_len [in]: Payload length
+ * @return: Message length, 0 if it does not fit in size bytes
+ */
+uint32_t nrLDPC_proto_pack(void *msg,
+                           uint32_t size,
+                           struct nrLDPC_proto_hdr *hdr,
+                           const void *payload,
+                           uint32_t payload_len);
+
+/**
+ * Parse and validate a message
+ *
+ * @msg [in]: Message
+ * @len [in]: Message length
+ * @hdr [out]: Message header
+ * @payload [out]: Payload address inside msg
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_proto_unpack(const void *msg, uint32_t len, struct nrLDPC_proto_hdr *hdr, const void **payload);
+
+/**
+ * Check that a response answers a request
+ *
+ * @req [in]: Request header
+ * @resp [in]: Response header
+ * @return: DOCA_SUCCESS on success, NRLDPC_PROTO_ERROR_CANCELLED when a cancel skipped the request and DOCA_ERROR
+ * otherwise
+ */
+doca_error_t nrLDPC_proto_check_resp(const struct nrLDPC_proto_hdr *req, const struct nrLDPC_proto_hdr *resp);
+
+#endif // NRLDPC_PROTO_H_
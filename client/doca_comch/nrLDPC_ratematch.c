@@ -0,0 +1,317 @@
+/*
+ * Filename: nrLDPC_ratematch.c
+ *
+ * Rate matching and recovery of the LDPC code blocks, see nrLDPC_ratematch.h. The bit selection and the bit
+ * interleaving are walked together, row by row of the interleaver, so the circular buffer position only moves
+ * forward and no E bits intermediate buffer is needed.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <doca_log.h>
+
+#include "nrLDPC_bg.h"
+#include "nrLDPC_bits.h"
+#include "nrLDPC_host_encod.h"
+#include "nrLDPC_ratematch.h"
+
+DOCA_LOG_REGISTER(NRLDPC_RATEMATCH);
+
+/* Counters of the rate matched decodes and encodes, updated by the calling threads without a lock */
+struct rm_counters {
+        _Atomic(uint64_t) calls;            /* Decodes sent with NRLDPC_PROTO_FLAG_RATE_MATCHED */
+        _Atomic(uint64_t) llr_bytes;        /* LLR bytes sent, E per decode */
+        _Atomic(uint64_t) full_bytes;       /* LLR bytes the recovered code blocks would have taken, N per decode */
+        _Atomic(uint64_t) host;             /* Code blocks recovered on the host */
+        _Atomic(uint64_t) encod_segs;       /* Segments encoded with NRLDPC_PROTO_FLAG_RATE_MATCHED */
+        _Atomic(uint64_t) encod_bytes;      /* Bytes of their responses */
+        _Atomic(uint64_t) encod_full_bytes; /* Bytes their codewords would have taken */
+        _Atomic(uint64_t) encod_host;       /* Segments encoded and rate matched on the host */
+};
+
+static struct rm_counters counters;
+
+static pthread_key_t rm_cw_key;                       /* Owns the codeword buffer of each thread */
+static pthread_once_t rm_cw_once = PTHREAD_ONCE_INIT; /* Creates rm_cw_key */
+
+/* k0 of each redundancy version, in Zc units times Ncb / N, TS 38.212 Table 5.4.2.1-2 */
+static const uint8_t rm_k0_num[2][4] = {
+        {0, 17, 33, 56}, /* BG1, N = 66 * Zc */
+        {0, 13, 25, 43}, /* BG2, N = 50 * Zc */
+};
+
+/* Bit positions of the circular buffer of a code block */
+struct rm_walk {
+        uint32_t pos;          /* Next position, from k0 on */
+        uint32_t ncb;          /* Circular buffer length (Ncb) */
+        uint32_t filler_start; /* First filler bit, K' - 2 * Zc */
+        uint32_t filler_end;   /* Position after the last one, K - 2 * Zc */
+};
+
+/*
+ * Create the key of the per thread codeword buffers
+ */
+static void rm_cw_key_create(void)
+{
+        (void)pthread_key_create(&rm_cw_key, free);
+}
+
+/**
+ * Get the codeword buffer of the calling thread, NRLDPC_PROTO_ENCOD_MAX_N bits, too large for the stacks of the
+ * OAI threads
+ *
+ * @return: The buffer on success and NULL otherwise
+ */
+static uint8_t *rm_cw_get(void)
+{
+        uint8_t *cw;
+
+        pthread_once(&rm_cw_once, rm_cw_key_create);
+        cw = pthread_getspecific(rm_cw_key);
+        if (cw == NULL) {
+                cw = malloc(NRLDPC_PROTO_ENCOD_MAX_N);
+                if (cw == NULL || pthread_setspecific(rm_cw_key, cw) != 0) {
+                        free(cw);
+                        return NULL;
+                }
+        }
+
+        return cw;
+}
+
+uint32_t nrLDPC_rm_k0(uint8_t bg, uint16_t z, uint32_t ncb, uint8_t rv)
+{
+        const struct nrLDPC_bg *g = nrLDPC_bg_get(bg);
+        uint32_t n;
+
+        if (g == NULL || z == 0)
+                return 0;
+        n = (uint32_t)(g->cols - NRLDPC_BG_PUNCTURED) * z;
+        return (uint32_t)((uint64_t)rm_k0_num[g->bg - 1][rv & 3] * ncb / n) * z;
+}
+
+doca_error_t nrLDPC_rm_check(uint8_t bg, uint16_t z, const struct nrLDPC_proto_rm *rm)
+{
+        const struct nrLDPC_bg *g = nrLDPC_bg_get(bg);
+        uint32_t filler_end;
+
+        if (g == NULL || nrLDPC_bg_ils(z) < 0) {
+                DOCA_LOG_ERR("Invalid code block: BG = %u, Zc = %u", bg, z);
+                return DOCA_ERROR_INVALID_VALUE;
+        }
+        filler_end = (uint32_t)(g->kb - NRLDPC_BG_PUNCTURED) * z;
+        if (rm->e == 0 || rm->rv > 3 || (rm->qm != 1 && rm->qm != 2 && rm->qm != 4 && rm->qm != 6 && rm->qm != 8) ||
+            rm->e % rm->qm != 0 || rm->f >= filler_end || rm->ncb < filler_end ||
+            rm->ncb > (uint32_t)(g->cols - NRLDPC_BG_PUNCTURED) * z) {
+                DOCA_LOG_ERR("Invalid rate matching: E = %u, rv = %u, Qm = %u, F = %u, Ncb = %u for BG = %u, Zc = %u",
+                             rm->e,
+                             rm->rv,
+                             rm->qm,
+                             rm->f,
+                             rm->ncb,
+                             bg,
+                             z);
+                return DOCA_ERROR_INVALID_VALUE;
+        }
+
+        return DOCA_SUCCESS;
+}
+
+/**
+ * Start walking the circular buffer of a code block, the rate matching must be checked
+ *
+ * @g [in]: Base graph
+ * @z [in]: Lifting size (Zc)
+ * @rm [in]: Rate matching
+ * @walk [out]: Walk at k0
+ */
+static void rm_walk_start(const struct nrLDPC_bg *g,
+                          uint16_t z,
+                          const struct nrLDPC_proto_rm *rm,
+                          struct rm_walk *walk)
+{
+        walk->pos = nrLDPC_rm_k0(g->bg, z, rm->ncb, rm->rv);
+        walk->ncb = rm->ncb;
+        walk->filler_end = (uint32_t)(g->kb - NRLDPC_BG_PUNCTURED) * z;
+        walk->filler_start = walk->filler_end - rm->f;
+}
+
+/**
+ * Position of the next bit selected, the filler bits are skipped
+ *
+ * @walk [in/out]: Walk
+ * @return: Position in the circular buffer
+ */
+static inline uint32_t rm_walk_next(struct rm_walk *walk)
+{
+        if (walk->pos >= walk->filler_start && walk->pos < walk->filler_end)
+                walk->pos = walk->filler_end;
+        if (walk->pos >= walk->ncb)
+                walk->pos = 0;
+        return walk->pos++;
+}
+
+doca_error_t nrLDPC_rm_match(uint8_t bg,
+                             uint16_t z,
+                             const struct nrLDPC_proto_rm *rm,
+                             const uint8_t *cw,
+                             uint8_t *bits)
+{
+        const struct nrLDPC_bg *g = nrLDPC_bg_get(bg);
+        struct rm_walk walk;
+        doca_error_t result;
+        uint32_t rows;
+        uint32_t i, j;
+
+        result = nrLDPC_rm_check(bg, z, rm);
+        if (result != DOCA_SUCCESS)
+                return result;
+
+        /* Bit e[i * E / Qm + j] of the selection is sent as f[i + j * Qm] */
+        rm_walk_start(g, z, rm, &walk);
+        rows = rm->e / rm->qm;
+        for (i = 0; i < rm->qm; i++)
+                for (j = 0; j < rows; j++)
+                        bits[i + j * rm->qm] = cw[rm_walk_next(&walk)];
+
+        return DOCA_SUCCESS;
+}
+
+doca_error_t nrLDPC_rm_encod(uint8_t bg,
+                             uint16_t z,
+                             uint32_t k,
+                             const struct nrLDPC_proto_rm *rm,
+                             const uint8_t *input,
+                             bool input_packed,
+                             uint8_t *bits)
+{
+        uint8_t *cw = rm_cw_get();
+        doca_error_t result;
+
+        if (cw == NULL)
+                return DOCA_ERROR_NO_MEMORY;
+        result = nrLDPC_rm_check(bg, z, rm);
+        if (result != DOCA_SUCCESS)
+                return result;
+        if ((uint32_t)(nrLDPC_bg_get(bg)->cols - NRLDPC_BG_PUNCTURED) * z > NRLDPC_PROTO_ENCOD_MAX_N)
+                return DOCA_ERROR_INVALID_VALUE;
+
+        result = nrLDPC_host_encod(bg, z, k, rm->f, input, input_packed, cw);
+        if (result != DOCA_SUCCESS)
+                return result;
+
+        return nrLDPC_rm_match(bg, z, rm, cw, bits);
+}
+
+doca_error_t nrLDPC_rm_recover(uint8_t bg,
+                               uint16_t z,
+                               const struct nrLDPC_proto_rm *rm,
+                               const int8_t *in,
+                               int8_t *llrs)
+{
+        const struct nrLDPC_bg *g = nrLDPC_bg_get(bg);
+        struct rm_walk walk;
+        doca_error_t result;
+        int8_t *d;
+        uint32_t rows, pos;
+        int32_t sum;
+        uint32_t i, j;
+
+        result = nrLDPC_rm_check(bg, z, rm);
+        if (result != DOCA_SUCCESS)
+                return result;
+
+        memset(llrs, 0, (size_t)g->cols * z);
+        d = llrs + NRLDPC_BG_PUNCTURED * z;
+        rm_walk_start(g, z, rm, &walk);
+        rows = rm->e / rm->qm;
+        for (i = 0; i < rm->qm; i++) {
+                for (j = 0; j < rows; j++) {
+                        pos = rm_walk_next(&walk);
+                        sum = d[pos] + in[i + j * rm->qm];
+                        if (sum > NRLDPC_RM_LLR_MAX)
+                                sum = NRLDPC_RM_LLR_MAX;
+                        else if (sum < -NRLDPC_RM_LLR_MAX)
+                                sum = -NRLDPC_RM_LLR_MAX;
+                        d[pos] = (int8_t)sum;
+                }
+        }
+        memset(d + walk.filler_start, NRLDPC_RM_FILLER_LLR, rm->f);
+
+        return DOCA_SUCCESS;
+}
+
+void nrLDPC_rm_init(void)
+{
+        atomic_store(&counters.calls, 0);
+        atomic_store(&counters.llr_bytes, 0);
+        atomic_store(&counters.full_bytes, 0);
+        atomic_store(&counters.host, 0);
+        atomic_store(&counters.encod_segs, 0);
+        atomic_store(&counters.encod_bytes, 0);
+        atomic_store(&counters.encod_full_bytes, 0);
+        atomic_store(&counters.encod_host, 0);
+}
+
+void nrLDPC_rm_count_sent(uint32_t n, uint32_t e)
+{
+        atomic_fetch_add_explicit(&counters.calls, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters.llr_bytes, e, memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters.full_bytes, n, memory_order_relaxed);
+}
+
+void nrLDPC_rm_count_host(void)
+{
+        atomic_fetch_add_explicit(&counters.host, 1, memory_order_relaxed);
+}
+
+void nrLDPC_rm_count_encod(uint32_t n, uint32_t e)
+{
+        atomic_fetch_add_explicit(&counters.encod_segs, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters.encod_bytes, nrLDPC_bits_bytes(e), memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters.encod_full_bytes, nrLDPC_bits_bytes(n), memory_order_relaxed);
+}
+
+void nrLDPC_rm_count_encod_host(void)
+{
+        atomic_fetch_add_explicit(&counters.encod_host, 1, memory_order_relaxed);
+}
+
+void nrLDPC_rm_get_stats(struct nrLDPC_rm_stats *stats)
+{
+        stats->calls = atomic_load_explicit(&counters.calls, memory_order_relaxed);
+        stats->llr_bytes = atomic_load_explicit(&counters.llr_bytes, memory_order_relaxed);
+        stats->full_bytes = atomic_load_explicit(&counters.full_bytes, memory_order_relaxed);
+        stats->host = atomic_load_explicit(&counters.host, memory_order_relaxed);
+        stats->encod_segs = atomic_load_explicit(&counters.encod_segs, memory_order_relaxed);
+        stats->encod_bytes = atomic_load_explicit(&counters.encod_bytes, memory_order_relaxed);
+        stats->encod_full_bytes = atomic_load_explicit(&counters.encod_full_bytes, memory_order_relaxed);
+        stats->encod_host = atomic_load_explicit(&counters.encod_host, memory_order_relaxed);
+}
+
+void nrLDPC_rm_report(void)
+{
+        struct nrLDPC_rm_stats stats;
+
+        nrLDPC_rm_get_stats(&stats);
+        if (stats.encod_segs != 0 || stats.encod_host != 0)
+                DOCA_LOG_INFO("Rate matched encodes: %lu segments sent, %lu bytes returned instead of %lu, %lu "
+                              "rate matched on the host",
+                              (unsigned long)stats.encod_segs,
+                              (unsigned long)stats.encod_bytes,
+                              (unsigned long)stats.encod_full_bytes,
+                              (unsigned long)stats.encod_host);
+        if (stats.calls == 0 && stats.host == 0)
+                return;
+        DOCA_LOG_INFO("Rate matched decodes: %lu sent, %lu LLR bytes instead of %lu, %lu recovered on the host",
+                      (unsigned long)stats.calls,
+                      (unsigned long)stats.llr_bytes,
+                      (unsigned long)stats.full_bytes,
+                      (unsigned long)stats.host);
+}
@@ -0,0 +1,159 @@
+/*
+ * Filename: nrLDPC_ratematch.h
+ *
+ * Rate matching of TS 38.212 5.4.2, NRLDPC_PROTO_FLAG_RATE_MATCHED: the bit selection of E bits from the circular
+ * buffer of the codeword, starting at the k0 of the redundancy version and skipping the filler bits, then the bit
+ * interleaving over Qm rows. The decoder request carries the E LLRs as received and the DPU server recovers the N
+ * LLRs it decodes, so a code block at a high code rate sends E bytes across PCIe instead of N and the host spends
+ * nothing on the recovery. The host recovers them itself when it decodes instead. The encoder request asks for
+ * the E bits ready for scrambling instead of the N bits of the codeword, rate matched on the DPU.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_RATEMATCH_H_
+#define NRLDPC_RATEMATCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <doca_error.h>
+
+#include "nrLDPC_proto.h"
+
+#define NRLDPC_RM_MAX_LLRS (NR_LDPC_NCOL_BG1 * NR_LDPC_ZMAX) /* Decoder LLRs of the largest code block */
+#define NRLDPC_RM_LLR_MAX 127                   /* LLRs of repeated bits saturate at plus or minus this */
+#define NRLDPC_RM_FILLER_LLR NRLDPC_RM_LLR_MAX  /* LLR of the filler bits, known to be 0 */
+
+/* Rate matched decodes and encodes sent to the DPU */
+struct nrLDPC_rm_stats {
+        uint64_t calls;            /* Decodes sent with NRLDPC_PROTO_FLAG_RATE_MATCHED */
+        uint64_t llr_bytes;        /* LLR bytes sent, E per decode */
+        uint64_t full_bytes;       /* LLR bytes the recovered code blocks would have taken, N per decode */
+        uint64_t host;             /* Code blocks recovered on the host, decoded there or sent from E = N on */
+        uint64_t encod_segs;       /* Segments encoded with NRLDPC_PROTO_FLAG_RATE_MATCHED */
+        uint64_t encod_bytes;      /* Bytes of their responses, E / 8 per segment */
+        uint64_t encod_full_bytes; /* Bytes their codewords would have taken, N / 8 per segment */
+        uint64_t encod_host;       /* Segments encoded and rate matched on the host */
+};
+
+/**
+ * Start of the bit selection in the circular buffer, k0 of TS 38.212 Table 5.4.2.1-2
+ *
+ * @bg [in]: Base graph, 1 or 2
+ * @z [in]: Lifting size (Zc)
+ * @ncb [in]: Circular buffer length (Ncb)
+ * @rv [in]: Redundancy version, 0 to 3
+ * @return: k0
+ */
+uint32_t nrLDPC_rm_k0(uint8_t bg, uint16_t z, uint32_t ncb, uint8_t rv);
+
+/**
+ * Check the rate matching of a code block
+ *
+ * @bg [in]: Base graph
+ * @z [in]: Lifting size (Zc)
+ * @rm [in]: Rate matching
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR_INVALID_VALUE for parameters out of TS 38.212
+ */
+doca_error_t nrLDPC_rm_check(uint8_t bg, uint16_t z, const struct nrLDPC_proto_rm *rm);
+
+/**
+ * Rate match a codeword: the E bits to scramble and modulate
+ *
+ * @bg [in]: Base graph, 1 or 2
+ * @z [in]: Lifting size (Zc)
+ * @rm [in]: Rate matching
+ * @cw [in]: Codeword from column 2 on, 66 * Zc bits for BG1 and 50 * Zc for BG2, one bit per byte
+ * @bits [out]: rm->e bits, interleaved, one bit per byte
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_rm_match(uint8_t bg,
+                             uint16_t z,
+                             const struct nrLDPC_proto_rm *rm,
+                             const uint8_t *cw,
+                             uint8_t *bits);
+
+/**
+ * Encode a segment and rate match its codeword, the host reference of the rate matched DPU encoder
+ *
+ * @bg [in]: Base graph, 1 or 2
+ * @z [in]: Lifting size (Zc)
+ * @k [in]: Input bits (K), the rm->f filler bits included
+ * @rm [in]: Rate matching
+ * @input [in]: K input bits, packed (8 per byte, first bit in the MSB) or one bit per byte
+ * @input_packed [in]: Layout of input
+ * @bits [out]: rm->e bits, interleaved, one bit per byte
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_rm_encod(uint8_t bg,
+                             uint16_t z,
+                             uint32_t k,
+                             const struct nrLDPC_proto_rm *rm,
+                             const uint8_t *input,
+                             bool input_packed,
+                             uint8_t *bits);
+
+/**
+ * Recover the LLRs of a code block from its rate matched LLRs, in the layout of nrLDPC_decod: the 2 * Zc punctured
+ * LLRs 0, the LLRs of repeated bits added with saturation, the filler bits NRLDPC_RM_FILLER_LLR and the bits not
+ * sent 0
+ *
+ * @bg [in]: Base graph, 1 or 2
+ * @z [in]: Lifting size (Zc)
+ * @rm [in]: Rate matching
+ * @in [in]: rm->e LLRs, as received
+ * @llrs [out]: The 68 * Zc LLRs for BG1, 52 * Zc for BG2
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_rm_recover(uint8_t bg,
+                               uint16_t z,
+                               const struct nrLDPC_proto_rm *rm,
+                               const int8_t *in,
+                               int8_t *llrs);
+
+/**
+ * Reset the counters, called by the session when it is created
+ */
+void nrLDPC_rm_init(void);
+
+/**
+ * Count a rate matched decode sent to the DPU
+ *
+ * @n [in]: LLRs of the recovered code block
+ * @e [in]: LLRs sent
+ */
+void nrLDPC_rm_count_sent(uint32_t n, uint32_t e);
+
+/**
+ * Count a rate matched code block recovered on the host
+ */
+void nrLDPC_rm_count_host(void);
+
+/**
+ * Count a segment encoded with NRLDPC_PROTO_FLAG_RATE_MATCHED
+ *
+ * @n [in]: Codeword bits of the segment
+ * @e [in]: Rate matched bits returned
+ */
+void nrLDPC_rm_count_encod(uint32_t n, uint32_t e);
+
+/**
+ * Count a segment encoded and rate matched on the host
+ */
+void nrLDPC_rm_count_encod_host(void);
+
+/**
+ * Read the counters
+ *
+ * @stats [out]: Counters since the session was created
+ */
+void nrLDPC_rm_get_stats(struct nrLDPC_rm_stats *stats);
+
+/**
+ * Log the counters, called by the session when it is destroyed
+ */
+void nrLDPC_rm_report(void);
+
+#endif // NRLDPC_RATEMATCH_H_
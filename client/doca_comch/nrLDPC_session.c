@@ -0,0 +1,2854 @@
+/*
+ * Copyright (c) 2023 NVIDIA CORPORATION & AFFILIATES, ALL RIGHTS RESERVED.
+ *
+ * This software product is a proprietary product of NVIDIA CORPORATION &
+ * AFFILIATES (the "Company") and all right, title, and interest in and to the
+ * software product, including all associated intellectual property rights, are
+ * and shall remain exclusively with the Company.
+ *
+ * This software product is governed by the End User License Agreement
+ * provided with the software product.
+ *
+ */
+
+/*
+ * Original filename: comch_data_path_high_speed_client_sample.c
+ *
+ * Filename: nrLDPC_session.c
+ *
+ * DOCA Communication Channel Client API customized by: Vlademir Brusse
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* pthread_setaffinity_np */
+#endif
+
+#include <errno.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <doca_comch.h>
+#include <doca_ctx.h>
+#include <doca_dev.h>
+#include <doca_error.h>
+#include <doca_log.h>
+#include <doca_pe.h>
+
+#include "comch_ctrl_path_common.h"
+#include "nrLDPC_common.h"
+#include "nrLDPC_crc.h"
+#include "nrLDPC_dispatch.h"
+#include "nrLDPC_harq.h"
+#include "nrLDPC_hedge.h"
+#include "nrLDPC_proto.h"
+#include "nrLDPC_ratematch.h"
+#include "nrLDPC_session.h"
+#include "common.h"
+
+DOCA_LOG_REGISTER(NRLDPC_SESSION);
+
+static struct nrLDPC_session session;                           /* The process-wide session */
+static _Atomic(bool) session_ready;                             /* session is initialized and usable */
+static pthread_mutex_t session_lock = PTHREAD_MUTEX_INITIALIZER; /* Serialises init and destroy */
+static bool log_backends_created;                               /* Logger backends are registered once per process */
+static uint32_t session_generation;                             /* Generation of the last session created */
+
+/* Channels owned by a thread, given back when it exits */
+struct session_thread_channels {
+        uint32_t generation;                                 /* Session the channels belong to */
+        struct nrLDPC_channel *channels[NRLDPC_SERVICE_NUM]; /* Channel of each service, NULL when none */
+        bool shared[NRLDPC_SERVICE_NUM];                     /* No channel was left, use the service lock */
+};
+
+/* Blocking batch handed to the progress thread through the submission ring */
+struct session_ring_wait {
+        void *const *resps;            /* Response messages, in request order */
+        uint32_t resp_size;            /* Size of each resps buffer */
+        uint32_t *resp_lens;           /* Response message lengths */
+        _Atomic(doca_error_t) result;  /* First error of the batch */
+        _Atomic(uint32_t) remaining;   /* Requests not completed yet */
+        sem_t done;                    /* Posted when remaining drops to 0 */
+};
+
+static pthread_key_t thread_channels_key;                        /* session_thread_channels of each thread */
+static pthread_once_t thread_channels_once = PTHREAD_ONCE_INIT; /* Creates thread_channels_key */
+
+/* Tags a thread gives its requests, see nrLDPC_session_set_deadline() and nrLDPC_session_set_abort() */
+struct session_sched_attr {
+        uint64_t deadline_ns;          /* Absolute deadline, 0 for the budget of the service */
+        enum nrLDPC_traffic_class cls; /* Traffic class */
+        decode_abort_t *abort;         /* Abort flag of the transport block, NULL for none */
+};
+
+static _Thread_local struct session_sched_attr session_sched_attr; /* Tags of the calling thread */
+
+/* Rank of each traffic class in EDF mode, retransmissions and low-latency traffic share the first one */
+static const uint32_t session_class_rank[NRLDPC_CLASS_NUM] = {
+        [NRLDPC_CLASS_DEFAULT] = 1,
+        [NRLDPC_CLASS_RETX] = 0,
+        [NRLDPC_CLASS_LOW_LATENCY] = 0,
+        [NRLDPC_CLASS_UPLINK] = 1,
+        [NRLDPC_CLASS_BULK] = 2,
+};
+
+/**
+ * Callback for client send task successful completion
+ *
+ * @task [in]: Send task object
+ * @task_user_data [in]: User data for task
+ * @ctx_user_data [in]: User data for context
+ */
+static void client_send_task_completion_callback(struct doca_comch_task_send *task,
+                                                 union doca_data task_user_data,
+                                                 union doca_data ctx_user_data)
+{
+        struct comch_data_path_client_objects *client_objs;
+
+        (void)task_user_data;
+
+        client_objs = (struct comch_data_path_client_objects *)(ctx_user_data.ptr);
+        client_objs->client_result = DOCA_SUCCESS;
+        DOCA_LOG_INFO("Client task sent successfully");
+        doca_task_free(doca_comch_task_send_as_task(task));
+}
+
+/**
+ * Callback for client send task completion with error
+ *
+ * @task [in]: Send task object
+ * @task_user_data [in]: User data for task
+ * @ctx_user_data [in]: User data for context
+ */
+static void client_send_task_completion_err_callback(struct doca_comch_task_send *task,
+                                                     union doca_data task_user_data,
+                                                     union doca_data ctx_user_data)
+{
+        struct comch_data_path_client_objects *client_objs;
+
+        (void)task_user_data;
+
+        client_objs = (struct comch_data_path_client_objects *)(ctx_user_data.ptr);
+        client_objs->client_result = doca_task_get_status(doca_comch_task_send_as_task(task));
+        DOCA_LOG_ERR("Message failed to send with error = %s", doca_error_get_name(client_objs->client_result));
+        doca_task_free(doca_comch_task_send_as_task(task));
+        (void)doca_ctx_stop(doca_comch_client_as_ctx(client_objs->client));
+}
+
+/**
+ * Get the client objects registered as user data of the client owning a connection
+ *
+ * @comch_connection [in]: Connection of the client
+ * @return: The client objects on success and NULL otherwise
+ */
+static struct comch_data_path_client_objects *client_objs_from_connection(struct doca_comch_connection *comch_connection)
+{
+        union doca_data user_data;
+        struct doca_comch_client *comch_client;
+        doca_error_t result;
+
+        comch_client = doca_comch_client_get_client_ctx(comch_connection);
+
+        result = doca_ctx_get_user_data(doca_comch_client_as_ctx(comch_client), &user_data);
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to get user data from ctx with error = %s", doca_error_get_name(result));
+                return NULL;
+        }
+
+        return (struct comch_data_path_client_objects *)(user_data.ptr);
+}
+
+/**
+ * Callback for client message recv event
+ *
+ * @event [in]: Recv event object
+ * @recv_buffer [in]: Message buffer
+ * @msg_len [in]: Message len
+ * @comch_connection [in]: Connection the message was received on
+ */
+static void client_message_recv_callback(struct doca_comch_event_msg_recv *event,
+                                         uint8_t *recv_buffer,
+                                         uint32_t msg_len,
+                                         struct doca_comch_connection *comch_connection)
+{
+        struct comch_data_path_client_objects *client_objs;
+        char count[11] = {0};
+        char proto[24] = {0};
+        char *features;
+
+        (void)event;
+
+        DOCA_LOG_INFO("Message received: '%.*s'", (int)msg_len, recv_buffer);
+
+        client_objs = client_objs_from_connection(comch_connection);
+        if (client_objs == NULL)
+                return;
+
+        if ((msg_len == strlen(STR_START_DATA_PATH_TEST)) &&
+            (strncmp(STR_START_DATA_PATH_TEST, (char *)recv_buffer, msg_len) == 0))
+                client_objs->data_path_test_started = true;
+        else if ((msg_len > strlen(STR_DATA_PATH_CREDITS)) && (msg_len < strlen(STR_DATA_PATH_CREDITS) + 11) &&
+                 (strncmp(STR_DATA_PATH_CREDITS, (char *)recv_buffer, strlen(STR_DATA_PATH_CREDITS)) == 0)) {
+                /* Sent before the start echo: the receives the server keeps posted for this client */
+                memcpy(count, recv_buffer + strlen(STR_DATA_PATH_CREDITS), msg_len - strlen(STR_DATA_PATH_CREDITS));
+                client_objs->server_credits = (uint32_t)strtoul(count, NULL, 10);
+        } else if ((msg_len > strlen(STR_DATA_PATH_PROTO)) && (msg_len < strlen(STR_DATA_PATH_PROTO) + 24) &&
+                   (strncmp(STR_DATA_PATH_PROTO, (char *)recv_buffer, strlen(STR_DATA_PATH_PROTO)) == 0)) {
+                /* Sent before the start echo too: "<version>,<features>", see nrLDPC_proto.h */
+                memcpy(proto, recv_buffer + strlen(STR_DATA_PATH_PROTO), msg_len - strlen(STR_DATA_PATH_PROTO));
+                client_objs->server_version = (uint32_t)strtoul(proto, &features, 10);
+                client_objs->server_features = *features == ',' ? (uint32_t)strtoul(features + 1, NULL, 0) : 0;
+        }
+        else if ((msg_len == strlen(STR_STOP_DATA_PATH_TEST)) &&
+                 (strncmp(STR_STOP_DATA_PATH_TEST, (char *)recv_buffer, msg_len) == 0)) {
+                client_objs->data_path_test_stopped = true;
+                client_objs->data_path->remote_consumer_id = INVALID_CONSUMER_ID;
+                (void)doca_ctx_stop(doca_comch_client_as_ctx(client_objs->client));
+        }
+}
+
+/**
+ * Client sends a message to server
+ *
+ * @client_objs [in]: The client objects to use
+ * @msg [in]: The msg to send
+ * @len [in]: The msg length
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t client_send_msg(struct comch_data_path_client_objects *client_objs, const char *msg, size_t len)
+{
+        doca_error_t result;
+        struct doca_comch_task_send *task;
+
+        result = doca_comch_client_task_send_alloc_init(client_objs->client,
+                                                        client_objs->connection,
+                                                        (void *)msg,
+                                                        len,
+                                                        &task);
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to allocate client task with error = %s", doca_error_get_name(result));
+                return result;
+        }
+
+        result = doca_task_submit(doca_comch_task_send_as_task(task));
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to send client task with error = %s", doca_error_get_name(result));
+                doca_task_free(doca_comch_task_send_as_task(task));
+                return result;
+        }
+
+        return DOCA_SUCCESS;
+}
+
+/**
+ * Callback triggered whenever CC client context state changes
+ *
+ * @user_data [in]: User data associated with the CC client context.
+ * @ctx [in]: The CC client context that had a state change
+ * @prev_state [in]: Previous context state
+ * @next_state [in]: Next context state (context is already in this state when the callback is called)
+ */
+static void client_state_changed_callback(const union doca_data user_data,
+                                          struct doca_ctx *ctx,
+                                          enum doca_ctx_states prev_state,
+                                          enum doca_ctx_states next_state)
+{
+        (void)ctx;
+        (void)prev_state;
+
+        struct comch_data_path_client_objects *client_objs = (struct comch_data_path_client_objects *)user_data.ptr;
+
+        switch (next_state) {
+        case DOCA_CTX_STATE_IDLE:
+                DOCA_LOG_INFO("CC client context has been stopped");
+                /* We can stop progressing the PE */
+                client_objs->client_finish = true;
+                break;
+        case DOCA_CTX_STATE_STARTING:
+                /**
+                 * The context is in starting state, need to progress until connection with server is established.
+                 */
+                DOCA_LOG_INFO("CC client context entered into starting state. Waiting for connection establishment");
+                break;
+        case DOCA_CTX_STATE_RUNNING:
+                /* Get a connection channel */
+                if (client_objs->connection == NULL) {
+                        client_objs->client_result =
+                                doca_comch_client_get_connection(client_objs->client, &client_objs->connection);
+                        if (client_objs->client_result != DOCA_SUCCESS) {
+                                DOCA_LOG_ERR("Failed to get connection from cc client with error = %s",
+                                             doca_error_get_name(client_objs->client_result));
+                                (void)doca_ctx_stop(doca_comch_client_as_ctx(client_objs->client));
+                        }
+                        DOCA_LOG_INFO("CC client context is running. Get a connection from server");
+                }
+                break;
+        case DOCA_CTX_STATE_STOPPING:
+                /**
+                 * The context is in stopping, this can happen when fatal error encountered or when stopping context.
+                 * doca_pe_progress() will cause all tasks to be flushed, and finally transition state to idle
+                 */
+                DOCA_LOG_INFO("CC client context entered into stopping state. Waiting for connection termination");
+                break;
+        default:
+                break;
+        }
+}
+
+/**
+ * Callback for new consumer arrival event
+ *
+ * @event [in]: New remote consumer event object
+ * @comch_connection [in]: The connection related to the consumer
+ * @id [in]: The ID of the new remote consumer
+ */
+static void new_consumer_callback(struct doca_comch_event_consumer *event,
+                                  struct doca_comch_connection *comch_connection,
+                                  uint32_t id)
+{
+        struct comch_data_path_client_objects *client_objs;
+
+        (void)event;
+
+        client_objs = client_objs_from_connection(comch_connection);
+        if (client_objs == NULL)
+                return;
+
+        client_objs->data_path->remote_consumer_id = id;
+
+        DOCA_LOG_INFO("Got a new remote consumer with ID = [%d]", id);
+}
+
+/**
+ * Callback for expired consumer arrival event
+ *
+ * @event [in]: Expired remote consumer event object
+ * @comch_connection [in]: The connection related to the consumer
+ * @id [in]: The ID of the expired remote consumer
+ */
+static void expired_consumer_callback(struct doca_comch_event_consumer *event,
+                                      struct doca_comch_connection *comch_connection,
+                                      uint32_t id)
+{
+        struct comch_data_path_client_objects *client_objs;
+
+        (void)event;
+
+        client_objs = client_objs_from_connection(comch_connection);
+        if (client_objs == NULL)
+                return;
+
+        if (client_objs->data_path->remote_consumer_id == id) {
+                DOCA_LOG_WARN("Remote consumer with ID = [%d] expired", id);
+                client_objs->data_path->remote_consumer_id = INVALID_CONSUMER_ID;
+        }
+}
+
+/**
+ * Stop the client of a service, after telling the server the data path is no longer used
+ *
+ * @client_objs [in]: Client objects to clean
+ */
+static void clean_comch_data_path_client_objects(struct comch_data_path_client_objects *client_objs)
+{
+        struct timespec ts = {
+                .tv_sec = 0,
+                .tv_nsec = SLEEP_IN_NANOS,
+        };
+
+        if (client_objs->client == NULL)
+                return;
+
+        /* Verify client is not already stopped due to a server error */
+        if (client_objs->client_finish == false) {
+                /* Exchange message with server to make connection is reliable */
+                client_objs->client_result =
+                        client_send_msg(client_objs, STR_STOP_DATA_PATH_TEST, strlen(STR_STOP_DATA_PATH_TEST));
+                if (client_objs->client_result != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Failed to submit send task with error = %s",
+                                     doca_error_get_name(client_objs->client_result));
+                        (void)doca_ctx_stop(doca_comch_client_as_ctx(client_objs->client));
+                } else {
+                        while (client_objs->data_path_test_stopped == false && client_objs->client_finish == false) {
+                                if (doca_pe_progress(client_objs->pe) == 0)
+                                        nanosleep(&ts, &ts);
+                        }
+                }
+                while (client_objs->client_finish == false) {
+                        if (doca_pe_progress(client_objs->pe) == 0)
+                                nanosleep(&ts, &ts);
+                }
+        }
+
+        clean_comch_ctrl_path_client(client_objs->client, client_objs->pe);
+        client_objs->client = NULL;
+        client_objs->pe = NULL;
+        client_objs->connection = NULL;
+}
+
+/**
+ * Connect the client of a service to its DPU server
+ *
+ * @client_objs [in]: Client objects, hw_dev and data_path must be set
+ * @server_name [in]: Server name to connect to
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t init_comch_data_path_client_objects(struct comch_data_path_client_objects *client_objs,
+                                                        const char *server_name)
+{
+        doca_error_t result;
+        struct comch_ctrl_path_client_cb_config client_cb_cfg = {
+                .send_task_comp_cb = client_send_task_completion_callback,
+                .send_task_comp_err_cb = client_send_task_completion_err_callback,
+                .msg_recv_cb = client_message_recv_callback,
+                .data_path_mode = true,
+                .new_consumer_cb = new_consumer_callback,
+                .expired_consumer_cb = expired_consumer_callback,
+                .ctx_user_data = client_objs,
+                .ctx_state_changed_cb = client_state_changed_callback};
+        struct timespec ts = {
+                .tv_sec = 0,
+                .tv_nsec = SLEEP_IN_NANOS,
+        };
+
+        /* Init CC client */
+        result = init_comch_ctrl_path_client(server_name,
+                                             client_objs->hw_dev,
+                                             &client_cb_cfg,
+                                             &(client_objs->client),
+                                             &(client_objs->pe));
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to init cc client with error = %s", doca_error_get_name(result));
+                return result;
+        }
+
+        /* Wait connection establishment */
+        while (client_objs->connection == NULL && client_objs->client_finish == false) {
+                if (doca_pe_progress(client_objs->pe) == 0)
+                        nanosleep(&ts, &ts);
+        }
+
+        if (client_objs->client_finish == true) {
+                clean_comch_data_path_client_objects(client_objs);
+                return DOCA_ERROR_INITIALIZATION;
+        }
+
+        /* Exchange message with server, to make connection is reliable */
+        client_objs->client_result =
+                client_send_msg(client_objs, STR_START_DATA_PATH_TEST, strlen(STR_START_DATA_PATH_TEST));
+        if (client_objs->client_result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to submit send task with error = %s",
+                             doca_error_get_name(client_objs->client_result));
+                (void)doca_ctx_stop(doca_comch_client_as_ctx(client_objs->client));
+                clean_comch_data_path_client_objects(client_objs);
+                return client_objs->client_result;
+        }
+        while (client_objs->data_path_test_started == false && client_objs->client_finish == false) {
+                if (doca_pe_progress(client_objs->pe) == 0)
+                        nanosleep(&ts, &ts);
+        }
+
+        if (client_objs->client_finish == true) {
+                clean_comch_data_path_client_objects(client_objs);
+                return DOCA_ERROR_INITIALIZATION;
+        }
+
+        return DOCA_SUCCESS;
+}
+
+uint32_t nrLDPC_session_depth(enum nrLDPC_service_type type)
+{
+        struct nrLDPC_service *svc = &session.services[type];
+        uint32_t credits;
+
+        if (session_ready == false || atomic_load_explicit(&svc->connected, memory_order_acquire) == false)
+                return 0;
+
+        /* Every request in flight holds a server credit, on the data path of the service or on a channel */
+        credits = atomic_load_explicit(&svc->credits, memory_order_relaxed);
+        return atomic_load_explicit(&svc->queued, memory_order_relaxed) +
+               (credits < svc->credit_limit ? svc->credit_limit - credits : 0);
+}
+
+uint32_t nrLDPC_session_max_msg_size(enum nrLDPC_service_type type)
+{
+        uint32_t encod_size;
+
+        if (type != NRLDPC_SERVICE_ENCOD)
+                return NRLDPC_PROTO_MAX_MSG_SIZE;
+
+        /* The encoder carries whole transport blocks, the codewords of the response are the largest message */
+        encod_size = NRLDPC_PROTO_ENCOD_MSG_SIZE(session.cfg.encod_msg_segs);
+        return encod_size > NRLDPC_PROTO_MAX_MSG_SIZE ? encod_size : NRLDPC_PROTO_MAX_MSG_SIZE;
+}
+
+/**
+ * Complete the oldest asynchronous request of a service, the service must be locked
+ *
+ * @svc [in]: Service
+ * @wait [in]: Wait for the response, otherwise only take it if it already arrived
+ * @return: DOCA_SUCCESS when a request was completed, with or without error, DOCA_ERROR_AGAIN when its response
+ *          has not arrived and DOCA_ERROR_NOT_FOUND when no asynchronous request is outstanding
+ */
+static doca_error_t service_complete_one(struct nrLDPC_service *svc, bool wait)
+{
+        struct nrLDPC_pending_fifo *pending = &svc->pending;
+        struct nrLDPC_pending_req req;
+        uint32_t max_msg_size = svc->data_path.max_msg_size;
+        uint32_t resp_len = 0;
+        doca_error_t result;
+
+        if (pending->count == 0)
+                return DOCA_ERROR_NOT_FOUND;
+
+        if (wait == true)
+                result = comch_data_path_recv_msg(&svc->data_path, svc->resp_buf, max_msg_size, &resp_len);
+        else
+                result = comch_data_path_poll_msg(&svc->data_path, svc->resp_buf, max_msg_size, &resp_len);
+        if (result == DOCA_ERROR_AGAIN)
+                return result;
+
+        req = pending->reqs[pending->head];
+        pending->head = (pending->head + 1) % pending->size;
+        pending->count--;
+        if (req.abort != NULL && req.cancelled == false)
+                svc->cancellable--;
+
+        if (result != DOCA_SUCCESS)
+                DOCA_LOG_ERR("Failed to receive response from %s with error = %s",
+                             svc->server_name,
+                             doca_error_get_name(result));
+        req.cb(req.user_data, req.tag, result == DOCA_SUCCESS ? svc->resp_buf : NULL, resp_len, result);
+
+        return DOCA_SUCCESS;
+}
+
+/**
+ * Append a request just sent to the asynchronous requests of a service, the service must be locked
+ *
+ * @svc [in]: Service
+ * @req [in]: Completion of the request
+ */
+static void service_pending_push(struct nrLDPC_service *svc, const struct nrLDPC_pending_req *req)
+{
+        struct nrLDPC_pending_fifo *pending = &svc->pending;
+
+        pending->reqs[(pending->head + pending->count) % pending->size] = *req;
+        pending->count++;
+        if (req->abort != NULL)
+                svc->cancellable++;
+}
+
+/**
+ * Allocate the cells of a submission ring, all free
+ *
+ * @ring [in]: Submission ring
+ * @size [in]: Number of cells, a power of 2
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t submit_ring_init(struct nrLDPC_submit_ring *ring, uint32_t size)
+{
+        uint32_t i;
+
+        ring->cells = aligned_alloc(CC_DATA_PATH_SLOT_ALIGN, (size_t)size * sizeof(*ring->cells));
+        if (ring->cells == NULL)
+                return DOCA_ERROR_NO_MEMORY;
+
+        for (i = 0; i < size; i++)
+                atomic_init(&ring->cells[i].seq, i);
+        ring->mask = size - 1;
+        atomic_init(&ring->tail, 0);
+        ring->head = 0;
+        return DOCA_SUCCESS;
+}
+
+/**
+ * Release the cells of a submission ring
+ *
+ * @ring [in]: Submission ring
+ */
+static void submit_ring_clean(struct nrLDPC_submit_ring *ring)
+{
+        free(ring->cells);
+        ring->cells = NULL;
+}
+
+/**
+ * Append a request to a submission ring, from any thread
+ *
+ * @ring [in]: Submission ring
+ * @desc [in]: Request, copied
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR_AGAIN when the ring is full
+ */
+static doca_error_t submit_ring_enqueue(struct nrLDPC_submit_ring *ring, const struct nrLDPC_submit_desc *desc)
+{
+        struct nrLDPC_submit_cell *cell;
+        uint64_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t seq;
+
+        for (;;) {
+                cell = &ring->cells[pos & ring->mask];
+                seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+                if (seq == pos) {
+                        /* The cell is free for this position, take the position */
+                        if (atomic_compare_exchange_weak_explicit(&ring->tail,
+                                                                  &pos,
+                                                                  pos + 1,
+                                                                  memory_order_relaxed,
+                                                                  memory_order_relaxed) == true)
+                                break;
+                } else if (seq < pos) {
+                        /* The cell still holds the request of the previous lap */
+                        return DOCA_ERROR_AGAIN;
+                } else {
+                        pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+                }
+        }
+
+        cell->desc = *desc;
+        atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+        return DOCA_SUCCESS;
+}
+
+/**
+ * Take the oldest requests of a submission ring, one consumer at a time
+ *
+ * @ring [in]: Submission ring
+ * @descs [out]: Requests, in enqueue order
+ * @max [in]: Size of descs
+ * @return: Number of requests taken, the ring ends at the first request whose enqueue is not complete yet
+ */
+static uint32_t submit_ring_dequeue(struct nrLDPC_submit_ring *ring, struct nrLDPC_submit_desc *descs, uint32_t max)
+{
+        struct nrLDPC_submit_cell *cell;
+        uint32_t n;
+
+        for (n = 0; n < max; n++) {
+                cell = &ring->cells[(ring->head + n) & ring->mask];
+                if (atomic_load_explicit(&cell->seq, memory_order_acquire) != ring->head + n + 1)
+                        break;
+                descs[n] = cell->desc;
+                /* Free for the enqueue one lap later */
+                atomic_store_explicit(&cell->seq, ring->head + n + ring->mask + 1, memory_order_release);
+        }
+
+        ring->head += n;
+        return n;
+}
+
+/**
+ * Whether a staged request must be sent before another one
+ *
+ * @a [in]: Request
+ * @b [in]: Other request
+ * @return: true when a goes first: lower rank, then earlier deadline, then dequeued first
+ */
+static bool submit_heap_before(const struct nrLDPC_submit_desc *a, const struct nrLDPC_submit_desc *b)
+{
+        if (a->rank != b->rank)
+                return a->rank < b->rank;
+        if (a->deadline_ns != b->deadline_ns)
+                return a->deadline_ns < b->deadline_ns;
+        return (int32_t)(a->seq - b->seq) < 0;
+}
+
+/**
+ * Add a staged request to the scheduling heap of a service
+ *
+ * @heap [in]: Scheduling heap, not full
+ * @desc [in]: Request, copied
+ */
+static void submit_heap_push(struct nrLDPC_submit_heap *heap, const struct nrLDPC_submit_desc *desc)
+{
+        uint32_t i = heap->count++;
+        uint32_t parent;
+
+        while (i > 0) {
+                parent = (i - 1) / 2;
+                if (submit_heap_before(desc, &heap->descs[parent]) == false)
+                        break;
+                heap->descs[i] = heap->descs[parent];
+                i = parent;
+        }
+        heap->descs[i] = *desc;
+}
+
+/**
+ * Place a request at a position of the scheduling heap whose subtrees are heaps, moving it down as needed
+ *
+ * @heap [in]: Scheduling heap
+ * @i [in]: Position, below count
+ * @desc [in]: Request, copied
+ */
+static void submit_heap_sift_down(struct nrLDPC_submit_heap *heap, uint32_t i, const struct nrLDPC_submit_desc *desc)
+{
+        uint32_t child;
+
+        for (;;) {
+                child = 2 * i + 1;
+                if (child >= heap->count)
+                        break;
+                if (child + 1 < heap->count && submit_heap_before(&heap->descs[child + 1], &heap->descs[child]))
+                        child++;
+                if (submit_heap_before(&heap->descs[child], desc) == false)
+                        break;
+                heap->descs[i] = heap->descs[child];
+                i = child;
+        }
+        heap->descs[i] = *desc;
+}
+
+/**
+ * Remove the request on top of the scheduling heap of a service, the one to send next
+ *
+ * @heap [in]: Scheduling heap, not empty
+ */
+static void submit_heap_pop(struct nrLDPC_submit_heap *heap)
+{
+        struct nrLDPC_submit_desc last = heap->descs[--heap->count];
+
+        if (heap->count > 0)
+                submit_heap_sift_down(heap, 0, &last);
+}
+
+/**
+ * Rebuild the scheduling heap of a service after requests were taken out of the middle of it
+ *
+ * @heap [in]: Scheduling heap, its descs in any order
+ */
+static void submit_heap_heapify(struct nrLDPC_submit_heap *heap)
+{
+        struct nrLDPC_submit_desc desc;
+        uint32_t i;
+
+        for (i = heap->count / 2; i-- > 0;) {
+                desc = heap->descs[i];
+                submit_heap_sift_down(heap, i, &desc);
+        }
+}
+
+/**
+ * Account for the arrival of a request in the moving average of the time between two requests of a service
+ *
+ * @co [in]: Coalescing stage of the service
+ * @staged_ns [in]: Staging time of the request
+ */
+static void coalesce_arrival(struct nrLDPC_coalescer *co, uint64_t staged_ns)
+{
+        uint64_t gap = staged_ns > co->last_staged_ns ? staged_ns - co->last_staged_ns : 0;
+
+        /* An idle period says nothing more than "slower than the window", it must not take long to forget */
+        if (gap > NRLDPC_COALESCE_GAP_WINDOWS * co->window_ns)
+                gap = NRLDPC_COALESCE_GAP_WINDOWS * co->window_ns;
+        if (staged_ns > co->last_staged_ns)
+                co->last_staged_ns = staged_ns;
+        co->gap_ewma_ns += (gap >> NRLDPC_COALESCE_EWMA_SHIFT) - (co->gap_ewma_ns >> NRLDPC_COALESCE_EWMA_SHIFT);
+}
+
+/**
+ * Move the requests enqueued on the submission ring of a service to its scheduling heap, NRLDPC_SUBMIT_BATCH at
+ * a time, so that the next request sent is the most urgent one handed over. The service must be locked.
+ *
+ * @svc [in]: Service
+ */
+static void service_pull_submits(struct nrLDPC_service *svc)
+{
+        struct nrLDPC_submit_heap *heap = &svc->sched;
+        struct nrLDPC_submit_desc batch[NRLDPC_SUBMIT_BATCH];
+        uint32_t max, n, i;
+
+        /* A staged request holds a producer slot, the heap has room for all of them */
+        while (heap->count < heap->size) {
+                max = heap->size - heap->count < NRLDPC_SUBMIT_BATCH ? heap->size - heap->count : NRLDPC_SUBMIT_BATCH;
+                n = submit_ring_dequeue(&svc->submits, batch, max);
+                for (i = 0; i < n; i++) {
+                        batch[i].seq = heap->next_seq++;
+                        submit_heap_push(heap, &batch[i]);
+                        if (svc->coalesce.window_ns != 0)
+                                coalesce_arrival(&svc->coalesce, batch[i].staged_ns);
+                }
+                if (n < max)
+                        break;
+        }
+}
+
+/**
+ * Code blocks (decoder) or segments (encoder) a request carries
+ *
+ * @hdr [in]: Request header
+ * @return: Number of blocks or segments
+ */
+static uint32_t coalesce_units(const struct nrLDPC_proto_hdr *hdr)
+{
+        if (hdr->op == NRLDPC_PROTO_OP_ENCOD_REQ && hdr->num_segs != 0)
+                return hdr->num_segs;
+        return 1;
+}
+
+/**
+ * Payload length of the response to a coalesced message
+ *
+ * @hdr [in]: Header of any request of the message
+ * @units [in]: Code blocks (decoder) or segments (encoder) of the message
+ * @return: Payload length, decoded bytes and block statuses or codewords
+ */
+static uint64_t coalesce_resp_len(const struct nrLDPC_proto_hdr *hdr, uint32_t units)
+{
+        if (hdr->op == NRLDPC_PROTO_OP_DECOD_REQ)
+                return (uint64_t)units * (hdr->k / 8 + sizeof(int32_t));
+        return (uint64_t)units * ((hdr->n + 7) / 8);
+}
+
+/**
+ * Check whether a request can share a coalesced message with another one
+ *
+ * @lead [in]: Header of the first request of the message
+ * @hdr [in]: Header of the request
+ * @return: true when both have the same shape: operation, BG, Z, K, N and the decoder or encoder parameters
+ */
+static bool coalesce_compatible(const struct nrLDPC_proto_hdr *lead, const struct nrLDPC_proto_hdr *hdr)
+{
+        if (hdr->op != lead->op || hdr->flags != 0 || hdr->bg != lead->bg || hdr->z != lead->z || hdr->k != lead->k ||
+            hdr->n != lead->n)
+                return false;
+        if (hdr->op == NRLDPC_PROTO_OP_DECOD_REQ)
+                return hdr->num_its == lead->num_its && hdr->crc_idx == lead->crc_idx && hdr->payload_len == hdr->n;
+        return hdr->op == NRLDPC_PROTO_OP_ENCOD_REQ && hdr->f == lead->f;
+}
+
+/**
+ * Completion of a coalesced message: hand each of its requests a response of its own, built from its part of
+ * the multi-block response, or the error of the message
+ *
+ * @user_data [in]: The nrLDPC_coalesce_group of the message
+ * @tag [in]: Unused
+ * @resp [in]: Response message
+ * @resp_len [in]: Response message length
+ * @status [in]: DOCA_SUCCESS when resp holds the response
+ */
+static void service_coalesce_done(void *user_data,
+                                  uint32_t tag,
+                                  const void *resp,
+                                  uint32_t resp_len,
+                                  doca_error_t status)
+{
+        struct nrLDPC_coalesce_group *group = user_data;
+        struct nrLDPC_service *svc = group->svc;
+        struct nrLDPC_coalescer *co = &svc->coalesce;
+        bool decod = group->hdr.op == NRLDPC_PROTO_OP_DECOD_REQ;
+        struct nrLDPC_coalesce_member *member;
+        struct nrLDPC_proto_hdr resp_hdr;
+        struct nrLDPC_proto_hdr hdr;
+        const uint8_t *payload = NULL;
+        uint32_t offset = 0;
+        uint32_t msg_len;
+        uint32_t len;
+        int32_t block_status;
+        uint32_t i;
+
+        (void)tag;
+        if (status == DOCA_SUCCESS)
+                status = nrLDPC_proto_unpack(resp, resp_len, &resp_hdr, (const void **)&payload);
+        if (status == DOCA_SUCCESS)
+                status = nrLDPC_proto_check_resp(&group->hdr, &resp_hdr);
+        if (status == DOCA_SUCCESS &&
+            resp_hdr.payload_len != coalesce_resp_len(&group->hdr, decod == true ? group->count : group->hdr.num_segs)) {
+                DOCA_LOG_ERR("Coalesced response of %u bytes from %s does not match its %u requests",
+                             resp_hdr.payload_len,
+                             svc->server_name,
+                             group->count);
+                status = DOCA_ERROR_IO_FAILED;
+        }
+
+        for (i = 0; i < group->count; i++) {
+                member = &group->members[i];
+                if (status != DOCA_SUCCESS) {
+                        member->req.cb(member->req.user_data, member->req.tag, NULL, 0, status);
+                        continue;
+                }
+
+                hdr = resp_hdr;
+                hdr.req_id = member->req_id;
+                hdr.flags = 0;
+                if (decod == true) {
+                        /* The decoded bytes of every block, then the status of every block */
+                        len = hdr.k / 8;
+                        offset = i * len;
+                        memcpy(&block_status,
+                               payload + group->count * len + i * sizeof(block_status),
+                               sizeof(block_status));
+                        hdr.status = block_status;
+                } else {
+                        len = member->num_segs * ((hdr.n + 7) / 8);
+                        hdr.num_segs = member->num_segs;
+                }
+                msg_len = nrLDPC_proto_pack(co->resp_buf, svc->data_path.max_msg_size, &hdr, payload + offset, len);
+                member->req.cb(member->req.user_data, member->req.tag, co->resp_buf, msg_len, DOCA_SUCCESS);
+                if (decod == false)
+                        offset += len;
+        }
+
+        co->free_groups[co->num_free++] = (uint32_t)(group - co->groups);
+}
+
+static uint64_t session_now_ns(void);
+
+/**
+ * Coalesce the request on top of the scheduling heap of a service with the compatible requests waiting behind it,
+ * the service must be locked. Their payloads are appended to the message of the top request, in its producer
+ * slot, and their slots released; the top request then completes them all through service_coalesce_done().
+ * Without wait, a small request that is not urgent is held while more requests can be expected.
+ *
+ * @svc [in]: Service, its scheduling heap not empty
+ * @wait [in]: Send whatever can be coalesced now, never hold the request
+ * @return: true when the top request is held, its send time in hold_until_ns, false when it can be sent
+ */
+static bool service_coalesce(struct nrLDPC_service *svc, bool wait)
+{
+        struct nrLDPC_coalescer *co = &svc->coalesce;
+        struct nrLDPC_submit_heap *heap = &svc->sched;
+        struct nrLDPC_submit_desc *lead = &heap->descs[0];
+        struct comch_data_path_objects *data_path = &svc->data_path;
+        uint32_t max_payload = data_path->max_msg_size - sizeof(struct nrLDPC_proto_hdr);
+        uint32_t threshold = session.cfg.coalesce_bytes;
+        uint32_t members[NRLDPC_COALESCE_MAX_REQS];
+        struct nrLDPC_coalesce_group *group;
+        struct nrLDPC_submit_desc *desc;
+        decode_abort_t *abort = lead->req.abort;
+        struct nrLDPC_proto_hdr lead_hdr;
+        struct nrLDPC_proto_hdr hdr;
+        uint32_t count = 1;
+        uint32_t payload, units;
+        uint64_t hold_ns, needed;
+        uint8_t *msg, *src;
+        uint32_t i, j;
+
+        /* Already coalesced, waiting for room in the pipeline */
+        if (lead->req.cb == service_coalesce_done || co->num_free == 0)
+                return false;
+
+        memcpy(&lead_hdr, local_mem_pool_addr(&data_path->producer_pool, lead->slot), sizeof(lead_hdr));
+        if (coalesce_compatible(&lead_hdr, &lead_hdr) == false || lead_hdr.payload_len == 0 ||
+            lead_hdr.payload_len >= threshold)
+                return false;
+        /* Several decoder blocks in a message need NRLDPC_PROTO_FLAG_BLOCKS, encoder segments are always served */
+        if (lead_hdr.op == NRLDPC_PROTO_OP_DECOD_REQ &&
+            (atomic_load_explicit(&svc->features, memory_order_relaxed) & NRLDPC_PROTO_FEATURE_BLOCKS) == 0)
+                return false;
+
+        /* The compatible requests waiting, in heap order, as long as both messages stay within max_msg_size */
+        payload = lead_hdr.payload_len;
+        units = coalesce_units(&lead_hdr);
+        for (i = 1; i < heap->count && count < NRLDPC_COALESCE_MAX_REQS && payload < threshold; i++) {
+                memcpy(&hdr, local_mem_pool_addr(&data_path->producer_pool, heap->descs[i].slot), sizeof(hdr));
+                if (coalesce_compatible(&lead_hdr, &hdr) == false || hdr.payload_len > max_payload - payload ||
+                    coalesce_resp_len(&lead_hdr, units + coalesce_units(&hdr)) > max_payload ||
+                    (hdr.op == NRLDPC_PROTO_OP_ENCOD_REQ && units + coalesce_units(&hdr) > NRLDPC_PROTO_ENCOD_MAX_SEGS))
+                        continue;
+                members[count++] = i;
+                payload += hdr.payload_len;
+                units += coalesce_units(&hdr);
+        }
+
+        /* Hold the message while it is not full, urgent traffic excepted */
+        if (wait == false && payload < threshold && count < NRLDPC_COALESCE_MAX_REQS &&
+            (session.cfg.sched_mode == NRLDPC_SCHED_FIFO || lead->rank != 0)) {
+                hold_ns = co->window_ns;
+                if (session.cfg.coalesce_adapt == true) {
+                        /* No request expected within the window, or as long as the missing ones take to come */
+                        needed = (threshold - payload + lead_hdr.payload_len - 1) / lead_hdr.payload_len;
+                        hold_ns = co->gap_ewma_ns >= co->window_ns ? 0 : co->gap_ewma_ns * needed;
+                        if (hold_ns > co->window_ns)
+                                hold_ns = co->window_ns;
+                }
+                if (hold_ns != 0 && lead->staged_ns + hold_ns > session_now_ns()) {
+                        co->hold_until_ns = lead->staged_ns + hold_ns;
+                        return true;
+                }
+        }
+        if (count == 1)
+                return false;
+
+        /* The message grows in place, out of the slot of its own size class: sent alone when no larger one is free */
+        if (comch_data_path_restage(data_path, &lead->slot, sizeof(lead_hdr) + lead_hdr.payload_len,
+                                    sizeof(lead_hdr) + payload) != DOCA_SUCCESS)
+                return false;
+        msg = local_mem_pool_addr(&data_path->producer_pool, lead->slot);
+
+        group = &co->groups[co->free_groups[--co->num_free]];
+        group->svc = svc;
+        group->count = count;
+        group->members[0] = (struct nrLDPC_coalesce_member){
+                .req = lead->req,
+                .req_id = lead_hdr.req_id,
+                .num_segs = (uint16_t)coalesce_units(&lead_hdr),
+        };
+
+        payload = lead_hdr.payload_len;
+        for (j = 1; j < count; j++) {
+                desc = &heap->descs[members[j]];
+                src = local_mem_pool_addr(&data_path->producer_pool, desc->slot);
+                memcpy(&hdr, src, sizeof(hdr));
+                memcpy(msg + sizeof(hdr) + payload, src + sizeof(hdr), hdr.payload_len);
+                payload += hdr.payload_len;
+                group->members[j] = (struct nrLDPC_coalesce_member){
+                        .req = desc->req,
+                        .req_id = hdr.req_id,
+                        .num_segs = (uint16_t)coalesce_units(&hdr),
+                };
+                if (desc->req.abort != abort)
+                        abort = NULL;
+                comch_data_path_unstage(data_path, desc->slot);
+                /* A message is never empty, len 0 marks the request as taken */
+                desc->len = 0;
+        }
+
+        lead_hdr.req_id = nrLDPC_proto_next_req_id();
+        lead_hdr.payload_len = payload;
+        if (lead_hdr.op == NRLDPC_PROTO_OP_DECOD_REQ)
+                lead_hdr.flags |= NRLDPC_PROTO_FLAG_BLOCKS;
+        else
+                lead_hdr.num_segs = (uint16_t)units;
+        memcpy(msg, &lead_hdr, sizeof(lead_hdr));
+        group->hdr = lead_hdr;
+        lead->len = sizeof(lead_hdr) + payload;
+        /* The message is dropped or cancelled as a whole, only when all its requests belong to the aborted block */
+        lead->req = (struct nrLDPC_pending_req){
+                .cb = service_coalesce_done,
+                .user_data = group,
+                .tag = 0,
+                .abort = abort,
+        };
+
+        /* The top request keeps its place, the others leave the heap */
+        for (i = 1, j = 1; i < heap->count; i++) {
+                if (heap->descs[i].len != 0)
+                        heap->descs[j++] = heap->descs[i];
+        }
+        heap->count = j;
+        submit_heap_heapify(heap);
+        atomic_fetch_sub(&svc->queued, count - 1);
+        co->msgs++;
+        co->reqs += count;
+        return false;
+}
+
+/**
+ * Drop the request on top of the scheduling heap of a service when its transport block was aborted while it
+ * waited, the service must be locked
+ *
+ * @svc [in]: Service, its scheduling heap not empty
+ * @return: true when the request was dropped, its cb called with NRLDPC_PROTO_ERROR_CANCELLED
+ */
+static bool service_drop_aborted(struct nrLDPC_service *svc)
+{
+        struct nrLDPC_submit_desc desc = svc->sched.descs[0];
+
+        if (nrLDPC_session_aborted(desc.req.abort) == false)
+                return false;
+
+        submit_heap_pop(&svc->sched);
+        atomic_fetch_sub(&svc->queued, 1);
+        comch_data_path_unstage(&svc->data_path, desc.slot);
+        if (desc.req.cb == service_coalesce_done)
+                svc->dropped += ((struct nrLDPC_coalesce_group *)desc.req.user_data)->count;
+        else
+                svc->dropped++;
+        desc.req.cb(desc.req.user_data, desc.req.tag, NULL, 0, NRLDPC_PROTO_ERROR_CANCELLED);
+        return true;
+}
+
+/**
+ * Request id of a staged request
+ *
+ * @svc [in]: Service
+ * @slot [in]: Producer slot holding the request
+ * @return: Request id of its header
+ */
+static uint32_t service_staged_req_id(struct nrLDPC_service *svc, uint32_t slot)
+{
+        struct nrLDPC_proto_hdr hdr;
+
+        memcpy(&hdr, local_mem_pool_addr(&svc->data_path.producer_pool, slot), sizeof(hdr));
+        return hdr.req_id;
+}
+
+/**
+ * Send the requests handed over by nrLDPC_session_submit(), most urgent first, the service must be locked.
+ * Those that do not fit in the pipeline stay in the scheduling heap, where later and more urgent requests can
+ * overtake them. With coalescing on, small requests go out coalesced and may be held a while. The requests of an
+ * aborted transport block are dropped instead.
+ *
+ * @svc [in]: Service
+ * @wait [in]: Make room in the pipeline by waiting for the oldest responses, otherwise stop when it is full
+ * @return: Number of requests sent or failed
+ */
+static uint32_t service_send_submits(struct nrLDPC_service *svc, bool wait)
+{
+        struct nrLDPC_submit_desc desc;
+        doca_error_t result;
+        uint32_t done = 0;
+
+        svc->coalesce.hold_until_ns = 0;
+        for (;;) {
+                service_pull_submits(svc);
+                if (svc->sched.count == 0)
+                        break;
+                if (service_drop_aborted(svc) == true) {
+                        done++;
+                        continue;
+                }
+                /* Coalesce only when the message can go now, requests keep arriving while the pipeline is full */
+                if (svc->coalesce.window_ns != 0 && svc->data_path.in_flight < svc->data_path.recv_depth &&
+                    atomic_load(&svc->credits) != 0 && service_coalesce(svc, wait) == true)
+                        break;
+                desc = svc->sched.descs[0];
+                if (desc.req.abort != NULL && session.cfg.cancel == true)
+                        desc.req.req_id = service_staged_req_id(svc, desc.slot);
+                else
+                        desc.req.abort = NULL;
+
+                result = comch_data_path_send_staged(&svc->data_path, desc.slot, desc.len);
+                if (result == DOCA_ERROR_AGAIN) {
+                        /* The pipeline is full, the request stays staged until the oldest one completes */
+                        if (wait == false)
+                                break;
+                        if (service_complete_one(svc, true) == DOCA_SUCCESS)
+                                continue;
+                        /* Or until the channels give back the credits they hold */
+                        if (svc->data_path.in_flight < svc->data_path.recv_depth) {
+                                comch_data_path_idle(&svc->data_path);
+                                continue;
+                        }
+                        comch_data_path_unstage(&svc->data_path, desc.slot);
+                }
+
+                submit_heap_pop(&svc->sched);
+                atomic_fetch_sub(&svc->queued, 1);
+                if (result == DOCA_SUCCESS) {
+                        service_pending_push(svc, &desc.req);
+                } else {
+                        DOCA_LOG_ERR("Failed to send request to %s with error = %s",
+                                     svc->server_name,
+                                     doca_error_get_name(result));
+                        desc.req.cb(desc.req.user_data, desc.req.tag, NULL, 0, result);
+                }
+                done++;
+        }
+
+        return done;
+}
+
+/**
+ * Completion of a cancel message: count the requests the server skipped
+ *
+ * @user_data [in]: The service
+ * @tag [in]: Unused
+ * @resp [in]: Response message
+ * @resp_len [in]: Response message length
+ * @status [in]: DOCA_SUCCESS when resp holds the response
+ */
+static void service_cancel_done(void *user_data, uint32_t tag, const void *resp, uint32_t resp_len, doca_error_t status)
+{
+        struct nrLDPC_service *svc = user_data;
+        struct nrLDPC_proto_hdr hdr;
+        const void *payload;
+
+        (void)tag;
+        if (status == DOCA_SUCCESS)
+                status = nrLDPC_proto_unpack(resp, resp_len, &hdr, &payload);
+        if (status != DOCA_SUCCESS || hdr.op != NRLDPC_PROTO_OP_CANCEL_RESP || hdr.status < 0) {
+                DOCA_LOG_WARN("Cancel message to %s failed, the requests it listed complete as usual",
+                              svc->server_name);
+                return;
+        }
+        svc->skipped += (uint32_t)hdr.status;
+}
+
+/**
+ * Send one cancel message listing the in-flight requests whose transport block was aborted since they were sent,
+ * the service must be locked. The server skips those it has not started yet and answers them with
+ * NRLDPC_PROTO_STATUS_CANCELLED, the others complete as usual.
+ *
+ * @svc [in]: Service
+ * @return: 1 when a cancel message was sent, 0 when nothing is to cancel or the pipeline has no room for it
+ */
+static uint32_t service_cancel_aborted(struct nrLDPC_service *svc)
+{
+        struct nrLDPC_pending_fifo *pending = &svc->pending;
+        uint8_t msg[sizeof(struct nrLDPC_proto_hdr) + NRLDPC_CANCEL_MAX_REQS * sizeof(uint32_t)];
+        struct nrLDPC_proto_hdr hdr = {.op = NRLDPC_PROTO_OP_CANCEL_REQ};
+        uint32_t reqs[NRLDPC_CANCEL_MAX_REQS];
+        uint32_t ids[NRLDPC_CANCEL_MAX_REQS];
+        struct nrLDPC_pending_req *req;
+        decode_abort_t *last = NULL;
+        bool aborted = false;
+        doca_error_t result;
+        uint32_t count = 0;
+        uint32_t len;
+        uint32_t i;
+
+        /* The requests of a transport block follow each other, each flag is read once per run */
+        for (i = 0; i < pending->count && count < NRLDPC_CANCEL_MAX_REQS; i++) {
+                req = &pending->reqs[(pending->head + i) % pending->size];
+                if (req->abort == NULL || req->cancelled == true)
+                        continue;
+                if (req->abort != last) {
+                        last = req->abort;
+                        aborted = nrLDPC_session_aborted(last);
+                }
+                if (aborted == true) {
+                        reqs[count] = (pending->head + i) % pending->size;
+                        ids[count++] = req->req_id;
+                }
+        }
+        if (count == 0)
+                return 0;
+
+        /* The cancel takes a slot of the pipeline like any request, it is tried again on the next poll */
+        hdr.req_id = nrLDPC_proto_next_req_id();
+        len = nrLDPC_proto_pack(msg, sizeof(msg), &hdr, ids, count * sizeof(uint32_t));
+        result = comch_data_path_send_msg(&svc->data_path, msg, len);
+        if (result != DOCA_SUCCESS) {
+                if (result != DOCA_ERROR_AGAIN)
+                        DOCA_LOG_ERR("Failed to send cancel to %s with error = %s",
+                                     svc->server_name,
+                                     doca_error_get_name(result));
+                return 0;
+        }
+
+        DOCA_LOG_DBG("Cancelling %u requests of aborted transport blocks on %s", count, svc->server_name);
+        for (i = 0; i < count; i++)
+                pending->reqs[reqs[i]].cancelled = true;
+        svc->cancellable -= count;
+        svc->cancelled += count;
+        service_pending_push(svc,
+                             &(struct nrLDPC_pending_req){
+                                     .cb = service_cancel_done,
+                                     .user_data = svc,
+                             });
+        return 1;
+}
+
+/**
+ * Complete all the asynchronous requests of a service, the ones still queued included, waiting for their
+ * responses. The service must be locked.
+ * Run before any synchronous exchange: the responses come back in request order.
+ *
+ * @svc [in]: Service
+ */
+static void service_flush(struct nrLDPC_service *svc)
+{
+        (void)service_send_submits(svc, true);
+        while (service_complete_one(svc, true) == DOCA_SUCCESS)
+                ;
+}
+
+/**
+ * Start the data path of a channel: a producer/consumer pair sharing the connection of the service, on a PE of
+ * its own so that its owner progresses it without any lock. The service must be locked.
+ *
+ * @svc [in]: Service, connected
+ * @channel [in]: Channel to start
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t service_start_channel(struct nrLDPC_service *svc, struct nrLDPC_channel *channel)
+{
+        struct comch_data_path_objects *data_path = &channel->data_path;
+        doca_error_t result;
+
+        memset(data_path, 0, sizeof(*data_path));
+        data_path->hw_dev = svc->data_path.hw_dev;
+        data_path->max_msg_size = svc->data_path.max_msg_size;
+        data_path->num_slots = svc->data_path.num_slots;
+        data_path->one_slot_size = svc->data_path.one_slot_size;
+        data_path->recv_depth = svc->data_path.recv_depth;
+        data_path->busy_poll = svc->data_path.busy_poll;
+        data_path->standin = svc->data_path.standin;
+        data_path->credits = svc->data_path.credits;
+
+        if (data_path->standin == NULL) {
+                result = doca_pe_create(&data_path->pe);
+                if (result != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Failed to create the PE of a channel with error = %s",
+                                     doca_error_get_name(result));
+                        return result;
+                }
+                data_path->connection = svc->data_path.connection;
+                data_path->remote_consumer_id = svc->data_path.remote_consumer_id;
+                data_path->route_replies = true;
+        }
+
+        result = comch_data_path_start(data_path);
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to start a channel to %s with error = %s",
+                             svc->server_name,
+                             doca_error_get_name(result));
+                if (data_path->pe != NULL)
+                        (void)doca_pe_destroy(data_path->pe);
+                data_path->pe = NULL;
+                return result;
+        }
+
+        channel->started = true;
+        return DOCA_SUCCESS;
+}
+
+/**
+ * Stop and release the channels of a service, the service must be locked and its threads done with them
+ *
+ * @svc [in]: Service
+ */
+static void service_stop_channels(struct nrLDPC_service *svc)
+{
+        struct comch_data_path_objects *data_path;
+        uint32_t i;
+
+        for (i = 0; i < svc->num_channels; i++) {
+                if (svc->channels[i].started == false)
+                        continue;
+                data_path = &svc->channels[i].data_path;
+                comch_data_path_stop(data_path);
+                if (data_path->pe != NULL)
+                        (void)doca_pe_destroy(data_path->pe);
+                data_path->pe = NULL;
+        }
+
+        free(svc->channels);
+        svc->channels = NULL;
+        svc->num_channels = 0;
+}
+
+/**
+ * Allocate the coalescing stage of a service, when coalescing is on
+ *
+ * @co [out]: Coalescing stage
+ * @num_groups [in]: Coalesced messages that can exist at once, the producer slots
+ * @msg_size [in]: Size of the largest message
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t coalescer_init(struct nrLDPC_coalescer *co, uint32_t num_groups, uint32_t msg_size)
+{
+        uint32_t i;
+
+        memset(co, 0, sizeof(*co));
+        if (session.cfg.coalesce_us == 0)
+                return DOCA_SUCCESS;
+
+        co->groups = calloc(num_groups, sizeof(*co->groups));
+        co->free_groups = calloc(num_groups, sizeof(*co->free_groups));
+        co->resp_buf = malloc(msg_size);
+        if (co->groups == NULL || co->free_groups == NULL || co->resp_buf == NULL)
+                return DOCA_ERROR_NO_MEMORY;
+
+        for (i = 0; i < num_groups; i++)
+                co->free_groups[i] = num_groups - 1 - i;
+        co->num_free = num_groups;
+        co->window_ns = (uint64_t)session.cfg.coalesce_us * 1000;
+        /* Nothing is held until requests are seen coming faster than the window */
+        co->gap_ewma_ns = NRLDPC_COALESCE_GAP_WINDOWS * co->window_ns;
+        return DOCA_SUCCESS;
+}
+
+/**
+ * Release the coalescing stage of a service
+ *
+ * @co [in]: Coalescing stage
+ */
+static void coalescer_clean(struct nrLDPC_coalescer *co)
+{
+        free(co->groups);
+        free(co->free_groups);
+        free(co->resp_buf);
+        memset(co, 0, sizeof(*co));
+}
+
+/**
+ * Establish the control path and the data path of a service
+ *
+ * @svc [in]: Service to connect
+ * @type [in]: Service type
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t nrLDPC_service_connect(struct nrLDPC_service *svc, enum nrLDPC_service_type type)
+{
+        struct comch_data_path_objects *data_path = &svc->data_path;
+        struct comch_data_path_client_objects *client_objs = &svc->client_objs;
+        doca_error_t result;
+
+        memset(data_path, 0, sizeof(*data_path));
+        memset(client_objs, 0, sizeof(*client_objs));
+        data_path->hw_dev = session.hw_dev;
+        data_path->max_msg_size = nrLDPC_session_max_msg_size(type);
+        data_path->num_slots = session.cfg.slab_slots;
+        data_path->one_slot_size = session.cfg.slot_classes == false;
+        data_path->recv_depth = session.cfg.recv_depth;
+        data_path->busy_poll = session.cfg.progress_mode == NRLDPC_PROGRESS_BUSY;
+        client_objs->hw_dev = session.hw_dev;
+        client_objs->data_path = data_path;
+
+        if (session.cfg.loopback == true) {
+                svc->standin.service = type;
+                svc->standin.service_ns = session.cfg.loopback_service_ns;
+                svc->standin.connect_ns = session.cfg.loopback_connect_ns;
+                svc->standin.rtt_ns = session.cfg.loopback_rtt_ns;
+                svc->standin.queued = session.cfg.loopback_queued;
+                svc->standin.hiccup_every = session.cfg.loopback_hiccup_every;
+                svc->standin.hiccup_ns = session.cfg.loopback_hiccup_ns;
+                svc->standin.features = session.cfg.loopback_features;
+                atomic_store(&svc->standin.requests, 0);
+                atomic_store(&svc->standin.busy_until_ns, 0);
+#ifdef NRLDPC_LOOPBACK_BUILD
+                nrLDPC_standin_connect(&svc->standin);
+#endif
+                data_path->standin = &svc->standin;
+        } else {
+                result = init_comch_data_path_client_objects(client_objs, svc->server_name);
+                if (result != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Failed to connect to %s with error = %s",
+                                     svc->server_name,
+                                     doca_error_get_name(result));
+                        return result;
+                }
+                data_path->pe = client_objs->pe;
+                data_path->connection = client_objs->connection;
+        }
+
+        /* The stand-in announces the version and the features it is told to emulate */
+        if (session.cfg.loopback == true) {
+                client_objs->server_version = session.cfg.loopback_version;
+                client_objs->server_features = svc->standin.features;
+        }
+        /* A server of another version, or one announcing none, would misread every request: the host decodes */
+        if (client_objs->server_version != NRLDPC_PROTO_VERSION) {
+                if (client_objs->server_version == 0)
+                        DOCA_LOG_ERR("%s announces no protocol version, it predates version %u",
+                                     svc->server_name,
+                                     NRLDPC_PROTO_VERSION);
+                else
+                        DOCA_LOG_ERR("%s speaks protocol version %u, version %u is needed",
+                                     svc->server_name,
+                                     client_objs->server_version,
+                                     NRLDPC_PROTO_VERSION);
+                clean_comch_data_path_client_objects(client_objs);
+                svc->refused = true;
+                return DOCA_ERROR_NOT_SUPPORTED;
+        }
+        atomic_store(&svc->features, client_objs->server_features & NRLDPC_PROTO_FEATURES_ALL);
+        DOCA_LOG_INFO("%s speaks protocol version %u, features 0x%x",
+                      svc->server_name,
+                      client_objs->server_version,
+                      atomic_load(&svc->features));
+
+        /* Never send more requests than the server has receives posted for, whichever data path they use */
+        svc->credit_limit = client_objs->server_credits;
+        if (session.cfg.credits != 0 && (svc->credit_limit == 0 || session.cfg.credits < svc->credit_limit))
+                svc->credit_limit = session.cfg.credits;
+        if (svc->credit_limit == 0)
+                svc->credit_limit = data_path->recv_depth;
+        atomic_store(&svc->credits, svc->credit_limit);
+        data_path->credits = &svc->credits;
+        DOCA_LOG_INFO("%s grants %u credits%s",
+                      svc->server_name,
+                      svc->credit_limit,
+                      client_objs->server_credits != 0 ? "" : " (not announced)");
+
+        result = comch_data_path_start(data_path);
+        if (result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to start data path to %s with error = %s",
+                             svc->server_name,
+                             doca_error_get_name(result));
+                clean_comch_data_path_client_objects(client_objs);
+                return result;
+        }
+
+        /* At most recv_depth requests are outstanding, so as many asynchronous ones */
+        memset(&svc->pending, 0, sizeof(svc->pending));
+        svc->pending.size = data_path->recv_depth != 0 ? data_path->recv_depth : CC_DATA_PATH_RECV_DEPTH;
+        svc->pending.reqs = calloc(svc->pending.size, sizeof(*svc->pending.reqs));
+        svc->resp_buf = malloc(data_path->max_msg_size);
+        /* Every producer slot, of any class, can hold a request waiting to be scheduled */
+        memset(&svc->sched, 0, sizeof(svc->sched));
+        svc->sched.size = local_mem_pool_slots(&data_path->producer_pool);
+        svc->sched.descs = calloc(svc->sched.size, sizeof(*svc->sched.descs));
+        /* The channels are only started by the threads claiming them */
+        svc->num_channels = session.cfg.thread_channels;
+        svc->channels = svc->num_channels != 0 ? calloc(svc->num_channels, sizeof(*svc->channels)) : NULL;
+        result = coalescer_init(&svc->coalesce, svc->sched.size, data_path->max_msg_size);
+        if (svc->pending.reqs == NULL || svc->resp_buf == NULL || svc->sched.descs == NULL ||
+            (svc->num_channels != 0 && svc->channels == NULL) || result != DOCA_SUCCESS) {
+                DOCA_LOG_ERR("Failed to allocate the asynchronous requests of %s", svc->server_name);
+                free(svc->pending.reqs);
+                free(svc->resp_buf);
+                free(svc->sched.descs);
+                svc->sched.descs = NULL;
+                coalescer_clean(&svc->coalesce);
+                free(svc->channels);
+                svc->channels = NULL;
+                svc->num_channels = 0;
+                comch_data_path_stop(data_path);
+                clean_comch_data_path_client_objects(client_objs);
+                return DOCA_ERROR_NO_MEMORY;
+        }
+
+        /* The emulated DPU keeps the HARQ soft buffers of the decoder */
+        if (session.cfg.loopback == true && type == NRLDPC_SERVICE_DECOD)
+                nrLDPC_harq_store_init(&svc->standin.harq, session.cfg.harq_buffers);
+
+        svc->connected = true;
+        DOCA_LOG_INFO("Connected to %s", svc->server_name);
+        return DOCA_SUCCESS;
+}
+
+/**
+ * Tear down the data path and the control path of a service
+ *
+ * @svc [in]: Service to disconnect
+ */
+static void nrLDPC_service_disconnect(struct nrLDPC_service *svc)
+{
+        if (svc->connected == false)
+                return;
+
+        /* Every asynchronous request gets its completion, OAI workers may be waiting for it */
+        service_flush(svc);
+        if (svc->coalesce.msgs != 0)
+                DOCA_LOG_INFO("%s: %lu requests coalesced into %lu messages",
+                              svc->server_name,
+                              (unsigned long)svc->coalesce.reqs,
+                              (unsigned long)svc->coalesce.msgs);
+        if (svc->dropped != 0 || svc->cancelled != 0)
+                DOCA_LOG_INFO("%s: %lu requests of aborted transport blocks dropped, %lu cancelled, %lu skipped",
+                              svc->server_name,
+                              (unsigned long)svc->dropped,
+                              (unsigned long)svc->cancelled,
+                              (unsigned long)svc->skipped);
+        free(svc->pending.reqs);
+        free(svc->resp_buf);
+        free(svc->sched.descs);
+        svc->pending.reqs = NULL;
+        svc->resp_buf = NULL;
+        svc->sched.descs = NULL;
+        coalescer_clean(&svc->coalesce);
+
+        /* The channels use the connection, they go first */
+        service_stop_channels(svc);
+
+        comch_data_path_stop(&svc->data_path);
+        clean_comch_data_path_client_objects(&svc->client_objs);
+        if (session.cfg.loopback == true && svc->standin.service == NRLDPC_SERVICE_DECOD)
+                nrLDPC_harq_store_clean(&svc->standin.harq);
+        svc->connected = false;
+}
+
+/**
+ * Parse an unsigned integer environment variable
+ *
+ * @name [in]: Variable name
+ * @def [in]: Value returned when the variable is not set
+ * @return: The variable value
+ */
+static uint32_t env_u32(const char *name, uint32_t def)
+{
+        const char *val = getenv(name);
+
+        if (val == NULL || *val == '\0')
+                return def;
+        return (uint32_t)strtoul(val, NULL, 0);
+}
+
+void nrLDPC_session_cfg_from_env(struct nrLDPC_session_cfg *cfg)
+{
+        uint32_t ring_size;
+        const char *val;
+
+        memset(cfg, 0, sizeof(*cfg));
+        strncpy(cfg->dev_pci_addr, NRLDPC_DEFAULT_PCI_ADDR, sizeof(cfg->dev_pci_addr) - 1);
+        cfg->connect_at_init[NRLDPC_SERVICE_ENCOD] = true;
+        cfg->connect_at_init[NRLDPC_SERVICE_DECOD] = true;
+
+        val = getenv(NRLDPC_ENV_PCI_ADDR);
+        if (val != NULL && *val != '\0')
+                strncpy(cfg->dev_pci_addr, val, sizeof(cfg->dev_pci_addr) - 1);
+
+        val = getenv(NRLDPC_ENV_SERVICES);
+        if (val != NULL) {
+                cfg->connect_at_init[NRLDPC_SERVICE_ENCOD] = strstr(val, "encod") != NULL;
+                cfg->connect_at_init[NRLDPC_SERVICE_DECOD] = strstr(val, "decod") != NULL;
+        }
+
+        cfg->loopback = env_u32(NRLDPC_ENV_LOOPBACK, 0) != 0;
+        cfg->loopback_service_ns = env_u32(NRLDPC_ENV_LOOPBACK_SERVICE_NS, 0);
+        cfg->loopback_connect_ns = env_u32(NRLDPC_ENV_LOOPBACK_CONNECT_NS, 0);
+        cfg->loopback_rtt_ns = env_u32(NRLDPC_ENV_LOOPBACK_RTT_NS, 0);
+        cfg->loopback_queued = env_u32(NRLDPC_ENV_LOOPBACK_QUEUED, 0) != 0;
+        cfg->loopback_hiccup_every = env_u32(NRLDPC_ENV_LOOPBACK_HICCUP_EVERY, 0);
+        cfg->loopback_hiccup_ns = env_u32(NRLDPC_ENV_LOOPBACK_HICCUP_NS, 0);
+        cfg->loopback_features = env_u32(NRLDPC_ENV_LOOPBACK_FEATURES, NRLDPC_PROTO_FEATURES_ALL);
+        cfg->loopback_version = env_u32(NRLDPC_ENV_LOOPBACK_VERSION, NRLDPC_PROTO_VERSION);
+        cfg->slab_slots = env_u32(NRLDPC_ENV_SLAB_SLOTS, CC_DATA_PATH_SLAB_SLOTS);
+        if (cfg->slab_slots == 0)
+                cfg->slab_slots = CC_DATA_PATH_SLAB_SLOTS;
+        cfg->recv_depth = env_u32(NRLDPC_ENV_RECV_DEPTH, CC_DATA_PATH_RECV_DEPTH);
+        if (cfg->recv_depth == 0)
+                cfg->recv_depth = CC_DATA_PATH_RECV_DEPTH;
+        cfg->slot_classes = env_u32(NRLDPC_ENV_SLOT_CLASSES, 1) != 0;
+        cfg->queue_depth = env_u32(NRLDPC_ENV_QUEUE_DEPTH, 0);
+        cfg->credits = env_u32(NRLDPC_ENV_CREDITS, 0);
+
+        val = getenv(NRLDPC_ENV_ENCOD_INPUT);
+        cfg->encod_input_packed = val == NULL || strcmp(val, "bytes") != 0;
+
+        cfg->encod_msg_segs = env_u32(NRLDPC_ENV_ENCOD_MSG_SEGS, NRLDPC_PROTO_ENCOD_MAX_SEGS);
+        if (cfg->encod_msg_segs == 0 || cfg->encod_msg_segs > NRLDPC_PROTO_ENCOD_MAX_SEGS)
+                cfg->encod_msg_segs = NRLDPC_PROTO_ENCOD_MAX_SEGS;
+
+        val = getenv(NRLDPC_ENV_PROGRESS_POLL);
+        cfg->progress_mode = NRLDPC_PROGRESS_SLEEP;
+        if (val != NULL && strcmp(val, "busy") == 0)
+                cfg->progress_mode = NRLDPC_PROGRESS_BUSY;
+        else if (val != NULL && strcmp(val, "event") == 0)
+                cfg->progress_mode = NRLDPC_PROGRESS_EVENT;
+        cfg->progress_spin_rate = env_u32(NRLDPC_ENV_PROGRESS_SPIN_RATE, NRLDPC_PROGRESS_SPIN_RATE);
+
+        val = getenv(NRLDPC_ENV_PROGRESS_CPU);
+        cfg->progress_cpu = val != NULL && *val != '\0' ? (int32_t)strtol(val, NULL, 0) : -1;
+
+        cfg->thread_channels = env_u32(NRLDPC_ENV_THREAD_CHANNELS, 0);
+        if (cfg->thread_channels > NRLDPC_MAX_THREAD_CHANNELS)
+                cfg->thread_channels = NRLDPC_MAX_THREAD_CHANNELS;
+
+        ring_size = env_u32(NRLDPC_ENV_SUBMIT_RING, NRLDPC_SUBMIT_RING_SIZE);
+        for (cfg->submit_ring_size = 2; cfg->submit_ring_size < ring_size && cfg->submit_ring_size < (1U << 20);)
+                cfg->submit_ring_size <<= 1;
+
+        val = getenv(NRLDPC_ENV_BLOCKING_PATH);
+        cfg->blocking_ring = val != NULL && strcmp(val, "ring") == 0;
+
+        val = getenv(NRLDPC_ENV_SCHED);
+        cfg->sched_mode = val != NULL && strcmp(val, "fifo") == 0 ? NRLDPC_SCHED_FIFO : NRLDPC_SCHED_EDF;
+        cfg->budget_us[NRLDPC_SERVICE_ENCOD] = env_u32(NRLDPC_ENV_ENCOD_BUDGET_US, NRLDPC_ENCOD_BUDGET_US);
+        cfg->budget_us[NRLDPC_SERVICE_DECOD] = env_u32(NRLDPC_ENV_DECOD_BUDGET_US, NRLDPC_DECOD_BUDGET_US);
+
+        cfg->coalesce_us = env_u32(NRLDPC_ENV_COALESCE_US, 0);
+        cfg->coalesce_bytes = env_u32(NRLDPC_ENV_COALESCE_BYTES, NRLDPC_COALESCE_BYTES);
+        cfg->coalesce_adapt = env_u32(NRLDPC_ENV_COALESCE_ADAPT, 1) != 0;
+        cfg->cancel = env_u32(NRLDPC_ENV_CANCEL, 1) != 0;
+
+        val = getenv(NRLDPC_ENV_HOST);
+        cfg->host_mode = NRLDPC_HOST_FALLBACK;
+        if (val != NULL && strcmp(val, "off") == 0)
+                cfg->host_mode = NRLDPC_HOST_OFF;
+        else if (val != NULL && strcmp(val, "always") == 0)
+                cfg->host_mode = NRLDPC_HOST_ALWAYS;
+        else if (val != NULL && strcmp(val, "auto") == 0)
+                cfg->host_mode = NRLDPC_HOST_AUTO;
+        cfg->host_cpu_pct = env_u32(NRLDPC_ENV_HOST_CPU_PCT, NRLDPC_DISPATCH_HOST_CPU_PCT);
+        cfg->dispatch_explore = env_u32(NRLDPC_ENV_DISPATCH_EXPLORE, NRLDPC_DISPATCH_EXPLORE);
+        cfg->hedge_pct = env_u32(NRLDPC_ENV_HEDGE_PCT, 0);
+        cfg->harq_buffers = env_u32(NRLDPC_ENV_HARQ_BUFFERS, NRLDPC_HARQ_BUFFERS);
+}
+
+/**
+ * Register the logger backends, the SDK keeps them for the lifetime of the process
+ *
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t create_log_backends(void)
+{
+        struct doca_log_backend *sdk_log;
+        doca_error_t result;
+
+        if (log_backends_created == true)
+                return DOCA_SUCCESS;
+
+        /* Register a logger backend */
+        result = doca_log_backend_create_standard();
+        if (result != DOCA_SUCCESS)
+                return result;
+
+        /* Register a logger backend for internal SDK errors and warnings */
+        result = doca_log_backend_create_with_file_sdk(stderr, &sdk_log);
+        if (result != DOCA_SUCCESS)
+                return result;
+        result = doca_log_backend_set_sdk_level(sdk_log, DOCA_LOG_LEVEL_WARNING);
+        if (result != DOCA_SUCCESS)
+                return result;
+
+        log_backends_created = true;
+        return DOCA_SUCCESS;
+}
+
+/**
+ * Create the session, session_lock must be held
+ *
+ * @cfg [in]: Session configuration
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t session_init_locked(const struct nrLDPC_session_cfg *cfg)
+{
+        static const char *const server_names[NRLDPC_SERVICE_NUM] = {NRLDPC_ENCOD_SERVER_NAME,
+                                                                      NRLDPC_DECOD_SERVER_NAME};
+        doca_error_t result;
+        int i;
+
+        if (session_ready == true)
+                return DOCA_SUCCESS;
+
+        result = create_log_backends();
+        if (result != DOCA_SUCCESS)
+                return result;
+
+        memset(&session, 0, sizeof(session));
+        session.cfg = *cfg;
+#ifndef NRLDPC_LOOPBACK_BUILD
+        /* The stand-in server is for benchmarks, it is not in the library unless configured with -Dloopback=true */
+        if (session.cfg.loopback == true) {
+                DOCA_LOG_ERR("%s is set, but the library is built without the loopback stand-in", NRLDPC_ENV_LOOPBACK);
+                return DOCA_ERROR_NOT_SUPPORTED;
+        }
+#endif
+        if (session.cfg.submit_ring_size < 2)
+                session.cfg.submit_ring_size = 2;
+        if (session.cfg.queue_depth != 0) {
+                /* One depth for the whole pipeline: slots to stage, receives to post and ring cells to queue */
+                session.cfg.slab_slots = session.cfg.queue_depth;
+                session.cfg.recv_depth = session.cfg.queue_depth;
+                while (session.cfg.submit_ring_size < session.cfg.queue_depth &&
+                       session.cfg.submit_ring_size < (1U << 20))
+                        session.cfg.submit_ring_size <<= 1;
+        }
+        session.progress_epfd = -1;
+        session.progress_wakefd = -1;
+        session.progress_timerfd = -1;
+        session.generation = ++session_generation;
+
+        /* Open DOCA device according to the given PCI address */
+        if (session.cfg.loopback == false) {
+                result = open_doca_device_with_pci(session.cfg.dev_pci_addr, NULL, &session.hw_dev);
+                if (result != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Failed to open Comm Channel DOCA device based on PCI address %s",
+                                     session.cfg.dev_pci_addr);
+                        return result;
+                }
+        }
+
+        for (i = 0; i < NRLDPC_SERVICE_NUM; i++) {
+                session.services[i].server_name = server_names[i];
+                pthread_mutex_init(&session.services[i].lock, NULL);
+        }
+
+        for (i = 0; i < NRLDPC_SERVICE_NUM; i++) {
+                result = submit_ring_init(&session.services[i].submits, session.cfg.submit_ring_size);
+                if (result != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Failed to allocate the submission ring of %s", server_names[i]);
+                        goto disconnect;
+                }
+        }
+
+        for (i = 0; i < NRLDPC_SERVICE_NUM; i++) {
+                if (session.cfg.connect_at_init[i] == false)
+                        continue;
+                result = nrLDPC_service_connect(&session.services[i], i);
+                /* The session still serves the other one, the calls of a refused service run on the host */
+                if (result != DOCA_SUCCESS && session.services[i].refused == false)
+                        goto disconnect;
+        }
+
+        if (session.cfg.host_mode == NRLDPC_HOST_AUTO)
+                nrLDPC_dispatch_init(session.cfg.host_cpu_pct, session.cfg.dispatch_explore);
+        if (session.cfg.hedge_pct != 0)
+                nrLDPC_hedge_init();
+        nrLDPC_harq_init();
+        nrLDPC_rm_init();
+        nrLDPC_crc_init();
+        session_ready = true;
+        if (session.cfg.loopback == true)
+                DOCA_LOG_WARN("LDPC offloading session ready on the loopback stand-in, no DPU is used");
+        else
+                DOCA_LOG_INFO("LDPC offloading session ready");
+        return DOCA_SUCCESS;
+
+disconnect:
+        for (i = 0; i < NRLDPC_SERVICE_NUM; i++) {
+                nrLDPC_service_disconnect(&session.services[i]);
+                submit_ring_clean(&session.services[i].submits);
+                pthread_mutex_destroy(&session.services[i].lock);
+        }
+        if (session.hw_dev != NULL) {
+                (void)doca_dev_close(session.hw_dev);
+                session.hw_dev = NULL;
+        }
+        return result;
+}
+
+/**
+ * Create the file descriptors the event mode progress thread waits on: the epoll set, the eventfd signalled by
+ * the submissions and the timer of the stand-in round trips. The PE notification handles join the set once the
+ * services are connected.
+ *
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t session_event_open(void)
+{
+        struct epoll_event ev = {.events = EPOLLIN};
+
+        session.progress_epfd = epoll_create1(EPOLL_CLOEXEC);
+        session.progress_wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        session.progress_timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (session.progress_epfd < 0 || session.progress_wakefd < 0 || session.progress_timerfd < 0)
+                goto fail;
+
+        ev.data.fd = session.progress_wakefd;
+        if (epoll_ctl(session.progress_epfd, EPOLL_CTL_ADD, session.progress_wakefd, &ev) != 0)
+                goto fail;
+        ev.data.fd = session.progress_timerfd;
+        if (epoll_ctl(session.progress_epfd, EPOLL_CTL_ADD, session.progress_timerfd, &ev) != 0)
+                goto fail;
+
+        return DOCA_SUCCESS;
+
+fail:
+        DOCA_LOG_ERR("Failed to create the progress thread events: %s", strerror(errno));
+        return DOCA_ERROR_OPERATING_SYSTEM;
+}
+
+/*
+ * Close the file descriptors of the event mode, if any
+ */
+static void session_event_close(void)
+{
+        int *fds[] = {&session.progress_timerfd, &session.progress_wakefd, &session.progress_epfd};
+        size_t i;
+
+        for (i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+                if (*fds[i] >= 0)
+                        close(*fds[i]);
+                *fds[i] = -1;
+        }
+}
+
+/*
+ * Wake the progress thread up if it is blocked in epoll
+ */
+static void session_progress_wake(void)
+{
+        uint64_t one = 1;
+
+        if (session.progress_wakefd >= 0)
+                (void)!write(session.progress_wakefd, &one, sizeof(one));
+}
+
+doca_error_t nrLDPC_session_init(const struct nrLDPC_session_cfg *cfg)
+{
+        doca_error_t result;
+
+        pthread_mutex_lock(&session_lock);
+        result = session_init_locked(cfg);
+        pthread_mutex_unlock(&session_lock);
+
+        return result;
+}
+
+void nrLDPC_session_destroy(void)
+{
+        doca_error_t result;
+        int i;
+
+        pthread_mutex_lock(&session_lock);
+        if (session_ready == false) {
+                /* The calls made without a session decoded on the host, with its store */
+                nrLDPC_harq_host_store_clean();
+                pthread_mutex_unlock(&session_lock);
+                return;
+        }
+        session_ready = false;
+
+        if (atomic_load(&session.progress_running) == true) {
+                atomic_store(&session.progress_running, false);
+                session_progress_wake();
+                pthread_join(session.progress_thread, NULL);
+        }
+        session_event_close();
+
+        for (i = 0; i < NRLDPC_SERVICE_NUM; i++) {
+                pthread_mutex_lock(&session.services[i].lock);
+                nrLDPC_service_disconnect(&session.services[i]);
+                pthread_mutex_unlock(&session.services[i].lock);
+                submit_ring_clean(&session.services[i].submits);
+                pthread_mutex_destroy(&session.services[i].lock);
+        }
+
+        if (session.hw_dev != NULL) {
+                result = doca_dev_close(session.hw_dev);
+                if (result != DOCA_SUCCESS)
+                        DOCA_LOG_ERR("Failed to close hw device properly with error = %s", doca_error_get_name(result));
+                session.hw_dev = NULL;
+        }
+
+        if (session.cfg.host_mode == NRLDPC_HOST_AUTO)
+                nrLDPC_dispatch_report();
+        if (session.cfg.hedge_pct != 0)
+                nrLDPC_hedge_report();
+        nrLDPC_harq_report();
+        nrLDPC_harq_host_store_clean();
+        nrLDPC_rm_report();
+        nrLDPC_crc_report();
+
+        pthread_mutex_unlock(&session_lock);
+        DOCA_LOG_INFO("LDPC offloading session closed");
+}
+
+struct nrLDPC_session *nrLDPC_session_get(void)
+{
+        struct nrLDPC_session_cfg cfg;
+        doca_error_t result;
+
+        if (session_ready == true)
+                return &session;
+
+        /* OAI did not call LDPCinit, create the session on first use */
+        pthread_mutex_lock(&session_lock);
+        nrLDPC_session_cfg_from_env(&cfg);
+        result = session_init_locked(&cfg);
+        pthread_mutex_unlock(&session_lock);
+
+        return result == DOCA_SUCCESS ? &session : NULL;
+}
+
+/**
+ * Lock a service, connecting it on first use
+ *
+ * @type [in]: Service to lock
+ * @svc [out]: The locked service
+ * @return: DOCA_SUCCESS on success, the service is then locked, and DOCA_ERROR otherwise
+ */
+static doca_error_t nrLDPC_service_lock(enum nrLDPC_service_type type, struct nrLDPC_service **svc)
+{
+        struct nrLDPC_session *s;
+        doca_error_t result;
+
+        s = nrLDPC_session_get();
+        if (s == NULL)
+                return DOCA_ERROR_INITIALIZATION;
+
+        *svc = &s->services[type];
+        pthread_mutex_lock(&(*svc)->lock);
+
+        if ((*svc)->connected == false) {
+                /* A server of another protocol is not retried on every call, the caller goes to the host */
+                if ((*svc)->refused == true) {
+                        pthread_mutex_unlock(&(*svc)->lock);
+                        return DOCA_ERROR_NOT_SUPPORTED;
+                }
+                result = nrLDPC_service_connect(*svc, type);
+                if (result != DOCA_SUCCESS) {
+                        pthread_mutex_unlock(&(*svc)->lock);
+                        return result;
+                }
+        }
+
+        return DOCA_SUCCESS;
+}
+
+uint32_t nrLDPC_session_features(enum nrLDPC_service_type type)
+{
+        struct nrLDPC_service *svc;
+        doca_error_t result;
+
+        /* The features do not change while the service is connected */
+        svc = &session.services[type];
+        if (session_ready == true && atomic_load_explicit(&svc->connected, memory_order_acquire) == true)
+                return atomic_load_explicit(&svc->features, memory_order_relaxed);
+
+        result = nrLDPC_service_lock(type, &svc);
+        if (result != DOCA_SUCCESS)
+                return 0;
+        pthread_mutex_unlock(&svc->lock);
+
+        return atomic_load_explicit(&svc->features, memory_order_relaxed);
+}
+
+doca_error_t nrLDPC_session_send(enum nrLDPC_service_type type, const void *req, uint32_t req_len)
+{
+        struct nrLDPC_service *svc;
+        doca_error_t result;
+
+        result = nrLDPC_service_lock(type, &svc);
+        if (result != DOCA_SUCCESS)
+                return result;
+        service_flush(svc);
+
+        result = comch_data_path_send_msg(&svc->data_path, req, req_len);
+        if (result != DOCA_SUCCESS && result != DOCA_ERROR_AGAIN)
+                DOCA_LOG_ERR("Failed to send request to %s with error = %s",
+                             svc->server_name,
+                             doca_error_get_name(result));
+
+        pthread_mutex_unlock(&svc->lock);
+        return result;
+}
+
+doca_error_t nrLDPC_session_recv(enum nrLDPC_service_type type, void *resp, uint32_t resp_size, uint32_t *resp_len)
+{
+        struct nrLDPC_service *svc;
+        doca_error_t result;
+
+        result = nrLDPC_service_lock(type, &svc);
+        if (result != DOCA_SUCCESS)
+                return result;
+        service_flush(svc);
+
+        result = comch_data_path_recv_msg(&svc->data_path, resp, resp_size, resp_len);
+        if (result != DOCA_SUCCESS && result != DOCA_ERROR_NOT_FOUND)
+                DOCA_LOG_ERR("Failed to receive response from %s with error = %s",
+                             svc->server_name,
+                             doca_error_get_name(result));
+
+        pthread_mutex_unlock(&svc->lock);
+        return result;
+}
+
+/**
+ * Give the channels of an exiting thread back to their services
+ *
+ * @arg [in]: session_thread_channels of the thread
+ */
+static void thread_channels_release(void *arg)
+{
+        struct session_thread_channels *tc = arg;
+        int i;
+
+        /* The channels of a destroyed session went away with it */
+        if (session_ready == true && tc->generation == session.generation) {
+                for (i = 0; i < NRLDPC_SERVICE_NUM; i++) {
+                        if (tc->channels[i] != NULL)
+                                atomic_store(&tc->channels[i]->claimed, false);
+                }
+        }
+        free(tc);
+}
+
+/*
+ * Create the key of the per thread channels
+ */
+static void thread_channels_key_create(void)
+{
+        (void)pthread_key_create(&thread_channels_key, thread_channels_release);
+}
+
+/**
+ * Get the channel of the calling thread on a service, claiming and starting a free one on first use
+ *
+ * @svc [in]: Service, connected
+ * @type [in]: Service type
+ * @return: The channel of the thread, NULL when it shares the service lock
+ */
+static struct nrLDPC_channel *service_thread_channel(struct nrLDPC_service *svc, enum nrLDPC_service_type type)
+{
+        struct session_thread_channels *tc;
+        struct nrLDPC_channel *channel = NULL;
+        doca_error_t result;
+        bool expected;
+        uint32_t i;
+
+        if (svc->num_channels == 0)
+                return NULL;
+
+        pthread_once(&thread_channels_once, thread_channels_key_create);
+        tc = pthread_getspecific(thread_channels_key);
+        if (tc == NULL) {
+                tc = calloc(1, sizeof(*tc));
+                if (tc == NULL || pthread_setspecific(thread_channels_key, tc) != 0) {
+                        free(tc);
+                        return NULL;
+                }
+        }
+        if (tc->generation != session.generation) {
+                memset(tc, 0, sizeof(*tc));
+                tc->generation = session.generation;
+        }
+        if (tc->channels[type] != NULL || tc->shared[type] == true)
+                return tc->channels[type];
+
+        for (i = 0; i < svc->num_channels && channel == NULL; i++) {
+                expected = false;
+                if (atomic_compare_exchange_strong(&svc->channels[i].claimed, &expected, true) == true)
+                        channel = &svc->channels[i];
+        }
+        if (channel == NULL) {
+                DOCA_LOG_WARN("All %u channels of %s are taken, the thread shares the service lock",
+                              svc->num_channels,
+                              svc->server_name);
+                tc->shared[type] = true;
+                return NULL;
+        }
+
+        /* A channel given back by an exited thread is still started */
+        if (channel->started == false) {
+                pthread_mutex_lock(&svc->lock);
+                result = service_start_channel(svc, channel);
+                pthread_mutex_unlock(&svc->lock);
+                if (result != DOCA_SUCCESS) {
+                        atomic_store(&channel->claimed, false);
+                        tc->shared[type] = true;
+                        return NULL;
+                }
+        }
+
+        tc->channels[type] = channel;
+        return channel;
+}
+
+/**
+ * Exchange a batch of requests on a data path, pipelined up to recv_depth outstanding requests
+ *
+ * @svc [in]: Service the data path belongs to
+ * @data_path [in]: Data path of the service or of a channel, used by the calling thread only
+ * @count [in]: Number of requests
+ * @reqs [in]: Request messages
+ * @req_lens [in]: Request message lengths
+ * @resps [out]: Response messages, in request order
+ * @resp_size [in]: Size of each resps buffer
+ * @resp_lens [out]: Response message lengths
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+static doca_error_t data_path_transact(struct nrLDPC_service *svc,
+                                       struct comch_data_path_objects *data_path,
+                                       uint32_t count,
+                                       const void *const *reqs,
+                                       const uint32_t *req_lens,
+                                       void *const *resps,
+                                       uint32_t resp_size,
+                                       uint32_t *resp_lens)
+{
+        uint32_t sent = 0;
+        uint32_t received = 0;
+        doca_error_t result;
+
+        /* Keep the pipeline full: send until the posted receives run out, then make room with the oldest response */
+        while (received < count) {
+                if (sent < count) {
+                        result = comch_data_path_send_msg(data_path, reqs[sent], req_lens[sent]);
+                        if (result == DOCA_SUCCESS) {
+                                sent++;
+                                continue;
+                        }
+                        if (result == DOCA_ERROR_AGAIN && sent == received &&
+                            data_path->in_flight < data_path->recv_depth) {
+                                /* Nothing of ours to wait for, the other data paths hold the server credits */
+                                comch_data_path_idle(data_path);
+                                continue;
+                        }
+                        if (result != DOCA_ERROR_AGAIN || sent == received) {
+                                DOCA_LOG_ERR("Failed to send request to %s with error = %s",
+                                             svc->server_name,
+                                             doca_error_get_name(result));
+                                goto drain;
+                        }
+                }
+
+                result = comch_data_path_recv_msg(data_path, resps[received], resp_size, &resp_lens[received]);
+                if (result != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Failed to receive response from %s with error = %s",
+                                     svc->server_name,
+                                     doca_error_get_name(result));
+                        received++;
+                        goto drain;
+                }
+                received++;
+        }
+
+        return DOCA_SUCCESS;
+
+drain:
+        /* Do not leave responses behind for the next request on the data path */
+        while (received < sent) {
+                if (comch_data_path_recv_msg(data_path, resps[received], resp_size, NULL) == DOCA_ERROR_NOT_FOUND)
+                        break;
+                received++;
+        }
+        return result;
+}
+
+static void session_progress_start(void);
+
+/**
+ * Completion of a request of a blocking batch sent through the submission ring
+ *
+ * @user_data [in]: The session_ring_wait of the batch
+ * @tag [in]: Index of the request in the batch
+ * @resp [in]: Response message
+ * @resp_len [in]: Response message length
+ * @status [in]: DOCA_SUCCESS when resp holds the response
+ */
+static void session_ring_done(void *user_data, uint32_t tag, const void *resp, uint32_t resp_len, doca_error_t status)
+{
+        struct session_ring_wait *wait = user_data;
+        doca_error_t expected = DOCA_SUCCESS;
+
+        if (status == DOCA_SUCCESS && resp_len > wait->resp_size) {
+                DOCA_LOG_ERR("Received %u bytes message, larger than the %u bytes response buffer",
+                             resp_len,
+                             wait->resp_size);
+                status = DOCA_ERROR_NO_MEMORY;
+        }
+
+        if (status == DOCA_SUCCESS) {
+                memcpy(wait->resps[tag], resp, resp_len);
+                wait->resp_lens[tag] = resp_len;
+        } else {
+                (void)atomic_compare_exchange_strong(&wait->result, &expected, status);
+        }
+
+        if (atomic_fetch_sub(&wait->remaining, 1) == 1)
+                sem_post(&wait->done);
+}
+
+/**
+ * Exchange a blocking batch through the submission ring: the progress thread sends the requests and completes
+ * them, the calling thread only waits
+ *
+ * @type [in]: Service to use, connected
+ * @count [in]: Number of requests
+ * @reqs [in]: Request messages
+ * @req_lens [in]: Request message lengths
+ * @resps [out]: Response messages, in request order
+ * @resp_size [in]: Size of each resps buffer
+ * @resp_lens [out]: Response message lengths
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_NOT_SUPPORTED when the progress thread is not running
+ *          and DOCA_ERROR otherwise
+ */
+static doca_error_t session_transact_ring(enum nrLDPC_service_type type,
+                                          uint32_t count,
+                                          const void *const *reqs,
+                                          const uint32_t *req_lens,
+                                          void *const *resps,
+                                          uint32_t resp_size,
+                                          uint32_t *resp_lens)
+{
+        struct session_ring_wait wait = {
+                .resps = resps,
+                .resp_size = resp_size,
+                .resp_lens = resp_lens,
+        };
+
+        session_progress_start();
+        if (atomic_load_explicit(&session.progress_running, memory_order_acquire) == false)
+                return DOCA_ERROR_NOT_SUPPORTED;
+
+        atomic_init(&wait.result, DOCA_SUCCESS);
+        atomic_init(&wait.remaining, count);
+        if (sem_init(&wait.done, 0, 0) != 0)
+                return DOCA_ERROR_OPERATING_SYSTEM;
+
+        /* Every request gets its completion, failed or not */
+        (void)nrLDPC_session_submit(type, count, reqs, req_lens, session_ring_done, &wait);
+
+        /* Busy-poll spins, the final wait only makes sure the completion is done with the semaphore */
+        if (session.cfg.progress_mode == NRLDPC_PROGRESS_BUSY) {
+                while (atomic_load_explicit(&wait.remaining, memory_order_acquire) != 0)
+                        sched_yield();
+        }
+        while (sem_wait(&wait.done) != 0)
+                ;
+        sem_destroy(&wait.done);
+
+        return atomic_load(&wait.result);
+}
+
+doca_error_t nrLDPC_session_transact(enum nrLDPC_service_type type,
+                                     const void *req,
+                                     uint32_t req_len,
+                                     void *resp,
+                                     uint32_t resp_size,
+                                     uint32_t *resp_len)
+{
+        uint32_t len = 0;
+        doca_error_t result;
+
+        /* The request is copied into a producer slot when sent, resp may alias it */
+        result = nrLDPC_session_transact_batch(type, 1, &req, &req_len, &resp, resp_size, &len);
+        if (resp_len != NULL)
+                *resp_len = len;
+        return result;
+}
+
+doca_error_t nrLDPC_session_transact_batch(enum nrLDPC_service_type type,
+                                           uint32_t count,
+                                           const void *const *reqs,
+                                           const uint32_t *req_lens,
+                                           void *const *resps,
+                                           uint32_t resp_size,
+                                           uint32_t *resp_lens)
+{
+        struct nrLDPC_channel *channel;
+        struct nrLDPC_service *svc;
+        doca_error_t result;
+
+        if (nrLDPC_session_get() == NULL)
+                return DOCA_ERROR_INITIALIZATION;
+        svc = &session.services[type];
+
+        /* The thread owns its channel, no lock and no other request in its pipeline */
+        if (svc->connected == true) {
+                channel = service_thread_channel(svc, type);
+                if (channel != NULL)
+                        return data_path_transact(svc,
+                                                  &channel->data_path,
+                                                  count,
+                                                  reqs,
+                                                  req_lens,
+                                                  resps,
+                                                  resp_size,
+                                                  resp_lens);
+
+                if (session.cfg.blocking_ring == true) {
+                        result = session_transact_ring(type, count, reqs, req_lens, resps, resp_size, resp_lens);
+                        if (result != DOCA_ERROR_NOT_SUPPORTED)
+                                return result;
+                }
+        }
+
+        result = nrLDPC_service_lock(type, &svc);
+        if (result != DOCA_SUCCESS)
+                return result;
+        service_flush(svc);
+
+        result = data_path_transact(svc, &svc->data_path, count, reqs, req_lens, resps, resp_size, resp_lens);
+
+        pthread_mutex_unlock(&svc->lock);
+        return result;
+}
+
+/**
+ * Event mode: block until a response completes, a stand-in response arrives or a request is submitted.
+ * Called when a polling round found nothing to do, it arms the notifications of the services with requests
+ * in flight and gives up, without blocking, if work turns up meanwhile.
+ */
+static void session_progress_wait(void)
+{
+        struct epoll_event ev = {.events = EPOLLIN};
+        struct epoll_event events[NRLDPC_SERVICE_NUM + 2];
+        struct itimerspec timer = {0};
+        bool armed[NRLDPC_SERVICE_NUM] = {false};
+        struct nrLDPC_service *svc;
+        uint64_t wake_ns = 0;
+        uint64_t ready_ns;
+        uint64_t count;
+        bool idle = true;
+        int i, n;
+
+        /* Pairs with the submitters: either they see the flag and signal wakefd, or their request is seen here */
+        atomic_store(&session.progress_sleeping, true);
+
+        for (i = 0; i < NRLDPC_SERVICE_NUM && idle == true; i++) {
+                svc = &session.services[i];
+                if (svc->connected == false)
+                        continue;
+
+                pthread_mutex_lock(&svc->lock);
+                if (svc->notify_added == false) {
+                        svc->notify_added = true;
+                        if (comch_data_path_get_notification_handle(&svc->data_path, &svc->notify_handle) ==
+                            DOCA_SUCCESS) {
+                                ev.data.fd = (int)svc->notify_handle;
+                                if (epoll_ctl(session.progress_epfd, EPOLL_CTL_ADD, ev.data.fd, &ev) != 0)
+                                        DOCA_LOG_ERR("Failed to wait on the %s notifications: %s",
+                                                     svc->server_name,
+                                                     strerror(errno));
+                        }
+                }
+
+                /* The requests left in the heap wait for a response, that one wakes us up */
+                if (atomic_load(&svc->queued) > svc->sched.count) {
+                        idle = false;
+                } else if (svc->pending.count != 0) {
+                        armed[i] = comch_data_path_arm(&svc->data_path, &ready_ns) == DOCA_SUCCESS;
+                        if (ready_ns != 0 && (wake_ns == 0 || ready_ns < wake_ns))
+                                wake_ns = ready_ns;
+                }
+                /* A request held for coalescing goes when its window ends */
+                if (svc->coalesce.hold_until_ns != 0 && (wake_ns == 0 || svc->coalesce.hold_until_ns < wake_ns))
+                        wake_ns = svc->coalesce.hold_until_ns;
+                pthread_mutex_unlock(&svc->lock);
+        }
+
+        if (idle == true && atomic_load(&session.progress_running) == true) {
+                if (wake_ns != 0) {
+                        timer.it_value.tv_sec = wake_ns / 1000000000ULL;
+                        timer.it_value.tv_nsec = wake_ns % 1000000000ULL;
+                        (void)timerfd_settime(session.progress_timerfd, TFD_TIMER_ABSTIME, &timer, NULL);
+                }
+
+                n = epoll_wait(session.progress_epfd, events, NRLDPC_SERVICE_NUM + 2, -1);
+                for (i = 0; i < n; i++) {
+                        if (events[i].data.fd == session.progress_wakefd ||
+                            events[i].data.fd == session.progress_timerfd)
+                                (void)!read(events[i].data.fd, &count, sizeof(count));
+                }
+
+                if (wake_ns != 0) {
+                        timer.it_value.tv_sec = 0;
+                        timer.it_value.tv_nsec = 0;
+                        (void)timerfd_settime(session.progress_timerfd, 0, &timer, NULL);
+                }
+        }
+        atomic_store(&session.progress_sleeping, false);
+
+        for (i = 0; i < NRLDPC_SERVICE_NUM; i++) {
+                if (armed[i] == false)
+                        continue;
+                svc = &session.services[i];
+                pthread_mutex_lock(&svc->lock);
+                comch_data_path_disarm(&svc->data_path, svc->notify_handle);
+                pthread_mutex_unlock(&svc->lock);
+        }
+}
+
+/**
+ * Session progress thread: sends the asynchronous requests handed over and completes them as their responses
+ * arrive, for all services. Between idle rounds it sleeps SLEEP_IN_NANOS, spins, or, in event mode, blocks in
+ * epoll while the request rate is below progress_spin_rate and spins above it.
+ *
+ * @arg [in]: Unused
+ * @return: NULL
+ */
+static void *session_progress_loop(void *arg)
+{
+        struct timespec ts = {
+                .tv_sec = 0,
+                .tv_nsec = SLEEP_IN_NANOS,
+        };
+        struct timespec clock;
+        enum nrLDPC_progress_mode mode = session.cfg.progress_mode;
+        uint64_t spin_rate = session.cfg.progress_spin_rate;
+        bool edf = session.cfg.sched_mode == NRLDPC_SCHED_EDF;
+        uint64_t window_start = 0;
+        uint64_t window_done = 0;
+        uint64_t now;
+        bool spinning = false;
+        uint32_t done;
+        int i;
+
+        (void)arg;
+        while (atomic_load_explicit(&session.progress_running, memory_order_relaxed) == true) {
+                /* In EDF mode the decoder goes first, its uplink classes outrank the bulk encodes */
+                done = 0;
+                for (i = 0; i < NRLDPC_SERVICE_NUM; i++)
+                        done += nrLDPC_session_poll(edf == true ? NRLDPC_SERVICE_NUM - 1 - i : i);
+
+                if (mode == NRLDPC_PROGRESS_EVENT && spin_rate != 0) {
+                        /* Every request is counted twice, when sent and when completed */
+                        window_done += done;
+                        clock_gettime(CLOCK_MONOTONIC, &clock);
+                        now = (uint64_t)clock.tv_sec * 1000000000ULL + clock.tv_nsec;
+                        if (now - window_start >= NRLDPC_PROGRESS_RATE_WINDOW_NS) {
+                                /* Half the rate to stop spinning, a rate close to the threshold does not flap */
+                                if (spinning == false)
+                                        spinning = window_done * 1000000000ULL / 2 >= spin_rate * (now - window_start);
+                                else
+                                        spinning = window_done * 1000000000ULL >= spin_rate * (now - window_start);
+                                window_start = now;
+                                window_done = 0;
+                        }
+                }
+
+                if (done != 0)
+                        continue;
+                /* Busy-poll never sleeps, it only lets the threads sharing the core run, if any */
+                if (mode == NRLDPC_PROGRESS_BUSY || spinning == true)
+                        sched_yield();
+                else if (mode == NRLDPC_PROGRESS_EVENT)
+                        session_progress_wait();
+                else
+                        nanosleep(&ts, NULL);
+        }
+
+        return NULL;
+}
+
+/*
+ * Start the session progress thread, once, on its configured core
+ */
+static void session_progress_start(void)
+{
+        static const char *const mode_names[] = {"sleep-poll", "busy-poll", "event"};
+        cpu_set_t cpus;
+        int ret;
+
+        if (atomic_load_explicit(&session.progress_running, memory_order_acquire) == true)
+                return;
+
+        pthread_mutex_lock(&session_lock);
+        if (session_ready == true && atomic_load(&session.progress_running) == false) {
+                if (session.cfg.progress_mode == NRLDPC_PROGRESS_EVENT && session_event_open() != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Progress thread falls back to sleep-poll");
+                        session_event_close();
+                        session.cfg.progress_mode = NRLDPC_PROGRESS_SLEEP;
+                }
+                atomic_store(&session.progress_running, true);
+                if (pthread_create(&session.progress_thread, NULL, session_progress_loop, NULL) != 0) {
+                        DOCA_LOG_ERR("Failed to start the progress thread, requests complete on the next call");
+                        atomic_store(&session.progress_running, false);
+                } else if (session.cfg.progress_cpu >= 0) {
+                        CPU_ZERO(&cpus);
+                        CPU_SET(session.cfg.progress_cpu, &cpus);
+                        ret = pthread_setaffinity_np(session.progress_thread, sizeof(cpus), &cpus);
+                        if (ret != 0)
+                                DOCA_LOG_ERR("Failed to pin the progress thread to core %d: %s",
+                                             session.cfg.progress_cpu,
+                                             strerror(ret));
+                }
+                if (atomic_load(&session.progress_running) == true)
+                        DOCA_LOG_INFO("Progress thread started, %s mode, core %d (-1: not pinned)",
+                                      mode_names[session.cfg.progress_mode],
+                                      session.cfg.progress_cpu);
+        }
+        pthread_mutex_unlock(&session_lock);
+}
+
+/*
+ * Let the progress thread free producer slots or ring cells, waking it up if it is blocked in epoll
+ */
+static void session_submit_backoff(void)
+{
+        if (atomic_load(&session.progress_sleeping) == true)
+                session_progress_wake();
+        sched_yield();
+}
+
+/**
+ * nrLDPC_session_submit() without the progress thread: send the requests under the service lock
+ *
+ * @svc [in]: Service to use, connected
+ * @count [in]: Number of requests
+ * @reqs [in]: Request messages
+ * @req_lens [in]: Request message lengths
+ * @cb [in]: Completion callback
+ * @user_data [in]: Callback argument
+ * @try_only [in]: Stop at the first request that would wait for room, leaving it and the next ones to the caller
+ * @submitted [out]: Number of requests sent, may be NULL
+ * @return: DOCA_SUCCESS when all requests are sent, DOCA_ERROR_AGAIN when try_only stopped and DOCA_ERROR
+ *          otherwise
+ */
+static doca_error_t session_submit_locked(struct nrLDPC_service *svc,
+                                          uint32_t count,
+                                          const void *const *reqs,
+                                          const uint32_t *req_lens,
+                                          nrLDPC_session_done_cb cb,
+                                          void *user_data,
+                                          bool try_only,
+                                          uint32_t *submitted)
+{
+        struct nrLDPC_pending_req req = {
+                .cb = cb,
+                .user_data = user_data,
+                .abort = session.cfg.cancel == true ? session_sched_attr.abort : NULL,
+        };
+        struct nrLDPC_proto_hdr hdr;
+        doca_error_t result = DOCA_SUCCESS;
+        uint32_t i;
+
+        pthread_mutex_lock(&svc->lock);
+        for (i = 0; i < count; i++) {
+                /* The pipeline is full, make room by completing the oldest request */
+                while ((result = comch_data_path_send_msg(&svc->data_path, reqs[i], req_lens[i])) == DOCA_ERROR_AGAIN) {
+                        if (service_complete_one(svc, try_only == false) == DOCA_SUCCESS)
+                                continue;
+                        if (try_only == true)
+                                break;
+                        /* Or wait for the channels to give back the credits they hold */
+                        if (svc->data_path.in_flight >= svc->data_path.recv_depth)
+                                break;
+                        comch_data_path_idle(&svc->data_path);
+                }
+                if (result != DOCA_SUCCESS) {
+                        if (result != DOCA_ERROR_AGAIN || try_only == false)
+                                DOCA_LOG_ERR("Failed to send request to %s with error = %s",
+                                             svc->server_name,
+                                             doca_error_get_name(result));
+                        break;
+                }
+
+                req.tag = i;
+                if (req.abort != NULL) {
+                        memcpy(&hdr, reqs[i], sizeof(hdr));
+                        req.req_id = hdr.req_id;
+                }
+                service_pending_push(svc, &req);
+        }
+        pthread_mutex_unlock(&svc->lock);
+
+        if (submitted != NULL)
+                *submitted = i;
+        if (result == DOCA_ERROR_AGAIN && try_only == true)
+                return result;
+        for (; i < count; i++)
+                cb(user_data, i, NULL, 0, result);
+        return result;
+}
+
+/**
+ * Check whether the requests already queued for the progress thread take all the server credits left
+ *
+ * @svc [in]: Service
+ * @return: true when one more request would have to wait for a response to be sent
+ */
+static bool service_credits_taken(struct nrLDPC_service *svc)
+{
+        return atomic_load_explicit(&svc->queued, memory_order_relaxed) >=
+               atomic_load_explicit(&svc->credits, memory_order_relaxed);
+}
+
+/**
+ * Current time
+ *
+ * @return: CLOCK_MONOTONIC time in nanoseconds
+ */
+static uint64_t session_now_ns(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void nrLDPC_session_set_deadline(uint64_t deadline_ns, enum nrLDPC_traffic_class cls)
+{
+        session_sched_attr.deadline_ns = deadline_ns;
+        session_sched_attr.cls = cls < NRLDPC_CLASS_NUM ? cls : NRLDPC_CLASS_DEFAULT;
+}
+
+uint64_t nrLDPC_session_deadline(enum nrLDPC_service_type type)
+{
+        if (session_sched_attr.deadline_ns != 0)
+                return session_sched_attr.deadline_ns;
+        return nrLDPC_session_slot_deadline(type, session_now_ns());
+}
+
+void nrLDPC_session_set_abort(decode_abort_t *ab)
+{
+        session_sched_attr.abort = ab;
+}
+
+bool nrLDPC_session_aborted(decode_abort_t *ab)
+{
+        bool failed;
+
+        if (ab == NULL)
+                return false;
+        pthread_mutex_lock(&ab->mutex_failure);
+        failed = ab->failed;
+        pthread_mutex_unlock(&ab->mutex_failure);
+        return failed;
+}
+
+void nrLDPC_session_abort(decode_abort_t *ab)
+{
+        if (ab == NULL)
+                return;
+        pthread_mutex_lock(&ab->mutex_failure);
+        ab->failed = true;
+        pthread_mutex_unlock(&ab->mutex_failure);
+}
+
+uint64_t nrLDPC_session_slot_deadline(enum nrLDPC_service_type type, uint64_t slot_start_ns)
+{
+        static const uint32_t budget_us[NRLDPC_SERVICE_NUM] = {NRLDPC_ENCOD_BUDGET_US, NRLDPC_DECOD_BUDGET_US};
+
+        if (session_ready == true)
+                return slot_start_ns + (uint64_t)session.cfg.budget_us[type] * 1000;
+        return slot_start_ns + (uint64_t)budget_us[type] * 1000;
+}
+
+/**
+ * Tag a request with the deadline and the traffic class set by the calling thread
+ *
+ * @type [in]: Service the request goes to
+ * @desc [out]: Staged request
+ */
+static void session_sched_tag(enum nrLDPC_service_type type, struct nrLDPC_submit_desc *desc)
+{
+        enum nrLDPC_traffic_class cls = session_sched_attr.cls;
+
+        /* Submission order only, seq does it */
+        desc->deadline_ns = 0;
+        desc->rank = 0;
+        if (session.cfg.sched_mode == NRLDPC_SCHED_FIFO)
+                return;
+
+        if (cls == NRLDPC_CLASS_DEFAULT)
+                cls = type == NRLDPC_SERVICE_ENCOD ? NRLDPC_CLASS_BULK : NRLDPC_CLASS_UPLINK;
+        desc->rank = session_class_rank[cls];
+        desc->deadline_ns = session_sched_attr.deadline_ns;
+        if (desc->deadline_ns == 0)
+                desc->deadline_ns = nrLDPC_session_slot_deadline(type, session_now_ns());
+}
+
+/**
+ * Hand a batch of requests to the progress thread, see nrLDPC_session_submit() and nrLDPC_session_try_submit()
+ *
+ * @type [in]: Service to use
+ * @count [in]: Number of requests
+ * @reqs [in]: Request messages
+ * @req_lens [in]: Request message lengths
+ * @cb [in]: Completion callback
+ * @user_data [in]: Callback argument
+ * @try_only [in]: Stop at the first request that would wait for room, leaving it and the next ones to the caller
+ * @submitted [out]: Number of requests handed over, may be NULL
+ * @return: DOCA_SUCCESS when all requests are handed over, DOCA_ERROR_AGAIN when try_only stopped and
+ *          DOCA_ERROR otherwise
+ */
+static doca_error_t session_submit(enum nrLDPC_service_type type,
+                                   uint32_t count,
+                                   const void *const *reqs,
+                                   const uint32_t *req_lens,
+                                   nrLDPC_session_done_cb cb,
+                                   void *user_data,
+                                   bool try_only,
+                                   uint32_t *submitted)
+{
+        struct nrLDPC_submit_desc desc;
+        struct nrLDPC_service *svc;
+        doca_error_t result;
+        uint32_t i = 0;
+
+        if (submitted != NULL)
+                *submitted = 0;
+        if (nrLDPC_session_get() == NULL) {
+                result = DOCA_ERROR_INITIALIZATION;
+                goto fail;
+        }
+        svc = &session.services[type];
+
+        /* The lock is only needed to connect the service on first use */
+        if (svc->connected == false) {
+                result = nrLDPC_service_lock(type, &svc);
+                if (result != DOCA_SUCCESS)
+                        goto fail;
+                pthread_mutex_unlock(&svc->lock);
+        }
+
+        /* The transport block failed already, its other code blocks are not worth sending */
+        if (nrLDPC_session_aborted(session_sched_attr.abort) == true) {
+                result = NRLDPC_PROTO_ERROR_CANCELLED;
+                goto fail;
+        }
+
+        session_progress_start();
+        if (atomic_load_explicit(&session.progress_running, memory_order_acquire) == false)
+                return session_submit_locked(svc, count, reqs, req_lens, cb, user_data, try_only, submitted);
+
+        /* The requests of a submission share the tags of the thread and arrive together */
+        session_sched_tag(type, &desc);
+        desc.staged_ns = session.cfg.coalesce_us != 0 ? session_now_ns() : 0;
+        for (i = 0; i < count; i++) {
+                /* Out of credits, the request would sit in the ring until a response comes back */
+                if (try_only == true && service_credits_taken(svc) == true) {
+                        result = DOCA_ERROR_AGAIN;
+                        goto would_block;
+                }
+
+                /* All producer slots are staged or in flight, let the progress thread send and free them */
+                while ((result = comch_data_path_stage_msg(&svc->data_path, reqs[i], req_lens[i], &desc.slot)) ==
+                       DOCA_ERROR_AGAIN) {
+                        if (try_only == true)
+                                goto would_block;
+                        session_submit_backoff();
+                }
+                if (result != DOCA_SUCCESS) {
+                        DOCA_LOG_ERR("Failed to stage request to %s with error = %s",
+                                     svc->server_name,
+                                     doca_error_get_name(result));
+                        goto fail;
+                }
+
+                desc.len = req_lens[i];
+                desc.req = (struct nrLDPC_pending_req){
+                        .cb = cb,
+                        .user_data = user_data,
+                        .tag = i,
+                        .abort = session_sched_attr.abort,
+                };
+                atomic_fetch_add(&svc->queued, 1);
+                while ((result = submit_ring_enqueue(&svc->submits, &desc)) == DOCA_ERROR_AGAIN) {
+                        if (try_only == true) {
+                                atomic_fetch_sub(&svc->queued, 1);
+                                comch_data_path_unstage(&svc->data_path, desc.slot);
+                                goto would_block;
+                        }
+                        session_submit_backoff();
+                }
+                if (submitted != NULL)
+                        *submitted = i + 1;
+        }
+
+        if (atomic_load(&session.progress_sleeping) == true)
+                session_progress_wake();
+        return DOCA_SUCCESS;
+
+would_block:
+        if (i != 0 && atomic_load(&session.progress_sleeping) == true)
+                session_progress_wake();
+        return result;
+
+fail:
+        if (i != 0 && atomic_load(&session.progress_sleeping) == true)
+                session_progress_wake();
+        for (; i < count; i++)
+                cb(user_data, i, NULL, 0, result);
+        return result;
+}
+
+doca_error_t nrLDPC_session_submit(enum nrLDPC_service_type type,
+                                   uint32_t count,
+                                   const void *const *reqs,
+                                   const uint32_t *req_lens,
+                                   nrLDPC_session_done_cb cb,
+                                   void *user_data)
+{
+        return session_submit(type, count, reqs, req_lens, cb, user_data, false, NULL);
+}
+
+doca_error_t nrLDPC_session_try_submit(enum nrLDPC_service_type type,
+                                       uint32_t count,
+                                       const void *const *reqs,
+                                       const uint32_t *req_lens,
+                                       nrLDPC_session_done_cb cb,
+                                       void *user_data,
+                                       uint32_t *submitted)
+{
+        return session_submit(type, count, reqs, req_lens, cb, user_data, true, submitted);
+}
+
+uint32_t nrLDPC_session_poll(enum nrLDPC_service_type type)
+{
+        struct nrLDPC_service *svc = &session.services[type];
+        uint32_t done = 0;
+
+        if (pthread_mutex_trylock(&svc->lock) != 0)
+                return 0;
+
+        if (svc->connected == true) {
+                done += service_send_submits(svc, false);
+                while (service_complete_one(svc, false) == DOCA_SUCCESS)
+                        done++;
+                /* A server without cancel still gets none of the queued requests of an aborted transport block */
+                if (svc->cancellable != 0 &&
+                    (atomic_load_explicit(&svc->features, memory_order_relaxed) & NRLDPC_PROTO_FEATURE_CANCEL) != 0)
+                        done += service_cancel_aborted(svc);
+        }
+
+        pthread_mutex_unlock(&svc->lock);
+        return done;
+}
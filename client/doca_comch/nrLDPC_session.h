@@ -0,0 +1,563 @@
+/*
+ * Filename: nrLDPC_session.h
+ *
+ * LDPC offloading session: the DOCA Comch objects shared by every nrLDPC_encod / nrLDPC_decod call.
+ * The device, the clients, their connections and the data path producers/consumers are created once by
+ * nrLDPC_initcall (LDPCinit) and torn down by nrLDPC_shutdown (LDPCshutdown).
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_SESSION_H_
+#define NRLDPC_SESSION_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include <doca_comch.h>
+#include <doca_dev.h>
+#include <doca_error.h>
+#include <doca_pe.h>
+
+#include "nrLDPC_common.h"
+#include "nrLDPC_proto.h"
+#include "nrLDPC_standin.h"
+
+#define NRLDPC_DEFAULT_PCI_ADDR "03:00.0"                       /* PCIe address, the representor address is "b1:00.0" */
+#define NRLDPC_ENCOD_SERVER_NAME "nrLDPC_encod_server"          /* DOCA Comch server name of the encoder service */
+#define NRLDPC_DECOD_SERVER_NAME "nrLDPC_decod_server"          /* DOCA Comch server name of the decoder service */
+
+/*
+ * Environment variables read by nrLDPC_session_cfg_from_env(), OAI gives no way to pass arguments to LDPCinit
+ */
+#define NRLDPC_ENV_PCI_ADDR "NRLDPC_PCI_ADDR"                     /* Comm Channel DOCA device PCI address */
+#define NRLDPC_ENV_SERVICES "NRLDPC_SERVICES"                     /* Services connected by LDPCinit, "encod,decod" */
+#define NRLDPC_ENV_LOOPBACK "NRLDPC_LOOPBACK"                     /* 1: in-process stand-in, -Dloopback=true builds */
+#define NRLDPC_ENV_LOOPBACK_SERVICE_NS "NRLDPC_LOOPBACK_SERVICE_NS" /* Stand-in processing time per request */
+#define NRLDPC_ENV_LOOPBACK_CONNECT_NS "NRLDPC_LOOPBACK_CONNECT_NS" /* Stand-in connection establishment time */
+#define NRLDPC_ENV_LOOPBACK_RTT_NS "NRLDPC_LOOPBACK_RTT_NS"       /* Stand-in PCIe round trip per request */
+#define NRLDPC_ENV_LOOPBACK_QUEUED "NRLDPC_LOOPBACK_QUEUED"       /* 1: stand-in serves on a timeline of its own */
+#define NRLDPC_ENV_LOOPBACK_HICCUP_EVERY "NRLDPC_LOOPBACK_HICCUP_EVERY" /* Stand-in stalls on 1 request in N */
+#define NRLDPC_ENV_LOOPBACK_HICCUP_NS "NRLDPC_LOOPBACK_HICCUP_NS" /* Stand-in stall duration */
+#define NRLDPC_ENV_LOOPBACK_FEATURES "NRLDPC_LOOPBACK_FEATURES" /* NRLDPC_PROTO_FEATURE_* the stand-in announces */
+#define NRLDPC_ENV_LOOPBACK_VERSION "NRLDPC_LOOPBACK_VERSION"   /* Protocol version the stand-in announces, 0 none */
+#define NRLDPC_ENV_SLAB_SLOTS "NRLDPC_SLAB_SLOTS"                 /* Registered slots of each producer/consumer slab */
+#define NRLDPC_ENV_SLOT_CLASSES "NRLDPC_SLOT_CLASSES"             /* 0: producer slots all of the largest message */
+#define NRLDPC_ENV_RECV_DEPTH "NRLDPC_RECV_DEPTH"                 /* Receives kept posted, bounds outstanding requests */
+#define NRLDPC_ENV_QUEUE_DEPTH "NRLDPC_QUEUE_DEPTH"               /* Outstanding requests: slots, receives, ring */
+#define NRLDPC_ENV_CREDITS "NRLDPC_CREDITS"                       /* Server receives, when the server does not say */
+#define NRLDPC_ENV_SCHED "NRLDPC_SCHED"                           /* Order queued requests are sent in: edf or fifo */
+#define NRLDPC_ENV_ENCOD_BUDGET_US "NRLDPC_ENCOD_BUDGET_US"       /* Encoder deadline, from the slot start */
+#define NRLDPC_ENV_DECOD_BUDGET_US "NRLDPC_DECOD_BUDGET_US"       /* Decoder deadline, from the slot start */
+#define NRLDPC_ENV_ENCOD_INPUT "NRLDPC_ENCOD_INPUT"               /* Encoder input layout: "packed" (OAI) or "bytes" */
+#define NRLDPC_ENV_ENCOD_MSG_SEGS "NRLDPC_ENCOD_MSG_SEGS"         /* Largest segments an encoder message can carry */
+#define NRLDPC_ENV_PROGRESS_POLL "NRLDPC_PROGRESS_POLL"           /* Waiting on the data path: sleep, busy or event */
+#define NRLDPC_ENV_PROGRESS_CPU "NRLDPC_PROGRESS_CPU"             /* Core the progress thread is pinned to */
+#define NRLDPC_ENV_PROGRESS_SPIN_RATE "NRLDPC_PROGRESS_SPIN_RATE" /* Event mode: requests/s above which it spins */
+#define NRLDPC_ENV_THREAD_CHANNELS "NRLDPC_THREAD_CHANNELS"       /* Producer/consumer pairs owned by calling threads */
+#define NRLDPC_ENV_SUBMIT_RING "NRLDPC_SUBMIT_RING"               /* Entries of the submission ring of each service */
+#define NRLDPC_ENV_BLOCKING_PATH "NRLDPC_BLOCKING_PATH"           /* Blocking calls: "lock" or "ring" */
+#define NRLDPC_ENV_COALESCE_US "NRLDPC_COALESCE_US"               /* Longest wait for requests to coalesce, 0 off */
+#define NRLDPC_ENV_COALESCE_BYTES "NRLDPC_COALESCE_BYTES"         /* Payload bytes a coalesced message is sent at */
+#define NRLDPC_ENV_COALESCE_ADAPT "NRLDPC_COALESCE_ADAPT"         /* 1: wait as long as the arrival rate makes it pay */
+#define NRLDPC_ENV_CANCEL "NRLDPC_CANCEL"                         /* 1: cancel in-flight requests of aborted blocks */
+#define NRLDPC_ENV_HOST "NRLDPC_HOST"                             /* Host CPU LDPC: off, fallback, always or auto */
+#define NRLDPC_ENV_HOST_CPU_PCT "NRLDPC_HOST_CPU_PCT"             /* auto: host CPU budget, percent of one core */
+#define NRLDPC_ENV_DISPATCH_EXPLORE "NRLDPC_DISPATCH_EXPLORE"     /* auto: 1 call in N measures the slower path */
+#define NRLDPC_ENV_HEDGE_PCT "NRLDPC_HEDGE_PCT"                   /* Blocking decodes: DPU share of the time left */
+#define NRLDPC_ENV_HARQ_BUFFERS "NRLDPC_HARQ_BUFFERS"             /* HARQ soft buffers kept resident */
+
+#define NRLDPC_PROGRESS_SPIN_RATE 50000         /* Default NRLDPC_PROGRESS_SPIN_RATE */
+#define NRLDPC_PROGRESS_RATE_WINDOW_NS 1000000  /* Request rate measurement window of the event mode */
+#define NRLDPC_MAX_THREAD_CHANNELS 64           /* Upper bound of NRLDPC_THREAD_CHANNELS */
+#define NRLDPC_SUBMIT_RING_SIZE 256             /* Default NRLDPC_SUBMIT_RING, rounded up to a power of 2 */
+#define NRLDPC_SUBMIT_BATCH 16                  /* Requests dequeued from the submission ring at once */
+#define NRLDPC_ENCOD_BUDGET_US 4000             /* Default NRLDPC_ENCOD_BUDGET_US, the downlink runs slots ahead */
+#define NRLDPC_DECOD_BUDGET_US 2000             /* Default NRLDPC_DECOD_BUDGET_US, the HARQ feedback budget */
+#define NRLDPC_COALESCE_BYTES 4096              /* Default NRLDPC_COALESCE_BYTES */
+#define NRLDPC_COALESCE_MAX_REQS 32             /* Requests of one coalesced message */
+#define NRLDPC_COALESCE_EWMA_SHIFT 3            /* Weight 1/8 of the last arrival gap in its moving average */
+#define NRLDPC_COALESCE_GAP_WINDOWS 4           /* Arrival gaps are counted up to this many windows */
+#define NRLDPC_CANCEL_MAX_REQS 64               /* Requests listed by one cancel message */
+
+/* How the session progress thread waits for work */
+enum nrLDPC_progress_mode {
+        NRLDPC_PROGRESS_SLEEP, /* Poll, sleep SLEEP_IN_NANOS when idle */
+        NRLDPC_PROGRESS_BUSY,  /* Poll without ever sleeping */
+        NRLDPC_PROGRESS_EVENT, /* Block in epoll on the PE notification handles, spin above progress_spin_rate */
+};
+
+/* When the host CPU runs the LDPC functions instead of the DPU */
+enum nrLDPC_host_mode {
+        NRLDPC_HOST_FALLBACK, /* When the DPU service cannot be reached or the request fails */
+        NRLDPC_HOST_OFF,      /* Never, the call fails with the DPU */
+        NRLDPC_HOST_ALWAYS,   /* Always, the DPU is not used */
+        NRLDPC_HOST_AUTO,     /* When it is expected to finish sooner, see nrLDPC_dispatch.h, and as a fallback */
+};
+
+/* Order the requests waiting for the progress thread are sent in */
+enum nrLDPC_sched_mode {
+        NRLDPC_SCHED_EDF,  /* By traffic class, then earliest deadline first */
+        NRLDPC_SCHED_FIFO, /* Submission order */
+};
+
+/* Traffic class of a request, the lower classes go first */
+enum nrLDPC_traffic_class {
+        NRLDPC_CLASS_DEFAULT,     /* Class of the service: uplink for the decoder, bulk for the encoder */
+        NRLDPC_CLASS_RETX,        /* HARQ retransmission, sent first */
+        NRLDPC_CLASS_LOW_LATENCY, /* Latency critical traffic, as urgent as retransmissions */
+        NRLDPC_CLASS_UPLINK,      /* Uplink decode of a first transmission */
+        NRLDPC_CLASS_BULK,        /* Downlink encode, sent when nothing more urgent waits */
+        NRLDPC_CLASS_NUM,
+};
+
+struct nrLDPC_session_cfg {
+        char dev_pci_addr[DOCA_DEVINFO_PCI_ADDR_SIZE]; /* Comm Channel DOCA device PCI address */
+        bool connect_at_init[NRLDPC_SERVICE_NUM];     /* Services connected by nrLDPC_session_init, others on first use */
+        bool loopback;                                /* Serve requests with the in-process stand-in server */
+        uint32_t loopback_service_ns;                 /* Stand-in processing time per request */
+        uint32_t loopback_connect_ns;                 /* Stand-in connection establishment time */
+        uint32_t loopback_rtt_ns;                     /* Stand-in PCIe round trip per request */
+        bool loopback_queued;                         /* Stand-in serves on a timeline of its own, not on the caller */
+        uint32_t loopback_hiccup_every;               /* Stand-in stalls on 1 request in N, 0 never */
+        uint32_t loopback_hiccup_ns;                  /* Stand-in stall duration */
+        uint32_t loopback_features;                   /* NRLDPC_PROTO_FEATURE_* the stand-in announces */
+        uint32_t loopback_version;                    /* Protocol version the stand-in announces, 0 for none */
+        uint32_t slab_slots;                          /* Registered slots of each producer/consumer slab */
+        bool slot_classes;                            /* Producer slots in size classes, else all of the largest */
+        uint32_t recv_depth;                          /* Receives kept posted, bounds outstanding requests */
+        uint32_t queue_depth;                         /* Outstanding requests, overrides slab_slots and recv_depth */
+        uint32_t credits;                             /* Server receives, 0 for what the server announces */
+        bool encod_input_packed;                      /* Encoder input is packed (OAI), else one bit per byte */
+        uint32_t encod_msg_segs;                      /* BG1 Zc = 384 segments an encoder message can carry */
+        enum nrLDPC_progress_mode progress_mode;      /* How the progress thread waits for work */
+        int32_t progress_cpu;                         /* Core the progress thread is pinned to, -1 for none */
+        uint32_t progress_spin_rate;                  /* Event mode: requests/s above which it spins, 0 never */
+        uint32_t thread_channels;                     /* Channels of each service handed out to threads, 0 for none */
+        uint32_t submit_ring_size;                    /* Entries of the submission ring, a power of 2 */
+        bool blocking_ring;                           /* Blocking calls go through the ring and the progress thread */
+        enum nrLDPC_sched_mode sched_mode;            /* Order the queued requests are sent in */
+        uint32_t budget_us[NRLDPC_SERVICE_NUM];       /* Deadline of a request of each service, from the slot start */
+        uint32_t coalesce_us;                         /* Longest wait for requests to coalesce with, 0 for none */
+        uint32_t coalesce_bytes;                      /* Payload bytes a coalesced message is sent at without waiting */
+        bool coalesce_adapt;                          /* Wait only as long as the arrival rate can fill the message */
+        bool cancel;                                  /* Cancel the in-flight requests of an aborted transport block */
+        enum nrLDPC_host_mode host_mode;              /* When the host CPU runs the LDPC functions */
+        uint32_t host_cpu_pct;                        /* auto: host CPU budget, percent of one core */
+        uint32_t dispatch_explore;                    /* auto: 1 call in N measures the slower path, 0 never */
+        uint32_t hedge_pct;                           /* Blocking decodes: % of the time left the DPU gets, 0 off */
+        uint32_t harq_buffers;                        /* HARQ soft buffers of the stand-in and of the host */
+};
+
+/* Control path objects of one DOCA Comch client */
+struct comch_data_path_client_objects {
+        struct doca_dev *hw_dev;                   /* Device used by the client, owned by the session */
+        struct doca_pe *pe;                        /* PE of the client, shared by its producer and consumer */
+        struct doca_comch_client *client;          /* Client object */
+        struct doca_comch_connection *connection;  /* CC connection object */
+        doca_error_t client_result;                /* Holds result will be updated in client callbacks */
+        bool client_finish;                        /* Controls whether client progress loop should be run */
+        bool data_path_test_started;               /* Indicate whether we can start data_path test */
+        bool data_path_test_stopped;               /* Indicate whether we can stop data_path test */
+        uint32_t server_credits;                   /* Receives the server announced, 0 if it did not */
+        uint32_t server_version;                   /* Protocol version the server announced, 0 if it did not */
+        uint32_t server_features;                  /* NRLDPC_PROTO_FEATURE_* the server announced */
+        struct comch_data_path_objects *data_path; /* Data path objects */
+};
+
+/**
+ * Completion of an asynchronous request, called once per request with its response, or with resp NULL and the
+ * error that prevented it. It runs with the service locked and must not call the session API of that service.
+ *
+ * @user_data [in]: Argument given to nrLDPC_session_submit()
+ * @tag [in]: Index of the request in its nrLDPC_session_submit() batch
+ * @resp [in]: Response message, valid during the call only
+ * @resp_len [in]: Response message length
+ * @status [in]: DOCA_SUCCESS when resp holds the response and DOCA_ERROR otherwise
+ */
+typedef void (*nrLDPC_session_done_cb)(void *user_data,
+                                       uint32_t tag,
+                                       const void *resp,
+                                       uint32_t resp_len,
+                                       doca_error_t status);
+
+/* Asynchronous request waiting for its response */
+struct nrLDPC_pending_req {
+        nrLDPC_session_done_cb cb; /* Completion callback */
+        void *user_data;           /* Callback argument */
+        uint32_t tag;              /* Index of the request in its submission */
+        uint32_t req_id;           /* Request id, set when sent to a cancellable request */
+        decode_abort_t *abort;     /* Abort flag of the transport block, NULL when not cancellable */
+        bool cancelled;            /* A cancel listing the request was sent */
+};
+
+/* Asynchronous requests of a service, in request order, the order the responses come back */
+struct nrLDPC_pending_fifo {
+        struct nrLDPC_pending_req *reqs; /* recv_depth entries */
+        uint32_t size;                   /* Capacity */
+        uint32_t head;                   /* Oldest request */
+        uint32_t count;                  /* Number of requests */
+};
+
+/* Request staged by an OAI thread, waiting for the progress thread to send it */
+struct nrLDPC_submit_desc {
+        uint32_t slot;                 /* Producer slot holding the staged request */
+        uint32_t len;                  /* Request message length */
+        struct nrLDPC_pending_req req; /* Completion of the request */
+        uint64_t deadline_ns;          /* CLOCK_MONOTONIC deadline, 0 in FIFO mode */
+        uint32_t rank;                 /* Rank of the traffic class, 0 first, 0 in FIFO mode */
+        uint32_t seq;                  /* Dequeue order, breaks the ties */
+        uint64_t staged_ns;            /* CLOCK_MONOTONIC staging time, 0 when coalescing is off */
+};
+
+/* Staged requests dequeued from the submission ring, the next one to send on top */
+struct nrLDPC_submit_heap {
+        struct nrLDPC_submit_desc *descs; /* Binary min-heap by rank, deadline and seq */
+        uint32_t size;                    /* Capacity, the producer slots that can hold staged requests */
+        uint32_t count;                   /* Number of requests */
+        uint32_t next_seq;                /* seq of the next request dequeued */
+};
+
+/* Request of a coalesced message, answered with its own slice of the response */
+struct nrLDPC_coalesce_member {
+        struct nrLDPC_pending_req req; /* Completion of the request */
+        uint32_t req_id;               /* Request id of the request, echoed in its response */
+        uint16_t num_segs;             /* Encoder: segments of the request */
+};
+
+/* Coalesced message: requests of concurrent callers sent as one multi-block message */
+struct nrLDPC_coalesce_group {
+        struct nrLDPC_service *svc;                                      /* Service the message went to */
+        struct nrLDPC_proto_hdr hdr;                                     /* Header of the coalesced message */
+        uint32_t count;                                                  /* Number of requests */
+        struct nrLDPC_coalesce_member members[NRLDPC_COALESCE_MAX_REQS]; /* Requests, in payload order */
+};
+
+/*
+ * Coalescing stage of a service, owned by the thread holding the service lock. Small requests of the same
+ * shape are held for up to coalesce_us, or until coalesce_bytes of them wait, and sent as one message.
+ */
+struct nrLDPC_coalescer {
+        struct nrLDPC_coalesce_group *groups; /* One per producer slot, a coalesced message holds one */
+        uint32_t *free_groups;                /* Stack of the free groups */
+        uint32_t num_free;                    /* Number of free groups */
+        uint8_t *resp_buf;                    /* Response of one request, handed to its completion callback */
+        uint64_t window_ns;                   /* Longest wait, coalesce_us */
+        uint64_t gap_ewma_ns;                 /* Moving average of the time between two requests */
+        uint64_t last_staged_ns;              /* Staging time of the last request dequeued */
+        uint64_t hold_until_ns;               /* Time the held request is sent at, 0 when none is held */
+        uint64_t msgs;                        /* Coalesced messages sent */
+        uint64_t reqs;                        /* Requests they carried */
+};
+
+/* Entry of the submission ring */
+struct nrLDPC_submit_cell {
+        _Atomic(uint64_t) seq;          /* Position the cell can be enqueued at, that position + 1 once filled */
+        struct nrLDPC_submit_desc desc; /* Request */
+};
+
+/*
+ * Bounded lock-free ring of staged requests: any number of OAI threads enqueue, the thread holding the service
+ * lock dequeues, in batches. The sequence number of each cell tells whose turn it is, so an enqueue is one
+ * compare-and-swap on tail and a dequeue touches no shared index. tail and head sit on cache lines of their own.
+ */
+struct nrLDPC_submit_ring {
+        struct nrLDPC_submit_cell *cells;                        /* size cells */
+        uint32_t mask;                                           /* size - 1, size is a power of 2 */
+        _Alignas(CC_DATA_PATH_SLOT_ALIGN) _Atomic(uint64_t) tail; /* Next position to enqueue at */
+        _Alignas(CC_DATA_PATH_SLOT_ALIGN) uint64_t head;         /* Next position to dequeue, owned by the consumer */
+};
+
+/*
+ * Data path owned by one calling thread: a producer/consumer pair and a PE of its own on the connection of the
+ * service. The blocking requests of the thread go through it without taking the service lock.
+ */
+struct nrLDPC_channel {
+        struct comch_data_path_objects data_path; /* Producer/consumer of the channel, used by its owner only */
+        _Atomic(bool) claimed;                    /* A thread owns the channel */
+        bool started;                             /* data_path is started, set by the first owner */
+};
+
+/* One DPU service (encoder or decoder) of the session */
+struct nrLDPC_service {
+        const char *server_name;                          /* DOCA Comch server name */
+        struct comch_data_path_client_objects client_objs; /* Control path: client, its PE and connection */
+        struct comch_data_path_objects data_path;          /* Data path: producer/consumer kept for the session */
+        struct nrLDPC_standin standin;                     /* Stand-in server used in loopback mode */
+        pthread_mutex_t lock;                              /* Serialises the requests on the data path */
+        _Atomic(bool) connected;                           /* Control and data path are established */
+        _Atomic(uint32_t) features;                        /* NRLDPC_PROTO_FEATURE_* of the server, once connected */
+        bool refused;                                      /* The server speaks another protocol, never reconnected */
+        struct nrLDPC_pending_fifo pending;                /* Asynchronous requests waiting for their response */
+        uint8_t *resp_buf;                                 /* Response handed to the completion callbacks */
+        struct nrLDPC_submit_ring submits;                 /* Requests handed to the progress thread */
+        struct nrLDPC_submit_heap sched;                   /* Dequeued requests waiting to be sent, most urgent first */
+        struct nrLDPC_coalescer coalesce;                  /* Merges small requests, when coalesce_us is not 0 */
+        _Atomic(uint32_t) queued;                          /* Requests in submits or sched, not sent yet */
+        doca_notification_handle_t notify_handle;          /* Event mode: readable when a response completes */
+        bool notify_added;                                 /* Event mode: notify_handle is in the epoll set */
+        struct nrLDPC_channel *channels;                   /* Channels handed out to the calling threads */
+        uint32_t num_channels;                             /* Number of channels */
+        _Atomic(uint32_t) credits;                         /* Server receives left, shared by data path and channels */
+        uint32_t credit_limit;                             /* Server receives granted on connection */
+        uint32_t cancellable;                              /* Pending requests with an abort flag, not cancelled yet */
+        uint64_t dropped;                                  /* Queued requests dropped, their transport block aborted */
+        uint64_t cancelled;                                /* In-flight requests listed in cancel messages */
+        uint64_t skipped;                                  /* Of those, skipped by the server */
+};
+
+struct nrLDPC_session {
+        struct nrLDPC_session_cfg cfg;                    /* Session configuration */
+        struct doca_dev *hw_dev;                          /* Device shared by all services */
+        struct nrLDPC_service services[NRLDPC_SERVICE_NUM]; /* Encoder and decoder services */
+        pthread_t progress_thread;                        /* Sends and completes the asynchronous requests */
+        _Atomic(bool) progress_running;                   /* progress_thread is started and must keep running */
+        _Atomic(bool) progress_sleeping;                  /* Event mode: progress_thread may be blocked in epoll */
+        int progress_epfd;                                /* Event mode: epoll set of the notification handles */
+        int progress_wakefd;                              /* Event mode: eventfd signalled on new submissions */
+        int progress_timerfd;                             /* Event mode: stand-in responses round trip timer */
+        uint32_t generation;                              /* Tells the channels of this session from older ones */
+};
+
+/**
+ * Fill a session configuration with the defaults overridden by the NRLDPC_* environment variables
+ *
+ * @cfg [out]: Session configuration
+ */
+void nrLDPC_session_cfg_from_env(struct nrLDPC_session_cfg *cfg);
+
+/**
+ * Create the process-wide session: open the device and connect the services selected in cfg
+ *
+ * @cfg [in]: Session configuration
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_session_init(const struct nrLDPC_session_cfg *cfg);
+
+/**
+ * Disconnect all services and release the session resources
+ */
+void nrLDPC_session_destroy(void);
+
+/**
+ * Get the process-wide session, creating it from the environment when LDPCinit was not called
+ *
+ * @return: The session on success and NULL otherwise
+ */
+struct nrLDPC_session *nrLDPC_session_get(void);
+
+/**
+ * Tag the requests the calling thread submits from now on with a deadline and a traffic class. In EDF mode
+ * (NRLDPC_SCHED=edf) the requests waiting for the progress thread are sent by class, retransmissions and
+ * low-latency traffic first and bulk last, and earliest deadline first within a class; in FIFO mode in the order
+ * they were submitted. Requests are only reordered while they wait: once sent they complete in order.
+ *
+ * @deadline_ns [in]: Absolute CLOCK_MONOTONIC deadline, 0 for the submission time plus the budget of the service
+ * @cls [in]: Traffic class, NRLDPC_CLASS_DEFAULT for the class of the service
+ */
+void nrLDPC_session_set_deadline(uint64_t deadline_ns, enum nrLDPC_traffic_class cls);
+
+/**
+ * Deadline of the requests of a slot, to give to nrLDPC_session_set_deadline()
+ *
+ * @type [in]: Service the requests go to
+ * @slot_start_ns [in]: CLOCK_MONOTONIC time the slot started at
+ * @return: slot_start_ns plus the budget of the service
+ */
+uint64_t nrLDPC_session_slot_deadline(enum nrLDPC_service_type type, uint64_t slot_start_ns);
+
+/**
+ * Deadline of a request the calling thread submits now
+ *
+ * @type [in]: Service the request goes to
+ * @return: The deadline set by nrLDPC_session_set_deadline(), or the current time plus the budget of the service
+ */
+uint64_t nrLDPC_session_deadline(enum nrLDPC_service_type type);
+
+/**
+ * Tag the requests the calling thread submits from now on with the abort flag of their transport block. Once
+ * the flag is set (OAI sets it when a code block of the transport block fails), the requests still waiting for
+ * the progress thread are dropped and, with NRLDPC_CANCEL, the ones already sent are listed in a cancel message
+ * so that the server skips those it has not started. Either way their cb gets NRLDPC_PROTO_ERROR_CANCELLED.
+ *
+ * @ab [in]: Abort flag of the transport block, NULL for none
+ */
+void nrLDPC_session_set_abort(decode_abort_t *ab);
+
+/**
+ * Read the abort flag of a transport block
+ *
+ * @ab [in]: Abort flag, may be NULL
+ * @return: true when the transport block is aborted
+ */
+bool nrLDPC_session_aborted(decode_abort_t *ab);
+
+/**
+ * Abort a transport block, as OAI does once one of its code blocks fails its CRC
+ *
+ * @ab [in]: Abort flag, may be NULL
+ */
+void nrLDPC_session_abort(decode_abort_t *ab);
+
+/**
+ * Send one request to a DPU service without waiting for its response. Up to recv_depth requests can be
+ * outstanding, as long as the server has credits left, their responses are read in the same order with
+ * nrLDPC_session_recv().
+ *
+ * @type [in]: Service to use
+ * @req [in]: Request message
+ * @req_len [in]: Request message length
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_AGAIN when recv_depth requests are outstanding or the server
+ *          credits are taken, and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_session_send(enum nrLDPC_service_type type, const void *req, uint32_t req_len);
+
+/**
+ * Wait for the response of the oldest outstanding request of a DPU service
+ *
+ * @type [in]: Service to use
+ * @resp [out]: Response message
+ * @resp_size [in]: Size of the resp buffer
+ * @resp_len [out]: Response message length, may be NULL
+ * @return: DOCA_SUCCESS on success, DOCA_ERROR_NOT_FOUND when no request is outstanding and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_session_recv(enum nrLDPC_service_type type, void *resp, uint32_t resp_size, uint32_t *resp_len);
+
+/**
+ * Send one request to a DPU service and wait for its response.
+ * The first NRLDPC_THREAD_CHANNELS threads calling it (or nrLDPC_session_transact_batch) each get a channel of
+ * their own, held until they exit, and never contend with other threads; the others share the service lock.
+ * Must not be mixed with nrLDPC_session_send() requests still outstanding on the same service.
+ *
+ * @type [in]: Service to use
+ * @req [in]: Request message
+ * @req_len [in]: Request message length
+ * @resp [out]: Response message, may alias req
+ * @resp_size [in]: Size of the resp buffer
+ * @resp_len [out]: Response message length, may be NULL
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_session_transact(enum nrLDPC_service_type type,
+                                     const void *req,
+                                     uint32_t req_len,
+                                     void *resp,
+                                     uint32_t resp_size,
+                                     uint32_t *resp_len);
+
+/**
+ * Send a batch of requests to a DPU service and wait for all their responses. The requests are pipelined,
+ * up to recv_depth of them outstanding, and no other request of the service is interleaved with the batch.
+ * Uses the channel of the calling thread like nrLDPC_session_transact().
+ * Must not be mixed with nrLDPC_session_send() requests still outstanding on the same service.
+ *
+ * @type [in]: Service to use
+ * @count [in]: Number of requests
+ * @reqs [in]: Request messages
+ * @req_lens [in]: Request message lengths
+ * @resps [out]: Response messages, in request order
+ * @resp_size [in]: Size of each resps buffer
+ * @resp_lens [out]: Response message lengths
+ * @return: DOCA_SUCCESS on success and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_session_transact_batch(enum nrLDPC_service_type type,
+                                           uint32_t count,
+                                           const void *const *reqs,
+                                           const uint32_t *req_lens,
+                                           void *const *resps,
+                                           uint32_t resp_size,
+                                           uint32_t *resp_lens);
+
+/**
+ * Send a batch of requests to a DPU service and return without waiting for their responses. The requests are
+ * staged in producer slots and handed to the session progress thread, started on the first submission, through
+ * a lock-free queue: the calling thread never takes the service lock. cb is called once per request, when its
+ * response arrives or when it fails, by the progress thread or by any later call on the service that needs the
+ * pipeline. Requests that cannot be staged get their cb called with the error before this function returns.
+ * When the pipeline or the server credits are exhausted the calling thread waits for room, see
+ * nrLDPC_session_try_submit() for a caller that would rather not.
+ *
+ * @type [in]: Service to use
+ * @count [in]: Number of requests
+ * @reqs [in]: Request messages, copied before this function returns
+ * @req_lens [in]: Request message lengths
+ * @cb [in]: Completion callback
+ * @user_data [in]: Callback argument
+ * @return: DOCA_SUCCESS when all requests are handed over and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_session_submit(enum nrLDPC_service_type type,
+                                   uint32_t count,
+                                   const void *const *reqs,
+                                   const uint32_t *req_lens,
+                                   nrLDPC_session_done_cb cb,
+                                   void *user_data);
+
+/*
+ * With NRLDPC_COALESCE_US set, the requests handed over by nrLDPC_session_submit() (and the blocking calls of
+ * NRLDPC_BLOCKING_PATH=ring) that share BG, Z, K and N are gathered by the progress thread: it holds a small
+ * request for up to the window, or until NRLDPC_COALESCE_BYTES of payload wait, and sends them all as one
+ * multi-block message (see nrLDPC_proto.h). Each cb still gets a response of its own, with its request id and
+ * its part of the payload. With NRLDPC_COALESCE_ADAPT the wait follows the arrival rate: no wait when requests
+ * come further apart than the window, and only as long as it takes to fill the message otherwise.
+ */
+
+/**
+ * Like nrLDPC_session_submit() but never waits: it stops at the first request that finds no free producer slot,
+ * no room in the submission ring, or no server credit left for it once the requests already queued are sent.
+ * On DOCA_ERROR_AGAIN the requests not handed over are left to the caller and their cb is not called, on any
+ * other error it is called as by nrLDPC_session_submit().
+ *
+ * @type [in]: Service to use
+ * @count [in]: Number of requests
+ * @reqs [in]: Request messages, copied before this function returns
+ * @req_lens [in]: Request message lengths
+ * @cb [in]: Completion callback
+ * @user_data [in]: Callback argument
+ * @submitted [out]: Number of requests handed over, the first ones of reqs
+ * @return: DOCA_SUCCESS when all requests are handed over, DOCA_ERROR_AGAIN when some would have had to wait
+ *          and DOCA_ERROR otherwise
+ */
+doca_error_t nrLDPC_session_try_submit(enum nrLDPC_service_type type,
+                                       uint32_t count,
+                                       const void *const *reqs,
+                                       const uint32_t *req_lens,
+                                       nrLDPC_session_done_cb cb,
+                                       void *user_data,
+                                       uint32_t *submitted);
+
+/**
+ * Send the asynchronous requests handed over while there is room in the pipeline and complete those whose
+ * response arrived, without waiting. Returns at once when another thread is using the service.
+ *
+ * @type [in]: Service to use
+ * @return: Number of requests sent or completed
+ */
+uint32_t nrLDPC_session_poll(enum nrLDPC_service_type type);
+
+/**
+ * Requests of a service not answered yet: waiting for the progress thread or in flight
+ *
+ * @type [in]: Service
+ * @return: Number of requests, 0 when the service is not connected
+ */
+uint32_t nrLDPC_session_depth(enum nrLDPC_service_type type);
+
+/**
+ * Optional parts of the protocol a service serves, as its server announced them on connection (see nrLDPC_proto.h).
+ * Connects the service on first use, then reads them without locking it, so completions may call it too.
+ *
+ * @type [in]: Service
+ * @return: NRLDPC_PROTO_FEATURE_* of the server, 0 when it cannot be reached or speaks another protocol
+ */
+uint32_t nrLDPC_session_features(enum nrLDPC_service_type type);
+
+/**
+ * Size of the largest message exchanged with a service, i.e. the size of its data path buffers
+ *
+ * @type [in]: Service type
+ * @return: Message size in bytes
+ */
+uint32_t nrLDPC_session_max_msg_size(enum nrLDPC_service_type type);
+
+#endif // NRLDPC_SESSION_H_
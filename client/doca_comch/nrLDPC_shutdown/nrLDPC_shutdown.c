@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+#include "nrLDPC_session.h"
+
 // ALIAS DECLARATION
 // LDPCshutdown declared as an alias for nrLDPC_encod
 extern int32_t LDPCshutdown(void)
@@ -18,14 +20,14 @@ extern int32_t LDPCshutdown(void)
  *
  * This function terminates the new 5G NR LDPC function required by OAI interface in the libldpc_armral.so
  * library as required to be dynamically loaded at run-time by the oai shared library loader.
- * Currentely there is nothing to do (dummy function).
+ * It stops the producers, consumers and clients of the session opened by nrLDPC_initcall, frees their
+ * registered buffers and closes the DOCA device.
  *
  * @return: EXIT_SUCCESS on success and EXIT_FAILURE otherwise
  */
 int32_t nrLDPC_shutdown(void)
 {
-
-        /* Library-specific initialization logic */
+        nrLDPC_session_destroy();
 
         return 0;                            /* Return 0 on success, other values on failure */
 }
@@ -0,0 +1,581 @@
+/*
+ * Filename: nrLDPC_standin.c
+ *
+ * In-process stand-in for the DPU LDPC servers
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "comch_ctrl_path_common.h"
+#include "nrLDPC_bg.h"
+#include "nrLDPC_bits.h"
+#include "nrLDPC_common.h"
+#include "nrLDPC_harq.h"
+#include "nrLDPC_host_decod.h"
+#include "nrLDPC_proto.h"
+#include "nrLDPC_ratematch.h"
+#include "nrLDPC_standin.h"
+
+/**
+ * Monotonic clock in nanoseconds
+ *
+ * @return: CLOCK_MONOTONIC time in nanoseconds
+ */
+static uint64_t standin_now_ns(void)
+{
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/**
+ * Busy wait, the DPU cores serving a request are not available to anything else either
+ *
+ * @ns [in]: Time to wait in nanoseconds
+ */
+static void standin_spin_ns(uint32_t ns)
+{
+        if (ns != 0)
+                nrLDPC_standin_wait(standin_now_ns() + ns);
+}
+
+uint64_t nrLDPC_standin_ready_ns(struct nrLDPC_standin *standin, bool queue, uint32_t service_ns)
+{
+        uint64_t now = standin_now_ns();
+        uint64_t stall_ns = 0;
+        uint64_t busy_until;
+        uint64_t start;
+
+        if (queue == false)
+                return now + standin->rtt_ns;
+        if (standin->hiccup_every != 0 &&
+            (atomic_fetch_add_explicit(&standin->requests, 1, memory_order_relaxed) + 1) % standin->hiccup_every == 0)
+                stall_ns = standin->hiccup_ns;
+        if (standin->queued == false)
+                return now + stall_ns + standin->rtt_ns;
+
+        /* The request waits for those before it, the channels of a service share the stand-in */
+        busy_until = atomic_load_explicit(&standin->busy_until_ns, memory_order_relaxed);
+        do {
+                start = busy_until > now ? busy_until : now;
+        } while (atomic_compare_exchange_weak_explicit(&standin->busy_until_ns,
+                                                       &busy_until,
+                                                       start + stall_ns + service_ns,
+                                                       memory_order_relaxed,
+                                                       memory_order_relaxed) == false);
+        return start + stall_ns + service_ns + standin->rtt_ns;
+}
+
+bool nrLDPC_standin_arrived(uint64_t ready_ns)
+{
+        return standin_now_ns() >= ready_ns;
+}
+
+void nrLDPC_standin_wait(uint64_t ready_ns)
+{
+        while (standin_now_ns() < ready_ns)
+                ;
+}
+
+void nrLDPC_standin_connect(const struct nrLDPC_standin *standin)
+{
+        struct timespec ts = {
+                .tv_sec = standin->connect_ns / 1000000000U,
+                .tv_nsec = standin->connect_ns % 1000000000U,
+        };
+
+        if (standin->connect_ns != 0)
+                nanosleep(&ts, NULL);
+}
+
+/**
+ * Encoder server: for each segment, an N bits codeword starting with the systematic part, i.e. the input bits
+ *
+ * @req [in]: Encoder request header
+ * @input [in]: Input bits of the segments
+ * @resp [out]: Response header
+ * @out [out]: Codewords
+ * @out_size [in]: Size of the out buffer
+ */
+static void standin_encod(const struct nrLDPC_proto_hdr *req,
+                          const uint8_t *input,
+                          struct nrLDPC_proto_hdr *resp,
+                          uint8_t *out,
+                          uint32_t out_size)
+{
+        uint32_t num_segs = req->num_segs != 0 ? req->num_segs : 1;
+        uint32_t seg_in = req->payload_len / num_segs;
+        uint32_t seg_out = req->n != 0 ? (req->n + 7) / 8 : seg_in;
+        uint32_t sys = seg_in < seg_out ? seg_in : seg_out;
+        uint32_t i;
+
+        if (seg_in * num_segs != req->payload_len || (uint64_t)seg_out * num_segs > out_size) {
+                resp->status = -1;
+                return;
+        }
+        for (i = 0; i < num_segs; i++) {
+                memcpy(out + i * seg_out, input + i * seg_in, sys);
+                memset(out + i * seg_out + sys, 0, seg_out - sys);
+        }
+        resp->payload_len = seg_out * num_segs;
+}
+
+/**
+ * Encoder server, rate matched request: each segment encoded and rate matched, its E bits packed. Unlike the
+ * codewords of standin_encod, these are the real ones, the bits OAI scrambles have to be right.
+ *
+ * @req [in]: Encoder request header
+ * @payload [in]: Rate matching of each segment, then their input bits
+ * @resp [out]: Response header
+ * @out [out]: Rate matched bits of each segment
+ * @out_size [in]: Size of the out buffer
+ */
+static void standin_encod_rm(const struct nrLDPC_proto_hdr *req,
+                             const uint8_t *payload,
+                             struct nrLDPC_proto_hdr *resp,
+                             uint8_t *out,
+                             uint32_t out_size)
+{
+        uint8_t bits[NRLDPC_PROTO_ENCOD_MAX_N];
+        uint32_t num_segs = req->num_segs != 0 ? req->num_segs : 1;
+        uint32_t seg_in = nrLDPC_bits_bytes(req->k);
+        const uint8_t *input = payload + num_segs * sizeof(struct nrLDPC_proto_rm);
+        struct nrLDPC_proto_rm rm;
+        uint32_t len = 0;
+        uint32_t i;
+
+        if ((uint64_t)num_segs * (sizeof(rm) + seg_in) != req->payload_len) {
+                resp->status = -1;
+                return;
+        }
+        for (i = 0; i < num_segs; i++) {
+                memcpy(&rm, payload + i * sizeof(rm), sizeof(rm));
+                if (rm.f != req->f || rm.e > NRLDPC_PROTO_ENCOD_MAX_N ||
+                    len + nrLDPC_bits_bytes(rm.e) > out_size ||
+                    nrLDPC_rm_encod(req->bg, req->z, req->k, &rm, input + i * seg_in, true, bits) != DOCA_SUCCESS) {
+                        resp->status = -1;
+                        return;
+                }
+                nrLDPC_bits_pack(bits, rm.e, out + len);
+                len += nrLDPC_bits_bytes(rm.e);
+        }
+        resp->payload_len = len;
+}
+
+/**
+ * Decode one code block. Without a CRC, the hard decision of its first Kprime LLRs, packed MSB first, as if decoded
+ * in one iteration. With one, the block is decoded for real by the host decoder, which stops at the first iteration
+ * the CRC passes as the DPU does: the iterations answered, and the processing time, are the ones of the DPU.
+ *
+ * @req [in]: Decoder request header
+ * @nbytes [in]: Decoded bytes, Kprime / 8
+ * @llrs [in]: LLRs of the block
+ * @num_llrs [in]: Number of LLRs
+ * @out [out]: nbytes decoded bytes
+ * @return: Status of the block: the iterations run, num_its + 1 when the CRC did not pass, and -1 on error
+ */
+static int32_t standin_decod_block(const struct nrLDPC_proto_hdr *req,
+                                   uint32_t nbytes,
+                                   const int8_t *llrs,
+                                   uint32_t num_llrs,
+                                   uint8_t *out)
+{
+        const struct nrLDPC_bg *g = nrLDPC_bg_get(req->bg);
+        t_nrLDPC_dec_params params = {0};
+        uint32_t num_iter;
+        uint32_t i, b;
+        uint8_t byte;
+
+        if (req->crc_idx == NRLDPC_PROTO_CRC_NONE) {
+                for (i = 0; i < nbytes; i++) {
+                        byte = 0;
+                        for (b = 0; b < 8 && i * 8 + b < num_llrs; b++)
+                                byte |= (llrs[i * 8 + b] < 0) << (7 - b);
+                        out[i] = byte;
+                }
+                return 1;
+        }
+
+        if (g == NULL || num_llrs < (uint32_t)g->cols * req->z || nbytes != req->k / 8)
+                return -1;
+        params.BG = req->bg;
+        params.Z = req->z;
+        params.Kprime = (int)req->k;
+        params.numMaxIter = req->num_its;
+        params.outMode = nrLDPC_outMode_BIT;
+        if (nrLDPC_host_decod_crc(&params, llrs, (int8_t *)out, &num_iter, req->crc_idx) != DOCA_SUCCESS)
+                return -1;
+
+        return (int32_t)num_iter;
+}
+
+/**
+ * Decoder server: every code block of the request decoded, see standin_decod_block
+ *
+ * @req [in]: Decoder request header
+ * @llrs [in]: LLRs
+ * @resp [out]: Response header
+ * @out [out]: Decoded bits, then the block statuses for NRLDPC_PROTO_FLAG_BLOCKS
+ * @out_size [in]: Size of the out buffer
+ */
+static void standin_decod(const struct nrLDPC_proto_hdr *req,
+                          const int8_t *llrs,
+                          struct nrLDPC_proto_hdr *resp,
+                          uint8_t *out,
+                          uint32_t out_size)
+{
+        uint32_t nbytes = req->k / 8;
+        int32_t status;
+        uint32_t blocks;
+        uint32_t i;
+
+        if ((req->flags & NRLDPC_PROTO_FLAG_BLOCKS) == 0) {
+                if (nbytes > out_size)
+                        nbytes = out_size;
+                status = standin_decod_block(req, nbytes, llrs, req->payload_len, out);
+                resp->payload_len = status >= 0 ? nbytes : 0;
+                resp->status = status;
+                return;
+        }
+
+        blocks = req->n != 0 ? req->payload_len / req->n : 0;
+        if (blocks == 0 || blocks * req->n != req->payload_len ||
+            (uint64_t)blocks * (nbytes + sizeof(status)) > out_size) {
+                resp->status = -1;
+                return;
+        }
+        for (i = 0; i < blocks; i++) {
+                status = standin_decod_block(req, nbytes, llrs + (size_t)i * req->n, req->n, out + (size_t)i * nbytes);
+                memcpy(out + (size_t)blocks * nbytes + i * sizeof(status), &status, sizeof(status));
+        }
+        resp->payload_len = blocks * (nbytes + sizeof(status));
+        resp->status = 1;
+}
+
+/**
+ * Decoder server, HARQ request: one code block combined with its soft buffer, then decoded
+ *
+ * @standin [in]: Stand-in server
+ * @req [in]: Decoder request header
+ * @payload [in]: Soft buffer of the block, then its LLRs
+ * @resp [out]: Response header
+ * @out [out]: Decoded bits
+ * @out_size [in]: Size of the out buffer
+ */
+static void standin_decod_harq(struct nrLDPC_standin *standin,
+                               const struct nrLDPC_proto_hdr *req,
+                               const uint8_t *payload,
+                               struct nrLDPC_proto_hdr *resp,
+                               uint8_t *out,
+                               uint32_t out_size)
+{
+        int8_t llrs[NRLDPC_HARQ_MAX_LLRS];
+        struct nrLDPC_proto_harq harq;
+        uint32_t nbytes = req->k / 8;
+        bool missed;
+
+        if ((req->flags & (NRLDPC_PROTO_FLAG_BLOCKS | NRLDPC_PROTO_FLAG_RATE_MATCHED)) != 0 ||
+            req->payload_len < sizeof(harq)) {
+                resp->status = -1;
+                return;
+        }
+        memcpy(&harq, payload, sizeof(harq));
+        if (nrLDPC_harq_combine(&standin->harq,
+                                &harq,
+                                req->n,
+                                (const int8_t *)payload + sizeof(harq),
+                                req->payload_len - sizeof(harq),
+                                llrs,
+                                &missed) != DOCA_SUCCESS) {
+                resp->status = -1;
+                return;
+        }
+
+        if (missed == true)
+                resp->flags |= NRLDPC_PROTO_FLAG_HARQ_MISS;
+        if (nbytes > out_size)
+                nbytes = out_size;
+        resp->status = standin_decod_block(req, nbytes, llrs, req->n, out);
+        resp->payload_len = resp->status >= 0 ? nbytes : 0;
+}
+
+/**
+ * Decoder server, rate matched request: the N LLRs of one code block recovered from its E LLRs, then decoded
+ *
+ * @req [in]: Decoder request header
+ * @payload [in]: Rate matching of the block, then its E LLRs
+ * @resp [out]: Response header
+ * @out [out]: Decoded bits
+ * @out_size [in]: Size of the out buffer
+ */
+static void standin_decod_rm(const struct nrLDPC_proto_hdr *req,
+                             const uint8_t *payload,
+                             struct nrLDPC_proto_hdr *resp,
+                             uint8_t *out,
+                             uint32_t out_size)
+{
+        int8_t llrs[NRLDPC_RM_MAX_LLRS];
+        struct nrLDPC_proto_rm rm;
+        uint32_t nbytes = req->k / 8;
+
+        if ((req->flags & (NRLDPC_PROTO_FLAG_BLOCKS | NRLDPC_PROTO_FLAG_HARQ)) != 0 ||
+            req->payload_len < sizeof(rm) || req->n > NRLDPC_RM_MAX_LLRS) {
+                resp->status = -1;
+                return;
+        }
+        memcpy(&rm, payload, sizeof(rm));
+        if (rm.e != req->payload_len - sizeof(rm) ||
+            nrLDPC_rm_recover(req->bg, req->z, &rm, (const int8_t *)payload + sizeof(rm), llrs) != DOCA_SUCCESS) {
+                resp->status = -1;
+                return;
+        }
+
+        if (nbytes > out_size)
+                nbytes = out_size;
+        resp->status = standin_decod_block(req, nbytes, llrs, req->n, out);
+        resp->payload_len = resp->status >= 0 ? nbytes : 0;
+}
+
+/**
+ * Decoder server, HARQ free: the soft buffers of the listed processes
+ *
+ * @standin [in]: Stand-in server
+ * @req [in]: HARQ free request header
+ * @payload [in]: nrLDPC_proto_harq of each process
+ * @resp [out]: Response header, its status is the number of buffers freed
+ */
+static void standin_harq_free(struct nrLDPC_standin *standin,
+                              const struct nrLDPC_proto_hdr *req,
+                              const uint8_t *payload,
+                              struct nrLDPC_proto_hdr *resp)
+{
+        struct nrLDPC_proto_harq harq;
+        uint32_t freed = 0;
+        uint32_t i;
+
+        for (i = 0; i < req->payload_len / sizeof(harq); i++) {
+                memcpy(&harq, payload + i * sizeof(harq), sizeof(harq));
+                freed += nrLDPC_harq_release(&standin->harq, harq.ulsch_id, harq.harq_pid);
+        }
+        resp->status = (int32_t)freed;
+}
+
+/**
+ * Processing time of a request: service_ns, the time of num_its iterations of each block of a decoder request.
+ * A block the CRC stops early takes its share of it, the DPU is free for the next request that much sooner.
+ *
+ * @standin [in]: Stand-in server
+ * @req [in]: Request header
+ * @resp [in]: Response header
+ * @out [in]: Response payload, the block statuses of a NRLDPC_PROTO_FLAG_BLOCKS decoder request
+ * @return: Processing time in nanoseconds
+ */
+static uint32_t standin_service_ns(const struct nrLDPC_standin *standin,
+                                   const struct nrLDPC_proto_hdr *req,
+                                   const struct nrLDPC_proto_hdr *resp,
+                                   const uint8_t *out)
+{
+        uint32_t blocks = 1;
+        uint64_t ran = 0;
+        int32_t status = resp->status;
+        uint32_t i;
+
+        if (req->op != NRLDPC_PROTO_OP_DECOD_REQ || req->crc_idx == NRLDPC_PROTO_CRC_NONE || req->num_its == 0 ||
+            resp->status < 0)
+                return standin->service_ns;
+        if ((req->flags & NRLDPC_PROTO_FLAG_BLOCKS) != 0)
+                blocks = req->payload_len / req->n;
+
+        for (i = 0; i < blocks; i++) {
+                if ((req->flags & NRLDPC_PROTO_FLAG_BLOCKS) != 0)
+                        memcpy(&status, out + (size_t)blocks * (req->k / 8) + i * sizeof(status), sizeof(status));
+                ran += status < 0 || status > req->num_its ? req->num_its : (uint32_t)status;
+        }
+
+        return (uint32_t)((uint64_t)standin->service_ns * ran / ((uint64_t)blocks * req->num_its));
+}
+
+/**
+ * Whether a request only uses the optional parts of the protocol the stand-in serves, as an older server would
+ *
+ * @standin [in]: Stand-in server
+ * @req [in]: Request header
+ * @return: true when every NRLDPC_PROTO_FEATURE_* the request needs is in standin->features
+ */
+static bool standin_serves(const struct nrLDPC_standin *standin, const struct nrLDPC_proto_hdr *req)
+{
+        uint32_t needed = 0;
+
+        if (req->op == NRLDPC_PROTO_OP_DECOD_REQ) {
+                if ((req->flags & NRLDPC_PROTO_FLAG_BLOCKS) != 0)
+                        needed |= NRLDPC_PROTO_FEATURE_BLOCKS;
+                if ((req->flags & NRLDPC_PROTO_FLAG_HARQ) != 0)
+                        needed |= NRLDPC_PROTO_FEATURE_HARQ;
+                if ((req->flags & NRLDPC_PROTO_FLAG_RATE_MATCHED) != 0)
+                        needed |= NRLDPC_PROTO_FEATURE_RM_DECOD;
+                if (req->crc_idx != NRLDPC_PROTO_CRC_NONE)
+                        needed |= NRLDPC_PROTO_FEATURE_CRC;
+        } else if (req->op == NRLDPC_PROTO_OP_ENCOD_REQ && (req->flags & NRLDPC_PROTO_FLAG_RATE_MATCHED) != 0) {
+                needed = NRLDPC_PROTO_FEATURE_RM_ENCOD;
+        } else if (req->op == NRLDPC_PROTO_OP_HARQ_FREE_REQ) {
+                needed = NRLDPC_PROTO_FEATURE_HARQ;
+        } else if (req->op == NRLDPC_PROTO_OP_CANCEL_REQ) {
+                needed = NRLDPC_PROTO_FEATURE_CANCEL;
+        }
+
+        return (needed & ~standin->features) == 0;
+}
+
+void nrLDPC_standin_serve(struct nrLDPC_standin *standin,
+                          const void *req,
+                          uint32_t req_len,
+                          void *resp,
+                          uint32_t resp_size,
+                          uint32_t *resp_len,
+                          uint32_t *service_ns)
+{
+        struct nrLDPC_proto_hdr req_hdr;
+        struct nrLDPC_proto_hdr resp_hdr;
+        const void *payload;
+        uint8_t *out = (uint8_t *)resp + sizeof(resp_hdr);
+        uint32_t out_size = resp_size - sizeof(resp_hdr);
+
+        atomic_fetch_add_explicit(&standin->served, 1, memory_order_relaxed);
+
+        *resp_len = 0;
+        *service_ns = standin->service_ns;
+        if (resp_size < sizeof(resp_hdr) || nrLDPC_proto_unpack(req, req_len, &req_hdr, &payload) != DOCA_SUCCESS) {
+                if (standin->queued == false)
+                        standin_spin_ns(*service_ns);
+                return;
+        }
+
+        resp_hdr = req_hdr;
+        resp_hdr.op = req_hdr.op + 1;
+        resp_hdr.status = 0;
+        resp_hdr.payload_len = 0;
+
+        if (standin_serves(standin, &req_hdr) == false) {
+                atomic_fetch_add_explicit(&standin->refused, 1, memory_order_relaxed);
+                resp_hdr.status = -1;
+        }
+        else if (standin->service == NRLDPC_SERVICE_ENCOD && req_hdr.op == NRLDPC_PROTO_OP_ENCOD_REQ &&
+                 (req_hdr.flags & NRLDPC_PROTO_FLAG_RATE_MATCHED) != 0)
+                standin_encod_rm(&req_hdr, payload, &resp_hdr, out, out_size);
+        else if (standin->service == NRLDPC_SERVICE_ENCOD && req_hdr.op == NRLDPC_PROTO_OP_ENCOD_REQ)
+                standin_encod(&req_hdr, payload, &resp_hdr, out, out_size);
+        else if (standin->service == NRLDPC_SERVICE_DECOD && req_hdr.op == NRLDPC_PROTO_OP_DECOD_REQ &&
+                 (req_hdr.flags & NRLDPC_PROTO_FLAG_HARQ) != 0)
+                standin_decod_harq(standin, &req_hdr, payload, &resp_hdr, out, out_size);
+        else if (standin->service == NRLDPC_SERVICE_DECOD && req_hdr.op == NRLDPC_PROTO_OP_DECOD_REQ &&
+                 (req_hdr.flags & NRLDPC_PROTO_FLAG_RATE_MATCHED) != 0)
+                standin_decod_rm(&req_hdr, payload, &resp_hdr, out, out_size);
+        else if (standin->service == NRLDPC_SERVICE_DECOD && req_hdr.op == NRLDPC_PROTO_OP_DECOD_REQ)
+                standin_decod(&req_hdr, payload, &resp_hdr, out, out_size);
+        else if (standin->service == NRLDPC_SERVICE_DECOD && req_hdr.op == NRLDPC_PROTO_OP_HARQ_FREE_REQ)
+                standin_harq_free(standin, &req_hdr, payload, &resp_hdr);
+        else
+                resp_hdr.status = -1;
+
+        *service_ns = standin_service_ns(standin, &req_hdr, &resp_hdr, out);
+        if (standin->queued == false)
+                standin_spin_ns(*service_ns);
+        *resp_len = nrLDPC_proto_pack(resp, resp_size, &resp_hdr, out, resp_hdr.payload_len);
+}
+
+/**
+ * Whether a cancel lists a request
+ *
+ * @ids [in]: Request ids of the cancel
+ * @num_ids [in]: Number of ids
+ * @req_id [in]: Request id to look up
+ * @return: true when req_id is listed
+ */
+static bool standin_cancel_lists(const uint8_t *ids, uint32_t num_ids, uint32_t req_id)
+{
+        uint32_t id;
+        uint32_t i;
+
+        for (i = 0; i < num_ids; i++) {
+                memcpy(&id, ids + i * sizeof(id), sizeof(id));
+                if (id == req_id)
+                        return true;
+        }
+        return false;
+}
+
+bool nrLDPC_standin_cancel(struct nrLDPC_standin *standin,
+                           const void *req,
+                           uint32_t req_len,
+                           struct comch_recv_fifo *fifo,
+                           const struct local_mem_slab *slab,
+                           void *resp,
+                           uint32_t resp_size,
+                           uint32_t *resp_len)
+{
+        struct nrLDPC_proto_hdr req_hdr;
+        struct nrLDPC_proto_hdr hdr;
+        const void *payload;
+        uint64_t now = standin_now_ns();
+        uint64_t shift_ns = 0;
+        uint64_t ready_ns;
+        uint64_t busy_ns;
+        uint64_t start;
+        uint32_t skipped = 0;
+        uint32_t idx;
+        void *msg;
+        uint32_t i;
+
+        if (req_len < sizeof(req_hdr))
+                return false;
+        memcpy(&req_hdr, req, sizeof(req_hdr));
+        /* Without NRLDPC_PROTO_FEATURE_CANCEL the cancel queues as any request, and fails */
+        if (req_hdr.op != NRLDPC_PROTO_OP_CANCEL_REQ || (standin->features & NRLDPC_PROTO_FEATURE_CANCEL) == 0)
+                return false;
+
+        *resp_len = 0;
+        if (nrLDPC_proto_unpack(req, req_len, &req_hdr, &payload) != DOCA_SUCCESS)
+                return true;
+
+        /*
+         * The responses are in the order the requests were sent, their ready time less their own service time
+         * gives back when the emulated DPU started them; those after a skipped one move up by the time it gave back
+         */
+        for (i = 0; standin->queued && i < fifo->count; i++) {
+                idx = (fifo->head + i) % fifo->size;
+                msg = local_mem_slab_addr(slab, fifo->slots[idx]);
+                memcpy(&hdr, msg, sizeof(hdr));
+                if (hdr.op == NRLDPC_PROTO_OP_CANCEL_RESP || hdr.status == NRLDPC_PROTO_STATUS_CANCELLED)
+                        continue;
+
+                ready_ns = fifo->ready_ns[idx] > shift_ns ? fifo->ready_ns[idx] - shift_ns : 0;
+                busy_ns = (uint64_t)standin->rtt_ns + fifo->service_ns[idx];
+                start = ready_ns > busy_ns ? ready_ns - busy_ns : 0;
+                if (start <= now || !standin_cancel_lists(payload, req_hdr.payload_len / sizeof(uint32_t),
+                                                          hdr.req_id)) {
+                        fifo->ready_ns[idx] = ready_ns;
+                        continue;
+                }
+
+                hdr.status = NRLDPC_PROTO_STATUS_CANCELLED;
+                fifo->lens[idx] = nrLDPC_proto_pack(msg, sizeof(hdr), &hdr, NULL, 0);
+                fifo->ready_ns[idx] = start + standin->rtt_ns;
+                shift_ns += fifo->service_ns[idx];
+                fifo->service_ns[idx] = 0;
+                skipped++;
+        }
+        /* Later requests of any channel of the service start earlier too */
+        atomic_fetch_sub_explicit(&standin->busy_until_ns, shift_ns, memory_order_relaxed);
+        atomic_fetch_add_explicit(&standin->skipped, skipped, memory_order_relaxed);
+
+        hdr = req_hdr;
+        hdr.op = NRLDPC_PROTO_OP_CANCEL_RESP;
+        hdr.status = (int32_t)skipped;
+        *resp_len = nrLDPC_proto_pack(resp, resp_size, &hdr, NULL, 0);
+        return true;
+}
@@ -0,0 +1,128 @@
+/*
+ * Filename: nrLDPC_standin.h
+ *
+ * In-process stand-in for the DPU LDPC servers. It answers data path messages with the same layout as
+ * nrLDPC_encod_server / nrLDPC_decod_server so the client side can be exercised and benchmarked on a
+ * host without a BlueField device.
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#ifndef NRLDPC_STANDIN_H_
+#define NRLDPC_STANDIN_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nrLDPC_harq.h"
+
+struct comch_recv_fifo;
+struct local_mem_slab;
+
+struct nrLDPC_standin {
+        uint8_t service;                 /* enum nrLDPC_service_type answered by this stand-in */
+        uint32_t service_ns;             /* Emulated DPU processing time per request */
+        uint32_t connect_ns;             /* Emulated client/server connection establishment time */
+        uint32_t rtt_ns;                 /* Emulated PCIe round trip, overlaps between outstanding requests */
+        bool queued;                     /* Serve requests one after the other on a timeline of its own */
+        uint32_t hiccup_every;           /* Stall on 1 request in hiccup_every, 0 never */
+        uint32_t hiccup_ns;              /* Stall duration, the requests queued after it wait too */
+        uint32_t features;               /* NRLDPC_PROTO_FEATURE_* served, requests using others fail */
+        _Atomic(uint64_t) requests;      /* Requests timed, paces the stalls */
+        _Atomic(uint64_t) busy_until_ns; /* Queued mode: time the emulated DPU is done with its requests */
+        _Atomic(uint64_t) served;        /* Requests answered, cancels excluded */
+        _Atomic(uint64_t) skipped;       /* Of those, skipped by a cancel before the emulated DPU started them */
+        _Atomic(uint64_t) refused;       /* Of those, failed for needing a feature outside features */
+        struct nrLDPC_harq_store harq;   /* Decoder: HARQ soft buffers resident on the emulated DPU */
+};
+
+/**
+ * Emulate the connection establishment with the DPU server
+ *
+ * @standin [in]: Stand-in server
+ */
+void nrLDPC_standin_connect(const struct nrLDPC_standin *standin);
+
+/**
+ * Answer one request the way the DPU server does.
+ * The encoder response carries the systematic bits only and the decoder response the hard decision of the
+ * systematic LLRs: the stand-in reproduces message sizes and timing, not the LDPC arithmetic. HARQ requests are
+ * combined with the soft buffers of the stand-in, the way the DPU server does, and their hard decision taken on
+ * the combined LLRs. Rate matched requests are recovered into the N LLRs of their code block first, as the DPU
+ * server does. Rate matched encoder requests are encoded for real, their E bits are the ones the DPU returns.
+ * Decoder requests checking a CRC are decoded for real too, by the host decoder stopping once the CRC passes, and
+ * take the share of service_ns of the iterations they ran. A request needing a feature outside standin->features
+ * fails with a negative status, as it would on a server that does not serve it.
+ * The calling core spins the processing time, unless the stand-in is queued: the response is then computed at
+ * once and only arrives, through nrLDPC_standin_ready_ns(), when the emulated DPU is done with it.
+ *
+ * @standin [in]: Stand-in server
+ * @req [in]: Request message
+ * @req_len [in]: Request message length
+ * @resp [out]: Response message
+ * @resp_size [in]: Size of the resp buffer
+ * @resp_len [out]: Response message length
+ * @service_ns [out]: Processing time of the request, to give nrLDPC_standin_ready_ns()
+ */
+void nrLDPC_standin_serve(struct nrLDPC_standin *standin,
+                          const void *req,
+                          uint32_t req_len,
+                          void *resp,
+                          uint32_t resp_size,
+                          uint32_t *resp_len,
+                          uint32_t *service_ns);
+
+/**
+ * Answer a cancel the way the DPU server does, on arrival: the listed requests the emulated DPU has not started
+ * get a header-only NRLDPC_PROTO_STATUS_CANCELLED response, available at once, and the requests queued after
+ * them start earlier. Only a queued stand-in skips requests, otherwise they are done by the time they are sent.
+ *
+ * @standin [in]: Stand-in server
+ * @req [in]: Request message
+ * @req_len [in]: Request message length
+ * @fifo [in/out]: Responses not read by the client yet, rewritten in place
+ * @slab [in]: Consumer slots holding the fifo responses
+ * @resp [out]: Response message
+ * @resp_size [in]: Size of the resp buffer
+ * @resp_len [out]: Response message length
+ * @return: true when req is a cancel, answered in resp, false for the requests of nrLDPC_standin_serve(), a
+ *          cancel without NRLDPC_PROTO_FEATURE_CANCEL included
+ */
+bool nrLDPC_standin_cancel(struct nrLDPC_standin *standin,
+                           const void *req,
+                           uint32_t req_len,
+                           struct comch_recv_fifo *fifo,
+                           const struct local_mem_slab *slab,
+                           void *resp,
+                           uint32_t resp_size,
+                           uint32_t *resp_len);
+
+/**
+ * Time at which the response of a request served now reaches the host, after the ones served before it when
+ * the stand-in is queued. One request in hiccup_every is delayed by hiccup_ns, a DPU hiccup.
+ *
+ * @standin [in]: Stand-in server
+ * @queue [in]: The request takes its turn on the emulated DPU, false for a cancel, handled on arrival
+ * @service_ns [in]: Processing time of the request, from nrLDPC_standin_serve()
+ * @return: CLOCK_MONOTONIC time in nanoseconds
+ */
+uint64_t nrLDPC_standin_ready_ns(struct nrLDPC_standin *standin, bool queue, uint32_t service_ns);
+
+/**
+ * Whether a response returned by nrLDPC_standin_ready_ns() has arrived
+ *
+ * @ready_ns [in]: CLOCK_MONOTONIC time in nanoseconds
+ * @return: true once ready_ns is reached
+ */
+bool nrLDPC_standin_arrived(uint64_t ready_ns);
+
+/**
+ * Busy wait until a response returned by nrLDPC_standin_ready_ns() has arrived
+ *
+ * @ready_ns [in]: CLOCK_MONOTONIC time in nanoseconds
+ */
+void nrLDPC_standin_wait(uint64_t ready_ns);
+
+#endif // NRLDPC_STANDIN_H_
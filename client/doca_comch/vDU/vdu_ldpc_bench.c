@@ -0,0 +1,3784 @@
+/*
+ * Benchmark component for offloading of the LDPC encoder/decoder of the High-PHY Layer of the vDU.
+ *
+ * Author: Vlademir Brusse
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include <nrLDPC_defs.h>
+
+#include "comch_ctrl_path_common.h"
+#include "nrLDPC_bg.h"
+#include "nrLDPC_bits.h"
+#include "nrLDPC_crc.h"
+#include "nrLDPC_dispatch.h"
+#include "nrLDPC_harq.h"
+#include "nrLDPC_hedge.h"
+#include "nrLDPC_host_decod.h"
+#include "nrLDPC_host_encod.h"
+#include "nrLDPC_proto.h"
+#include "nrLDPC_ratematch.h"
+#include "nrLDPC_session.h"
+
+/* a 512-bit input block */
+#define INPUT_BLOCK_512 "00010010001000011001111100010101000001100010011110100101000010100101000001001100000101110101011110000001010011011001011000110010001101110001100010100101100111000010000101101111101101111000101001011011111011001001001111011001111011000001011101011100101000100011011011100000010101010010111011001001000100001110110000011110111111100100011011010110100001001111010101001010011100010011011001001111111111111011000001101010110100010011011000111111011001001011110001110001000100000010101100011011101101011011101000010110"
+
+#define BENCH_DEFAULT_ITERATIONS 1000
+#define BENCH_WARMUP_ITERATIONS 16
+#define BENCH_MAX_THREADS 16
+#define BENCH_FIXTURE_ENV 12      /* NRLDPC_* variables a benchmark sets at most */
+#define BENCH_COALESCE_K 80      /* Kprime of the coalesce benchmark blocks, BG2 Z = 8 */
+#define BENCH_COALESCE_N (52 * 8) /* LLRs of the coalesce benchmark blocks */
+#define BENCH_ABORT_C 16          /* Code blocks of the abort benchmark transport blocks */
+#define BENCH_HOSTENC_SEGS 4      /* Segments of the transport block the hostenc benchmark routes to the host */
+#define BENCH_HOSTDEC_LLR_SCALE 8 /* Quantisation of the hostdec channel LLRs, steps per unit */
+#define BENCH_HOSTDEC_BLOCKS 8    /* Noisy codewords the hostdec throughput runs cycle through */
+#define BENCH_HOSTDEC_ITERS 8     /* numMaxIter of the hostdec benchmark */
+#define BENCH_HOSTDEC_FALLBACK_E 33000 /* Rate matched LLRs of the hostdec fallback, more than a message holds */
+#define BENCH_LIFTING_DEPTH 16    /* Asynchronous decodes in flight in the lifting benchmark */
+#define BENCH_DISPATCH_LARGE 2    /* BG1 Zc = 96 code blocks of a dispatch benchmark slot */
+#define BENCH_DISPATCH_SMALL 6    /* BG2 Zc = 8 code blocks of a dispatch benchmark slot */
+#define BENCH_HEDGE_Z 64          /* Lifting size of the BG1 code blocks of the hedge benchmark */
+#define BENCH_HARQ_Z 64           /* Lifting size of the BG1 code blocks of the harq benchmark */
+#define BENCH_HARQ_PROCESSES 16   /* HARQ processes of the harq benchmark, transmitted in turn */
+#define BENCH_RM_Z 64             /* Lifting size of the BG1 code blocks of the ratematch benchmark */
+#define BENCH_RM_F 56             /* Filler bits of the ratematch benchmark code blocks */
+#define BENCH_RM_QM 4             /* Modulation order of the ratematch benchmark, 16QAM */
+#define BENCH_RMENC_SEGS 4        /* Segments of the rmencod benchmark transport blocks, BG1 Zc = 64 */
+#define BENCH_CRC_Z 64            /* Lifting size of the BG1 code blocks of the crc benchmark */
+#define BENCH_CRC_C 16            /* Code blocks of the crc benchmark transport blocks */
+
+/* OAI LDPC Interfaces */
+int32_t nrLDPC_initcall(void);
+int32_t nrLDPC_shutdown(void);
+int32_t nrLDPC_encod(uint8_t **inputArr, uint8_t *outputArr, encoder_implemparams_t *impp);
+int32_t nrLDPC_encod_async(uint8_t **inputArr, uint8_t *outputArr, encoder_implemparams_t *impp);
+int32_t nrLDPC_decod(t_nrLDPC_dec_params *p_decParams,
+                     uint8_t harq_pid,
+                     uint8_t ulsch_id,
+                     uint8_t C,
+                     int8_t *p_llr,
+                     int8_t *p_out,
+                     t_nrLDPC_time_stats *p_time_stats,
+                     decode_abort_t *ab);
+int32_t nrLDPC_decod_async(t_nrLDPC_dec_params *p_decParams,
+                           uint8_t harq_pid,
+                           uint8_t ulsch_id,
+                           uint8_t C,
+                           int8_t *p_llr,
+                           int8_t *p_out,
+                           t_nrLDPC_time_stats *p_time_stats,
+                           decode_abort_t *ab,
+                           task_ans_t *ans);
+int32_t nrLDPC_decod_harq(t_nrLDPC_dec_params *p_decParams,
+                          uint8_t harq_pid,
+                          uint8_t ulsch_id,
+                          uint16_t segment,
+                          bool new_data,
+                          int8_t *p_llr,
+                          int8_t *p_out,
+                          decode_abort_t *ab,
+                          task_ans_t *ans);
+int32_t nrLDPC_decod_harq_release(uint8_t harq_pid, uint8_t ulsch_id);
+int32_t nrLDPC_decod_rm(t_nrLDPC_dec_params *p_decParams,
+                        uint8_t harq_pid,
+                        uint8_t ulsch_id,
+                        uint32_t E,
+                        uint8_t rv,
+                        uint8_t Qm,
+                        uint32_t F,
+                        uint32_t Ncb,
+                        int8_t *p_e,
+                        int8_t *p_out,
+                        decode_abort_t *ab,
+                        task_ans_t *ans);
+int32_t nrLDPC_encod_rm(uint8_t **input,
+                        uint8_t *output,
+                        encoder_implemparams_t *pencod_params,
+                        const nrLDPC_params_per_cb_t *perCB,
+                        uint8_t rv,
+                        uint8_t Qm,
+                        uint32_t Ncb,
+                        task_ans_t *ans);
+
+/* Latency samples of one benchmark run */
+struct bench_stats {
+        uint64_t *samples_ns; /* Per call latency */
+        uint32_t count;       /* Number of samples */
+};
+
+/* Session of a benchmark and the NRLDPC_* variables its runs set, put back when the benchmark ends */
+struct bench_fixture {
+        const char *names[BENCH_FIXTURE_ENV]; /* Variables set by the benchmark */
+        char *saved[BENCH_FIXTURE_ENV];       /* Their values before the benchmark, NULL when unset */
+        uint32_t num_env;                     /* Number of variables set */
+        bool open;                            /* A session is open */
+};
+
+/*
+ * Monotonic clock in nanoseconds
+ */
+static uint64_t bench_now_ns(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Set, or unset when value is NULL, a variable of the fixture. The value it had before the benchmark is kept the
+ * first time the variable is set, bench_fixture_end puts it back.
+ *
+ * @fx [in]: Fixture of the benchmark
+ * @name [in]: NRLDPC_* variable
+ * @value [in]: Value of the next sessions, NULL to unset
+ */
+static void bench_fixture_env(struct bench_fixture *fx, const char *name, const char *value)
+{
+        const char *saved;
+        uint32_t i;
+
+        for (i = 0; i < fx->num_env; i++) {
+                if (strcmp(fx->names[i], name) == 0)
+                        break;
+        }
+        if (i == fx->num_env && fx->num_env < BENCH_FIXTURE_ENV) {
+                saved = getenv(name);
+                fx->names[i] = name;
+                fx->saved[i] = saved != NULL ? strdup(saved) : NULL;
+                fx->num_env++;
+        }
+
+        if (value != NULL)
+                setenv(name, value, 1);
+        else
+                unsetenv(name);
+}
+
+/*
+ * Set a variable of the fixture unless the command line set it, the values a benchmark runs with by default
+ *
+ * @fx [in]: Fixture of the benchmark
+ * @name [in]: NRLDPC_* variable
+ * @value [in]: Default value
+ */
+static void bench_fixture_default(struct bench_fixture *fx, const char *name, const char *value)
+{
+        if (getenv(name) == NULL)
+                bench_fixture_env(fx, name, value);
+}
+
+/*
+ * Default service time, round trip and queueing of the loopback stand-in, a DPU server loaded by one slot
+ *
+ * @fx [in]: Fixture of the benchmark
+ * @service_ns [in]: NRLDPC_LOOPBACK_SERVICE_NS, NULL to keep the stand-in default
+ * @rtt_ns [in]: NRLDPC_LOOPBACK_RTT_NS, NULL to keep the stand-in default
+ * @queued [in]: NRLDPC_LOOPBACK_QUEUED, NULL to keep the stand-in default
+ */
+static void bench_fixture_loopback(struct bench_fixture *fx,
+                                   const char *service_ns,
+                                   const char *rtt_ns,
+                                   const char *queued)
+{
+        if (service_ns != NULL)
+                bench_fixture_default(fx, NRLDPC_ENV_LOOPBACK_SERVICE_NS, service_ns);
+        if (rtt_ns != NULL)
+                bench_fixture_default(fx, NRLDPC_ENV_LOOPBACK_RTT_NS, rtt_ns);
+        if (queued != NULL)
+                bench_fixture_default(fx, NRLDPC_ENV_LOOPBACK_QUEUED, queued);
+}
+
+/*
+ * Open the session of the next run with the variables set so far
+ *
+ * @fx [in]: Fixture of the benchmark
+ * @return: 0 on success, -1 if LDPCinit failed
+ */
+static int bench_fixture_open(struct bench_fixture *fx)
+{
+        if (nrLDPC_initcall() != 0)
+                return -1;
+        fx->open = true;
+        return 0;
+}
+
+/*
+ * Close the session of the run, if one is open
+ *
+ * @fx [in]: Fixture of the benchmark
+ */
+static void bench_fixture_close(struct bench_fixture *fx)
+{
+        if (!fx->open)
+                return;
+        nrLDPC_shutdown();
+        fx->open = false;
+}
+
+/*
+ * End of the benchmark: close the session left open by a failed run and put back the variables it set
+ *
+ * @fx [in]: Fixture of the benchmark
+ */
+static void bench_fixture_end(struct bench_fixture *fx)
+{
+        uint32_t i;
+
+        bench_fixture_close(fx);
+        for (i = 0; i < fx->num_env; i++) {
+                if (fx->saved[i] != NULL)
+                        setenv(fx->names[i], fx->saved[i], 1);
+                else
+                        unsetenv(fx->names[i]);
+                free(fx->saved[i]);
+        }
+        fx->num_env = 0;
+}
+
+static int bench_cmp_u64(const void *a, const void *b)
+{
+        uint64_t x = *(const uint64_t *)a;
+        uint64_t y = *(const uint64_t *)b;
+
+        return (x > y) - (x < y);
+}
+
+/*
+ * Print min/avg/percentiles of a run, the samples are sorted in place
+ */
+static void bench_stats_print(const char *name, struct bench_stats *stats)
+{
+        uint64_t sum = 0;
+        uint32_t i;
+
+        if (stats->count == 0) {
+                printf("%-24s no samples\n", name);
+                return;
+        }
+
+        qsort(stats->samples_ns, stats->count, sizeof(uint64_t), bench_cmp_u64);
+        for (i = 0; i < stats->count; i++)
+                sum += stats->samples_ns[i];
+
+        printf("%-24s %8u %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+               name,
+               stats->count,
+               stats->samples_ns[0] / 1e3,
+               sum / 1e3 / stats->count,
+               stats->samples_ns[stats->count / 2] / 1e3,
+               stats->samples_ns[(uint64_t)stats->count * 99 / 100] / 1e3,
+               stats->samples_ns[(uint64_t)stats->count * 999 / 1000] / 1e3,
+               stats->samples_ns[stats->count - 1] / 1e3);
+}
+
+static void bench_stats_header(void)
+{
+        printf("%-24s %8s %10s %10s %10s %10s %10s %10s\n",
+               "run", "calls", "min_us", "avg_us", "p50_us", "p99_us", "p99.9_us", "max_us");
+}
+
+/*
+ * One code block encode request, the same block vdu_high_phy_ldpc_codes sends, packed as OAI does.
+ * Blocking when ans is NULL, otherwise submitted with nrLDPC_encod_async and completed on ans.
+ */
+static int bench_encode_one_ans(task_ans_t *ans)
+{
+        static uint8_t inputBlock[10560];
+        static uint8_t outputBlock[10560];
+        static uint8_t packedBlock[1056];
+        uint8_t *pinput = packedBlock;
+        encoder_implemparams_t enc_params = {
+                .BG = 0,
+                .Zc = 8,
+                .K = 128,
+                .Kb = 4,
+                .F = 48,
+                .ans = ans,
+        };
+
+        if (inputBlock[0] == 0) {
+                memcpy(inputBlock, INPUT_BLOCK_512, strlen(INPUT_BLOCK_512));
+                nrLDPC_bits_pack(inputBlock, enc_params.K, packedBlock);
+        }
+
+        if (ans != NULL)
+                return nrLDPC_encod_async(&pinput, outputBlock, &enc_params);
+        return nrLDPC_encod(&pinput, outputBlock, &enc_params);
+}
+
+static int bench_encode_one(void)
+{
+        return bench_encode_one_ans(NULL);
+}
+
+/*
+ * setup: per call latency of nrLDPC_encod when every call sets up and tears down the DOCA Comch client,
+ * connection, producer, consumer and buffers (the behaviour before the session existed) against the
+ * session opened once by LDPCinit.
+ */
+static int bench_setup(uint32_t iterations)
+{
+        struct bench_stats stats = {0};
+        uint64_t start;
+        uint32_t i;
+
+        stats.samples_ns = calloc(iterations, sizeof(uint64_t));
+        if (stats.samples_ns == NULL)
+                return EXIT_FAILURE;
+
+        bench_stats_header();
+
+        /* Before: init, one request and shutdown per call */
+        for (i = 0; i < iterations; i++) {
+                start = bench_now_ns();
+                if (nrLDPC_initcall() != 0 || bench_encode_one() != 0) {
+                        printf("per-call encode failed at iteration %u\n", i);
+                        free(stats.samples_ns);
+                        return EXIT_FAILURE;
+                }
+                nrLDPC_shutdown();
+                stats.samples_ns[stats.count++] = bench_now_ns() - start;
+        }
+        bench_stats_print("encode per-call setup", &stats);
+
+        /* After: one session, requests only */
+        if (nrLDPC_initcall() != 0) {
+                free(stats.samples_ns);
+                return EXIT_FAILURE;
+        }
+        for (i = 0; i < BENCH_WARMUP_ITERATIONS; i++)
+                (void)bench_encode_one();
+
+        stats.count = 0;
+        for (i = 0; i < iterations; i++) {
+                start = bench_now_ns();
+                if (bench_encode_one() != 0) {
+                        printf("session encode failed at iteration %u\n", i);
+                        break;
+                }
+                stats.samples_ns[stats.count++] = bench_now_ns() - start;
+        }
+        nrLDPC_shutdown();
+        bench_stats_print("encode session", &stats);
+
+        free(stats.samples_ns);
+        return EXIT_SUCCESS;
+}
+
+/*
+ * slab: memory registrations done by the data path. The per-call setup registers producer and consumer
+ * memory on every request, the session registers its slabs once and must not register anything after warm-up.
+ */
+static int bench_slab(uint32_t iterations)
+{
+        struct bench_stats stats = {0};
+        uint64_t regs_start;
+        uint64_t regs_steady;
+        uint64_t start;
+        uint32_t i;
+
+        stats.samples_ns = calloc(iterations, sizeof(uint64_t));
+        if (stats.samples_ns == NULL)
+                return EXIT_FAILURE;
+
+        /* Per-call setup */
+        regs_start = comch_data_path_mem_registrations();
+        for (i = 0; i < BENCH_WARMUP_ITERATIONS; i++) {
+                if (nrLDPC_initcall() != 0 || bench_encode_one() != 0) {
+                        free(stats.samples_ns);
+                        return EXIT_FAILURE;
+                }
+                nrLDPC_shutdown();
+        }
+        printf("per-call setup: %.1f registrations per request\n",
+               (double)(comch_data_path_mem_registrations() - regs_start) / BENCH_WARMUP_ITERATIONS);
+
+        /* Session: slabs registered at LDPCinit, warm-up, then steady state */
+        regs_start = comch_data_path_mem_registrations();
+        if (nrLDPC_initcall() != 0) {
+                free(stats.samples_ns);
+                return EXIT_FAILURE;
+        }
+        for (i = 0; i < BENCH_WARMUP_ITERATIONS; i++)
+                (void)bench_encode_one();
+        regs_steady = comch_data_path_mem_registrations();
+
+        for (i = 0; i < iterations; i++) {
+                start = bench_now_ns();
+                if (bench_encode_one() != 0) {
+                        printf("session encode failed at iteration %u\n", i);
+                        break;
+                }
+                stats.samples_ns[stats.count++] = bench_now_ns() - start;
+        }
+
+        printf("session: %lu registrations at warm-up, %lu during %u requests\n",
+               (unsigned long)(regs_steady - regs_start),
+               (unsigned long)(comch_data_path_mem_registrations() - regs_steady),
+               stats.count);
+        bench_stats_header();
+        bench_stats_print("encode slab", &stats);
+        nrLDPC_shutdown();
+        free(stats.samples_ns);
+
+        return comch_data_path_mem_registrations() == regs_steady ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+ * pipeline: encoder request throughput with 1 to recv_depth requests outstanding on the data path.
+ * Each round sends depth requests back to back, then reads the depth responses in order.
+ */
+static int bench_pipeline(uint32_t iterations)
+{
+        static const uint32_t depths[] = {1, 2, 4, 8, 16, 32, 64};
+        struct nrLDPC_proto_hdr hdr = {
+                .op = NRLDPC_PROTO_OP_ENCOD_REQ,
+                .bg = 0,
+                .z = 8,
+                .k = 128,
+                .n = 66 * 8,
+                .f = 48,
+        };
+        uint8_t packed[128 / 8];
+        uint8_t *req;
+        uint8_t *resp;
+        uint32_t req_len;
+        struct nrLDPC_session *s;
+        uint64_t start;
+        uint64_t elapsed;
+        uint32_t depth;
+        uint32_t done;
+        uint32_t d, i;
+        doca_error_t result;
+
+        req = calloc(1, NRLDPC_PROTO_MAX_MSG_SIZE);
+        resp = calloc(1, NRLDPC_PROTO_MAX_MSG_SIZE);
+        if (req == NULL || resp == NULL || nrLDPC_initcall() != 0) {
+                free(req);
+                free(resp);
+                return EXIT_FAILURE;
+        }
+        s = nrLDPC_session_get();
+
+        nrLDPC_bits_pack((const uint8_t *)INPUT_BLOCK_512, hdr.k, packed);
+        req_len = nrLDPC_proto_pack(req, NRLDPC_PROTO_MAX_MSG_SIZE, &hdr, packed, sizeof(packed));
+
+        printf("%-8s %10s %12s %12s\n", "depth", "requests", "req_per_s", "avg_us");
+        for (d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+                depth = depths[d];
+                if (depth > s->cfg.recv_depth)
+                        break;
+
+                done = 0;
+                start = bench_now_ns();
+                while (done < iterations) {
+                        for (i = 0; i < depth; i++) {
+                                result = nrLDPC_session_send(NRLDPC_SERVICE_ENCOD, req, req_len);
+                                if (result != DOCA_SUCCESS)
+                                        goto fail;
+                        }
+                        for (i = 0; i < depth; i++) {
+                                result = nrLDPC_session_recv(NRLDPC_SERVICE_ENCOD,
+                                                             resp,
+                                                             NRLDPC_PROTO_MAX_MSG_SIZE,
+                                                             NULL);
+                                if (result != DOCA_SUCCESS)
+                                        goto fail;
+                        }
+                        done += depth;
+                }
+                elapsed = bench_now_ns() - start;
+                printf("%-8u %10u %12.0f %12.2f\n",
+                       depth,
+                       done,
+                       (double)done * 1e9 / elapsed,
+                       (double)elapsed / done / 1000.0);
+        }
+
+        nrLDPC_shutdown();
+        free(req);
+        free(resp);
+        return EXIT_SUCCESS;
+
+fail:
+        printf("pipeline depth %u failed with error = %s\n", depth, doca_error_get_name(result));
+        nrLDPC_shutdown();
+        free(req);
+        free(resp);
+        return EXIT_FAILURE;
+}
+
+/*
+ * proto: bytes on the wire and serialization cost of a BG2, Z = 96 decode, the legacy fixed-size
+ * structures against the nrLDPC_proto.h messages.
+ */
+static int bench_proto(uint32_t iterations)
+{
+        const uint32_t z = 96;
+        const uint32_t n = 52 * z;
+        const uint32_t kprime = 10 * z - 16;
+        struct ldpc_decod_params_t *legacy;
+        struct nrLDPC_proto_hdr hdr = {
+                .op = NRLDPC_PROTO_OP_DECOD_REQ,
+                .bg = 2,
+                .z = z,
+                .k = kprime,
+                .n = n,
+                .num_its = 8,
+        };
+        struct nrLDPC_proto_hdr parsed;
+        const void *payload;
+        uint8_t *msg;
+        int8_t *llrs;
+        uint8_t *out;
+        uint32_t req_len = 0;
+        uint32_t resp_len = 0;
+        uint64_t start;
+        uint64_t legacy_ns;
+        uint64_t proto_ns;
+        uint32_t i;
+
+        legacy = calloc(1, sizeof(*legacy));
+        msg = calloc(1, NRLDPC_PROTO_MAX_MSG_SIZE);
+        llrs = calloc(n, 1);
+        out = calloc(kprime / 8, 1);
+        if (legacy == NULL || msg == NULL || llrs == NULL || out == NULL) {
+                free(legacy);
+                free(msg);
+                free(llrs);
+                free(out);
+                return EXIT_FAILURE;
+        }
+        for (i = 0; i < n; i++)
+                llrs[i] = (int8_t)(i * 37);
+
+        /* Legacy: the whole struct goes both ways, the caller fills it and reads data_out back */
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++) {
+                memset(legacy->llrs, 0, n);
+                memcpy(legacy->llrs, llrs, n);
+                legacy->n = n;
+                legacy->kp = kprime / 8;
+                legacy->bg = hdr.bg;
+                legacy->z = z;
+                legacy->num_its = hdr.num_its;
+                memcpy(out, legacy->data_out, kprime / 8);
+        }
+        legacy_ns = bench_now_ns() - start;
+
+        /* Proto: pack the request, unpack the response and copy its payload out */
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++) {
+                hdr.op = NRLDPC_PROTO_OP_DECOD_REQ;
+                hdr.req_id = nrLDPC_proto_next_req_id();
+                req_len = nrLDPC_proto_pack(msg, NRLDPC_PROTO_MAX_MSG_SIZE, &hdr, llrs, n);
+                hdr.op = NRLDPC_PROTO_OP_DECOD_RESP;
+                resp_len = nrLDPC_proto_pack(msg, NRLDPC_PROTO_MAX_MSG_SIZE, &hdr, out, kprime / 8);
+                if (nrLDPC_proto_unpack(msg, resp_len, &parsed, &payload) != DOCA_SUCCESS)
+                        break;
+                memcpy(out, payload, parsed.payload_len);
+        }
+        proto_ns = bench_now_ns() - start;
+
+        printf("BG2 Z=%u decode: N=%u LLRs, Kprime=%u bits\n", z, n, kprime);
+        printf("%-8s %12s %12s %12s %14s\n", "format", "req_bytes", "resp_bytes", "total", "ns_per_req");
+        printf("%-8s %12zu %12zu %12zu %14.1f\n",
+               "legacy",
+               sizeof(*legacy),
+               sizeof(*legacy),
+               2 * sizeof(*legacy),
+               (double)legacy_ns / iterations);
+        printf("%-8s %12u %12u %12u %14.1f\n",
+               "proto",
+               req_len,
+               resp_len,
+               req_len + resp_len,
+               (double)proto_ns / iterations);
+        printf("PCIe bytes reduced %.1fx\n", (double)(2 * sizeof(*legacy)) / (req_len + resp_len));
+
+        free(legacy);
+        free(msg);
+        free(llrs);
+        free(out);
+        return EXIT_SUCCESS;
+}
+
+/*
+ * bits: pack of a BG1, Z = 384 segment (K = 8448 bits) and unpack of its codeword (N = 25344 bits),
+ * scalar against the SIMD kernels, whose output must be identical.
+ */
+static int bench_bits(uint32_t iterations)
+{
+        const uint32_t k = 22 * 384;
+        const uint32_t n = 66 * 384;
+        uint8_t *bytes;
+        uint8_t *packed;
+        uint8_t *packed_ref;
+        uint8_t *unpacked;
+        uint8_t *unpacked_ref;
+        uint64_t start;
+        uint64_t pack_scalar_ns, pack_ns;
+        uint64_t unpack_scalar_ns, unpack_ns;
+        uint32_t i;
+        int ret = EXIT_FAILURE;
+
+        bytes = calloc(n, 1);
+        packed = calloc(n / 8, 1);
+        packed_ref = calloc(n / 8, 1);
+        unpacked = calloc(n, 1);
+        unpacked_ref = calloc(n, 1);
+        if (bytes == NULL || packed == NULL || packed_ref == NULL || unpacked == NULL || unpacked_ref == NULL)
+                goto out;
+        for (i = 0; i < n; i++)
+                bytes[i] = (uint8_t)((i * 2654435761u) >> 31);
+
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+                nrLDPC_bits_pack_scalar(bytes, k, packed_ref);
+        pack_scalar_ns = bench_now_ns() - start;
+
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+                nrLDPC_bits_pack(bytes, k, packed);
+        pack_ns = bench_now_ns() - start;
+
+        nrLDPC_bits_pack(bytes, n, packed);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+                nrLDPC_bits_unpack_scalar(packed, n, unpacked_ref);
+        unpack_scalar_ns = bench_now_ns() - start;
+
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++)
+                nrLDPC_bits_unpack(packed, n, unpacked);
+        unpack_ns = bench_now_ns() - start;
+
+        nrLDPC_bits_pack_scalar(bytes, k, packed_ref);
+        nrLDPC_bits_pack(bytes, k, packed);
+        if (memcmp(packed, packed_ref, k / 8) != 0 || memcmp(unpacked, unpacked_ref, n) != 0 ||
+            memcmp(unpacked, bytes, n) != 0) {
+                printf("bits: SIMD and scalar kernels disagree\n");
+                goto out;
+        }
+
+        printf("SIMD kernels: %s\n", nrLDPC_bits_simd() ? "avx2" : "none (scalar)");
+        printf("%-16s %8s %12s %12s %10s\n", "kernel", "bits", "scalar_ns", "dispatch_ns", "speedup");
+        printf("%-16s %8u %12.1f %12.1f %9.1fx\n",
+               "pack (K)",
+               k,
+               (double)pack_scalar_ns / iterations,
+               (double)pack_ns / iterations,
+               (double)pack_scalar_ns / pack_ns);
+        printf("%-16s %8u %12.1f %12.1f %9.1fx\n",
+               "unpack (N)",
+               n,
+               (double)unpack_scalar_ns / iterations,
+               (double)unpack_ns / iterations,
+               (double)unpack_scalar_ns / unpack_ns);
+        printf("Encoder PCIe bytes: %u + %u packed vs %u + %u one bit per byte\n", k / 8, n / 8, k, n);
+        ret = EXIT_SUCCESS;
+
+out:
+        free(bytes);
+        free(packed);
+        free(packed_ref);
+        free(unpacked);
+        free(unpacked_ref);
+        return ret;
+}
+
+/*
+ * segments: code blocks per second of a BG1, Zc = 384 transport block of 1 to 144 segments, one nrLDPC_encod
+ * call per segment (n_segments = 0) against one call for the whole transport block (n_segments, first_seg).
+ */
+static int bench_segments(uint32_t iterations)
+{
+        static const uint32_t counts[] = {1, 8, 32, NR_LDPC_MAX_NUM_CB};
+        const uint32_t k = 22 * 384;
+        const uint32_t n = 66 * 384;
+        encoder_implemparams_t enc_params = {
+                .BG = 1,
+                .Zc = 384,
+                .K = k,
+                .Kb = 22,
+                .F = 0,
+        };
+        uint8_t *inputs[NR_LDPC_MAX_NUM_CB];
+        uint8_t *mem;
+        uint8_t *output;
+        uint64_t start;
+        uint64_t seg_ns, tb_ns;
+        uint32_t count;
+        uint32_t c, it, j;
+        int ret = EXIT_FAILURE;
+
+        mem = calloc(NR_LDPC_MAX_NUM_CB, k / 8);
+        output = calloc(NR_LDPC_MAX_NUM_CB, n);
+        if (mem == NULL || output == NULL || nrLDPC_initcall() != 0)
+                goto out;
+        for (j = 0; j < NR_LDPC_MAX_NUM_CB * k / 8; j++)
+                mem[j] = (uint8_t)(j * 2654435761u >> 24);
+        for (j = 0; j < NR_LDPC_MAX_NUM_CB; j++)
+                inputs[j] = mem + j * (k / 8);
+
+        printf("BG1 Zc=384: K=%u, N=%u bits, %u bytes encoder messages\n",
+               k,
+               n,
+               nrLDPC_session_max_msg_size(NRLDPC_SERVICE_ENCOD));
+        printf("%-10s %14s %14s %10s\n", "segments", "per_seg_cb_s", "tb_cb_s", "speedup");
+        for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+                count = counts[c];
+
+                enc_params.n_segments = 0;
+                enc_params.output = NULL;
+                start = bench_now_ns();
+                for (it = 0; it < iterations; it++) {
+                        for (j = 0; j < count; j++) {
+                                if (nrLDPC_encod(&inputs[j], output + (size_t)j * n, &enc_params) != 0)
+                                        goto fail;
+                        }
+                }
+                seg_ns = bench_now_ns() - start;
+
+                enc_params.n_segments = count;
+                enc_params.first_seg = 0;
+                enc_params.output = output;
+                start = bench_now_ns();
+                for (it = 0; it < iterations; it++) {
+                        if (nrLDPC_encod(inputs, output, &enc_params) != 0)
+                                goto fail;
+                }
+                tb_ns = bench_now_ns() - start;
+
+                /* The stand-in codeword starts with the input bits of its own segment */
+                if (output[(size_t)(count - 1) * n] != (inputs[count - 1][0] >> 7))
+                        goto fail;
+
+                printf("%-10u %14.0f %14.0f %9.1fx\n",
+                       count,
+                       (double)count * iterations * 1e9 / seg_ns,
+                       (double)count * iterations * 1e9 / tb_ns,
+                       (double)seg_ns / tb_ns);
+        }
+        ret = EXIT_SUCCESS;
+        goto shutdown;
+
+fail:
+        printf("segments: encoding of %u segments failed\n", count);
+shutdown:
+        nrLDPC_shutdown();
+out:
+        free(mem);
+        free(output);
+        return ret;
+}
+
+/*
+ * Busy wait, stands for the High-PHY work a worker does between submitting code blocks and joining them
+ *
+ * @ns [in]: Time to wait in nanoseconds
+ */
+static void bench_spin_ns(uint64_t ns)
+{
+        uint64_t end = bench_now_ns() + ns;
+
+        while (bench_now_ns() < end)
+                ;
+}
+
+/*
+ * async: one worker encoding batches of BG1, Zc = 384 code blocks, one blocking nrLDPC_encod call after the
+ * other against nrLDPC_encod_async submissions joined on a task_ans_t, without and with 100 us of other
+ * work per batch that the asynchronous worker overlaps with the offload.
+ */
+static int bench_async(uint32_t iterations)
+{
+        const uint32_t k = 22 * 384;
+        const uint32_t n = 66 * 384;
+        const uint64_t work_ns = 100000;
+        encoder_implemparams_t enc_params = {
+                .BG = 1,
+                .Zc = 384,
+                .K = k,
+                .Kb = 22,
+                .F = 0,
+        };
+        uint8_t *inputs[CC_DATA_PATH_RECV_DEPTH];
+        struct nrLDPC_session *s;
+        task_ans_t ans;
+        uint8_t *mem;
+        uint8_t *output;
+        uint64_t start;
+        uint64_t ns[4];
+        uint32_t batch;
+        uint32_t run, it, j;
+        int ret = EXIT_FAILURE;
+
+        mem = calloc(CC_DATA_PATH_RECV_DEPTH, k / 8);
+        output = calloc(CC_DATA_PATH_RECV_DEPTH, n);
+        if (mem == NULL || output == NULL || nrLDPC_initcall() != 0)
+                goto out;
+        s = nrLDPC_session_get();
+        batch = s->cfg.recv_depth < CC_DATA_PATH_RECV_DEPTH ? s->cfg.recv_depth : CC_DATA_PATH_RECV_DEPTH;
+        for (j = 0; j < CC_DATA_PATH_RECV_DEPTH * k / 8; j++)
+                mem[j] = (uint8_t)(j * 2654435761u >> 24);
+        for (j = 0; j < CC_DATA_PATH_RECV_DEPTH; j++)
+                inputs[j] = mem + j * (k / 8);
+
+        /* Runs: blocking, asynchronous, blocking + work, asynchronous + work */
+        for (run = 0; run < 4; run++) {
+                start = bench_now_ns();
+                for (it = 0; it < iterations; it++) {
+                        if (run % 2 == 0) {
+                                enc_params.ans = NULL;
+                                for (j = 0; j < batch; j++) {
+                                        if (nrLDPC_encod(&inputs[j], output + (size_t)j * n, &enc_params) != 0)
+                                                goto fail;
+                                }
+                                if (run == 2)
+                                        bench_spin_ns(work_ns);
+                        } else {
+                                init_task_ans(&ans, batch);
+                                enc_params.ans = &ans;
+                                for (j = 0; j < batch; j++) {
+                                        if (nrLDPC_encod_async(&inputs[j], output + (size_t)j * n, &enc_params) != 0)
+                                                goto fail;
+                                }
+                                if (run == 3)
+                                        bench_spin_ns(work_ns);
+                                join_task_ans(&ans);
+                                sem_destroy(&ans.sem);
+                        }
+                }
+                ns[run] = bench_now_ns() - start;
+        }
+
+        printf("BG1 Zc=384 code blocks, batches of %u, %u batches\n", batch, iterations);
+        printf("%-26s %14s %14s\n", "worker", "cb_per_s", "batch_us");
+        printf("%-26s %14.0f %14.1f\n",
+               "blocking",
+               (double)batch * iterations * 1e9 / ns[0],
+               (double)ns[0] / iterations / 1000.0);
+        printf("%-26s %14.0f %14.1f\n",
+               "async",
+               (double)batch * iterations * 1e9 / ns[1],
+               (double)ns[1] / iterations / 1000.0);
+        printf("%-26s %14.0f %14.1f\n",
+               "blocking + 100us work",
+               (double)batch * iterations * 1e9 / ns[2],
+               (double)ns[2] / iterations / 1000.0);
+        printf("%-26s %14.0f %14.1f\n",
+               "async + 100us work",
+               (double)batch * iterations * 1e9 / ns[3],
+               (double)ns[3] / iterations / 1000.0);
+        ret = EXIT_SUCCESS;
+        goto shutdown;
+
+fail:
+        printf("async: encoding failed\n");
+shutdown:
+        nrLDPC_shutdown();
+out:
+        free(mem);
+        free(output);
+        return ret;
+}
+
+#define BENCH_HIST_BUCKETS 10 /* Latency histogram buckets, the last one is open */
+
+/* Upper bound of each latency histogram bucket but the last one, in microseconds */
+static const uint32_t bench_hist_us[BENCH_HIST_BUCKETS - 1] = {2, 5, 10, 20, 50, 100, 200, 500, 1000};
+
+/*
+ * Count the samples of a run in the latency histogram buckets
+ */
+static void bench_hist_fill(const struct bench_stats *stats, uint32_t *hist)
+{
+        uint32_t i, b;
+
+        memset(hist, 0, BENCH_HIST_BUCKETS * sizeof(*hist));
+        for (i = 0; i < stats->count; i++) {
+                for (b = 0; b < BENCH_HIST_BUCKETS - 1; b++) {
+                        if (stats->samples_ns[i] < bench_hist_us[b] * 1000ULL)
+                                break;
+                }
+                hist[b]++;
+        }
+}
+
+/*
+ * poll: latency of single code block requests with the data path waits sleeping SLEEP_IN_NANOS (sleep-poll)
+ * against busy-polling, both for blocking nrLDPC_encod calls and for nrLDPC_encod_async submissions handed to
+ * the progress thread. The requests are spaced by a 50 us pause, the way slots spread them, so that every
+ * request finds the waiting threads idle. NRLDPC_PROGRESS_CPU pins the progress thread, busy-poll needs a core
+ * of its own to pay off.
+ */
+static int bench_poll(uint32_t iterations)
+{
+        static const char *const modes[2] = {"sleep", "busy"};
+        static const char *const names[4] = {"sync sleep-poll",
+                                             "sync busy-poll",
+                                             "async sleep-poll",
+                                             "async busy-poll"};
+        const struct timespec gap = {
+                .tv_sec = 0,
+                .tv_nsec = 50000,
+        };
+        struct bench_stats stats[4] = {0};
+        struct bench_fixture fx = {0};
+        uint32_t hist[4][BENCH_HIST_BUCKETS];
+        task_ans_t ans;
+        uint64_t start;
+        uint32_t mode, async, run, i, b;
+        int ret = EXIT_FAILURE;
+
+        for (run = 0; run < 4; run++) {
+                stats[run].samples_ns = calloc(iterations, sizeof(uint64_t));
+                if (stats[run].samples_ns == NULL)
+                        goto out;
+        }
+
+        for (mode = 0; mode < 2; mode++) {
+                bench_fixture_env(&fx, NRLDPC_ENV_PROGRESS_POLL, modes[mode]);
+                if (bench_fixture_open(&fx) != 0)
+                        goto out;
+
+                for (async = 0; async < 2; async++) {
+                        run = async * 2 + mode;
+                        for (i = 0; i < BENCH_WARMUP_ITERATIONS + iterations; i++) {
+                                nanosleep(&gap, NULL);
+                                start = bench_now_ns();
+                                if (async == 1) {
+                                        init_task_ans(&ans, 1);
+                                        if (bench_encode_one_ans(&ans) != 0)
+                                                goto fail;
+                                        join_task_ans(&ans);
+                                        sem_destroy(&ans.sem);
+                                } else if (bench_encode_one() != 0) {
+                                        goto fail;
+                                }
+                                if (i >= BENCH_WARMUP_ITERATIONS)
+                                        stats[run].samples_ns[stats[run].count++] = bench_now_ns() - start;
+                        }
+                }
+                bench_fixture_close(&fx);
+        }
+
+        printf("%-12s", "latency_us");
+        for (run = 0; run < 4; run++)
+                printf(" %18s", names[run]);
+        printf("\n");
+        for (run = 0; run < 4; run++)
+                bench_hist_fill(&stats[run], hist[run]);
+        for (b = 0; b < BENCH_HIST_BUCKETS; b++) {
+                if (b < BENCH_HIST_BUCKETS - 1)
+                        printf("< %-10u", bench_hist_us[b]);
+                else
+                        printf(">= %-9u", bench_hist_us[b - 1]);
+                for (run = 0; run < 4; run++)
+                        printf(" %10u %6.2f%%", hist[run][b], 100.0 * hist[run][b] / stats[run].count);
+                printf("\n");
+        }
+
+        printf("\n");
+        bench_stats_header();
+        for (run = 0; run < 4; run++)
+                bench_stats_print(names[run], &stats[run]);
+        ret = EXIT_SUCCESS;
+        goto out;
+
+fail:
+        printf("poll: encoding failed\n");
+out:
+        bench_fixture_end(&fx);
+        for (run = 0; run < 4; run++)
+                free(stats[run].samples_ns);
+        return ret;
+}
+
+/*
+ * pe: PE polling done per encode request. The client, producer and consumer of a data path share one PE, so
+ * a polling round is one doca_pe_progress call; with a PE each, the rounds waiting for a response progressed
+ * the client and consumer PEs and those waiting for a send the producer PE. The stand-in server completes the
+ * requests without PE, run it against the DPU.
+ */
+static int bench_pe(uint32_t iterations)
+{
+        struct comch_data_path_objects *data_path;
+        struct nrLDPC_session *s;
+        uint64_t send_polls, recv_polls;
+        uint32_t i;
+
+        if (nrLDPC_initcall() != 0)
+                return EXIT_FAILURE;
+        for (i = 0; i < BENCH_WARMUP_ITERATIONS; i++)
+                (void)bench_encode_one();
+
+        s = nrLDPC_session_get();
+        data_path = &s->services[NRLDPC_SERVICE_ENCOD].data_path;
+        send_polls = data_path->send_polls;
+        recv_polls = data_path->recv_polls;
+        for (i = 0; i < iterations; i++) {
+                if (bench_encode_one() != 0) {
+                        printf("pe: encoding failed at iteration %u\n", i);
+                        nrLDPC_shutdown();
+                        return EXIT_FAILURE;
+                }
+        }
+        send_polls = data_path->send_polls - send_polls;
+        recv_polls = data_path->recv_polls - recv_polls;
+        nrLDPC_shutdown();
+
+        printf("%-36s %12u\n", "requests", iterations);
+        printf("%-36s %12.2f\n", "polling rounds waiting for the send", (double)send_polls / iterations);
+        printf("%-36s %12.2f\n", "polling rounds waiting for the reply", (double)recv_polls / iterations);
+        printf("%-36s %12.2f\n", "doca_pe_progress calls, one PE", (double)(send_polls + recv_polls) / iterations);
+        printf("%-36s %12.2f\n",
+               "doca_pe_progress calls, three PEs",
+               (double)(send_polls + 2 * recv_polls) / iterations);
+        if (send_polls + recv_polls == 0)
+                printf("no PE polled: the stand-in server answers without DOCA Comch\n");
+        return EXIT_SUCCESS;
+}
+
+/* Progress thread configuration compared by the event benchmark */
+struct bench_progress_mode {
+        const char *name;      /* Name printed */
+        const char *poll;      /* NRLDPC_PROGRESS_POLL */
+        const char *spin_rate; /* NRLDPC_PROGRESS_SPIN_RATE, NULL for the default */
+};
+
+/*
+ * CPU time consumed by a thread in nanoseconds
+ */
+static uint64_t bench_thread_cpu_ns(pthread_t thread)
+{
+        struct timespec ts;
+        clockid_t cid;
+
+        if (pthread_getcpuclockid(thread, &cid) != 0 || clock_gettime(cid, &ts) != 0)
+                return 0;
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Latency of one asynchronous code block request, submitted after a pause and joined on its task_ans_t
+ *
+ * @gap [in]: Pause before the request, none when 0
+ * @return: Latency in nanoseconds, 0 on failure
+ */
+static uint64_t bench_async_one(const struct timespec *gap)
+{
+        task_ans_t ans;
+        uint64_t start;
+
+        if (gap->tv_nsec != 0)
+                nanosleep(gap, NULL);
+        start = bench_now_ns();
+        init_task_ans(&ans, 1);
+        if (bench_encode_one_ans(&ans) != 0)
+                return 0;
+        join_task_ans(&ans);
+        sem_destroy(&ans.sem);
+        return bench_now_ns() - start;
+}
+
+/*
+ * event: CPU utilisation of the progress thread and latency of asynchronous single code block requests for
+ * the progress modes, under a sparse load (one code block every 200 us, a bursty cell that is mostly idle) and
+ * a dense one (the next code block as soon as the previous one completed). The event mode blocks in epoll on
+ * the PE notification handles, the adaptive event mode spins above NRLDPC_PROGRESS_SPIN_RATE requests/s.
+ */
+static int bench_event(uint32_t iterations)
+{
+        static const struct bench_progress_mode modes[] = {
+                {"sleep-poll", "sleep", NULL},
+                {"busy-poll", "busy", NULL},
+                {"event", "event", "0"},
+                {"event adaptive", "event", NULL},
+        };
+        static const uint32_t gaps_ns[2] = {200000, 0};
+        struct bench_fixture fx = {0};
+        struct bench_stats stats = {0};
+        struct timespec gap = {0};
+        struct nrLDPC_session *s;
+        uint64_t wall, cpu;
+        uint32_t load, m, i;
+        int ret = EXIT_FAILURE;
+
+        stats.samples_ns = calloc(iterations, sizeof(uint64_t));
+        if (stats.samples_ns == NULL)
+                return EXIT_FAILURE;
+
+        printf("%-8s %-16s %10s %10s %10s %10s %12s\n",
+               "load", "progress", "req_per_s", "p50_us", "p99_us", "p99.9_us", "progress_cpu");
+        for (load = 0; load < 2; load++) {
+                gap.tv_nsec = gaps_ns[load];
+                for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+                        bench_fixture_env(&fx, NRLDPC_ENV_PROGRESS_POLL, modes[m].poll);
+                        bench_fixture_env(&fx, NRLDPC_ENV_PROGRESS_SPIN_RATE, modes[m].spin_rate);
+                        if (bench_fixture_open(&fx) != 0)
+                                goto out;
+
+                        /* The first submission starts the progress thread */
+                        for (i = 0; i < BENCH_WARMUP_ITERATIONS; i++) {
+                                if (bench_async_one(&gap) == 0)
+                                        goto fail;
+                        }
+                        s = nrLDPC_session_get();
+                        cpu = bench_thread_cpu_ns(s->progress_thread);
+                        wall = bench_now_ns();
+                        for (stats.count = 0; stats.count < iterations; stats.count++) {
+                                stats.samples_ns[stats.count] = bench_async_one(&gap);
+                                if (stats.samples_ns[stats.count] == 0)
+                                        goto fail;
+                        }
+                        cpu = bench_thread_cpu_ns(s->progress_thread) - cpu;
+                        wall = bench_now_ns() - wall;
+                        bench_fixture_close(&fx);
+
+                        qsort(stats.samples_ns, stats.count, sizeof(uint64_t), bench_cmp_u64);
+                        printf("%-8s %-16s %10.0f %10.2f %10.2f %10.2f %11.1f%%\n",
+                               load == 0 ? "sparse" : "dense",
+                               modes[m].name,
+                               stats.count * 1e9 / wall,
+                               stats.samples_ns[stats.count / 2] / 1e3,
+                               stats.samples_ns[(uint64_t)stats.count * 99 / 100] / 1e3,
+                               stats.samples_ns[(uint64_t)stats.count * 999 / 1000] / 1e3,
+                               100.0 * cpu / wall);
+                }
+        }
+        ret = EXIT_SUCCESS;
+        goto out;
+
+fail:
+        printf("event: encoding failed\n");
+out:
+        bench_fixture_end(&fx);
+        free(stats.samples_ns);
+        return ret;
+}
+
+/* One OAI worker of the threads benchmark */
+struct bench_thread {
+        pthread_t thread;          /* Worker thread */
+        pthread_barrier_t *start;  /* Releases all the workers and the timer at once */
+        uint32_t iterations;       /* Decoder calls to make */
+        uint64_t *samples_ns;      /* Latency of each call */
+        uint32_t count;            /* Calls made */
+        int ret;                   /* 0 when all calls succeeded */
+};
+
+/*
+ * One BG2, Z = 64 code block decode request
+ *
+ * @llr [in]: 52 * 64 LLRs
+ * @out [out]: 80 bytes, the 640 decoded bits
+ * @return: 0 on success
+ */
+static int bench_decode_one(int8_t *llr, int8_t *out)
+{
+        t_nrLDPC_dec_params dec_params = {
+                .BG = 2,
+                .Z = 64,
+                .R = 15,
+                .numMaxIter = 8,
+                .Kprime = 640,
+                .outMode = nrLDPC_outMode_BIT,
+        };
+
+        return nrLDPC_decod(&dec_params, 0, 0, 1, llr, out, NULL, NULL);
+}
+
+/*
+ * Worker of the threads benchmark: blocking nrLDPC_decod calls, one after the other
+ */
+static void *bench_thread_run(void *arg)
+{
+        struct bench_thread *t = arg;
+        int8_t llr[52 * 64];
+        int8_t out[640 / 8];
+        uint64_t start;
+        uint32_t i;
+
+        for (i = 0; i < sizeof(llr); i++)
+                llr[i] = (i * 2654435761u >> 31) != 0 ? 64 : -64;
+
+        /* The first call claims the channel of the thread, when there is one left */
+        t->ret = bench_decode_one(llr, out);
+        pthread_barrier_wait(t->start);
+        for (t->count = 0; t->count < t->iterations && t->ret == 0; t->count++) {
+                start = bench_now_ns();
+                t->ret = bench_decode_one(llr, out);
+                t->samples_ns[t->count] = bench_now_ns() - start;
+        }
+
+        return NULL;
+}
+
+/*
+ * threads: aggregate decoder code blocks/s and per call latency of 1 to 16 OAI workers calling nrLDPC_decod
+ * concurrently, all sharing the data path of the service behind its lock, each with a channel of its own
+ * (NRLDPC_THREAD_CHANNELS), then all enqueuing on the submission ring drained by the progress thread
+ * (NRLDPC_BLOCKING_PATH=ring). Every worker makes iterations calls.
+ */
+static int bench_threads(uint32_t iterations)
+{
+        static const uint32_t thread_counts[] = {1, 2, 4, 8, 16};
+        static const char *const models[] = {"shared", "per-thread", "ring"};
+        struct bench_thread threads[BENCH_MAX_THREADS];
+        struct bench_fixture fx = {0};
+        struct bench_stats stats = {0};
+        pthread_barrier_t start;
+        char channels[16];
+        uint64_t wall;
+        uint32_t model, c, n, i;
+        int ret = EXIT_FAILURE;
+
+        stats.samples_ns = calloc((size_t)BENCH_MAX_THREADS * iterations, sizeof(uint64_t));
+        if (stats.samples_ns == NULL)
+                return EXIT_FAILURE;
+
+        printf("%-12s %8s %12s %10s %10s %10s\n", "data path", "threads", "cb_per_s", "p50_us", "p99_us", "p99.9_us");
+        for (model = 0; model < sizeof(models) / sizeof(models[0]); model++) {
+                snprintf(channels, sizeof(channels), "%u", model == 1 ? BENCH_MAX_THREADS : 0);
+                bench_fixture_env(&fx, NRLDPC_ENV_THREAD_CHANNELS, channels);
+                bench_fixture_env(&fx, NRLDPC_ENV_BLOCKING_PATH, model == 2 ? "ring" : "lock");
+                for (c = 0; c < sizeof(thread_counts) / sizeof(thread_counts[0]); c++) {
+                        n = thread_counts[c];
+                        if (bench_fixture_open(&fx) != 0)
+                                goto out;
+
+                        pthread_barrier_init(&start, NULL, n + 1);
+                        for (i = 0; i < n; i++) {
+                                threads[i] = (struct bench_thread){
+                                        .start = &start,
+                                        .iterations = iterations,
+                                        .samples_ns = stats.samples_ns + (size_t)i * iterations,
+                                };
+                                if (pthread_create(&threads[i].thread, NULL, bench_thread_run, &threads[i]) != 0) {
+                                        printf("threads: failed to create worker %u\n", i);
+                                        exit(EXIT_FAILURE);
+                                }
+                        }
+                        pthread_barrier_wait(&start);
+                        wall = bench_now_ns();
+                        for (i = 0; i < n; i++)
+                                pthread_join(threads[i].thread, NULL);
+                        wall = bench_now_ns() - wall;
+                        pthread_barrier_destroy(&start);
+                        bench_fixture_close(&fx);
+
+                        stats.count = 0;
+                        for (i = 0; i < n; i++) {
+                                if (threads[i].ret != 0) {
+                                        printf("threads: decoding failed in worker %u\n", i);
+                                        goto out;
+                                }
+                                /* Compact the samples of the workers */
+                                memmove(stats.samples_ns + stats.count,
+                                        threads[i].samples_ns,
+                                        threads[i].count * sizeof(uint64_t));
+                                stats.count += threads[i].count;
+                        }
+
+                        qsort(stats.samples_ns, stats.count, sizeof(uint64_t), bench_cmp_u64);
+                        printf("%-12s %8u %12.0f %10.2f %10.2f %10.2f\n",
+                               models[model],
+                               n,
+                               stats.count * 1e9 / wall,
+                               stats.samples_ns[stats.count / 2] / 1e3,
+                               stats.samples_ns[(uint64_t)stats.count * 99 / 100] / 1e3,
+                               stats.samples_ns[(uint64_t)stats.count * 999 / 1000] / 1e3);
+                }
+        }
+        ret = EXIT_SUCCESS;
+
+out:
+        bench_fixture_end(&fx);
+        free(stats.samples_ns);
+        return ret;
+}
+
+/*
+ * credits: encoder requests/s against a server granting 4..64 credits over a queue depth of 64, submitters that
+ * are queued when the credits run out against ones that are told it would block and poll for completions.
+ * The outstanding column is the most requests the server was ever holding, never above the credits.
+ */
+struct bench_credits {
+        _Atomic(uint32_t) done;   /* Completed requests */
+        _Atomic(uint32_t) failed; /* Requests completed with an error */
+};
+
+static void bench_credits_done(void *user_data, uint32_t tag, const void *resp, uint32_t resp_len, doca_error_t status)
+{
+        struct bench_credits *credits = user_data;
+
+        (void)tag;
+        (void)resp;
+        (void)resp_len;
+        if (status != DOCA_SUCCESS)
+                atomic_fetch_add(&credits->failed, 1);
+        atomic_fetch_add(&credits->done, 1);
+}
+
+static int bench_credits(uint32_t iterations)
+{
+        static const uint32_t grants[] = {4, 16, 64};
+        static const char *const modes[] = {"queued", "try"};
+        struct nrLDPC_proto_hdr hdr = {
+                .op = NRLDPC_PROTO_OP_ENCOD_REQ,
+                .bg = 0,
+                .z = 8,
+                .k = 128,
+                .n = 66 * 8,
+                .f = 48,
+        };
+        struct bench_credits credits;
+        struct bench_fixture fx = {0};
+        struct nrLDPC_service *svc;
+        const void *reqs[1];
+        uint32_t req_lens[1];
+        uint8_t packed[128 / 8];
+        uint8_t *req;
+        char value[16];
+        uint64_t elapsed;
+        uint64_t would_block;
+        uint32_t outstanding;
+        uint32_t peak;
+        uint32_t submitted;
+        uint32_t g, mode, i;
+        doca_error_t result;
+        int ret = EXIT_FAILURE;
+
+        req = calloc(1, NRLDPC_PROTO_MAX_MSG_SIZE);
+        if (req == NULL)
+                return EXIT_FAILURE;
+        nrLDPC_bits_pack((const uint8_t *)INPUT_BLOCK_512, hdr.k, packed);
+        req_lens[0] = nrLDPC_proto_pack(req, NRLDPC_PROTO_MAX_MSG_SIZE, &hdr, packed, sizeof(packed));
+        reqs[0] = req;
+
+        bench_fixture_env(&fx, NRLDPC_ENV_QUEUE_DEPTH, "64");
+        printf("%-8s %8s %12s %12s %12s\n", "credits", "submit", "req_per_s", "would_block", "outstanding");
+        for (g = 0; g < sizeof(grants) / sizeof(grants[0]); g++) {
+                snprintf(value, sizeof(value), "%u", grants[g]);
+                bench_fixture_env(&fx, NRLDPC_ENV_CREDITS, value);
+                for (mode = 0; mode < sizeof(modes) / sizeof(modes[0]); mode++) {
+                        if (bench_fixture_open(&fx) != 0)
+                                goto out;
+                        svc = &nrLDPC_session_get()->services[NRLDPC_SERVICE_ENCOD];
+
+                        atomic_store(&credits.done, 0);
+                        atomic_store(&credits.failed, 0);
+                        would_block = 0;
+                        peak = 0;
+                        elapsed = bench_now_ns();
+                        for (i = 0; i < iterations;) {
+                                if (mode == 0) {
+                                        result = nrLDPC_session_submit(NRLDPC_SERVICE_ENCOD,
+                                                                       1,
+                                                                       reqs,
+                                                                       req_lens,
+                                                                       bench_credits_done,
+                                                                       &credits);
+                                        submitted = result == DOCA_SUCCESS ? 1 : 0;
+                                } else {
+                                        result = nrLDPC_session_try_submit(NRLDPC_SERVICE_ENCOD,
+                                                                           1,
+                                                                           reqs,
+                                                                           req_lens,
+                                                                           bench_credits_done,
+                                                                           &credits,
+                                                                           &submitted);
+                                }
+                                if (result == DOCA_ERROR_AGAIN) {
+                                        /* Would block: do something else, here reap what completed */
+                                        would_block++;
+                                        (void)nrLDPC_session_poll(NRLDPC_SERVICE_ENCOD);
+                                } else if (result != DOCA_SUCCESS) {
+                                        printf("credits: submission failed with error = %s\n",
+                                               doca_error_get_name(result));
+                                        goto out;
+                                }
+                                i += submitted;
+
+                                outstanding = svc->credit_limit - atomic_load(&svc->credits);
+                                if (outstanding > peak)
+                                        peak = outstanding;
+                        }
+                        while (atomic_load(&credits.done) < iterations)
+                                (void)nrLDPC_session_poll(NRLDPC_SERVICE_ENCOD);
+                        elapsed = bench_now_ns() - elapsed;
+                        bench_fixture_close(&fx);
+
+                        if (atomic_load(&credits.failed) != 0) {
+                                printf("credits: %u requests failed\n", atomic_load(&credits.failed));
+                                goto out;
+                        }
+                        printf("%-8u %8s %12.0f %12lu %12u\n",
+                               grants[g],
+                               modes[mode],
+                               (double)iterations * 1e9 / elapsed,
+                               (unsigned long)would_block,
+                               peak);
+                }
+        }
+        ret = EXIT_SUCCESS;
+
+out:
+        bench_fixture_end(&fx);
+        free(req);
+        return ret;
+}
+
+/*
+ * edf: deadline-miss rate of the uplink decodes under load, FIFO against EDF scheduling. The stand-in server is
+ * queued, as a DPU it works besides the host, and takes NRLDPC_LOOPBACK_SERVICE_NS per request (50 us by default),
+ * two at a time in the pipeline so that the others wait in the scheduling heap; a burst first measures how many
+ * requests/s it serves. Requests then arrive at
+ * random (exponential gaps) at 0.7 to 1.3 times that rate. The mix: 10% retransmissions and 10% low-latency
+ * requests due 10 service times after their arrival, 50% uplink due after 20 to 60 and 30% bulk due after 100.
+ */
+#define BENCH_EDF_CLASSES 4 /* Traffic classes of the edf benchmark */
+
+struct bench_edf_req {
+        uint64_t arrival_ns;          /* Submission time */
+        uint64_t deadline_ns;         /* Absolute deadline */
+        uint64_t done_ns;             /* Completion time, 0 until completed */
+        uint32_t cls;                 /* Index in bench_edf_classes */
+        _Atomic(uint32_t) *completed; /* Completed requests of the run */
+};
+
+static const enum nrLDPC_traffic_class bench_edf_classes[BENCH_EDF_CLASSES] = {NRLDPC_CLASS_RETX,
+                                                                              NRLDPC_CLASS_LOW_LATENCY,
+                                                                              NRLDPC_CLASS_UPLINK,
+                                                                              NRLDPC_CLASS_BULK};
+
+static void bench_edf_done(void *user_data, uint32_t tag, const void *resp, uint32_t resp_len, doca_error_t status)
+{
+        struct bench_edf_req *req = user_data;
+
+        (void)tag;
+        (void)resp;
+        (void)resp_len;
+        /* A failed request misses its deadline */
+        req->done_ns = status == DOCA_SUCCESS ? bench_now_ns() : UINT64_MAX;
+        atomic_fetch_add(req->completed, 1);
+}
+
+static int bench_edf(uint32_t iterations)
+{
+        static const char *const modes[] = {"fifo", "edf"};
+        static const double loads[] = {0.7, 0.9, 1.1, 1.3};
+        static const char *const class_names[BENCH_EDF_CLASSES] = {"retx", "low-lat", "uplink", "bulk"};
+        struct nrLDPC_proto_hdr hdr = {
+                .op = NRLDPC_PROTO_OP_DECOD_REQ,
+                .bg = 2,
+                .z = 8,
+                .k = 80,
+                .n = 52 * 8,
+                .num_its = 8,
+        };
+        struct bench_fixture fx = {0};
+        struct bench_edf_req *reqs;
+        _Atomic(uint32_t) completed;
+        int8_t llr[52 * 8];
+        uint8_t *msg;
+        const void *msgs[1];
+        uint32_t msg_len;
+        uint32_t missed[BENCH_EDF_CLASSES];
+        uint32_t total[BENCH_EDF_CLASSES];
+        uint32_t all_missed;
+        uint64_t service_ns;
+        uint64_t served_ns;
+        uint64_t start;
+        uint64_t now;
+        unsigned int seed;
+        uint32_t mode, l, c, i;
+        double gap;
+        int ret = EXIT_FAILURE;
+
+        /* Defaults only, the stand-in service time is set from the command line environment */
+        bench_fixture_loopback(&fx, "50000", NULL, "1");
+        bench_fixture_env(&fx, NRLDPC_ENV_RECV_DEPTH, "2");
+        bench_fixture_env(&fx, NRLDPC_ENV_SLAB_SLOTS, "1024");
+        bench_fixture_env(&fx, NRLDPC_ENV_SUBMIT_RING, "1024");
+        service_ns = strtoull(getenv(NRLDPC_ENV_LOOPBACK_SERVICE_NS), NULL, 0);
+        if (service_ns == 0)
+                service_ns = 50000;
+
+        reqs = calloc(iterations, sizeof(*reqs));
+        msg = calloc(1, NRLDPC_PROTO_MAX_MSG_SIZE);
+        if (reqs == NULL || msg == NULL)
+                goto out;
+        for (i = 0; i < sizeof(llr); i++)
+                llr[i] = (int8_t)((i * 37) % 255 - 127);
+        msg_len = nrLDPC_proto_pack(msg, NRLDPC_PROTO_MAX_MSG_SIZE, &hdr, llr, sizeof(llr));
+        msgs[0] = msg;
+
+        /* Time the server takes per request, host overheads included, when it is never idle */
+        bench_fixture_env(&fx, NRLDPC_ENV_SCHED, "fifo");
+        if (bench_fixture_open(&fx) != 0)
+                goto out;
+        atomic_store(&completed, 0);
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++) {
+                reqs[i].completed = &completed;
+                if (nrLDPC_session_submit(NRLDPC_SERVICE_DECOD, 1, msgs, &msg_len, bench_edf_done, &reqs[i]) !=
+                    DOCA_SUCCESS)
+                        printf("edf: submission failed\n");
+        }
+        while (atomic_load(&completed) < iterations)
+                sched_yield();
+        served_ns = (bench_now_ns() - start) / iterations;
+        bench_fixture_close(&fx);
+
+        printf("stand-in service time %lu us, served in %.1f us, %u requests per run, deadline misses in %%\n",
+               (unsigned long)(service_ns / 1000),
+               served_ns / 1000.0,
+               iterations);
+        printf("%-6s %6s", "sched", "load");
+        for (c = 0; c < BENCH_EDF_CLASSES; c++)
+                printf(" %8s", class_names[c]);
+        printf(" %8s\n", "all");
+        for (l = 0; l < sizeof(loads) / sizeof(loads[0]); l++) {
+                for (mode = 0; mode < sizeof(modes) / sizeof(modes[0]); mode++) {
+                        bench_fixture_env(&fx, NRLDPC_ENV_SCHED, modes[mode]);
+                        if (bench_fixture_open(&fx) != 0)
+                                goto out;
+
+                        /* Same arrivals and deadlines for both modes */
+                        seed = 1 + l;
+                        start = bench_now_ns() + 1000000;
+                        now = start;
+                        for (i = 0; i < iterations; i++) {
+                                gap = -log((rand_r(&seed) + 1.0) / (RAND_MAX + 2.0)) * served_ns / loads[l];
+                                now += (uint64_t)gap;
+                                c = rand_r(&seed) % 10;
+                                reqs[i].cls = c == 0 ? 0 : c == 1 ? 1 : c < 7 ? 2 : 3;
+                                reqs[i].arrival_ns = now;
+                                if (reqs[i].cls < 2)
+                                        reqs[i].deadline_ns = now + 10 * service_ns;
+                                else if (reqs[i].cls == 2)
+                                        reqs[i].deadline_ns = now + (20 + rand_r(&seed) % 41) * service_ns;
+                                else
+                                        reqs[i].deadline_ns = now + 100 * service_ns;
+                                reqs[i].done_ns = 0;
+                                reqs[i].completed = &completed;
+                        }
+
+                        atomic_store(&completed, 0);
+                        for (i = 0; i < iterations; i++) {
+                                while (bench_now_ns() < reqs[i].arrival_ns)
+                                        sched_yield();
+                                nrLDPC_session_set_deadline(reqs[i].deadline_ns, bench_edf_classes[reqs[i].cls]);
+                                if (nrLDPC_session_submit(NRLDPC_SERVICE_DECOD,
+                                                          1,
+                                                          msgs,
+                                                          &msg_len,
+                                                          bench_edf_done,
+                                                          &reqs[i]) != DOCA_SUCCESS)
+                                        printf("edf: submission failed\n");
+                        }
+                        while (atomic_load(&completed) < iterations)
+                                sched_yield();
+                        nrLDPC_session_set_deadline(0, NRLDPC_CLASS_DEFAULT);
+                        bench_fixture_close(&fx);
+
+                        memset(missed, 0, sizeof(missed));
+                        memset(total, 0, sizeof(total));
+                        all_missed = 0;
+                        for (i = 0; i < iterations; i++) {
+                                total[reqs[i].cls]++;
+                                if (reqs[i].done_ns > reqs[i].deadline_ns) {
+                                        missed[reqs[i].cls]++;
+                                        all_missed++;
+                                }
+                        }
+                        printf("%-6s %6.1f", modes[mode], loads[l]);
+                        for (c = 0; c < BENCH_EDF_CLASSES; c++)
+                                printf(" %8.1f", total[c] != 0 ? 100.0 * missed[c] / total[c] : 0.0);
+                        printf(" %8.1f\n", 100.0 * all_missed / iterations);
+                }
+        }
+        ret = EXIT_SUCCESS;
+
+out:
+        bench_fixture_end(&fx);
+        free(reqs);
+        free(msg);
+        return ret;
+}
+
+/*
+ * coalesce: decoder throughput and latency of small BG2 Z = 8 code blocks, one request each, with coalescing off,
+ * a fixed 5, 10 or 20 us window and the adaptive 20 us window. The queued stand-in charges
+ * NRLDPC_LOOPBACK_SERVICE_NS per message (20 us by default), the per-message overhead coalescing amortizes.
+ * Each window runs a saturated burst (code blocks/s) and Poisson arrivals at 20% of the uncoalesced rate
+ * (latency from submission to completion); every response is checked against its own request.
+ */
+struct bench_coalesce_req {
+        uint64_t arrival_ns;          /* Submission time, from the start of the run until submitted */
+        uint64_t done_ns;             /* Completion time */
+        uint32_t index;               /* Request index, seeds its LLRs and its request id */
+        _Atomic(uint32_t) *completed; /* Completed requests of the run */
+        _Atomic(uint32_t) *errors;    /* Failed or mismatching responses of the run */
+};
+
+/*
+ * LLRs of request index, different for every request so that a response handed to the wrong caller shows
+ */
+static void bench_coalesce_llrs(uint32_t index, int8_t *llr, uint32_t n)
+{
+        uint32_t i;
+
+        for (i = 0; i < n; i++)
+                llr[i] = (int8_t)((i * 37 + index * 11) % 255 - 127);
+}
+
+static void bench_coalesce_done(void *user_data,
+                                uint32_t tag,
+                                const void *resp,
+                                uint32_t resp_len,
+                                doca_error_t status)
+{
+        struct bench_coalesce_req *req = user_data;
+        struct nrLDPC_proto_hdr hdr;
+        const uint8_t *payload;
+        int8_t llr[BENCH_COALESCE_K];
+        uint8_t byte;
+        bool ok;
+        uint32_t i, b;
+
+        (void)tag;
+        req->done_ns = bench_now_ns();
+        ok = status == DOCA_SUCCESS && nrLDPC_proto_unpack(resp, resp_len, &hdr, (const void **)&payload) ==
+                                               DOCA_SUCCESS;
+        ok = ok && hdr.req_id == req->index + 1 && hdr.status >= 0 && hdr.payload_len == BENCH_COALESCE_K / 8;
+        if (ok == true) {
+                /* The stand-in decodes the hard decision of the first K LLRs */
+                bench_coalesce_llrs(req->index, llr, BENCH_COALESCE_K);
+                for (i = 0; i < BENCH_COALESCE_K / 8 && ok == true; i++) {
+                        byte = 0;
+                        for (b = 0; b < 8; b++)
+                                byte |= (llr[i * 8 + b] < 0) << (7 - b);
+                        ok = payload[i] == byte;
+                }
+        }
+        if (ok == false)
+                atomic_fetch_add(req->errors, 1);
+        atomic_fetch_add(req->completed, 1);
+}
+
+/*
+ * One run of the coalesce benchmark: submit the requests at their arrival times, from the start of the run,
+ * all 0 for as fast as possible.
+ * Returns the time from the first submission to the last completion, 0 when the session failed.
+ */
+static uint64_t bench_coalesce_run(struct bench_fixture *fx,
+                                   struct bench_coalesce_req *reqs,
+                                   uint32_t iterations,
+                                   uint8_t *msg,
+                                   double *blocks_per_msg)
+{
+        struct nrLDPC_proto_hdr hdr = {
+                .op = NRLDPC_PROTO_OP_DECOD_REQ,
+                .bg = 2,
+                .z = 8,
+                .k = BENCH_COALESCE_K,
+                .n = BENCH_COALESCE_N,
+                .num_its = 8,
+        };
+        struct nrLDPC_session *session;
+        int8_t llr[BENCH_COALESCE_N];
+        const void *msgs[1] = {msg};
+        uint64_t start;
+        uint64_t elapsed_ns;
+        uint32_t msg_len;
+        uint32_t i;
+
+        if (bench_fixture_open(fx) != 0)
+                return 0;
+
+        start = bench_now_ns();
+        for (i = 0; i < iterations; i++) {
+                while (bench_now_ns() < start + reqs[i].arrival_ns)
+                        sched_yield();
+                hdr.req_id = i + 1;
+                bench_coalesce_llrs(i, llr, BENCH_COALESCE_N);
+                msg_len = nrLDPC_proto_pack(msg, NRLDPC_PROTO_MAX_MSG_SIZE, &hdr, llr, sizeof(llr));
+                reqs[i].arrival_ns = bench_now_ns();
+                if (nrLDPC_session_submit(NRLDPC_SERVICE_DECOD, 1, msgs, &msg_len, bench_coalesce_done, &reqs[i]) !=
+                    DOCA_SUCCESS)
+                        printf("coalesce: submission failed\n");
+        }
+        while (atomic_load(reqs[0].completed) < iterations)
+                sched_yield();
+        elapsed_ns = bench_now_ns() - start;
+
+        session = nrLDPC_session_get();
+        *blocks_per_msg = 1.0;
+        if (session != NULL && session->services[NRLDPC_SERVICE_DECOD].coalesce.msgs != 0)
+                /* The requests sent alone are messages of one block */
+                *blocks_per_msg = (double)iterations /
+                                  (iterations - session->services[NRLDPC_SERVICE_DECOD].coalesce.reqs +
+                                   session->services[NRLDPC_SERVICE_DECOD].coalesce.msgs);
+        bench_fixture_close(fx);
+        return elapsed_ns;
+}
+
+static int bench_coalesce(uint32_t iterations)
+{
+        static const struct {
+                const char *name;   /* Printed name */
+                const char *window; /* NRLDPC_COALESCE_US */
+                const char *adapt;  /* NRLDPC_COALESCE_ADAPT */
+        } windows[] = {
+                {"off", "0", "0"},
+                {"5us", "5", "0"},
+                {"10us", "10", "0"},
+                {"20us", "20", "0"},
+                {"adaptive", "20", "1"},
+        };
+        struct bench_coalesce_req *reqs;
+        struct bench_fixture fx = {0};
+        struct bench_stats stats = {0};
+        _Atomic(uint32_t) completed;
+        _Atomic(uint32_t) errors;
+        double blocks_per_msg[2];
+        uint64_t served_ns = 0;
+        uint64_t elapsed_ns;
+        uint64_t now;
+        unsigned int seed;
+        uint8_t *msg;
+        uint32_t w, i;
+        int ret = EXIT_FAILURE;
+
+        /* Defaults only, the stand-in times are set from the command line environment */
+        bench_fixture_loopback(&fx, "20000", NULL, "1");
+        bench_fixture_env(&fx, NRLDPC_ENV_SLAB_SLOTS, "1024");
+        bench_fixture_env(&fx, NRLDPC_ENV_SUBMIT_RING, "1024");
+
+        reqs = calloc(iterations, sizeof(*reqs));
+        stats.samples_ns = calloc(iterations, sizeof(uint64_t));
+        msg = calloc(1, NRLDPC_PROTO_MAX_MSG_SIZE);
+        if (reqs == NULL || stats.samples_ns == NULL || msg == NULL)
+                goto out;
+
+        printf("stand-in %s ns per message, %u requests of %u LLRs per run, p50/p99 at 20%% load\n",
+               getenv(NRLDPC_ENV_LOOPBACK_SERVICE_NS),
+               iterations,
+               BENCH_COALESCE_N);
+        printf("%-10s %12s %10s %10s %10s %10s %8s\n",
+               "window", "sat_cb/s", "blk/msg", "p50_us", "p99_us", "blk/msg", "errors");
+        for (w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+                bench_fixture_env(&fx, NRLDPC_ENV_COALESCE_US, windows[w].window);
+                bench_fixture_env(&fx, NRLDPC_ENV_COALESCE_ADAPT, windows[w].adapt);
+                atomic_store(&errors, 0);
+
+                /* Saturated: every caller submits at once */
+                atomic_store(&completed, 0);
+                for (i = 0; i < iterations; i++)
+                        reqs[i] = (struct bench_coalesce_req){.index = i, .completed = &completed, .errors = &errors};
+                elapsed_ns = bench_coalesce_run(&fx, reqs, iterations, msg, &blocks_per_msg[0]);
+                if (elapsed_ns == 0)
+                        goto out;
+                /* The light load is set from the uncoalesced rate, the first run */
+                if (served_ns == 0)
+                        served_ns = elapsed_ns / iterations;
+
+                /* Light load: Poisson arrivals at 20% of what one request per message sustains */
+                atomic_store(&completed, 0);
+                seed = 1;
+                now = 0;
+                for (i = 0; i < iterations; i++) {
+                        now += (uint64_t)(-log((rand_r(&seed) + 1.0) / (RAND_MAX + 2.0)) * served_ns / 0.2);
+                        reqs[i] = (struct bench_coalesce_req){
+                                .arrival_ns = now,
+                                .index = i,
+                                .completed = &completed,
+                                .errors = &errors,
+                        };
+                }
+                if (bench_coalesce_run(&fx, reqs, iterations, msg, &blocks_per_msg[1]) == 0)
+                        goto out;
+                for (i = 0; i < iterations; i++)
+                        stats.samples_ns[i] = reqs[i].done_ns - reqs[i].arrival_ns;
+                stats.count = iterations;
+                qsort(stats.samples_ns, stats.count, sizeof(uint64_t), bench_cmp_u64);
+
+                printf("%-10s %12.0f %10.2f %10.2f %10.2f %10.2f %8u\n",
+                       windows[w].name,
+                       iterations * 1e9 / elapsed_ns,
+                       blocks_per_msg[0],
+                       stats.samples_ns[stats.count / 2] / 1e3,
+                       stats.samples_ns[(uint64_t)stats.count * 99 / 100] / 1e3,
+                       blocks_per_msg[1],
+                       atomic_load(&errors));
+        }
+        ret = EXIT_SUCCESS;
+
+out:
+        bench_fixture_end(&fx);
+        free(reqs);
+        free(stats.samples_ns);
+        free(msg);
+        return ret;
+}
+
+/*
+ * abort: DPU work saved when an early code block fails. Transport blocks of BENCH_ABORT_C BG2 Z = 64 code blocks
+ * are submitted at once with nrLDPC_decod_async; as soon as block 1 completes its CRC is taken as failed and the
+ * abort flag of the transport block set, as OAI does. The queued stand-in decodes one block per
+ * NRLDPC_LOOPBACK_SERVICE_NS (20 us by default) with NRLDPC_RECV_DEPTH (8) blocks in flight. Runs: abort flag
+ * ignored (no flag given), queued blocks dropped (NRLDPC_CANCEL=0), queued blocks dropped and in-flight ones
+ * cancelled. Blocks decoded is what the stand-in served minus what the cancels skipped.
+ */
+static int bench_abort(uint32_t iterations)
+{
+        static const struct {
+                const char *name;   /* Printed name */
+                bool tag;           /* Give the abort flag to nrLDPC_decod_async */
+                const char *cancel; /* NRLDPC_CANCEL */
+        } modes[] = {
+                {"ignore", false, "0"},
+                {"drop", true, "0"},
+                {"drop+cancel", true, "1"},
+        };
+        t_nrLDPC_dec_params dec_params = {
+                .BG = 2,
+                .Z = 64,
+                .R = 15,
+                .numMaxIter = 8,
+                .Kprime = 640,
+                .outMode = nrLDPC_outMode_BIT,
+        };
+        static int8_t llr[52 * 64];
+        static int8_t out[BENCH_ABORT_C][640 / 8];
+        task_ans_t ans[BENCH_ABORT_C];
+        struct bench_fixture fx = {0};
+        struct nrLDPC_session *session;
+        struct nrLDPC_service *svc;
+        decode_abort_t ab;
+        uint64_t served, skipped, dropped;
+        uint64_t start, elapsed_ns;
+        uint32_t m, i, c;
+        int ret = EXIT_FAILURE;
+
+        /* Defaults only, the stand-in times are set from the command line environment */
+        bench_fixture_loopback(&fx, "20000", NULL, "1");
+        bench_fixture_default(&fx, NRLDPC_ENV_RECV_DEPTH, "8");
+        bench_fixture_default(&fx, NRLDPC_ENV_PROGRESS_POLL, "busy");
+        for (i = 0; i < sizeof(llr); i++)
+                llr[i] = (int8_t)((i * 37) % 255 - 127);
+
+        printf("stand-in %s ns per block, %s blocks in flight, %u transport blocks of %u code blocks, block 1 fails\n",
+               getenv(NRLDPC_ENV_LOOPBACK_SERVICE_NS),
+               getenv(NRLDPC_ENV_RECV_DEPTH),
+               iterations,
+               BENCH_ABORT_C);
+        printf("%-12s %12s %12s %12s %12s %12s\n", "run", "decoded/TB", "dropped/TB", "skipped/TB", "saved", "us/TB");
+        for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+                bench_fixture_env(&fx, NRLDPC_ENV_CANCEL, modes[m].cancel);
+                if (bench_fixture_open(&fx) != 0)
+                        goto out;
+                pthread_mutex_init(&ab.mutex_failure, NULL);
+
+                start = bench_now_ns();
+                for (i = 0; i < iterations; i++) {
+                        ab.failed = false;
+                        for (c = 0; c < BENCH_ABORT_C; c++) {
+                                init_task_ans(&ans[c], 1);
+                                (void)nrLDPC_decod_async(&dec_params,
+                                                         0,
+                                                         0,
+                                                         BENCH_ABORT_C,
+                                                         llr,
+                                                         out[c],
+                                                         NULL,
+                                                         modes[m].tag == true ? &ab : NULL,
+                                                         &ans[c]);
+                        }
+                        /* The CRC of block 1 fails, the rest of the transport block is not needed */
+                        join_task_ans(&ans[1]);
+                        pthread_mutex_lock(&ab.mutex_failure);
+                        ab.failed = true;
+                        pthread_mutex_unlock(&ab.mutex_failure);
+                        for (c = 0; c < BENCH_ABORT_C; c++) {
+                                if (c != 1)
+                                        join_task_ans(&ans[c]);
+                                sem_destroy(&ans[c].sem);
+                        }
+                }
+                elapsed_ns = bench_now_ns() - start;
+
+                session = nrLDPC_session_get();
+                if (session == NULL) {
+                        pthread_mutex_destroy(&ab.mutex_failure);
+                        goto out;
+                }
+                svc = &session->services[NRLDPC_SERVICE_DECOD];
+                served = atomic_load(&svc->standin.served);
+                skipped = atomic_load(&svc->standin.skipped);
+                dropped = svc->dropped;
+                bench_fixture_close(&fx);
+                pthread_mutex_destroy(&ab.mutex_failure);
+
+                printf("%-12s %12.2f %12.2f %12.2f %11.1f%% %12.2f\n",
+                       modes[m].name,
+                       (double)(served - skipped) / iterations,
+                       (double)dropped / iterations,
+                       (double)skipped / iterations,
+                       100.0 * (1.0 - (double)(served - skipped) / ((uint64_t)iterations * BENCH_ABORT_C)),
+                       elapsed_ns / 1e3 / iterations);
+        }
+        ret = EXIT_SUCCESS;
+
+out:
+        bench_fixture_end(&fx);
+        return ret;
+}
+
+/*
+ * Check the host encoder on one segment of random bits: scalar and AVX2 kernels, packed and byte input agree,
+ * the output starts with the systematic bits, fillers as 0, and the punctured columns followed by the output
+ * satisfy every parity check of H
+ *
+ * @bg [in]: Base graph
+ * @z [in]: Lifting size
+ * @f [in]: Filler bits
+ * @seed [in]: Random bits seed
+ * @return: 0 when the codeword is right, 1 otherwise
+ */
+static uint32_t bench_hostenc_check(uint8_t bg, uint16_t z, uint32_t f, uint32_t seed)
+{
+        static uint8_t bits[NRLDPC_BG_MAX_COLS * NRLDPC_BG_MAX_Z];
+        static uint8_t packed[NRLDPC_PROTO_ENCOD_MAX_K / 8];
+        static uint8_t out[NRLDPC_PROTO_ENCOD_MAX_N];
+        static uint8_t out_ref[NRLDPC_PROTO_ENCOD_MAX_N];
+        const struct nrLDPC_bg *g = nrLDPC_bg_get(bg);
+        uint32_t k = (uint32_t)g->kb * z;
+        uint32_t n = (uint32_t)(g->cols - NRLDPC_BG_PUNCTURED) * z;
+        uint32_t i;
+
+        for (i = 0; i < k; i++) {
+                seed = seed * 1103515245u + 12345u;
+                bits[i] = i < k - f ? (seed >> 16) & 1 : 0;
+        }
+        nrLDPC_bits_pack(bits, k, packed);
+
+        if (nrLDPC_host_encod_scalar(bg, z, k, f, bits, false, out_ref) != DOCA_SUCCESS ||
+            nrLDPC_host_encod(bg, z, k, f, packed, true, out) != DOCA_SUCCESS || memcmp(out, out_ref, n) != 0 ||
+            memcmp(out, bits + NRLDPC_BG_PUNCTURED * z, k - NRLDPC_BG_PUNCTURED * z) != 0)
+                return 1;
+
+        memcpy(bits + NRLDPC_BG_PUNCTURED * z, out, n);
+        return nrLDPC_bg_syndrome(g, z, bits) != 0;
+}
+
+/*
+ * hostenc: the host CPU encoder. Checks every lifting size of both base graphs against the parity-check matrix,
+ * the nrLDPC_encod routing to the host (NRLDPC_HOST=always) and, when a DPU is there, the codewords of the DPU
+ * encoder; then the code blocks per second of one core, scalar and AVX2 kernels.
+ */
+static int bench_hostenc(uint32_t iterations)
+{
+        static const struct {
+                uint8_t bg; /* Base graph */
+                uint16_t z; /* Lifting size */
+        } sizes[] = {{1, 384}, {1, 208}, {1, 64}, {2, 384}, {2, 104}, {2, 16}};
+        static uint8_t segs[BENCH_HOSTENC_SEGS][NRLDPC_PROTO_ENCOD_MAX_K / 8];
+        static uint8_t out[BENCH_HOSTENC_SEGS * NRLDPC_PROTO_ENCOD_MAX_N];
+        static uint8_t out_ref[BENCH_HOSTENC_SEGS * NRLDPC_PROTO_ENCOD_MAX_N];
+        uint8_t *inputs[BENCH_HOSTENC_SEGS];
+        encoder_implemparams_t enc_params = {
+                .BG = 1,
+                .Zc = 384,
+                .K = 22 * 384,
+                .Kb = 22,
+                .F = 96,
+                .n_segments = BENCH_HOSTENC_SEGS,
+                .output = out,
+        };
+        struct bench_fixture fx = {0};
+        struct nrLDPC_session *session;
+        uint32_t checked = 0, failed = 0;
+        uint32_t k, n, i, s;
+        uint64_t start, scalar_ns, simd_ns;
+        uint16_t z;
+        uint8_t bg;
+
+        for (bg = 1; bg <= 2; bg++) {
+                for (z = 2; z <= NRLDPC_BG_MAX_Z; z++) {
+                        if (nrLDPC_bg_ils(z) < 0)
+                                continue;
+                        failed += bench_hostenc_check(bg, z, 0, z);
+                        failed += bench_hostenc_check(bg, z, z / 3, z * 7);
+                        checked += 2;
+                }
+        }
+        printf("H check: %u codewords of BG1/BG2, all 51 lifting sizes, %u wrong\n", checked, failed);
+
+        for (s = 0; s < BENCH_HOSTENC_SEGS; s++) {
+                for (i = 0; i < sizeof(segs[s]); i++)
+                        segs[s][i] = (uint8_t)((i * 2654435761u + s * 40503u) >> 24);
+                inputs[s] = segs[s];
+        }
+        n = 66 * 384;
+        for (s = 0; s < BENCH_HOSTENC_SEGS; s++)
+                (void)nrLDPC_host_encod(1, 384, enc_params.K, enc_params.F, segs[s], true, out_ref + s * n);
+
+        /* Routing: the whole transport block encoded by nrLDPC_encod on the host */
+        bench_fixture_env(&fx, NRLDPC_ENV_HOST, "always");
+        if (bench_fixture_open(&fx) != 0)
+                goto fail;
+        memset(out, 0, sizeof(out));
+        i = nrLDPC_encod(inputs, NULL, &enc_params) == EXIT_SUCCESS &&
+            memcmp(out, out_ref, BENCH_HOSTENC_SEGS * n) == 0;
+        printf("nrLDPC_encod, NRLDPC_HOST=always: %s\n", i ? "same codewords" : "WRONG");
+        failed += !i;
+        bench_fixture_close(&fx);
+        bench_fixture_env(&fx, NRLDPC_ENV_HOST, NULL);
+
+        /* The stand-in does not encode, only the DPU gives reference codewords */
+        if (bench_fixture_open(&fx) != 0)
+                goto fail;
+        session = nrLDPC_session_get();
+        if (session != NULL && session->cfg.loopback == false) {
+                bench_fixture_env(&fx, NRLDPC_ENV_HOST, "off");
+                memset(out, 0, sizeof(out));
+                i = nrLDPC_encod(inputs, NULL, &enc_params) == EXIT_SUCCESS &&
+                    memcmp(out, out_ref, BENCH_HOSTENC_SEGS * n) == 0;
+                printf("DPU encoder: %s\n", i ? "same codewords" : "DIFFERENT codewords");
+                failed += !i;
+        } else {
+                printf("DPU encoder: not compared (loopback stand-in)\n");
+        }
+        bench_fixture_end(&fx);
+
+        printf("SIMD kernels: %s\n", nrLDPC_host_encod_simd() ? "avx2" : "none (scalar)");
+        printf("%-4s %5s %7s %14s %14s %10s %12s\n", "BG", "Zc", "K", "scalar_cb/s", "dispatch_cb/s", "speedup",
+               "Mbit/s");
+        for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+                k = (sizes[i].bg == 1 ? 22 : 10) * sizes[i].z;
+
+                start = bench_now_ns();
+                for (s = 0; s < iterations; s++)
+                        (void)nrLDPC_host_encod_scalar(sizes[i].bg, sizes[i].z, k, 0, segs[s % BENCH_HOSTENC_SEGS],
+                                                       true, out);
+                scalar_ns = bench_now_ns() - start;
+
+                start = bench_now_ns();
+                for (s = 0; s < iterations; s++)
+                        (void)nrLDPC_host_encod(sizes[i].bg, sizes[i].z, k, 0, segs[s % BENCH_HOSTENC_SEGS], true,
+                                                out);
+                simd_ns = bench_now_ns() - start;
+
+                printf("%-4u %5u %7u %14.0f %14.0f %9.1fx %12.1f\n",
+                       sizes[i].bg,
+                       sizes[i].z,
+                       k,
+                       iterations * 1e9 / scalar_ns,
+                       iterations * 1e9 / simd_ns,
+                       (double)scalar_ns / simd_ns,
+                       (double)iterations * k * 1e3 / simd_ns);
+        }
+
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+fail:
+        bench_fixture_end(&fx);
+        return EXIT_FAILURE;
+}
+
+/*
+ * Send bits over a BPSK AWGN channel: bit 0 as +1, Es = 1, noise variance 1 / (2 Es/N0), LLR 2y / sigma^2
+ * quantised to int8
+ *
+ * @bits [in]: Bits, one per byte
+ * @n [in]: Number of bits
+ * @es_n0_db [in]: Es/N0 in dB
+ * @seed [in/out]: Random seed
+ * @llr [out]: The n LLRs, as received
+ * @return: Hard decision errors of the bits
+ */
+static uint32_t bench_awgn_llrs(const uint8_t *bits, uint32_t n, double es_n0_db, unsigned int *seed, int8_t *llr)
+{
+        double sigma2 = 1.0 / (2.0 * pow(10.0, es_n0_db / 10.0));
+        uint32_t errors = 0;
+        double u1, u2, y, l;
+        uint32_t i;
+
+        for (i = 0; i < n; i++) {
+                u1 = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+                u2 = (rand_r(seed) + 1.0) / (RAND_MAX + 2.0);
+                y = (bits[i] != 0 ? -1.0 : 1.0) + sqrt(sigma2) * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+                l = round(2.0 * y / sigma2 * BENCH_HOSTDEC_LLR_SCALE);
+                llr[i] = l > 127 ? 127 : l < -127 ? -127 : (int8_t)l;
+                errors += (y < 0) != (bits[i] != 0);
+        }
+
+        return errors;
+}
+
+/*
+ * Encode random bits on the host and send the codeword over the channel of bench_awgn_llrs(). The punctured columns
+ * and the columns from tx_cols on are not transmitted, their LLRs are 0.
+ *
+ * @bg [in]: Base graph
+ * @z [in]: Lifting size
+ * @tx_cols [in]: Columns up to which the codeword is transmitted
+ * @es_n0_db [in]: Es/N0 in dB
+ * @seed [in/out]: Random seed
+ * @bits [out]: The Kb * Zc information bits, one per byte
+ * @llr [out]: The cols * Zc LLRs, in the layout of nrLDPC_decod
+ * @return: Hard decision errors of the transmitted bits
+ */
+static uint32_t bench_hostdec_channel(uint8_t bg,
+                                      uint16_t z,
+                                      uint32_t tx_cols,
+                                      double es_n0_db,
+                                      unsigned int *seed,
+                                      uint8_t *bits,
+                                      int8_t *llr)
+{
+        static uint8_t cw[NRLDPC_PROTO_ENCOD_MAX_N];
+        const struct nrLDPC_bg *g = nrLDPC_bg_get(bg);
+        uint32_t k = (uint32_t)g->kb * z;
+        uint32_t i;
+
+        for (i = 0; i < k; i++)
+                bits[i] = rand_r(seed) & 1;
+        (void)nrLDPC_host_encod(bg, z, k, 0, bits, false, cw);
+
+        memset(llr, 0, (size_t)g->cols * z);
+        return bench_awgn_llrs(cw, (tx_cols - NRLDPC_BG_PUNCTURED) * z, es_n0_db, seed, llr + NRLDPC_BG_PUNCTURED * z);
+}
+
+/*
+ * hostdec: the host CPU decoder. Checks the AVX2 kernels against the scalar ones and the output modes against each
+ * other, the nrLDPC_decod routing to the host (NRLDPC_HOST=always) and the host recovery of rate matched LLRs a
+ * message cannot hold; then the BLER against Es/N0 over an AWGN channel and the code blocks per second of one core.
+ */
+static int bench_hostdec(uint32_t iterations)
+{
+        static const struct {
+                uint8_t bg;       /* Base graph */
+                uint16_t z;       /* Lifting size */
+                uint32_t tx_cols; /* Columns transmitted, punctured ones included */
+                const char *rate; /* Code rate, printed */
+                double snr_db;    /* First Es/N0 of the BLER curve, 0.5 dB steps */
+        } curves[] = {{1, 128, 68, "1/3", -5.0}, {1, 128, 35, "2/3", -0.5}, {2, 64, 52, "1/5", -7.5}};
+        static const struct {
+                uint8_t bg; /* Base graph */
+                uint16_t z; /* Lifting size */
+        } sizes[] = {{1, 384}, {1, 128}, {2, 384}, {2, 64}};
+        static uint8_t bits[22 * NRLDPC_BG_MAX_Z];
+        static uint8_t packed[22 * NRLDPC_BG_MAX_Z / 8];
+        static int8_t llr[BENCH_HOSTDEC_BLOCKS][NRLDPC_BG_MAX_COLS * NRLDPC_BG_MAX_Z];
+        static int8_t out[22 * NRLDPC_BG_MAX_Z];
+        static int8_t out_ref[22 * NRLDPC_BG_MAX_Z];
+        static int8_t out_rm[22 * NRLDPC_BG_MAX_Z];
+        static int8_t rx[BENCH_HOSTDEC_FALLBACK_E];
+        struct nrLDPC_proto_rm rm = {
+                .e = BENCH_HOSTDEC_FALLBACK_E,
+                .ncb = 66 * 384,
+                .qm = 2,
+        };
+        t_nrLDPC_dec_params dec_params = {
+                .R = 15,
+                .numMaxIter = BENCH_HOSTDEC_ITERS,
+                .outMode = nrLDPC_outMode_LLRINT8,
+        };
+        struct bench_fixture fx = {0};
+        const struct nrLDPC_bg *g;
+        unsigned int seed = 1;
+        uint32_t checked = 0, failed = 0;
+        uint32_t num_iter, ref_iter, blk_err, bit_err, tx_bits, sum_iter;
+        uint64_t start, scalar_ns, simd_ns, scalar_runs;
+        task_ans_t ans;
+        double snr;
+        uint32_t c, i, j, b, pt;
+        int ok;
+
+        /* Bit exact kernels and output modes, around the waterfall where the iterations differ the most */
+        for (i = 0; i < sizeof(curves) / sizeof(curves[0]); i++) {
+                dec_params.BG = curves[i].bg;
+                dec_params.Z = curves[i].z;
+                dec_params.Kprime = nrLDPC_bg_get(curves[i].bg)->kb * curves[i].z;
+                for (b = 0; b < 16; b++) {
+                        (void)bench_hostdec_channel(curves[i].bg, curves[i].z, curves[i].tx_cols,
+                                                    curves[i].snr_db + b * 0.25, &seed, bits, llr[0]);
+                        dec_params.outMode = nrLDPC_outMode_LLRINT8;
+                        ok = nrLDPC_host_decod_scalar(&dec_params, llr[0], out_ref, &ref_iter) == DOCA_SUCCESS &&
+                             nrLDPC_host_decod(&dec_params, llr[0], out, &num_iter) == DOCA_SUCCESS &&
+                             num_iter == ref_iter && memcmp(out, out_ref, dec_params.Kprime) == 0;
+                        for (j = 0; j < (uint32_t)dec_params.Kprime; j++)
+                                bits[j] = out_ref[j] < 0;
+                        nrLDPC_bits_pack(bits, dec_params.Kprime, packed);
+                        dec_params.outMode = nrLDPC_outMode_BITINT8;
+                        ok = ok && nrLDPC_host_decod(&dec_params, llr[0], out, &num_iter) == DOCA_SUCCESS &&
+                             memcmp(out, bits, dec_params.Kprime) == 0;
+                        dec_params.outMode = nrLDPC_outMode_BIT;
+                        ok = ok && nrLDPC_host_decod(&dec_params, llr[0], out, &num_iter) == DOCA_SUCCESS &&
+                             memcmp(out, packed, dec_params.Kprime / 8) == 0;
+                        failed += !ok;
+                        checked++;
+                }
+        }
+        printf("Kernels: %u noisy codewords, scalar vs %s and output modes, %u different\n",
+               checked,
+               nrLDPC_host_decod_simd() ? "avx2" : "scalar",
+               failed);
+
+        /* Routing: nrLDPC_decod on the host, by configuration and by fallback */
+        dec_params.outMode = nrLDPC_outMode_BIT;
+        dec_params.BG = 1;
+        dec_params.Z = 384;
+        dec_params.Kprime = 22 * 384;
+        (void)bench_hostdec_channel(1, 384, 68, -3.0, &seed, bits, llr[0]);
+        (void)nrLDPC_host_decod(&dec_params, llr[0], out_ref, &num_iter);
+        /*
+         * The codeword sent once and a third, E LLRs from the circular buffer: E is above N, the host recovers them
+         * and sends the N LLRs, with NRLDPC_HOST off too. The stand-in answers their hard decision.
+         */
+        for (i = 0; i < rm.e; i++)
+                rx[i] = llr[0][NRLDPC_BG_PUNCTURED * 384 + i % rm.ncb];
+        (void)nrLDPC_rm_recover(1, 384, &rm, rx, llr[1]);
+        for (i = 0; i < (uint32_t)dec_params.Kprime; i++)
+                bits[i] = llr[1][i] < 0;
+        nrLDPC_bits_pack(bits, dec_params.Kprime, (uint8_t *)out_rm);
+        for (c = 0; c < 2; c++) {
+                bench_fixture_env(&fx, NRLDPC_ENV_HOST, c == 0 ? "always" : "off");
+                if (bench_fixture_open(&fx) != 0)
+                        goto fail;
+                memset(out, 0, sizeof(out));
+                if (c == 0)
+                        ok = nrLDPC_decod(&dec_params, 0, 0, 1, llr[0], out, NULL, NULL) == EXIT_SUCCESS &&
+                             memcmp(out, out_ref, dec_params.Kprime / 8) == 0;
+                else
+                        ok = nrLDPC_decod_rm(&dec_params, 0, 0, rm.e, rm.rv, rm.qm, rm.f, rm.ncb, rx, out, NULL,
+                                             NULL) == EXIT_SUCCESS &&
+                             memcmp(out, out_rm, dec_params.Kprime / 8) == 0;
+                memset(out, 0, sizeof(out));
+                init_task_ans(&ans, 1);
+                /* The answer is awaited whatever the blocking call gave */
+                if (c == 0)
+                        ok = nrLDPC_decod_async(&dec_params, 0, 0, 1, llr[0], out, NULL, NULL, &ans) == EXIT_SUCCESS &&
+                             ok;
+                else
+                        ok = nrLDPC_decod_rm(&dec_params, 0, 0, rm.e, rm.rv, rm.qm, rm.f, rm.ncb, rx, out, NULL,
+                                             &ans) == EXIT_SUCCESS &&
+                             ok;
+                join_task_ans(&ans);
+                ok = ok && memcmp(out, c == 0 ? out_ref : out_rm, dec_params.Kprime / 8) == 0;
+                printf("%s, %s: %s\n",
+                       c == 0 ? "nrLDPC_decod and nrLDPC_decod_async" : "nrLDPC_decod_rm, blocking and async",
+                       c == 0 ? "NRLDPC_HOST=always" : "E above N recovered on the host, NRLDPC_HOST=off",
+                       ok ? "same bits" : "WRONG");
+                failed += !ok;
+                bench_fixture_close(&fx);
+        }
+
+        /*
+         * One bit per byte whichever decoder answers: the packed bits of the DPU are unpacked, blocking and async.
+         * The stand-in answers the hard decision of the LLRs, the punctured ones are given too so that it is right.
+         */
+        dec_params.outMode = nrLDPC_outMode_BITINT8;
+        (void)bench_hostdec_channel(1, 384, 68, 10.0, &seed, bits, llr[0]);
+        for (i = 0; i < NRLDPC_BG_PUNCTURED * 384; i++)
+                llr[0][i] = bits[i] != 0 ? -127 : 127;
+        for (c = 0, ok = 1; c < 2; c++) {
+                bench_fixture_env(&fx, NRLDPC_ENV_HOST, c == 0 ? "off" : "always");
+                if (bench_fixture_open(&fx) != 0)
+                        goto fail;
+                memset(out, 0x55, sizeof(out));
+                ok = ok && nrLDPC_decod(&dec_params, 0, 0, 1, llr[0], out, NULL, NULL) == EXIT_SUCCESS &&
+                     memcmp(out, bits, dec_params.Kprime) == 0;
+                memset(out, 0x55, sizeof(out));
+                init_task_ans(&ans, 1);
+                ok = nrLDPC_decod_async(&dec_params, 0, 0, 1, llr[0], out, NULL, NULL, &ans) == EXIT_SUCCESS && ok;
+                join_task_ans(&ans);
+                ok = ok && memcmp(out, bits, dec_params.Kprime) == 0;
+                bench_fixture_close(&fx);
+        }
+        bench_fixture_end(&fx);
+        printf("nrLDPC_decod and nrLDPC_decod_async, nrLDPC_outMode_BITINT8, DPU and host: %s\n",
+               ok ? "same bytes" : "WRONG");
+        failed += !ok;
+
+        /* BLER curves */
+        printf("\nBLER over AWGN, BPSK, %u iterations max, LLRs quantised to 1/%u\n",
+               BENCH_HOSTDEC_ITERS,
+               BENCH_HOSTDEC_LLR_SCALE);
+        printf("%-4s %5s %6s %5s %8s %8s %10s %10s %8s\n", "BG", "Zc", "K", "rate", "Es/N0", "Eb/N0", "raw_BER",
+               "BLER", "iters");
+        for (i = 0; i < sizeof(curves) / sizeof(curves[0]); i++) {
+                g = nrLDPC_bg_get(curves[i].bg);
+                dec_params.BG = curves[i].bg;
+                dec_params.Z = curves[i].z;
+                dec_params.Kprime = g->kb * curves[i].z;
+                dec_params.outMode = nrLDPC_outMode_BITINT8;
+                tx_bits = (curves[i].tx_cols - NRLDPC_BG_PUNCTURED) * curves[i].z;
+                for (pt = 0; pt < 6; pt++) {
+                        snr = curves[i].snr_db + pt * 0.5;
+                        blk_err = 0;
+                        bit_err = 0;
+                        sum_iter = 0;
+                        for (b = 0; b < iterations; b++) {
+                                bit_err += bench_hostdec_channel(curves[i].bg, curves[i].z, curves[i].tx_cols, snr,
+                                                                 &seed, bits, llr[0]);
+                                (void)nrLDPC_host_decod(&dec_params, llr[0], out, &num_iter);
+                                blk_err += memcmp(out, bits, dec_params.Kprime) != 0;
+                                sum_iter += num_iter > BENCH_HOSTDEC_ITERS ? BENCH_HOSTDEC_ITERS : num_iter;
+                        }
+                        printf("%-4u %5u %6d %5s %8.1f %8.2f %10.2e %10.2e %8.2f\n",
+                               curves[i].bg,
+                               curves[i].z,
+                               dec_params.Kprime,
+                               curves[i].rate,
+                               snr,
+                               snr - 10.0 * log10((double)dec_params.Kprime / tx_bits),
+                               (double)bit_err / ((double)iterations * tx_bits),
+                               (double)blk_err / iterations,
+                               (double)sum_iter / iterations);
+                }
+        }
+
+        /* Throughput: a good channel, early termination after a few iterations, and a bad one, all iterations */
+        printf("\nSIMD kernels: %s\n", nrLDPC_host_decod_simd() ? "avx2" : "none (scalar)");
+        printf("%-4s %5s %6s %8s %8s %14s %14s %10s %10s\n", "BG", "Zc", "K", "Es/N0", "iters", "scalar_cb/s",
+               "dispatch_cb/s", "speedup", "Mbit/s");
+        scalar_runs = iterations / 10 + 1;
+        dec_params.outMode = nrLDPC_outMode_BIT;
+        for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+                g = nrLDPC_bg_get(sizes[i].bg);
+                dec_params.BG = sizes[i].bg;
+                dec_params.Z = sizes[i].z;
+                dec_params.Kprime = g->kb * sizes[i].z;
+                for (c = 0; c < 2; c++) {
+                        snr = c == 0 ? -1.0 : -8.0;
+                        sum_iter = 0;
+                        for (b = 0; b < BENCH_HOSTDEC_BLOCKS; b++) {
+                                (void)bench_hostdec_channel(sizes[i].bg, sizes[i].z, g->cols, snr, &seed, bits,
+                                                            llr[b]);
+                                (void)nrLDPC_host_decod(&dec_params, llr[b], out, &num_iter);
+                                sum_iter += num_iter > BENCH_HOSTDEC_ITERS ? BENCH_HOSTDEC_ITERS : num_iter;
+                        }
+
+                        start = bench_now_ns();
+                        for (b = 0; b < scalar_runs; b++)
+                                (void)nrLDPC_host_decod_scalar(&dec_params, llr[b % BENCH_HOSTDEC_BLOCKS], out,
+                                                               &num_iter);
+                        scalar_ns = bench_now_ns() - start;
+
+                        start = bench_now_ns();
+                        for (b = 0; b < iterations; b++)
+                                (void)nrLDPC_host_decod(&dec_params, llr[b % BENCH_HOSTDEC_BLOCKS], out, &num_iter);
+                        simd_ns = bench_now_ns() - start;
+
+                        printf("%-4u %5u %6d %8.1f %8.2f %14.0f %14.0f %9.1fx %10.1f\n",
+                               sizes[i].bg,
+                               sizes[i].z,
+                               dec_params.Kprime,
+                               snr,
+                               (double)sum_iter / BENCH_HOSTDEC_BLOCKS,
+                               scalar_runs * 1e9 / scalar_ns,
+                               iterations * 1e9 / simd_ns,
+                               (scalar_ns / (double)scalar_runs) / (simd_ns / (double)iterations),
+                               (double)iterations * dec_params.Kprime * 1e3 / simd_ns);
+                }
+        }
+
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+fail:
+        bench_fixture_end(&fx);
+        return EXIT_FAILURE;
+}
+
+/*
+ * dispatch: NRLDPC_HOST=auto against the DPU only and the host only, on slots of large BG1 Zc = 96 and small
+ * BG2 Zc = 8 code blocks, decoded by blocking calls then asynchronously. The stand-in adds a round trip to each
+ * request and serves them one at a time: the small blocks are decoded sooner on the host, the large ones on the
+ * DPU as long as the queue ahead of them is short. The routing counters of auto follow each auto run, the last
+ * one with a host budget too small for all the blocks the host would take.
+ */
+static int bench_dispatch(uint32_t iterations)
+{
+        static const struct {
+                const char *name;    /* Printed name */
+                const char *host;    /* NRLDPC_HOST */
+                const char *cpu_pct; /* NRLDPC_HOST_CPU_PCT */
+        } modes[] = {
+                {"dpu", "fallback", "100"},
+                {"host", "always", "100"},
+                {"auto", "auto", "100"},
+                {"auto, 5% of a core", "auto", "5"},
+        };
+        static const struct {
+                uint8_t bg;      /* Base graph */
+                uint16_t z;      /* Lifting size */
+                uint32_t blocks; /* Code blocks of a slot */
+        } kinds[] = {{1, 96, BENCH_DISPATCH_LARGE}, {2, 8, BENCH_DISPATCH_SMALL}};
+        static uint8_t bits[22 * 96];
+        static int8_t llr[2][68 * 96];
+        static int8_t out[BENCH_DISPATCH_LARGE + BENCH_DISPATCH_SMALL][22 * 96 / 8];
+        t_nrLDPC_dec_params dec_params[2];
+        task_ans_t ans[BENCH_DISPATCH_LARGE + BENCH_DISPATCH_SMALL];
+        struct nrLDPC_dispatch_stats stats;
+        struct bench_fixture fx = {0};
+        struct bench_stats slot_stats;
+        unsigned int seed = 1;
+        uint64_t dpu_ns, queue_ns, host_ns, start, elapsed_ns;
+        uint32_t a, m, i, k, j, n;
+        int ret = EXIT_FAILURE;
+
+        /* Defaults only, the stand-in times are set from the command line environment */
+        bench_fixture_loopback(&fx, "20000", "50000", "1");
+        bench_fixture_default(&fx, NRLDPC_ENV_PROGRESS_POLL, "event");
+
+        for (k = 0; k < 2; k++) {
+                dec_params[k] = (t_nrLDPC_dec_params){
+                        .BG = kinds[k].bg,
+                        .Z = kinds[k].z,
+                        .R = 15,
+                        .numMaxIter = BENCH_HOSTDEC_ITERS,
+                        .Kprime = nrLDPC_bg_get(kinds[k].bg)->kb * kinds[k].z,
+                        .outMode = nrLDPC_outMode_BIT,
+                };
+                (void)bench_hostdec_channel(kinds[k].bg, kinds[k].z, nrLDPC_bg_get(kinds[k].bg)->cols, -4.0, &seed,
+                                            bits, llr[k]);
+        }
+
+        slot_stats.samples_ns = calloc(iterations, sizeof(uint64_t));
+        if (slot_stats.samples_ns == NULL)
+                goto out;
+
+        printf("stand-in %s ns per request and %s ns round trip, slots of %u BG1 Zc = 96 and %u BG2 Zc = 8 decodes\n",
+               getenv(NRLDPC_ENV_LOOPBACK_SERVICE_NS),
+               getenv(NRLDPC_ENV_LOOPBACK_RTT_NS),
+               BENCH_DISPATCH_LARGE,
+               BENCH_DISPATCH_SMALL);
+        for (a = 0; a < 2; a++) {
+                printf("\n%s calls, slot latency\n", a == 0 ? "Blocking" : "Asynchronous");
+                bench_stats_header();
+                for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+                        bench_fixture_env(&fx, NRLDPC_ENV_HOST, modes[m].host);
+                        bench_fixture_env(&fx, NRLDPC_ENV_HOST_CPU_PCT, modes[m].cpu_pct);
+                        if (bench_fixture_open(&fx) != 0)
+                                goto out;
+
+                        slot_stats.count = 0;
+                        elapsed_ns = 0;
+                        for (i = 0; i < iterations + BENCH_WARMUP_ITERATIONS; i++) {
+                                /* The large blocks first, the small ones are decoded while the DPU works on them */
+                                start = bench_now_ns();
+                                for (k = 0, n = 0; k < 2; k++) {
+                                        for (j = 0; j < kinds[k].blocks; j++, n++) {
+                                                if (a == 0) {
+                                                        (void)nrLDPC_decod(&dec_params[k], 0, 0, kinds[k].blocks,
+                                                                           llr[k], out[n], NULL, NULL);
+                                                        continue;
+                                                }
+                                                init_task_ans(&ans[n], 1);
+                                                (void)nrLDPC_decod_async(&dec_params[k], 0, 0, kinds[k].blocks,
+                                                                         llr[k], out[n], NULL, NULL, &ans[n]);
+                                        }
+                                }
+                                for (j = 0; j < n && a == 1; j++) {
+                                        join_task_ans(&ans[j]);
+                                        sem_destroy(&ans[j].sem);
+                                }
+                                if (i >= BENCH_WARMUP_ITERATIONS) {
+                                        slot_stats.samples_ns[slot_stats.count] = bench_now_ns() - start;
+                                        elapsed_ns += slot_stats.samples_ns[slot_stats.count++];
+                                }
+                        }
+                        bench_stats_print(modes[m].name, &slot_stats);
+
+                        if (strcmp(modes[m].host, "auto") == 0) {
+                                nrLDPC_dispatch_get_stats(NRLDPC_SERVICE_DECOD, &stats);
+                                printf("  routed %lu to the DPU, %lu to the host: %lu explored, %lu denied by the "
+                                       "budget, %lu and %lu late; host CPU %.1f%%\n",
+                                       (unsigned long)stats.routed[NRLDPC_ROUTE_DPU],
+                                       (unsigned long)stats.routed[NRLDPC_ROUTE_HOST],
+                                       (unsigned long)stats.explored,
+                                       (unsigned long)stats.budget_denied,
+                                       (unsigned long)stats.late[NRLDPC_ROUTE_DPU],
+                                       (unsigned long)stats.late[NRLDPC_ROUTE_HOST],
+                                       100.0 * stats.host_ns / elapsed_ns);
+                                for (k = 0; k < 2; k++) {
+                                        if (nrLDPC_dispatch_estimate(NRLDPC_SERVICE_DECOD, kinds[k].bg, kinds[k].z,
+                                                                     BENCH_HOSTDEC_ITERS, &dpu_ns, &queue_ns,
+                                                                     &host_ns) == false)
+                                                continue;
+                                        printf("  BG%u Zc = %u: DPU %.1f us + %.1f us per request in flight, "
+                                               "host %.1f us\n",
+                                               kinds[k].bg,
+                                               kinds[k].z,
+                                               dpu_ns / 1e3,
+                                               queue_ns / 1e3,
+                                               host_ns / 1e3);
+                                }
+                        }
+                        bench_fixture_close(&fx);
+                }
+        }
+        ret = EXIT_SUCCESS;
+
+out:
+        bench_fixture_end(&fx);
+        free(slot_stats.samples_ns);
+        return ret;
+}
+
+/*
+ * hedge: blocking decodes of BG1 Zc = 64 code blocks on a stand-in that stalls 2 ms on one request in 200, a DPU
+ * hiccup, with a 500 us budget. Without hedging the stalled calls blow the budget, with NRLDPC_HEDGE_PCT the host
+ * decodes them too once the DPU is late. Prints the latency, the p99.9 of the hedge counters and how often the
+ * hedge fired, which path answered first, and the calls answered after their deadline.
+ */
+static int bench_hedge(uint32_t iterations)
+{
+        static const char *const pcts[] = {"0", "50", "25", "10"};
+        static uint8_t bits[22 * BENCH_HEDGE_Z];
+        static int8_t llr[68 * BENCH_HEDGE_Z];
+        static int8_t out[22 * BENCH_HEDGE_Z / 8];
+        t_nrLDPC_dec_params dec_params = {
+                .BG = 1,
+                .Z = BENCH_HEDGE_Z,
+                .R = 13,
+                .numMaxIter = BENCH_HOSTDEC_ITERS,
+                .Kprime = 22 * BENCH_HEDGE_Z,
+                .outMode = nrLDPC_outMode_BIT,
+        };
+        struct nrLDPC_hedge_stats stats;
+        struct bench_fixture fx = {0};
+        struct bench_stats call_stats;
+        unsigned int seed = 1;
+        uint64_t start, deadline_ns;
+        uint32_t late, m, i;
+        char name[32];
+        int ret = EXIT_FAILURE;
+
+        /* Defaults only, the stand-in times are set from the command line environment */
+        bench_fixture_loopback(&fx, "20000", "50000", "1");
+        bench_fixture_default(&fx, NRLDPC_ENV_LOOPBACK_HICCUP_EVERY, "200");
+        bench_fixture_default(&fx, NRLDPC_ENV_LOOPBACK_HICCUP_NS, "2000000");
+        bench_fixture_default(&fx, NRLDPC_ENV_DECOD_BUDGET_US, "500");
+        bench_fixture_default(&fx, NRLDPC_ENV_PROGRESS_POLL, "event");
+
+        (void)bench_hostdec_channel(1, BENCH_HEDGE_Z, nrLDPC_bg_get(1)->cols, 0.0, &seed, bits, llr);
+
+        call_stats.samples_ns = calloc(iterations, sizeof(uint64_t));
+        if (call_stats.samples_ns == NULL)
+                goto out;
+
+        printf("stand-in %s ns per request, %s ns round trip, %s ns stall every %s requests, budget %s us\n",
+               getenv(NRLDPC_ENV_LOOPBACK_SERVICE_NS),
+               getenv(NRLDPC_ENV_LOOPBACK_RTT_NS),
+               getenv(NRLDPC_ENV_LOOPBACK_HICCUP_NS),
+               getenv(NRLDPC_ENV_LOOPBACK_HICCUP_EVERY),
+               getenv(NRLDPC_ENV_DECOD_BUDGET_US));
+        bench_stats_header();
+        for (m = 0; m < sizeof(pcts) / sizeof(pcts[0]); m++) {
+                bench_fixture_env(&fx, NRLDPC_ENV_HEDGE_PCT, pcts[m]);
+                if (bench_fixture_open(&fx) != 0)
+                        goto out;
+
+                call_stats.count = 0;
+                late = 0;
+                for (i = 0; i < iterations + BENCH_WARMUP_ITERATIONS; i++) {
+                        start = bench_now_ns();
+                        deadline_ns = nrLDPC_session_slot_deadline(NRLDPC_SERVICE_DECOD, start);
+                        nrLDPC_session_set_deadline(deadline_ns, NRLDPC_CLASS_DEFAULT);
+                        (void)nrLDPC_decod(&dec_params, 0, 0, 1, llr, out, NULL, NULL);
+                        if (i < BENCH_WARMUP_ITERATIONS)
+                                continue;
+                        call_stats.samples_ns[call_stats.count] = bench_now_ns() - start;
+                        late += start + call_stats.samples_ns[call_stats.count++] > deadline_ns;
+                }
+                nrLDPC_session_set_deadline(0, NRLDPC_CLASS_DEFAULT);
+
+                snprintf(name, sizeof(name), m == 0 ? "no hedge" : "hedge at %s%%", pcts[m]);
+                bench_stats_print(name, &call_stats);
+                if (m != 0) {
+                        nrLDPC_hedge_get_stats(&stats);
+                        printf("  fired %lu of %lu (%.2f%%): host first %lu, DPU first %lu; late %lu; "
+                               "p99.9 %lu us\n",
+                               (unsigned long)stats.fired,
+                               (unsigned long)stats.calls,
+                               stats.calls != 0 ? 100.0 * stats.fired / stats.calls : 0.0,
+                               (unsigned long)stats.host_won,
+                               (unsigned long)stats.dpu_won,
+                               (unsigned long)stats.late,
+                               (unsigned long)(stats.p999_ns / 1000));
+                } else {
+                        printf("  late %u\n", late);
+                }
+                bench_fixture_close(&fx);
+        }
+        ret = EXIT_SUCCESS;
+
+out:
+        bench_fixture_end(&fx);
+        free(call_stats.samples_ns);
+        return ret;
+}
+
+/*
+ * Send the circular buffer positions [start, start + len) of a BG1 codeword over the channel of
+ * bench_awgn_llrs(), one redundancy version of a HARQ transmission: the LLRs of the other positions are 0.
+ *
+ * @z [in]: Lifting size
+ * @cw [in]: Codeword, the (68 - 2) * Zc transmitted bits, one per byte
+ * @start [in]: First position sent
+ * @len [in]: Positions sent, wrapping around the circular buffer
+ * @es_n0_db [in]: Es/N0 in dB
+ * @seed [in/out]: Random seed
+ * @llr [out]: The 68 * Zc LLRs, in the layout of nrLDPC_decod
+ */
+static void bench_harq_channel(uint16_t z,
+                               const uint8_t *cw,
+                               uint32_t start,
+                               uint32_t len,
+                               double es_n0_db,
+                               unsigned int *seed,
+                               int8_t *llr)
+{
+        uint32_t ncb = (NR_LDPC_NCOL_BG1 - NRLDPC_BG_PUNCTURED) * z;
+        uint32_t pos, run;
+
+        memset(llr, 0, (size_t)NR_LDPC_NCOL_BG1 * z);
+        /* One run up to the end of the circular buffer at a time */
+        for (pos = start % ncb; len > 0; pos = 0) {
+                run = ncb - pos < len ? ncb - pos : len;
+                (void)bench_awgn_llrs(cw + pos, run, es_n0_db, seed, llr + NRLDPC_BG_PUNCTURED * z + pos);
+                len -= run;
+        }
+}
+
+/*
+ * harq: transport blocks of one BG1 Zc = 64 code block sent in two halves of the circular buffer at Es/N0 = 0 dB,
+ * the first one at rate 2/3, then the second one, combined with it, on 16 HARQ processes in turn: all first
+ * transmissions, then all retransmissions, then the ACKs releasing the processes. Compares the host combining the
+ * LLRs and sending the whole buffer each time with the buffers kept resident on the DPU (the stand-in), by the LLR
+ * bytes sent and the decoded bits, which must be the same; then with fewer DPU buffers than processes, the
+ * retransmissions missing their buffer; and on the host decoder, the BLER of each transmission.
+ */
+static int bench_harq(uint32_t iterations)
+{
+        static const struct {
+                const char *name;    /* Printed name */
+                const char *host;    /* NRLDPC_HOST */
+                const char *buffers; /* NRLDPC_HARQ_BUFFERS */
+                bool resident;       /* nrLDPC_decod_harq, else combined here and sent with nrLDPC_decod */
+        } modes[] = {
+                {"host combining", "fallback", "256", false},
+                {"DPU resident", "fallback", "256", true},
+                {"DPU resident, 8 buffers", "fallback", "8", true},
+                {"host decoder", "always", "256", true},
+        };
+        static uint8_t bits[BENCH_HARQ_PROCESSES][22 * BENCH_HARQ_Z];
+        static uint8_t cw[BENCH_HARQ_PROCESSES][66 * BENCH_HARQ_Z];
+        static int8_t soft[BENCH_HARQ_PROCESSES][68 * BENCH_HARQ_Z];
+        static int8_t llr[68 * BENCH_HARQ_Z];
+        static int8_t out[22 * BENCH_HARQ_Z];
+        t_nrLDPC_dec_params dec_params = {
+                .BG = 1,
+                .Z = BENCH_HARQ_Z,
+                .R = 13,
+                .numMaxIter = BENCH_HOSTDEC_ITERS,
+                .Kprime = 22 * BENCH_HARQ_Z,
+                .outMode = nrLDPC_outMode_BITINT8,
+        };
+        uint32_t n = 68 * BENCH_HARQ_Z;
+        uint32_t e = 66 * BENCH_HARQ_Z / 2;
+        uint32_t rounds = (iterations + BENCH_HARQ_PROCESSES - 1) / BENCH_HARQ_PROCESSES;
+        uint32_t decodes = rounds * BENCH_HARQ_PROCESSES * 2;
+        uint32_t nbytes = dec_params.Kprime / 8;
+        uint32_t blk_err[2], mismatches, failed = 0;
+        struct nrLDPC_harq_stats stats;
+        struct bench_fixture fx = {0};
+        uint64_t bytes;
+        uint8_t *ref;
+        unsigned int seed;
+        uint32_t m, r, p, t, d, i;
+        int8_t *in;
+        int32_t sum;
+        int ret = EXIT_FAILURE;
+
+        bench_fixture_loopback(&fx, "20000", "50000", NULL);
+
+        /* Decoded bits of the host combining run, the DPU resident runs must give the same */
+        ref = malloc((size_t)decodes * nbytes);
+        if (ref == NULL)
+                goto out;
+
+        printf("%u transport blocks of 1 BG1 Zc = %u code block on %u HARQ processes, 2 transmissions of %u of the %u "
+               "LLRs each, Es/N0 0 dB\n",
+               rounds * BENCH_HARQ_PROCESSES,
+               BENCH_HARQ_Z,
+               BENCH_HARQ_PROCESSES,
+               e,
+               n);
+        printf("%-24s %10s %14s %10s %8s %10s %10s %10s\n", "mode", "decodes", "LLR_bytes/dec", "saved", "misses",
+               "mismatch", "BLER_tx1", "BLER_tx2");
+        for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+                bench_fixture_env(&fx, NRLDPC_ENV_HOST, modes[m].host);
+                bench_fixture_env(&fx, NRLDPC_ENV_HARQ_BUFFERS, modes[m].buffers);
+                if (bench_fixture_open(&fx) != 0)
+                        goto out;
+
+                /* Every run sends the same bits over the same channel */
+                seed = 1;
+                d = 0;
+                mismatches = 0;
+                blk_err[0] = 0;
+                blk_err[1] = 0;
+                for (r = 0; r < rounds; r++) {
+                        for (t = 0; t < 2; t++) {
+                                for (p = 0; p < BENCH_HARQ_PROCESSES; p++, d++) {
+                                        if (t == 0) {
+                                                for (i = 0; i < dec_params.Kprime; i++)
+                                                        bits[p][i] = rand_r(&seed) & 1;
+                                                (void)nrLDPC_host_encod(1, BENCH_HARQ_Z, dec_params.Kprime, 0,
+                                                                        bits[p], false, cw[p]);
+                                        }
+                                        bench_harq_channel(BENCH_HARQ_Z, cw[p], t * e, e, 0.0, &seed, llr);
+
+                                        in = llr;
+                                        if (modes[m].resident == false) {
+                                                /* What OAI does today: combine here, send the whole buffer */
+                                                for (i = 0; i < n; i++) {
+                                                        sum = (t == 0 ? 0 : soft[p][i]) + llr[i];
+                                                        soft[p][i] = sum > 127 ? 127 : sum < -127 ? -127 : sum;
+                                                }
+                                                in = soft[p];
+                                                (void)nrLDPC_decod(&dec_params, p, 0, 1, in, out, NULL, NULL);
+                                        } else {
+                                                (void)nrLDPC_decod_harq(&dec_params, p, 0, 0, t == 0, in, out, NULL,
+                                                                        NULL);
+                                        }
+
+                                        if (m == 0)
+                                                memcpy(ref + (size_t)d * nbytes, out, nbytes);
+                                        else if (m < 3)
+                                                mismatches += memcmp(ref + (size_t)d * nbytes, out, nbytes) != 0;
+                                        else
+                                                blk_err[t] += memcmp(out, bits[p], dec_params.Kprime) != 0;
+                                }
+                        }
+                        for (p = 0; p < BENCH_HARQ_PROCESSES && modes[m].resident == true; p++)
+                                (void)nrLDPC_decod_harq_release(p, 0);
+                }
+
+                nrLDPC_harq_get_stats(&stats);
+                bytes = modes[m].resident ? stats.llr_bytes + stats.calls * sizeof(struct nrLDPC_proto_harq) :
+                                            (uint64_t)decodes * n;
+                if (m < 3)
+                        printf("%-24s %10u %14.0f %9.1f%% %8lu %10u %10s %10s\n",
+                               modes[m].name,
+                               decodes,
+                               (double)bytes / decodes,
+                               100.0 - 100.0 * bytes / ((double)decodes * n),
+                               (unsigned long)stats.missed,
+                               mismatches,
+                               "-",
+                               "-");
+                else
+                        printf("%-24s %10u %14s %10s %8s %10s %10.3f %10.3f\n",
+                               modes[m].name,
+                               decodes,
+                               "-",
+                               "-",
+                               "-",
+                               "-",
+                               (double)blk_err[0] / (decodes / 2),
+                               (double)blk_err[1] / (decodes / 2));
+                /* The DPU resident buffers decode the same LLRs as the host combining */
+                if (m == 1)
+                        failed += mismatches != 0;
+                bench_fixture_close(&fx);
+        }
+        ret = failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+out:
+        bench_fixture_end(&fx);
+        free(ref);
+        return ret;
+}
+
+/*
+ * ratematch: BG1 Zc = 64 code blocks with 56 filler bits, rate matched for 16QAM at code rates from a repetition to
+ * 0.9, the redundancy versions in turn. Compares the rate recovery done on the host, its time per code block and
+ * the N LLRs sent with nrLDPC_decod, with the E LLRs sent with nrLDPC_decod_rm and recovered on the DPU (the
+ * stand-in) while E is below N, NRLDPC_HOST off, by the LLR bytes sent and the decoded bits, which must be the
+ * same; then, on the host decoder, the BLER of the code blocks recovered from their E LLRs, over rv 0 and 3, the
+ * ones decodable by themselves.
+ */
+static int bench_ratematch(uint32_t iterations)
+{
+        static const struct {
+                const char *name; /* Printed code rate */
+                uint32_t e;       /* Rate matched bits, a multiple of BENCH_RM_QM */
+                double es_n0_db;  /* Es/N0 of the channel */
+        } rates[] = {
+                {"0.27", 5000, -2.0},
+                {"1/3", 4056, -1.0},
+                {"1/2", 2704, 2.0},
+                {"2/3", 2028, 4.0},
+                {"0.9", 1500, 7.0},
+        };
+        static const uint8_t rvs[4] = {0, 2, 3, 1};
+        static uint8_t bits[22 * BENCH_RM_Z];
+        static uint8_t cw[66 * BENCH_RM_Z];
+        static uint8_t tx[NRLDPC_PROTO_MAX_PAYLOAD];
+        static int8_t rx[NRLDPC_PROTO_MAX_PAYLOAD];
+        static int8_t llr[68 * BENCH_RM_Z];
+        static int8_t out[22 * BENCH_RM_Z];
+        t_nrLDPC_dec_params dec_params = {
+                .BG = 1,
+                .Z = BENCH_RM_Z,
+                .R = 13,
+                .numMaxIter = BENCH_HOSTDEC_ITERS,
+                .Kprime = 22 * BENCH_RM_Z - BENCH_RM_F,
+                .outMode = nrLDPC_outMode_BITINT8,
+        };
+        struct nrLDPC_proto_rm rm = {
+                .ncb = 66 * BENCH_RM_Z,
+                .f = BENCH_RM_F,
+                .qm = BENCH_RM_QM,
+        };
+        uint32_t n = 68 * BENCH_RM_Z;
+        uint32_t nbytes = dec_params.Kprime / 8;
+        uint32_t mismatches, blk_err, failed = 0;
+        struct bench_fixture fx = {0};
+        struct nrLDPC_rm_stats stats;
+        uint64_t rm_ns, start, sent;
+        unsigned int seed;
+        uint32_t r, m, it, i;
+        uint8_t *ref;
+        int ret = EXIT_FAILURE;
+
+        bench_fixture_loopback(&fx, "20000", "50000", NULL);
+
+        /* Decoded bits of the host recovery run, the DPU recovery run must give the same */
+        ref = malloc((size_t)iterations * nbytes);
+        if (ref == NULL)
+                goto out;
+
+        printf("%u BG1 Zc = %u code blocks per code rate, Kprime = %u, F = %u, Qm = %u, rv 0, 2, 3, 1 in turn, N = %u "
+               "LLRs\n",
+               iterations,
+               BENCH_RM_Z,
+               dec_params.Kprime,
+               BENCH_RM_F,
+               BENCH_RM_QM,
+               n);
+        printf("%-6s %6s %8s %16s %16s %8s %14s %10s %12s\n", "rate", "E", "Es/N0", "host_bytes/dec",
+               "DPU_bytes/dec", "saved", "host_rm_ns/cb", "mismatch", "BLER_rv0/3");
+        for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+                rm.e = rates[r].e;
+                rm_ns = 0;
+                mismatches = 0;
+                blk_err = 0;
+                for (m = 0; m < 3; m++) {
+                        /* Host recovery, DPU recovery with no host decoder to fall back on, then the host decoder */
+                        bench_fixture_env(&fx, NRLDPC_ENV_HOST, m == 0 ? "fallback" : m == 1 ? "off" : "always");
+                        if (bench_fixture_open(&fx) != 0)
+                                goto out;
+
+                        /* Every run sends the same bits over the same channel */
+                        seed = 1;
+                        for (it = 0; it < iterations; it++) {
+                                memset(bits, 0, sizeof(bits));
+                                for (i = 0; i < dec_params.Kprime; i++)
+                                        bits[i] = rand_r(&seed) & 1;
+                                (void)nrLDPC_host_encod(1, BENCH_RM_Z, 22 * BENCH_RM_Z, BENCH_RM_F, bits, false, cw);
+                                rm.rv = rvs[it % 4];
+                                (void)nrLDPC_rm_match(1, BENCH_RM_Z, &rm, cw, tx);
+                                (void)bench_awgn_llrs(tx, rm.e, rates[r].es_n0_db, &seed, rx);
+
+                                if (m == 0) {
+                                        /* What OAI does today: recover the N LLRs here, send them all */
+                                        start = bench_now_ns();
+                                        (void)nrLDPC_rm_recover(1, BENCH_RM_Z, &rm, rx, llr);
+                                        rm_ns += bench_now_ns() - start;
+                                        (void)nrLDPC_decod(&dec_params, 0, 0, 1, llr, out, NULL, NULL);
+                                        memcpy(ref + (size_t)it * nbytes, out, nbytes);
+                                        continue;
+                                }
+
+                                (void)nrLDPC_decod_rm(&dec_params, 0, 0, rm.e, rm.rv, rm.qm, rm.f, rm.ncb, rx, out,
+                                                      NULL, NULL);
+                                if (m == 1)
+                                        mismatches += memcmp(ref + (size_t)it * nbytes, out, nbytes) != 0;
+                                else if (rm.rv == 0 || rm.rv == 3)
+                                        blk_err += memcmp(out, bits, dec_params.Kprime) != 0;
+                        }
+
+                        if (m == 1)
+                                nrLDPC_rm_get_stats(&stats);
+                        bench_fixture_close(&fx);
+                }
+
+                /* From E = N on, the host recovers the code blocks and sends the N LLRs */
+                sent = stats.llr_bytes + stats.calls * sizeof(rm) + stats.host * n;
+
+                printf("%-6s %6u %6.1fdB %16u %16.0f %7.1f%% %14.0f %10u %12.3f\n",
+                       rates[r].name,
+                       rm.e,
+                       rates[r].es_n0_db,
+                       n,
+                       (double)sent / iterations,
+                       100.0 - 100.0 * sent / ((double)iterations * n),
+                       (double)rm_ns / iterations,
+                       mismatches,
+                       (double)blk_err / ((iterations + 1) / 2));
+                /* The DPU recovers the LLRs the host does, and E only travels while it is below N */
+                failed += mismatches != 0 || stats.calls + stats.host != iterations || sent > (uint64_t)iterations * n;
+        }
+        ret = failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+out:
+        bench_fixture_end(&fx);
+        free(ref);
+        return ret;
+}
+
+/*
+ * rmencod: transport blocks of 4 BG1 Zc = 64 segments with 56 filler bits, rate matched for 16QAM at code rates
+ * from 1/3 to 0.9, the redundancy versions in turn, the last two segments Qm bits longer as OAI splits G.
+ * Compares what OAI does today, the N codeword bits returned by nrLDPC_encod and rate matched on the host, with
+ * nrLDPC_encod_rm returning the E bits rate matched on the DPU (the stand-in), blocking and asynchronous, and
+ * with the host encoding them (NRLDPC_HOST=always): bytes returned per segment, host rate matching time per
+ * segment, time per transport block. The E bits must be those of nrLDPC_host_encod and nrLDPC_rm_match.
+ */
+static int bench_rmencod(uint32_t iterations)
+{
+        static const struct {
+                const char *name; /* Printed code rate */
+                uint32_t e;       /* Rate matched bits of the first segments, a multiple of BENCH_RM_QM */
+        } rates[] = {
+                {"1/3", 4056},
+                {"1/2", 2704},
+                {"2/3", 2028},
+                {"0.9", 1500},
+        };
+        static const char *const modes[] = {"codewords+host_rm", "DPU_rm", "DPU_rm_async", "host_rm"};
+        static const uint8_t rvs[4] = {0, 2, 3, 1};
+        static uint8_t packed[BENCH_RMENC_SEGS][22 * BENCH_RM_Z / 8];
+        static uint8_t cw[66 * BENCH_RM_Z];
+        static uint8_t out[BENCH_RMENC_SEGS * 66 * BENCH_RM_Z];
+        static uint8_t ref[BENCH_RMENC_SEGS * 66 * BENCH_RM_Z];
+        static uint8_t rm_out[BENCH_RMENC_SEGS * 66 * BENCH_RM_Z];
+        encoder_implemparams_t enc_params = {
+                .n_segments = BENCH_RMENC_SEGS,
+                .K = 22 * BENCH_RM_Z,
+                .Kb = 22,
+                .Zc = BENCH_RM_Z,
+                .F = BENCH_RM_F,
+                .BG = 1,
+        };
+        nrLDPC_params_per_cb_t perCB[BENCH_RMENC_SEGS];
+        struct nrLDPC_proto_rm rm = {
+                .ncb = 66 * BENCH_RM_Z,
+                .f = BENCH_RM_F,
+                .qm = BENCH_RM_QM,
+        };
+        uint8_t *inputs[BENCH_RMENC_SEGS];
+        uint32_t n = 66 * BENCH_RM_Z;
+        uint32_t mismatches, failed = 0;
+        uint32_t total_e, offset;
+        struct bench_fixture fx = {0};
+        struct nrLDPC_rm_stats stats;
+        uint64_t rm_ns, tb_ns, start, rm_start;
+        char bytes[16], saved[16], host_ns[16], mismatch[16];
+        unsigned int seed;
+        task_ans_t ans;
+        uint32_t r, m, it, c, i;
+        int ret;
+
+        bench_fixture_loopback(&fx, "20000", "50000", NULL);
+        for (c = 0; c < BENCH_RMENC_SEGS; c++)
+                inputs[c] = packed[c];
+
+        printf("%u transport blocks of %u BG1 Zc = %u segments per code rate, K = %u, F = %u, Qm = %u, rv 0, 2, 3, 1 "
+               "in turn, N = %u bits\n",
+               iterations,
+               BENCH_RMENC_SEGS,
+               BENCH_RM_Z,
+               enc_params.K,
+               BENCH_RM_F,
+               BENCH_RM_QM,
+               n);
+        printf("%-6s %6s %-18s %10s %8s %15s %10s %10s\n", "rate", "E", "mode", "bytes/seg", "saved",
+               "host_rm_ns/seg", "us/TB", "mismatch");
+        for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+                total_e = 0;
+                for (c = 0; c < BENCH_RMENC_SEGS; c++) {
+                        perCB[c].E_cb = rates[r].e + (c >= BENCH_RMENC_SEGS - 2 ? BENCH_RM_QM : 0);
+                        total_e += perCB[c].E_cb;
+                }
+
+                for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+                        bench_fixture_env(&fx, NRLDPC_ENV_HOST, m < 3 ? "fallback" : "always");
+                        if (bench_fixture_open(&fx) != 0)
+                                goto fail;
+
+                        /* Every mode encodes the same transport blocks */
+                        seed = 1;
+                        rm_ns = 0;
+                        tb_ns = 0;
+                        mismatches = 0;
+                        for (it = 0; it < iterations; it++) {
+                                for (c = 0; c < BENCH_RMENC_SEGS; c++)
+                                        for (i = 0; i < sizeof(packed[c]); i++)
+                                                packed[c][i] = (uint8_t)rand_r(&seed);
+                                rm.rv = rvs[it % 4];
+
+                                start = bench_now_ns();
+                                if (m == 0) {
+                                        /* What OAI does today: the N codeword bits back, rate matched here */
+                                        ret = nrLDPC_encod(inputs, out, &enc_params);
+                                        rm_start = bench_now_ns();
+                                        for (c = 0, offset = 0; c < BENCH_RMENC_SEGS; offset += rm.e, c++) {
+                                                rm.e = perCB[c].E_cb;
+                                                (void)nrLDPC_rm_match(1, BENCH_RM_Z, &rm, out + c * n, rm_out + offset);
+                                        }
+                                        rm_ns += bench_now_ns() - rm_start;
+                                        tb_ns += bench_now_ns() - start;
+                                } else if (m == 2) {
+                                        init_task_ans(&ans, 1);
+                                        ret = nrLDPC_encod_rm(inputs, out, &enc_params, perCB, rm.rv, rm.qm, rm.ncb,
+                                                              &ans);
+                                        join_task_ans(&ans);
+                                        tb_ns += bench_now_ns() - start;
+                                } else {
+                                        ret = nrLDPC_encod_rm(inputs, out, &enc_params, perCB, rm.rv, rm.qm, rm.ncb,
+                                                              NULL);
+                                        tb_ns += bench_now_ns() - start;
+                                }
+                                if (ret != 0) {
+                                        printf("rmencod: %s encoding failed\n", modes[m]);
+                                        goto fail;
+                                }
+                                /* The stand-in codewords are not real ones, only the rate matched bits are */
+                                if (m == 0)
+                                        continue;
+
+                                for (c = 0, offset = 0; c < BENCH_RMENC_SEGS; offset += rm.e, c++) {
+                                        rm.e = perCB[c].E_cb;
+                                        (void)nrLDPC_host_encod(1, BENCH_RM_Z, enc_params.K, BENCH_RM_F, packed[c],
+                                                                true, cw);
+                                        (void)nrLDPC_rm_match(1, BENCH_RM_Z, &rm, cw, ref + offset);
+                                }
+                                mismatches += memcmp(ref, out, total_e) != 0;
+                        }
+
+                        nrLDPC_rm_get_stats(&stats);
+                        bench_fixture_close(&fx);
+                        /* Nothing crosses PCIe when the host encodes */
+                        snprintf(bytes, sizeof(bytes), "-");
+                        snprintf(saved, sizeof(saved), "-");
+                        snprintf(host_ns, sizeof(host_ns), "0");
+                        snprintf(mismatch, sizeof(mismatch), "%u", mismatches);
+                        if (m == 0) {
+                                snprintf(bytes, sizeof(bytes), "%u", n / 8);
+                                snprintf(mismatch, sizeof(mismatch), "-");
+                                snprintf(host_ns,
+                                         sizeof(host_ns),
+                                         "%.0f",
+                                         (double)rm_ns / iterations / BENCH_RMENC_SEGS);
+                        } else if (m < 3 && stats.encod_segs != 0) {
+                                snprintf(bytes, sizeof(bytes), "%.0f", (double)stats.encod_bytes / stats.encod_segs);
+                                snprintf(saved,
+                                         sizeof(saved),
+                                         "%.1f%%",
+                                         100.0 - 100.0 * stats.encod_bytes / ((double)stats.encod_segs * (n / 8)));
+                        }
+                        printf("%-6s %6u %-18s %10s %8s %15s %10.1f %10s\n",
+                               rates[r].name,
+                               rates[r].e,
+                               modes[m],
+                               bytes,
+                               saved,
+                               host_ns,
+                               tb_ns / 1e3 / iterations,
+                               mismatch);
+                        /* Rate matched where asked, and bit-exact with the host reference */
+                        if (m == 1 || m == 2)
+                                failed += stats.encod_segs != iterations * BENCH_RMENC_SEGS || stats.encod_host != 0;
+                        if (m == 3)
+                                failed += stats.encod_host != iterations * BENCH_RMENC_SEGS;
+                        failed += mismatches != 0;
+                }
+        }
+
+        bench_fixture_end(&fx);
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+fail:
+        bench_fixture_end(&fx);
+        return EXIT_FAILURE;
+}
+
+/**
+ * Decoded bits the stand-in answers, the hard decision of the first Kprime LLRs
+ *
+ * @llr [in]: LLRs
+ * @kprime [in]: Decoded bits, a multiple of 8
+ * @out [out]: Kprime / 8 bytes, packed
+ */
+static void bench_lifting_expected(const int8_t *llr, uint32_t kprime, uint8_t *out)
+{
+        uint32_t i, b;
+
+        for (i = 0; i < kprime / 8; i++) {
+                out[i] = 0;
+                for (b = 0; b < 8; b++)
+                        out[i] |= (llr[i * 8 + b] < 0) << (7 - b);
+        }
+}
+
+/**
+ * Read a staged message, the way the DMA engine does when it is sent
+ *
+ * @slot [in]: Producer slot
+ * @len [in]: Message length
+ * @return: Sum of its 64-bit words
+ */
+static uint64_t bench_lifting_read(const void *slot, uint32_t len)
+{
+        const uint64_t *w = slot;
+        uint64_t sum = 0;
+        uint32_t i;
+
+        for (i = 0; i < len / sizeof(*w); i++)
+                sum += w[i];
+        return sum;
+}
+
+/*
+ * lifting: every lifting size of both base graphs decoded through the DPU (the stand-in), the request messages
+ * of BG1 Zc > 96 now included, with the producer slot class each one stages into; then the time to stage a message
+ * and read it back, batches of BENCH_LIFTING_DEPTH in flight, one size per class, with the producer slots in size
+ * classes and all of the largest message (NRLDPC_SLOT_CLASSES=0), and the slot memory the batch spans.
+ */
+static int bench_lifting(uint32_t iterations)
+{
+        static const uint32_t class_sizes[] = {1024, 4 * 1024, 8 * 1024, NRLDPC_PROTO_MAX_MSG_SIZE};
+        static const struct {
+                uint8_t bg; /* Base graph */
+                uint16_t z; /* Lifting size */
+        } sizes[] = {{2, 16}, {2, 64}, {1, 96}, {1, 384}};
+        static int8_t llr[NRLDPC_BG_MAX_COLS * NRLDPC_BG_MAX_Z];
+        static uint8_t out[22 * NRLDPC_BG_MAX_Z / 8];
+        static uint8_t ref[22 * NRLDPC_BG_MAX_Z / 8];
+        uint32_t slots[BENCH_LIFTING_DEPTH];
+        struct local_mem_pool pool;
+        uint32_t blocks[2][sizeof(class_sizes) / sizeof(class_sizes[0])] = {{0}};
+        uint16_t z_min[2][sizeof(class_sizes) / sizeof(class_sizes[0])] = {{0}};
+        uint16_t z_max[2][sizeof(class_sizes) / sizeof(class_sizes[0])] = {{0}};
+        t_nrLDPC_dec_params dec_params = {
+                .R = 15,
+                .numMaxIter = 8,
+                .outMode = nrLDPC_outMode_BIT,
+        };
+        struct bench_fixture fx = {0};
+        const struct nrLDPC_bg *g;
+        char slot[16], bg1[32], bg2[32];
+        unsigned int seed = 1;
+        uint32_t wrong = 0, checked = 0, failed = 0;
+        uint32_t n, c, i, j, d, m;
+        uint32_t slot_size = 0;
+        uint64_t start, elapsed_ns[2];
+        uint64_t sum = 0;
+        uint8_t *msg;
+        uint16_t z;
+        uint8_t bg;
+
+        /* Every block through the DPU, none decoded on the host */
+        bench_fixture_env(&fx, NRLDPC_ENV_HOST, "off");
+        for (i = 0; i < sizeof(llr); i++)
+                llr[i] = (int8_t)(rand_r(&seed) % 64 - 32);
+
+        /* Coverage: every BG and Zc of TS 38.212 Table 5.3.2-1 */
+        if (bench_fixture_open(&fx) != 0) {
+                bench_fixture_end(&fx);
+                return EXIT_FAILURE;
+        }
+        for (bg = 1; bg <= 2; bg++) {
+                g = nrLDPC_bg_get(bg);
+                for (z = 2; z <= NRLDPC_BG_MAX_Z; z++) {
+                        if (nrLDPC_bg_ils(z) < 0)
+                                continue;
+                        n = g->cols * z;
+                        dec_params.BG = bg;
+                        dec_params.Z = z;
+                        /* Kprime byte aligned, the rest of K filler bits */
+                        dec_params.Kprime = g->kb * z & ~7U;
+                        bench_lifting_expected(llr, dec_params.Kprime, ref);
+                        memset(out, 0, sizeof(out));
+                        if (nrLDPC_decod(&dec_params, 0, 0, 1, llr, (int8_t *)out, NULL, NULL) != EXIT_SUCCESS ||
+                            memcmp(out, ref, dec_params.Kprime / 8) != 0)
+                                wrong++;
+                        checked++;
+                        /* The request message, header and LLRs, takes the smallest class holding it */
+                        for (c = 0; class_sizes[c] < sizeof(struct nrLDPC_proto_hdr) + n; c++)
+                                ;
+                        if (blocks[bg - 1][c]++ == 0)
+                                z_min[bg - 1][c] = z;
+                        z_max[bg - 1][c] = z;
+                }
+        }
+        bench_fixture_end(&fx);
+
+        printf("%u code blocks of BG1/BG2, all 51 lifting sizes, %u wrong\n", checked, wrong);
+        failed += wrong;
+        printf("%-10s %18s %18s\n", "slot", "BG1 Zc", "BG2 Zc");
+        for (c = 0; c < sizeof(class_sizes) / sizeof(class_sizes[0]); c++) {
+                snprintf(slot, sizeof(slot), "%u KiB", class_sizes[c] / 1024);
+                snprintf(bg1, sizeof(bg1), "-");
+                snprintf(bg2, sizeof(bg2), "-");
+                if (blocks[0][c] != 0)
+                        snprintf(bg1, sizeof(bg1), "%u..%u (%u)", z_min[0][c], z_max[0][c], blocks[0][c]);
+                if (blocks[1][c] != 0)
+                        snprintf(bg2, sizeof(bg2), "%u..%u (%u)", z_min[1][c], z_max[1][c], blocks[1][c]);
+                printf("%-10s %18s %18s\n", slot, bg1, bg2);
+        }
+
+        /* Staging: batches of messages copied into producer slots then read, as the DMA does, in both layouts */
+        msg = calloc(1, NRLDPC_PROTO_MAX_MSG_SIZE);
+        if (msg == NULL)
+                return EXIT_FAILURE;
+        for (j = 0; j < NRLDPC_PROTO_MAX_MSG_SIZE; j++)
+                msg[j] = (uint8_t)rand_r(&seed);
+        printf("\n%u batches of %u messages staged in producer slots, then read\n", iterations, BENCH_LIFTING_DEPTH);
+        printf("%-4s %5s %10s %12s %12s %14s %14s\n", "BG", "Zc", "msg_bytes", "class_slot", "classes_ns",
+               "one_size_ns", "slots_KiB");
+        for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+                g = nrLDPC_bg_get(sizes[i].bg);
+                n = sizeof(struct nrLDPC_proto_hdr) + g->cols * sizes[i].z;
+                for (m = 0; m < 2; m++) {
+                        if (init_local_mem_pool(&pool, NULL, NRLDPC_PROTO_MAX_MSG_SIZE, BENCH_LIFTING_DEPTH, m == 1) !=
+                            DOCA_SUCCESS) {
+                                free(msg);
+                                return EXIT_FAILURE;
+                        }
+                        start = 0;
+                        for (j = 0; j < iterations + BENCH_WARMUP_ITERATIONS; j++) {
+                                if (j == BENCH_WARMUP_ITERATIONS)
+                                        start = bench_now_ns();
+                                for (d = 0; d < BENCH_LIFTING_DEPTH; d++) {
+                                        slots[d] = local_mem_pool_get(&pool, n);
+                                        memcpy(local_mem_pool_addr(&pool, slots[d]), msg, n);
+                                }
+                                for (d = 0; d < BENCH_LIFTING_DEPTH; d++) {
+                                        sum += bench_lifting_read(local_mem_pool_addr(&pool, slots[d]), n);
+                                        local_mem_pool_put(&pool, slots[d]);
+                                }
+                        }
+                        elapsed_ns[m] = bench_now_ns() - start;
+                        if (m == 0)
+                                slot_size = local_mem_pool_size(&pool, slots[0]);
+                        clean_local_mem_pool(&pool);
+                }
+                snprintf(slot, sizeof(slot), "%u KiB", slot_size / 1024);
+                printf("%-4u %5u %10u %12s %12.1f %14.1f %7u/%-6u\n",
+                       sizes[i].bg,
+                       sizes[i].z,
+                       n,
+                       slot,
+                       (double)elapsed_ns[0] / ((uint64_t)iterations * BENCH_LIFTING_DEPTH),
+                       (double)elapsed_ns[1] / ((uint64_t)iterations * BENCH_LIFTING_DEPTH),
+                       BENCH_LIFTING_DEPTH * slot_size / 1024,
+                       BENCH_LIFTING_DEPTH * NRLDPC_PROTO_MAX_MSG_SIZE / 1024);
+        }
+        /* Keeps the reads */
+        failed += sum == 1;
+        free(msg);
+
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * The check_crc of OAI's decoder parameters: the CRC pass the host runs on a decoded code block
+ *
+ * @decoded_bytes [in]: Decoded bits, packed
+ * @n [in]: Number of bits, the CRC included
+ * @crc_type [in]: CRC, NRLDPC_CRC24_B only
+ * @return: 1 when the CRC passes, 0 otherwise
+ */
+static int bench_crc_oai(uint8_t *decoded_bytes, uint32_t n, uint8_t crc_type)
+{
+        return crc_type == NRLDPC_CRC24_B && nrLDPC_crc_check(NRLDPC_PROTO_CRC_24B, decoded_bytes, n / 8);
+}
+
+/**
+ * A BG1 Zc = BENCH_CRC_Z code block carrying its CRC24B, sent over the channel of bench_awgn_llrs()
+ *
+ * @es_n0_db [in]: Es/N0 in dB
+ * @seed [in/out]: Random seed
+ * @packed [out]: The 22 * Zc bits of the block, packed, its CRC in the last 24
+ * @llr [out]: The 68 * Zc LLRs, in the layout of nrLDPC_decod
+ */
+static void bench_crc_block(double es_n0_db, unsigned int *seed, uint8_t *packed, int8_t *llr)
+{
+        static uint8_t bits[22 * BENCH_CRC_Z];
+        static uint8_t cw[66 * BENCH_CRC_Z];
+        uint32_t k = 22 * BENCH_CRC_Z;
+        uint32_t crc;
+        uint32_t i;
+
+        for (i = 0; i < k - 24; i++)
+                bits[i] = rand_r(seed) & 1;
+        nrLDPC_bits_pack(bits, k - 24, packed);
+        crc = nrLDPC_crc_compute(NRLDPC_PROTO_CRC_24B, packed, (k - 24) / 8);
+        for (i = 0; i < 24; i++)
+                bits[k - 24 + i] = (crc >> (23 - i)) & 1;
+        nrLDPC_bits_pack(bits, k, packed);
+        (void)nrLDPC_host_encod(1, BENCH_CRC_Z, k, 0, bits, false, cw);
+
+        memset(llr, 0, NRLDPC_BG_PUNCTURED * BENCH_CRC_Z);
+        (void)bench_awgn_llrs(cw, 66 * BENCH_CRC_Z, es_n0_db, seed, llr + NRLDPC_BG_PUNCTURED * BENCH_CRC_Z);
+}
+
+/*
+ * crc: BG1 Zc = 64 code blocks carrying their CRC24B, as the segments of a large transport block, over the AWGN
+ * channel of bench_awgn_llrs() from the waterfall up. Decoded on the DPU (the stand-in, which decodes the
+ * requests checking a CRC with the host decoder) with check_crc set: the iterations the DPU runs before the CRC
+ * passes instead of all numMaxIter, the CRC failures, the wrong bits of the blocks passing it, which must be none,
+ * and the CRC pass per block the host no longer runs. Then the code blocks per second of transport blocks decoded
+ * asynchronously by a queued stand-in whose service time follows the iterations, without and with the CRC.
+ */
+static int bench_crc(uint32_t iterations)
+{
+        static const double snrs[] = {-4.0, -3.5, -3.0, -2.5, -2.0, -1.0};
+        static uint8_t packed[BENCH_CRC_C][22 * BENCH_CRC_Z / 8];
+        static uint8_t out[BENCH_CRC_C][22 * BENCH_CRC_Z / 8];
+        static int8_t llr[BENCH_CRC_C][68 * BENCH_CRC_Z];
+        t_nrLDPC_dec_params dec_params = {
+                .BG = 1,
+                .Z = BENCH_CRC_Z,
+                .R = 15,
+                .numMaxIter = BENCH_HOSTDEC_ITERS,
+                .Kprime = 22 * BENCH_CRC_Z,
+                .outMode = nrLDPC_outMode_BIT,
+                .crc_type = NRLDPC_CRC24_B,
+        };
+        struct nrLDPC_crc_stats before, after;
+        struct bench_fixture fx = {0};
+        task_ans_t ans[BENCH_CRC_C];
+        decode_abort_t ab;
+        unsigned int seed = 1;
+        uint32_t failed = 0, crc_failed, wrong_bits, sum_iter, aborted, tbs;
+        uint64_t start, crc_ns, elapsed_ns;
+        int32_t ret;
+        int sum = 0;
+        uint32_t i, b, j, m;
+
+        /* The CRC itself: a clean block passes it, the same block with one bit flipped does not */
+        bench_crc_block(10.0, &seed, packed[0], llr[0]);
+        memcpy(out[0], packed[0], sizeof(out[0]));
+        out[0][17] ^= 0x10;
+        j = bench_crc_oai(packed[0], dec_params.Kprime, NRLDPC_CRC24_B) == 1 &&
+            bench_crc_oai(out[0], dec_params.Kprime, NRLDPC_CRC24_B) == 0;
+        printf("CRC24B of a clean code block: %s\n", j ? "pass, fails with one bit flipped" : "WRONG");
+        failed += !j;
+
+        bench_fixture_env(&fx, NRLDPC_ENV_HOST, "off");
+        if (bench_fixture_open(&fx) != 0)
+                goto fail;
+
+        printf("\nBG1 Zc = %u, K = %d with CRC24B, rate 1/3, BPSK over AWGN, %u iterations max, %u blocks a point\n",
+               BENCH_CRC_Z,
+               dec_params.Kprime,
+               BENCH_HOSTDEC_ITERS,
+               iterations);
+        printf("%8s %10s %10s %10s %12s %12s %14s\n", "Es/N0", "DPU_iters", "no_CRC", "CRC_fail", "wrong_bits",
+               "dpu_counted", "host_crc_ns");
+        dec_params.check_crc = bench_crc_oai;
+        for (i = 0; i < sizeof(snrs) / sizeof(snrs[0]); i++) {
+                crc_failed = 0;
+                wrong_bits = 0;
+                sum_iter = 0;
+                nrLDPC_crc_get_stats(&before);
+                for (b = 0; b < iterations; b++) {
+                        bench_crc_block(snrs[i], &seed, packed[0], llr[0]);
+                        ret = nrLDPC_decod(&dec_params, 0, 0, 1, llr[0], (int8_t *)out[0], NULL, NULL);
+                        if (ret < 0 || ret > BENCH_HOSTDEC_ITERS) {
+                                crc_failed++;
+                                sum_iter += BENCH_HOSTDEC_ITERS;
+                                continue;
+                        }
+                        sum_iter += ret;
+                        for (j = 0; j < sizeof(out[0]); j++)
+                                wrong_bits += __builtin_popcount(out[0][j] ^ packed[0][j]);
+                }
+                nrLDPC_crc_get_stats(&after);
+
+                /* The pass OAI runs on each block when the decoder does not check the CRC */
+                start = bench_now_ns();
+                for (b = 0; b < iterations; b++)
+                        sum += bench_crc_oai(out[0], dec_params.Kprime, NRLDPC_CRC24_B);
+                crc_ns = bench_now_ns() - start;
+
+                printf("%8.1f %10.2f %10u %10.2e %12u %12lu %14.0f\n",
+                       snrs[i],
+                       (double)sum_iter / iterations,
+                       BENCH_HOSTDEC_ITERS,
+                       (double)crc_failed / iterations,
+                       wrong_bits,
+                       (unsigned long)(after.dpu_blocks - before.dpu_blocks),
+                       (double)crc_ns / iterations);
+                failed += wrong_bits != 0 || after.dpu_blocks - before.dpu_blocks != iterations;
+        }
+        bench_fixture_close(&fx);
+
+        /*
+         * Defaults only, the stand-in times are set from the command line environment. The stand-in decodes the
+         * requests checking a CRC on the host before it queues them: its service time is kept well above that
+         */
+        bench_fixture_loopback(&fx, "400000", NULL, "1");
+        printf("\nTransport blocks of %u code blocks, asynchronous decodes, stand-in %s ns per %u iterations\n",
+               BENCH_CRC_C,
+               getenv(NRLDPC_ENV_LOOPBACK_SERVICE_NS),
+               BENCH_HOSTDEC_ITERS);
+        printf("%8s %8s %12s %10s %12s %10s\n", "Es/N0", "CRC", "cb/s", "TB_abort", "DPU_decoded", "speedup");
+        tbs = iterations / BENCH_CRC_C + 1;
+        pthread_mutex_init(&ab.mutex_failure, NULL);
+        for (i = 0; i < 2; i++) {
+                for (b = 0; b < BENCH_CRC_C; b++)
+                        bench_crc_block(i == 0 ? -3.5 : -2.0, &seed, packed[b], llr[b]);
+                for (m = 0; m < 2; m++) {
+                        dec_params.check_crc = m == 0 ? NULL : bench_crc_oai;
+                        if (bench_fixture_open(&fx) != 0) {
+                                pthread_mutex_destroy(&ab.mutex_failure);
+                                goto fail;
+                        }
+                        aborted = 0;
+                        nrLDPC_crc_get_stats(&before);
+                        start = bench_now_ns();
+                        for (j = 0; j < tbs; j++) {
+                                ab.failed = false;
+                                for (b = 0; b < BENCH_CRC_C; b++) {
+                                        init_task_ans(&ans[b], 1);
+                                        (void)nrLDPC_decod_async(&dec_params, 0, 0, BENCH_CRC_C, llr[b],
+                                                                 (int8_t *)out[b], NULL, &ab, &ans[b]);
+                                }
+                                for (b = 0; b < BENCH_CRC_C; b++)
+                                        join_task_ans(&ans[b]);
+                                aborted += nrLDPC_session_aborted(&ab);
+                        }
+                        elapsed_ns = bench_now_ns() - start;
+                        nrLDPC_crc_get_stats(&after);
+                        if (m == 0)
+                                crc_ns = elapsed_ns;
+                        /* The blocks of an aborted transport block still queued are dropped, not decoded */
+                        printf("%8.1f %8s %12.0f %10u %12lu %9.2fx\n",
+                               i == 0 ? -3.5 : -2.0,
+                               m == 0 ? "off" : "CRC24B",
+                               (double)tbs * BENCH_CRC_C * 1e9 / elapsed_ns,
+                               aborted,
+                               m == 0 ? (unsigned long)tbs * BENCH_CRC_C
+                                      : (unsigned long)(after.dpu_blocks - before.dpu_blocks),
+                               (double)crc_ns / elapsed_ns);
+                        bench_fixture_close(&fx);
+                }
+        }
+        pthread_mutex_destroy(&ab.mutex_failure);
+        bench_fixture_end(&fx);
+
+        /* Keeps the CRC passes */
+        failed += sum == -1;
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+fail:
+        bench_fixture_end(&fx);
+        return EXIT_FAILURE;
+}
+
+/*
+ * features: the client against servers that do not serve the whole protocol, emulated by the stand-in: one
+ * announcing every feature, one announcing none (NRLDPC_LOOPBACK_FEATURES=0) and one of an older version
+ * (NRLDPC_LOOPBACK_VERSION). Each one gets HARQ decodes, rate matched decodes and encodes, CRC checked decodes and
+ * transport blocks aborted with code blocks in flight, NRLDPC_HOST fallback. The client must send no request the
+ * server refuses and do the rest on the host; the rate matched bits are those of nrLDPC_rm_encod whoever computes
+ * them. With NRLDPC_HOST off, the server of an older version fails the calls.
+ */
+static int bench_features(uint32_t iterations)
+{
+        static const struct {
+                const char *name;     /* Printed name */
+                const char *features; /* NRLDPC_LOOPBACK_FEATURES */
+                const char *version;  /* NRLDPC_LOOPBACK_VERSION, NULL for NRLDPC_PROTO_VERSION */
+        } servers[] = {
+                {"all features", "0x3f", NULL},
+                {"no feature", "0", NULL},
+                {"older version", "0x3f", "9"},
+        };
+        static uint8_t bits[22 * BENCH_RM_Z];
+        static uint8_t cw[66 * BENCH_RM_Z];
+        static uint8_t tx[66 * BENCH_RM_Z];
+        static int8_t rx[66 * BENCH_RM_Z];
+        static int8_t llr[68 * BENCH_RM_Z];
+        static int8_t out[BENCH_ABORT_C][22 * BENCH_RM_Z];
+        static uint8_t packed[22 * BENCH_RM_Z / 8];
+        static uint8_t enc_out[66 * BENCH_RM_Z];
+        static uint8_t enc_ref[66 * BENCH_RM_Z];
+        t_nrLDPC_dec_params dec_params = {
+                .BG = 1,
+                .Z = BENCH_RM_Z,
+                .R = 13,
+                .numMaxIter = BENCH_HOSTDEC_ITERS,
+                .Kprime = 22 * BENCH_RM_Z,
+                .outMode = nrLDPC_outMode_BITINT8,
+        };
+        t_nrLDPC_dec_params crc_params = {
+                .BG = 1,
+                .Z = BENCH_CRC_Z,
+                .R = 15,
+                .numMaxIter = BENCH_HOSTDEC_ITERS,
+                .Kprime = 22 * BENCH_CRC_Z,
+                .outMode = nrLDPC_outMode_BIT,
+                .crc_type = NRLDPC_CRC24_B,
+                .check_crc = bench_crc_oai,
+        };
+        encoder_implemparams_t enc_params = {
+                .n_segments = 1,
+                .K = 22 * BENCH_RM_Z,
+                .Kb = 22,
+                .Zc = BENCH_RM_Z,
+                .BG = 1,
+        };
+        struct nrLDPC_proto_rm rm = {
+                .e = 2704,
+                .ncb = 66 * BENCH_RM_Z,
+                .qm = BENCH_RM_QM,
+        };
+        nrLDPC_params_per_cb_t perCB = {.E_cb = 2704};
+        uint8_t *inputs[1] = {packed};
+        uint32_t e = 66 * BENCH_RM_Z / 2;
+        struct nrLDPC_harq_stats harq;
+        struct nrLDPC_rm_stats rms;
+        struct nrLDPC_crc_stats crc;
+        struct bench_fixture fx = {0};
+        struct nrLDPC_session *session;
+        task_ans_t ans[BENCH_ABORT_C];
+        decode_abort_t ab;
+        uint64_t refused, served, cancelled;
+        uint32_t features, failures, failed = 0;
+        unsigned int seed;
+        uint32_t s, it, t, c, i;
+        int32_t ret;
+
+        printf("%u calls of each kind per server: HARQ (2 transmissions), rate matched decode and encode, CRC24B, "
+               "transport blocks of %u aborted after block 1\n",
+               iterations,
+               BENCH_ABORT_C);
+        printf("%-14s %8s %8s %9s %8s %10s %8s %9s %10s %9s\n", "server", "features", "refused", "HARQ_DPU",
+               "RM_DPU", "RMenc_DPU", "CRC_DPU", "CRC_host", "cancelled", "failures");
+        bench_fixture_env(&fx, NRLDPC_ENV_HOST, "fallback");
+        for (s = 0; s < sizeof(servers) / sizeof(servers[0]); s++) {
+                bench_fixture_env(&fx, NRLDPC_ENV_LOOPBACK_FEATURES, servers[s].features);
+                bench_fixture_env(&fx, NRLDPC_ENV_LOOPBACK_VERSION, servers[s].version);
+                if (bench_fixture_open(&fx) != 0)
+                        goto fail;
+                features = nrLDPC_session_features(NRLDPC_SERVICE_DECOD);
+                pthread_mutex_init(&ab.mutex_failure, NULL);
+
+                seed = 1;
+                failures = 0;
+                for (it = 0; it < iterations; it++) {
+                        for (i = 0; i < dec_params.Kprime; i++)
+                                bits[i] = rand_r(&seed) & 1;
+                        (void)nrLDPC_host_encod(1, BENCH_RM_Z, dec_params.Kprime, 0, bits, false, cw);
+
+                        /* HARQ: a first transmission and a retransmission of the other half */
+                        for (t = 0; t < 2; t++) {
+                                bench_harq_channel(BENCH_RM_Z, cw, t * e, e, 10.0, &seed, llr);
+                                ret = nrLDPC_decod_harq(&dec_params, it % BENCH_HARQ_PROCESSES, 0, 0, t == 0, llr,
+                                                        out[0], NULL, NULL);
+                                failures += ret != EXIT_SUCCESS;
+                        }
+                        (void)nrLDPC_decod_harq_release(it % BENCH_HARQ_PROCESSES, 0);
+
+                        /* Rate matched decode, E below N */
+                        rm.rv = it % 4;
+                        (void)nrLDPC_rm_match(1, BENCH_RM_Z, &rm, cw, tx);
+                        (void)bench_awgn_llrs(tx, rm.e, 10.0, &seed, rx);
+                        ret = nrLDPC_decod_rm(&dec_params, 0, 0, rm.e, rm.rv, rm.qm, rm.f, rm.ncb, rx, out[0], NULL,
+                                              NULL);
+                        failures += ret != EXIT_SUCCESS;
+
+                        /* Rate matched encode, bit-exact with the host */
+                        nrLDPC_bits_pack(bits, enc_params.K, packed);
+                        ret = nrLDPC_encod_rm(inputs, enc_out, &enc_params, &perCB, rm.rv, rm.qm, rm.ncb, NULL);
+                        (void)nrLDPC_rm_encod(1, BENCH_RM_Z, enc_params.K, &rm, packed, true, enc_ref);
+                        failures += ret != 0 || memcmp(enc_out, enc_ref, rm.e) != 0;
+
+                        /* CRC: the iterations, or numMaxIter + 1 when it fails */
+                        bench_crc_block(10.0, &seed, packed, llr);
+                        ret = nrLDPC_decod(&crc_params, 0, 0, 1, llr, out[0], NULL, NULL);
+                        failures += ret < 0 || ret > BENCH_HOSTDEC_ITERS + 1;
+
+                        /* Transport block aborted once block 1 completes */
+                        ab.failed = false;
+                        for (c = 0; c < BENCH_ABORT_C; c++) {
+                                init_task_ans(&ans[c], 1);
+                                (void)nrLDPC_decod_async(&dec_params, 0, 0, BENCH_ABORT_C, llr, out[c], NULL, &ab,
+                                                         &ans[c]);
+                        }
+                        join_task_ans(&ans[1]);
+                        pthread_mutex_lock(&ab.mutex_failure);
+                        ab.failed = true;
+                        pthread_mutex_unlock(&ab.mutex_failure);
+                        for (c = 0; c < BENCH_ABORT_C; c++) {
+                                if (c != 1)
+                                        join_task_ans(&ans[c]);
+                                sem_destroy(&ans[c].sem);
+                        }
+                }
+
+                session = nrLDPC_session_get();
+                if (session == NULL) {
+                        pthread_mutex_destroy(&ab.mutex_failure);
+                        goto fail;
+                }
+                refused = atomic_load(&session->services[NRLDPC_SERVICE_DECOD].standin.refused) +
+                          atomic_load(&session->services[NRLDPC_SERVICE_ENCOD].standin.refused);
+                served = atomic_load(&session->services[NRLDPC_SERVICE_DECOD].standin.served) +
+                         atomic_load(&session->services[NRLDPC_SERVICE_ENCOD].standin.served);
+                cancelled = session->services[NRLDPC_SERVICE_DECOD].cancelled;
+                nrLDPC_harq_get_stats(&harq);
+                nrLDPC_rm_get_stats(&rms);
+                nrLDPC_crc_get_stats(&crc);
+                bench_fixture_close(&fx);
+                pthread_mutex_destroy(&ab.mutex_failure);
+
+                printf("%-14s %#8x %8lu %9lu %8lu %10lu %8lu %9lu %10lu %9u\n",
+                       servers[s].name,
+                       features,
+                       (unsigned long)refused,
+                       (unsigned long)harq.calls,
+                       (unsigned long)rms.calls,
+                       (unsigned long)rms.encod_segs,
+                       (unsigned long)crc.dpu_blocks,
+                       (unsigned long)crc.host_blocks,
+                       (unsigned long)cancelled,
+                       failures);
+                /* Nothing the server does not serve is sent to it, and every call is answered */
+                failed += refused != 0 || failures != 0;
+                if (s == 0)
+                        failed += harq.calls != 2 * iterations || rms.calls != iterations ||
+                                  rms.encod_segs != iterations || crc.dpu_blocks != iterations;
+                else if (s == 1)
+                        failed += harq.calls != 0 || rms.calls != 0 || rms.encod_segs != 0 || crc.dpu_blocks != 0 ||
+                                  crc.host_blocks != iterations || cancelled != 0;
+                else
+                        failed += features != 0 || served != 0;
+        }
+
+        /* Without the host to fall back on, a server of another version serves nothing */
+        bench_fixture_env(&fx, NRLDPC_ENV_HOST, "off");
+        if (bench_fixture_open(&fx) != 0)
+                goto fail;
+        ret = nrLDPC_decod_rm(&dec_params, 0, 0, rm.e, rm.rv, rm.qm, rm.f, rm.ncb, rx, out[0], NULL, NULL);
+        bench_fixture_end(&fx);
+        printf("older version, NRLDPC_HOST off: decoding %s\n", ret == EXIT_SUCCESS ? "SUCCEEDED" : "fails");
+        failed += ret == EXIT_SUCCESS;
+
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+fail:
+        bench_fixture_end(&fx);
+        return EXIT_FAILURE;
+}
+
+struct bench_entry {
+        const char *name;                   /* Benchmark name given on the command line */
+        int (*run)(uint32_t iterations);    /* Benchmark function */
+        const char *help;                   /* One line description */
+};
+
+static const struct bench_entry benches[] = {
+        {"setup", bench_setup, "per call latency: per-call client setup vs persistent session"},
+        {"slab", bench_slab, "memory registrations per request, must be zero after warm-up"},
+        {"pipeline", bench_pipeline, "encoder throughput with 1..recv_depth outstanding requests"},
+        {"proto", bench_proto, "wire bytes and serialization cost, legacy structs vs nrLDPC_proto"},
+        {"bits", bench_bits, "encoder bit pack/unpack, scalar vs SIMD kernels"},
+        {"async", bench_async, "encoder code blocks/s, blocking calls vs async submissions joined on task_ans_t"},
+        {"segments", bench_segments, "encoder code blocks/s, one call per segment vs one per transport block"},
+        {"poll", bench_poll, "request latency histogram, sleep-poll vs busy-poll data path and progress thread"},
+        {"pe", bench_pe, "doca_pe_progress calls per request, one PE per data path vs one per context"},
+        {"event", bench_event, "progress thread CPU and p99 latency, polling vs event-driven vs adaptive modes"},
+        {"threads", bench_threads, "decoder code blocks/s of 1..16 threads: shared, channel per thread, ring"},
+        {"credits", bench_credits, "encoder requests/s and would-block count with 4..64 server credits"},
+        {"edf", bench_edf, "decoder deadline-miss rate under 0.8..1.4 load, FIFO vs EDF scheduling"},
+        {"coalesce", bench_coalesce, "decoder code blocks/s and latency, coalescing off vs 5..20 us windows"},
+        {"abort", bench_abort, "DPU code blocks decoded when block 1 of a transport block fails: ignore, drop, cancel"},
+        {"hostenc", bench_hostenc, "host CPU encoder: H check of all BG/Zc, routing, code blocks/s scalar vs SIMD"},
+        {"hostdec", bench_hostdec, "host CPU decoder: scalar vs SIMD, routing, BLER vs Es/N0 over AWGN, code blocks/s"},
+        {"dispatch", bench_dispatch, "decoder slots, DPU only vs host only vs NRLDPC_HOST=auto, routing counters"},
+        {"hedge", bench_hedge, "decoder latency with DPU hiccups, no hedge vs host decoding at 10..50% of the budget"},
+        {"harq", bench_harq, "HARQ retransmissions: LLR bytes sent, host combining vs DPU resident soft buffers"},
+        {"ratematch", bench_ratematch, "rate recovery: LLR bytes and host time, recovered on the host vs on the DPU"},
+        {"rmencod", bench_rmencod, "rate matching: bytes and host time, codewords rate matched on the host vs the DPU"},
+        {"lifting", bench_lifting, "decoder: all BG/Zc through the DPU, staging in size-classed vs one-size slots"},
+        {"crc", bench_crc, "decoder: code block CRC checked on the DPU, iterations run, failures, host CRC time"},
+        {"features", bench_features, "protocol negotiation: servers without features or of an older version"},
+};
+
+/*
+ * Component: High PHY layer of the vDU.
+ *
+ * vdu_ldpc_bench - Benchmarks of the LDPC offloading library through the OAI interface.
+ * Runs against the DPU servers, or against the in-process stand-in server when NRLDPC_LOOPBACK=1
+ * (NRLDPC_LOOPBACK_SERVICE_NS / NRLDPC_LOOPBACK_CONNECT_NS emulate the DPU processing and connection times).
+ *
+ * Command line:        $./vdu_ldpc_bench <benchmark> [iterations]
+ *
+ * @return: EXIT_SUCCESS on success and EXIT_FAILURE otherwise
+ */
+int main(int argc, char **argv)
+{
+        uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+        size_t i;
+
+        if (argc < 2) {
+                printf("Usage: %s <benchmark> [iterations]\n", argv[0]);
+                for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++)
+                        printf("  %-12s %s\n", benches[i].name, benches[i].help);
+                return EXIT_FAILURE;
+        }
+
+        if (argc > 2)
+                iterations = (uint32_t)strtoul(argv[2], NULL, 0);
+        if (iterations == 0)
+                iterations = 1;
+
+        for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+                if (strcmp(argv[1], benches[i].name) == 0)
+                        return benches[i].run(iterations);
+        }
+
+        printf("Unknown benchmark '%s'\n", argv[1]);
+        return EXIT_FAILURE;
+}
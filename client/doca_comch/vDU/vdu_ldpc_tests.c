@@ -0,0 +1,648 @@
+/*
+ * Unit tests of the host side building blocks of the LDPC offloading library: CRC, rate matching and recovery,
+ * HARQ soft buffers, wire protocol and host encoder. They need neither a DPU nor the stand-in.
+ *
+ * Author: Vlademir Brusse
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nrLDPC_defs.h>
+
+#include "nrLDPC_bg.h"
+#include "nrLDPC_bits.h"
+#include "nrLDPC_crc.h"
+#include "nrLDPC_harq.h"
+#include "nrLDPC_host_encod.h"
+#include "nrLDPC_proto.h"
+#include "nrLDPC_ratematch.h"
+
+#define TEST_LIFTING_SIZES 51 /* Lifting sizes of TS 38.212 Table 5.3.2-1 */
+#define TEST_BG1_ENTRIES 316  /* Circulants of BG1 */
+#define TEST_BG2_ENTRIES 197  /* Circulants of BG2 */
+#define TEST_RM_LLR 50        /* Magnitude of the rate matched LLRs, three repetitions saturate */
+#define TEST_HARQ_N 16        /* LLRs of the code blocks of the harq tests */
+
+/* Fail the running test when cond does not hold */
+#define TEST_CHECK(cond) \
+        do { \
+                if (!(cond)) { \
+                        printf("  %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+                        return 1; \
+                } \
+        } while (0)
+
+/*
+ * Next value of the test random sequence
+ *
+ * @seed [in/out]: State
+ * @return: 15 random bits
+ */
+static uint32_t test_rand(uint32_t *seed)
+{
+        *seed = *seed * 1103515245u + 12345u;
+        return (*seed >> 16) & 0x7fff;
+}
+
+/*
+ * CRC as TS 38.212 5.1 defines it, one bit at a time: the remainder of the division of the bits, MSB first,
+ * followed by len zeros, by the generator polynomial
+ *
+ * @poly [in]: Generator polynomial without its highest term
+ * @len [in]: Degree of the polynomial, bits of the CRC
+ * @bytes [in]: Bytes
+ * @num [in]: Number of bytes
+ * @return: CRC
+ */
+static uint32_t test_crc_ref(uint32_t poly, uint32_t len, const uint8_t *bytes, uint32_t num)
+{
+        uint32_t mask = (1u << len) - 1;
+        uint32_t reg = 0;
+        uint32_t i, b, top;
+
+        for (i = 0; i < num; i++) {
+                for (b = 0; b < 8; b++) {
+                        top = (reg >> (len - 1) & 1) ^ (bytes[i] >> (7 - b) & 1);
+                        reg = (reg << 1) & mask;
+                        if (top != 0)
+                                reg ^= poly;
+                }
+        }
+        return reg;
+}
+
+/*
+ * crc: CRC24A, CRC24B and CRC16 against their check values and the polynomials of TS 38.212 5.1, and the check of
+ * blocks carrying their CRC
+ */
+static int test_crc(void)
+{
+        /* g(D) of TS 38.212 5.1, from their terms: gCRC24A, gCRC24B and gCRC16 */
+        const uint32_t poly[3] = {
+                1u << 23 | 1u << 18 | 1u << 17 | 1u << 14 | 1u << 11 | 1u << 10 | 1u << 7 | 1u << 6 | 1u << 5 |
+                        1u << 4 | 1u << 3 | 1u << 1 | 1u,
+                1u << 23 | 1u << 6 | 1u << 5 | 1u << 1 | 1u,
+                1u << 12 | 1u << 5 | 1u,
+        };
+        const uint8_t crcs[3] = {NRLDPC_PROTO_CRC_24A, NRLDPC_PROTO_CRC_24B, NRLDPC_PROTO_CRC_16};
+        const uint32_t lens[3] = {24, 24, 16};
+        const uint32_t check[3] = {0xcde703, 0x23ef52, 0x31c3}; /* Of "123456789", CRC-24/LTE-A, -LTE-B, -XMODEM */
+        uint8_t block[256 + 3];
+        uint32_t seed = 1;
+        uint32_t c, len, i, crc;
+
+        TEST_CHECK(nrLDPC_crc_len(NRLDPC_PROTO_CRC_NONE) == 0);
+        TEST_CHECK(nrLDPC_crc_compute(NRLDPC_PROTO_CRC_NONE, (const uint8_t *)"123456789", 9) == 0);
+        for (c = 0; c < 3; c++) {
+                TEST_CHECK(nrLDPC_crc_len(crcs[c]) == lens[c]);
+                TEST_CHECK(nrLDPC_crc_compute(crcs[c], (const uint8_t *)"123456789", 9) == check[c]);
+                TEST_CHECK(test_crc_ref(poly[c], lens[c], (const uint8_t *)"123456789", 9) == check[c]);
+
+                /* Every length around the 4 bytes steps of the tables */
+                for (len = 0; len <= 256; len++) {
+                        for (i = 0; i < len; i++)
+                                block[i] = (uint8_t)test_rand(&seed);
+                        crc = nrLDPC_crc_compute(crcs[c], block, len);
+                        TEST_CHECK(crc == test_crc_ref(poly[c], lens[c], block, len));
+                        if (len == 0)
+                                continue;
+
+                        /* The CRC follows the block MSB first, as TS 38.212 5.1 attaches it */
+                        for (i = 0; i < lens[c] / 8; i++)
+                                block[len + i] = (uint8_t)(crc >> (lens[c] - 8 * (i + 1)));
+                        TEST_CHECK(nrLDPC_crc_check(crcs[c], block, len + lens[c] / 8));
+                        i = test_rand(&seed) % ((len + lens[c] / 8) * 8);
+                        block[i / 8] ^= (uint8_t)(0x80 >> (i % 8));
+                        TEST_CHECK(!nrLDPC_crc_check(crcs[c], block, len + lens[c] / 8));
+                }
+                /* A block no longer than its CRC carries none */
+                memset(block, 0, sizeof(block));
+                TEST_CHECK(!nrLDPC_crc_check(crcs[c], block, lens[c] / 8));
+        }
+
+        return 0;
+}
+
+/*
+ * rm_k0: k0 of TS 38.212 Table 5.4.2.1-2, full circular buffers and limited ones (LBRM)
+ */
+static int test_rm_k0(void)
+{
+        const uint32_t bg1[4] = {0, 17, 33, 56};
+        const uint32_t bg2[4] = {0, 13, 25, 43};
+        uint8_t rv;
+
+        for (rv = 0; rv < 4; rv++) {
+                TEST_CHECK(nrLDPC_rm_k0(1, 384, 66 * 384, rv) == bg1[rv] * 384);
+                TEST_CHECK(nrLDPC_rm_k0(1, 13, 66 * 13, rv) == bg1[rv] * 13);
+                TEST_CHECK(nrLDPC_rm_k0(2, 384, 50 * 384, rv) == bg2[rv] * 384);
+                TEST_CHECK(nrLDPC_rm_k0(2, 7, 50 * 7, rv) == bg2[rv] * 7);
+        }
+
+        /* Ncb = 2/3 N: floor(17 * 2/3) = 11, 22 and floor(56 * 2/3) = 37 Zc */
+        TEST_CHECK(nrLDPC_rm_k0(1, 384, 16896, 0) == 0);
+        TEST_CHECK(nrLDPC_rm_k0(1, 384, 16896, 1) == 11 * 384);
+        TEST_CHECK(nrLDPC_rm_k0(1, 384, 16896, 2) == 22 * 384);
+        TEST_CHECK(nrLDPC_rm_k0(1, 384, 16896, 3) == 37 * 384);
+
+        return 0;
+}
+
+/*
+ * Bit selection and interleaving of TS 38.212 5.4.2.1 and 5.4.2.2, as written there: the E bits from k0 on,
+ * wrapping around at Ncb and skipping the filler bits, then written row by row into Qm rows and read by columns
+ *
+ * @bg [in]: Base graph
+ * @z [in]: Lifting size
+ * @rm [in]: Rate matching
+ * @pos [out]: Position in the codeword of each of the E bits sent, in the order they are sent
+ */
+static void test_rm_ref(uint8_t bg, uint16_t z, const struct nrLDPC_proto_rm *rm, uint32_t *pos)
+{
+        static uint32_t selected[NRLDPC_RM_MAX_LLRS * 4];
+        const struct nrLDPC_bg *g = nrLDPC_bg_get(bg);
+        uint32_t filler_end = (uint32_t)(g->kb - NRLDPC_BG_PUNCTURED) * z;
+        uint32_t filler_start = filler_end - rm->f;
+        uint32_t k0 = nrLDPC_rm_k0(bg, z, rm->ncb, rm->rv);
+        uint32_t rows = rm->e / rm->qm;
+        uint32_t k = 0, j = 0, p, i;
+
+        while (k < rm->e) {
+                p = (k0 + j++) % rm->ncb;
+                if (p < filler_start || p >= filler_end)
+                        selected[k++] = p;
+        }
+        for (i = 0; i < rm->qm; i++)
+                for (j = 0; j < rows; j++)
+                        pos[i + j * rm->qm] = selected[i * rows + j];
+}
+
+/*
+ * One rate matching round trip: the selection of nrLDPC_rm_match() and the LLRs nrLDPC_rm_recover() gives back,
+ * against test_rm_ref()
+ *
+ * @bg [in]: Base graph
+ * @z [in]: Lifting size
+ * @rm [in]: Rate matching
+ * @seed [in/out]: Random bits
+ * @return: 0 when both match, 1 otherwise
+ */
+static int test_rm_one(uint8_t bg, uint16_t z, const struct nrLDPC_proto_rm *rm, uint32_t *seed)
+{
+        static uint8_t cw[NRLDPC_PROTO_ENCOD_MAX_N];
+        static uint8_t bits[NRLDPC_RM_MAX_LLRS * 4];
+        static uint32_t pos[NRLDPC_RM_MAX_LLRS * 4];
+        static int8_t in[NRLDPC_RM_MAX_LLRS * 4];
+        static int8_t llrs[NRLDPC_RM_MAX_LLRS];
+        static int8_t ref[NRLDPC_RM_MAX_LLRS];
+        const struct nrLDPC_bg *g = nrLDPC_bg_get(bg);
+        uint32_t filler_end = (uint32_t)(g->kb - NRLDPC_BG_PUNCTURED) * z;
+        int8_t *d = ref + NRLDPC_BG_PUNCTURED * z;
+        uint32_t n = (uint32_t)(g->cols - NRLDPC_BG_PUNCTURED) * z;
+        int32_t sum;
+        uint32_t i;
+
+        for (i = 0; i < n; i++)
+                cw[i] = i >= filler_end - rm->f && i < filler_end ? 0 : test_rand(seed) & 1;
+        test_rm_ref(bg, z, rm, pos);
+
+        TEST_CHECK(nrLDPC_rm_match(bg, z, rm, cw, bits) == DOCA_SUCCESS);
+        for (i = 0; i < rm->e; i++)
+                TEST_CHECK(bits[i] == cw[pos[i]]);
+
+        /* LLRs positive for a 0, the repeated ones added with saturation, the filler bits known */
+        for (i = 0; i < rm->e; i++)
+                in[i] = bits[i] != 0 ? -TEST_RM_LLR : TEST_RM_LLR;
+        memset(ref, 0, (size_t)g->cols * z);
+        for (i = 0; i < rm->e; i++) {
+                sum = d[pos[i]] + in[i];
+                if (sum > NRLDPC_RM_LLR_MAX)
+                        sum = NRLDPC_RM_LLR_MAX;
+                else if (sum < -NRLDPC_RM_LLR_MAX)
+                        sum = -NRLDPC_RM_LLR_MAX;
+                d[pos[i]] = (int8_t)sum;
+        }
+        memset(d + filler_end - rm->f, NRLDPC_RM_FILLER_LLR, rm->f);
+
+        TEST_CHECK(nrLDPC_rm_recover(bg, z, rm, in, llrs) == DOCA_SUCCESS);
+        TEST_CHECK(memcmp(llrs, ref, (size_t)g->cols * z) == 0);
+
+        return 0;
+}
+
+/*
+ * Round trips of one circular buffer: every rv and modulation order, E a third of the buffer, then 2.5 times it
+ *
+ * @bg [in]: Base graph
+ * @z [in]: Lifting size
+ * @f [in]: Filler bits
+ * @ncb [in]: Circular buffer length
+ * @seed [in/out]: Random bits
+ * @return: 0 when they all match, 1 otherwise
+ */
+static int test_rm_buffer(uint8_t bg, uint16_t z, uint16_t f, uint16_t ncb, uint32_t *seed)
+{
+        const uint8_t qms[5] = {1, 2, 4, 6, 8};
+        struct nrLDPC_proto_rm rm = {.ncb = ncb, .f = f};
+        uint32_t avail = (uint32_t)ncb - f;
+        uint32_t q, e;
+
+        for (rm.rv = 0; rm.rv < 4; rm.rv++) {
+                for (q = 0; q < 5; q++) {
+                        rm.qm = qms[q];
+                        for (e = avail / 3; e <= avail * 5 / 2; e += avail * 13 / 6) {
+                                rm.e = e - e % rm.qm;
+                                if (test_rm_one(bg, z, &rm, seed) != 0) {
+                                        printf("  BG%u Zc=%u F=%u Ncb=%u rv=%u Qm=%u E=%u\n",
+                                               bg,
+                                               z,
+                                               rm.f,
+                                               rm.ncb,
+                                               rm.rv,
+                                               rm.qm,
+                                               rm.e);
+                                        return 1;
+                                }
+                        }
+                }
+        }
+
+        return 0;
+}
+
+/*
+ * rm_roundtrip: nrLDPC_rm_match() and nrLDPC_rm_recover() on both base graphs, every rv and modulation order,
+ * with and without filler bits, E below and above Ncb (repetition) and limited circular buffers (LBRM)
+ */
+static int test_rm_roundtrip(void)
+{
+        const uint16_t zs[3] = {7, 64, 384};
+        struct nrLDPC_proto_rm rm;
+        const struct nrLDPC_bg *g;
+        uint32_t seed = 7;
+        uint32_t n, filler_end;
+        uint8_t bg;
+        uint32_t i;
+
+        for (bg = 1; bg <= 2; bg++) {
+                g = nrLDPC_bg_get(bg);
+                for (i = 0; i < 3; i++) {
+                        n = (uint32_t)(g->cols - NRLDPC_BG_PUNCTURED) * zs[i];
+                        filler_end = (uint32_t)(g->kb - NRLDPC_BG_PUNCTURED) * zs[i];
+                        TEST_CHECK(test_rm_buffer(bg, zs[i], 0, (uint16_t)n, &seed) == 0);
+                        TEST_CHECK(test_rm_buffer(bg, zs[i], (uint16_t)(filler_end / 3), (uint16_t)n, &seed) == 0);
+                        n = filler_end + (n - filler_end) / 2;
+                        TEST_CHECK(test_rm_buffer(bg, zs[i], 0, (uint16_t)n, &seed) == 0);
+                        TEST_CHECK(test_rm_buffer(bg, zs[i], (uint16_t)(filler_end / 3), (uint16_t)n, &seed) == 0);
+                }
+        }
+
+        /* Out of TS 38.212 */
+        rm = (struct nrLDPC_proto_rm){.e = 1000, .ncb = 66 * 64, .f = 0, .rv = 0, .qm = 2};
+        TEST_CHECK(nrLDPC_rm_check(1, 64, &rm) == DOCA_SUCCESS);
+        TEST_CHECK(nrLDPC_rm_check(1, 63, &rm) != DOCA_SUCCESS);
+        TEST_CHECK(nrLDPC_rm_check(3, 64, &rm) != DOCA_SUCCESS);
+        rm.e = 1001;
+        TEST_CHECK(nrLDPC_rm_check(1, 64, &rm) != DOCA_SUCCESS);
+        rm.e = 1000;
+        rm.qm = 3;
+        TEST_CHECK(nrLDPC_rm_check(1, 64, &rm) != DOCA_SUCCESS);
+        rm.qm = 2;
+        rm.rv = 4;
+        TEST_CHECK(nrLDPC_rm_check(1, 64, &rm) != DOCA_SUCCESS);
+        rm.rv = 0;
+        rm.ncb = 20 * 64 - 1;
+        TEST_CHECK(nrLDPC_rm_check(1, 64, &rm) != DOCA_SUCCESS);
+        rm.ncb = 66 * 64 + 1;
+        TEST_CHECK(nrLDPC_rm_check(1, 64, &rm) != DOCA_SUCCESS);
+
+        return 0;
+}
+
+/*
+ * Combine one transmission of TEST_HARQ_N LLRs all equal to llr
+ *
+ * @store [in]: Store
+ * @harq_pid [in]: HARQ process, ulsch_id 0 and segment 0
+ * @new_data [in]: First transmission
+ * @llr [in]: LLR
+ * @combined [out]: Combined LLRs
+ * @missed [out]: A retransmission whose buffer was not found
+ * @return: Result of nrLDPC_harq_combine()
+ */
+static doca_error_t test_harq_send(struct nrLDPC_harq_store *store,
+                                   uint8_t harq_pid,
+                                   bool new_data,
+                                   int8_t llr,
+                                   int8_t *combined,
+                                   bool *missed)
+{
+        struct nrLDPC_proto_harq harq = {.harq_pid = harq_pid, .ctrl = new_data ? NRLDPC_PROTO_HARQ_NEW_DATA : 0};
+        int8_t llrs[TEST_HARQ_N];
+
+        memset(llrs, llr, sizeof(llrs));
+        return nrLDPC_harq_combine(store, &harq, TEST_HARQ_N, llrs, TEST_HARQ_N, combined, missed);
+}
+
+/*
+ * Whether all the LLRs of a code block of the harq tests are equal to llr
+ *
+ * @llrs [in]: TEST_HARQ_N LLRs
+ * @llr [in]: LLR
+ * @return: true when they all are
+ */
+static bool test_harq_all(const int8_t *llrs, int8_t llr)
+{
+        uint32_t i;
+
+        for (i = 0; i < TEST_HARQ_N; i++)
+                if (llrs[i] != llr)
+                        return false;
+        return true;
+}
+
+/*
+ * harq: soft combining with saturation and wrap-around, least recently used eviction, release of a HARQ process
+ */
+static int test_harq(void)
+{
+        struct nrLDPC_harq_store store;
+        struct nrLDPC_proto_harq harq = {0};
+        int8_t combined[TEST_HARQ_N];
+        int8_t llrs[4] = {1, 2, 3, 4};
+        bool missed;
+
+        nrLDPC_harq_store_init(&store, 2);
+
+        /* Processes 1 and 2 take the two buffers, 1 is combined again: 2 is the least recently used */
+        TEST_CHECK(test_harq_send(&store, 1, true, 10, combined, &missed) == DOCA_SUCCESS && !missed);
+        TEST_CHECK(test_harq_all(combined, 10));
+        TEST_CHECK(test_harq_send(&store, 2, true, 20, combined, &missed) == DOCA_SUCCESS && !missed);
+        TEST_CHECK(test_harq_send(&store, 1, false, 10, combined, &missed) == DOCA_SUCCESS && !missed);
+        TEST_CHECK(test_harq_all(combined, 20));
+        TEST_CHECK(store.evicted == 0);
+
+        /* 3 evicts 2, whose retransmission misses its buffer and evicts 1 in turn */
+        TEST_CHECK(test_harq_send(&store, 3, true, 30, combined, &missed) == DOCA_SUCCESS && !missed);
+        TEST_CHECK(store.evicted == 1);
+        TEST_CHECK(test_harq_send(&store, 2, false, 20, combined, &missed) == DOCA_SUCCESS && missed);
+        TEST_CHECK(test_harq_all(combined, 20));
+        TEST_CHECK(store.evicted == 2 && store.missed == 1);
+        TEST_CHECK(test_harq_send(&store, 3, false, 30, combined, &missed) == DOCA_SUCCESS && !missed);
+        TEST_CHECK(test_harq_all(combined, 60));
+
+        /* Saturation, and new data starting the buffer over */
+        TEST_CHECK(test_harq_send(&store, 3, false, 100, combined, &missed) == DOCA_SUCCESS && !missed);
+        TEST_CHECK(test_harq_all(combined, NRLDPC_HARQ_LLR_MAX));
+        TEST_CHECK(test_harq_send(&store, 3, false, -128, combined, &missed) == DOCA_SUCCESS && !missed);
+        TEST_CHECK(test_harq_all(combined, -1));
+        TEST_CHECK(test_harq_send(&store, 3, true, -100, combined, &missed) == DOCA_SUCCESS && !missed);
+        TEST_CHECK(test_harq_all(combined, -100));
+
+        /* A window wrapping around the end of the buffer */
+        harq.harq_pid = 3;
+        harq.offset = TEST_HARQ_N - 2;
+        TEST_CHECK(nrLDPC_harq_combine(&store, &harq, TEST_HARQ_N, llrs, 4, combined, &missed) == DOCA_SUCCESS);
+        TEST_CHECK(combined[TEST_HARQ_N - 2] == -99 && combined[TEST_HARQ_N - 1] == -98);
+        TEST_CHECK(combined[0] == -97 && combined[1] == -96 && combined[2] == -100);
+        harq.offset = TEST_HARQ_N;
+        TEST_CHECK(nrLDPC_harq_combine(&store, &harq, TEST_HARQ_N, llrs, 4, combined, &missed) != DOCA_SUCCESS);
+
+        /* Releasing process 3 frees its buffer, another process is not touched */
+        TEST_CHECK(nrLDPC_harq_release(&store, 0, 4) == 0);
+        TEST_CHECK(nrLDPC_harq_release(&store, 0, 3) == 1);
+        TEST_CHECK(test_harq_send(&store, 3, false, 5, combined, &missed) == DOCA_SUCCESS && missed);
+        TEST_CHECK(test_harq_send(&store, 2, false, 5, combined, &missed) == DOCA_SUCCESS && !missed);
+        TEST_CHECK(test_harq_all(combined, 25));
+
+        nrLDPC_harq_store_clean(&store);
+        return 0;
+}
+
+/*
+ * harq_window: the smallest circular window holding the non-zero LLRs of a transmission
+ */
+static int test_harq_window(void)
+{
+        int8_t llrs[10] = {0};
+        uint32_t offset, len;
+
+        nrLDPC_harq_window(llrs, 10, &offset, &len);
+        TEST_CHECK(len == 0);
+
+        llrs[3] = 1;
+        llrs[5] = -1;
+        nrLDPC_harq_window(llrs, 10, &offset, &len);
+        TEST_CHECK(offset == 3 && len == 3);
+
+        /* Non-zero LLRs at both ends: the window wraps around */
+        memset(llrs, 0, sizeof(llrs));
+        llrs[0] = llrs[2] = llrs[8] = llrs[9] = 1;
+        nrLDPC_harq_window(llrs, 10, &offset, &len);
+        TEST_CHECK(offset == 8 && len == 5);
+
+        memset(llrs, 1, sizeof(llrs));
+        nrLDPC_harq_window(llrs, 10, &offset, &len);
+        TEST_CHECK(len == 10);
+
+        return 0;
+}
+
+/*
+ * proto: header and payload packing, parsing of valid, truncated and foreign messages, response matching
+ */
+static int test_proto(void)
+{
+        struct nrLDPC_proto_hdr hdr = {0};
+        struct nrLDPC_proto_hdr out;
+        struct nrLDPC_proto_hdr resp;
+        uint8_t msg[sizeof(hdr) + 8];
+        const uint8_t payload[5] = {1, 2, 3, 4, 5};
+        const void *p;
+        uint32_t len;
+
+        hdr.op = NRLDPC_PROTO_OP_DECOD_REQ;
+        hdr.bg = 2;
+        hdr.flags = NRLDPC_PROTO_FLAG_HARQ;
+        hdr.z = 384;
+        hdr.req_id = 0x12345678;
+        hdr.k = 3840;
+        hdr.n = 52 * 384;
+        hdr.num_its = 8;
+        hdr.crc_idx = NRLDPC_PROTO_CRC_24B;
+        hdr.status = -7;
+
+        len = nrLDPC_proto_pack(msg, sizeof(msg), &hdr, payload, sizeof(payload));
+        TEST_CHECK(len == sizeof(hdr) + sizeof(payload));
+        TEST_CHECK(hdr.magic == NRLDPC_PROTO_MAGIC && hdr.version == NRLDPC_PROTO_VERSION);
+        TEST_CHECK(nrLDPC_proto_unpack(msg, len, &out, &p) == DOCA_SUCCESS);
+        TEST_CHECK(memcmp(&out, &hdr, sizeof(hdr)) == 0 && out.payload_len == sizeof(payload));
+        TEST_CHECK(p == msg + sizeof(hdr) && memcmp(p, payload, sizeof(payload)) == 0);
+
+        /* Too small a buffer, a truncated message, another magic or version */
+        TEST_CHECK(nrLDPC_proto_pack(msg, sizeof(msg), &hdr, payload, sizeof(msg)) == 0);
+        TEST_CHECK(nrLDPC_proto_pack(msg, sizeof(hdr) - 1, &hdr, NULL, 0) == 0);
+        TEST_CHECK(nrLDPC_proto_unpack(msg, len - 1, &out, &p) != DOCA_SUCCESS);
+        TEST_CHECK(nrLDPC_proto_unpack(msg, sizeof(hdr) - 1, &out, &p) != DOCA_SUCCESS);
+        msg[0] ^= 0xff;
+        TEST_CHECK(nrLDPC_proto_unpack(msg, len, &out, &p) == DOCA_ERROR_NOT_SUPPORTED);
+        msg[0] ^= 0xff;
+        msg[2]++;
+        TEST_CHECK(nrLDPC_proto_unpack(msg, len, &out, &p) == DOCA_ERROR_NOT_SUPPORTED);
+
+        /* A response answers the request of its id with the next op */
+        resp = hdr;
+        resp.op = NRLDPC_PROTO_OP_DECOD_RESP;
+        resp.status = 3;
+        TEST_CHECK(nrLDPC_proto_check_resp(&hdr, &resp) == DOCA_SUCCESS);
+        resp.status = NRLDPC_PROTO_STATUS_CANCELLED;
+        TEST_CHECK(nrLDPC_proto_check_resp(&hdr, &resp) == NRLDPC_PROTO_ERROR_CANCELLED);
+        resp.status = -1;
+        TEST_CHECK(nrLDPC_proto_check_resp(&hdr, &resp) == DOCA_ERROR_IO_FAILED);
+        resp.status = 0;
+        resp.req_id++;
+        TEST_CHECK(nrLDPC_proto_check_resp(&hdr, &resp) == DOCA_ERROR_UNEXPECTED);
+        resp.req_id--;
+        resp.op = NRLDPC_PROTO_OP_ENCOD_RESP;
+        TEST_CHECK(nrLDPC_proto_check_resp(&hdr, &resp) == DOCA_ERROR_UNEXPECTED);
+
+        return 0;
+}
+
+/*
+ * Parity checks of H a codeword fails, computed from the base graph as TS 38.212 5.3.2 lifts it
+ *
+ * @g [in]: Base graph
+ * @z [in]: Lifting size
+ * @cw [in]: The cols * z bits of the codeword, punctured columns included, one bit per byte
+ * @return: Number of failed checks
+ */
+static uint32_t test_syndrome(const struct nrLDPC_bg *g, uint16_t z, const uint8_t *cw)
+{
+        int ils = nrLDPC_bg_ils(z);
+        const struct nrLDPC_bg_entry *e;
+        uint32_t failed = 0;
+        uint32_t r, k;
+        uint8_t check;
+
+        for (r = 0; r < g->rows; r++) {
+                for (k = 0; k < z; k++) {
+                        check = 0;
+                        for (e = &g->entries[g->row_start[r]]; e < &g->entries[g->row_start[r + 1]]; e++)
+                                check ^= cw[(uint32_t)e->col * z + (k + e->v[ils] % z) % z];
+                        failed += check;
+                }
+        }
+        return failed;
+}
+
+/*
+ * host_encod: H c = 0 for a random codeword of every lifting size of both base graphs, with filler bits, and the
+ * systematic bits copied through
+ */
+static int test_host_encod(void)
+{
+        static uint8_t cw[NRLDPC_BG_MAX_COLS * NRLDPC_BG_MAX_Z];
+        static uint8_t packed[NRLDPC_PROTO_ENCOD_MAX_K / 8];
+        static uint8_t out[NRLDPC_PROTO_ENCOD_MAX_N];
+        const struct nrLDPC_bg *g;
+        uint32_t seed = 3;
+        uint32_t sizes = 0;
+        uint32_t k, f, n, i;
+        uint16_t z;
+        uint8_t bg;
+
+        TEST_CHECK(nrLDPC_bg_get(1)->row_start[nrLDPC_bg_get(1)->rows] == TEST_BG1_ENTRIES);
+        TEST_CHECK(nrLDPC_bg_get(2)->row_start[nrLDPC_bg_get(2)->rows] == TEST_BG2_ENTRIES);
+        for (z = 1; z <= NRLDPC_BG_MAX_Z; z++) {
+                if (nrLDPC_bg_ils(z) < 0)
+                        continue;
+                sizes++;
+                for (bg = 1; bg <= 2; bg++) {
+                        g = nrLDPC_bg_get(bg);
+                        k = (uint32_t)g->kb * z;
+                        f = z / 2;
+                        n = (uint32_t)(g->cols - NRLDPC_BG_PUNCTURED) * z;
+                        for (i = 0; i < k; i++)
+                                cw[i] = i < k - f ? test_rand(&seed) & 1 : 0;
+                        nrLDPC_bits_pack(cw, k, packed);
+                        if (nrLDPC_host_encod(bg, z, k, f, packed, true, out) != DOCA_SUCCESS ||
+                            memcmp(out, cw + NRLDPC_BG_PUNCTURED * z, k - NRLDPC_BG_PUNCTURED * z) != 0) {
+                                printf("  BG%u Zc=%u: encoding failed\n", bg, z);
+                                return 1;
+                        }
+                        memcpy(cw + NRLDPC_BG_PUNCTURED * z, out, n);
+                        if (test_syndrome(g, z, cw) != 0) {
+                                printf("  BG%u Zc=%u: %u parity checks fail\n", bg, z, test_syndrome(g, z, cw));
+                                return 1;
+                        }
+                }
+        }
+        TEST_CHECK(sizes == TEST_LIFTING_SIZES);
+
+        /* Out of TS 38.212 */
+        TEST_CHECK(nrLDPC_host_encod(3, 64, 22 * 64, 0, packed, true, out) != DOCA_SUCCESS);
+        TEST_CHECK(nrLDPC_host_encod(1, 63, 22 * 63, 0, packed, true, out) != DOCA_SUCCESS);
+        TEST_CHECK(nrLDPC_host_encod(2, 64, 10 * 64 + 1, 0, packed, true, out) != DOCA_SUCCESS);
+
+        return 0;
+}
+
+/* Unit test */
+struct test_entry {
+        const char *name;  /* Name on the command line and in meson */
+        int (*run)(void);  /* Test, 0 when it passes */
+};
+
+static const struct test_entry tests[] = {
+        {"crc", test_crc},
+        {"rm_k0", test_rm_k0},
+        {"rm_roundtrip", test_rm_roundtrip},
+        {"harq", test_harq},
+        {"harq_window", test_harq_window},
+        {"proto", test_proto},
+        {"host_encod", test_host_encod},
+};
+
+/*
+ * Component: High PHY layer of the vDU.
+ *
+ * vdu_ldpc_tests - Unit tests of the LDPC offloading library, run by meson test.
+ *
+ * Command line:        $./vdu_ldpc_tests [test...]
+ *
+ * @return: EXIT_SUCCESS when every test run passes and EXIT_FAILURE otherwise
+ */
+int main(int argc, char **argv)
+{
+        int failed = 0;
+        int ran = 0;
+        size_t i;
+        int a;
+
+        for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+                for (a = 1; a < argc && strcmp(argv[a], tests[i].name) != 0; a++)
+                        ;
+                if (argc > 1 && a == argc)
+                        continue;
+                ran++;
+                if (tests[i].run() != 0) {
+                        printf("FAIL %s\n", tests[i].name);
+                        failed++;
+                } else {
+                        printf("ok   %s\n", tests[i].name);
+                }
+        }
+
+        if (ran == 0) {
+                printf("No such test\n");
+                return EXIT_FAILURE;
+        }
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
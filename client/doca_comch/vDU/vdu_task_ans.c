@@ -0,0 +1,34 @@
+/*
+ * Completion counters of the vDU programs built without OAI: the library reports completed jobs through
+ * completed_task_ans(), which OAI's task_ans.c provides in the real vDU.
+ *
+ * Author: Vlademir Brusse
+ *
+ * Date: 2026/10/17
+ *
+ */
+
+#include <nrLDPC_defs.h>
+
+/*
+ * From /openairinterface5g/common/utils/threadPool/task_ans.c
+ */
+void init_task_ans(task_ans_t* ans, unsigned int num_jobs)
+{
+  ans->counter = num_jobs;
+  sem_init(&ans->sem, 0, 0);
+}
+
+void completed_task_ans(task_ans_t* task)
+{
+  int num_jobs = atomic_fetch_sub_explicit(&task->counter, 1, memory_order_relaxed);
+  if (num_jobs == 1) {
+    sem_post(&task->sem);
+  }
+}
+
+void join_task_ans(task_ans_t* ans)
+{
+  while (sem_wait(&ans->sem) != 0)
+    ;
+}